@@ -95,12 +95,14 @@ esp_err_t va_board_button_init()
 }
 
 extern esp_err_t ledc_lyrat_init();
+extern void ledc_lyrat_set_fade(const uint32_t * ui_led_v, int fade_ms);
 
 esp_err_t va_board_led_init()
 {
     va_led_config_t *ab_led_conf = NULL;
     led_lyrat_pattern_init(&ab_led_conf);
     ledc_lyrat_init();
+    va_led_set_fade_cb(ledc_lyrat_set_fade);
     va_led_init((va_led_config_t *)ab_led_conf);
     return ESP_OK;
 }
@@ -17,6 +17,7 @@
 #include <resampling.h>
 #include <va_dsp.h>
 #include <lyrat_init.h>
+#include <va_latency.h>
 
 #include "app_defs.h"
 
@@ -64,6 +65,7 @@ static void ww_detection_task(void *arg)
             lyrat_stream_audio((uint8_t *)buffer, (audio_chunksize * sizeof(int16_t)), portMAX_DELAY);
             int r = esp_wwe_detect(buffer);
             if (r && dd.detect_wakeword) {
+                va_latency_mark(VA_LATENCY_WAKE);
                 int new_ms = (chunks*audio_chunksize*1000)/frequency;
 #if !defined (CTC_CS48L32_SENSORY_TRIGGER)
 #if defined(CTC_TRIGGER_TEST)
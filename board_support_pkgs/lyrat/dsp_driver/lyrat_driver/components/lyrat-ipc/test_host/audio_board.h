@@ -0,0 +1,5 @@
+#pragma once
+
+#include "driver/i2s.h"
+
+void audio_board_i2s_init_default(i2s_config_t *i2s_config);
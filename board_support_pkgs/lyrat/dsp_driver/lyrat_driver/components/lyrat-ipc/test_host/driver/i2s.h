@@ -0,0 +1,25 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    I2S_NUM_0 = 0,
+    I2S_NUM_1,
+} i2s_port_t;
+
+typedef enum {
+    I2S_BITS_PER_SAMPLE_16BIT = 16,
+    I2S_BITS_PER_SAMPLE_32BIT = 32,
+} i2s_bits_per_sample_t;
+
+typedef enum {
+    I2S_CHANNEL_MONO = 1,
+    I2S_CHANNEL_STEREO = 2,
+} i2s_channel_t;
+
+typedef struct {
+    int sample_rate;
+    i2s_bits_per_sample_t bits_per_sample;
+} i2s_config_t;
+
+esp_err_t i2s_set_clk(i2s_port_t i2s_num, uint32_t rate, i2s_bits_per_sample_t bits, i2s_channel_t ch);
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdlib.h>
+
+#define esp_audio_mem_malloc(size)      malloc(size)
+#define esp_audio_mem_calloc(n, size)   calloc(n, size)
+#define esp_audio_mem_free(ptr)         free(ptr)
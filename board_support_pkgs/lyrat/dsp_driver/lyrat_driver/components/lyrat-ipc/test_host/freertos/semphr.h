@@ -0,0 +1,16 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef struct host_sem *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+
+SemaphoreHandle_t host_sem_create(unsigned int max_count, unsigned int initial_count);
+
+#define vSemaphoreCreateBinary(sem) ((sem) = host_sem_create(1, 1))
+#define xSemaphoreCreateBinary()    host_sem_create(1, 0)
+#define xSemaphoreCreateMutex()     host_sem_create(1, 1)
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
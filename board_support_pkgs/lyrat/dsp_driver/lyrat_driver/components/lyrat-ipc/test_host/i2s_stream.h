@@ -0,0 +1,35 @@
+#pragma once
+
+/* Replay stand-in for the I2S reader stream: the harness pushes WAV frames
+ * into the stream output callback instead of the I2S DMA task.
+ */
+
+#include <audio_common.h>
+#include <driver/i2s.h>
+#include <media_hal.h>
+
+typedef struct audio_stream {
+    const char *label;
+    audio_io_fn_arg_t stream_output;
+    audio_event_fn_arg_t event_func;
+    bool running;
+} audio_stream_t;
+
+typedef struct i2s_stream_config {
+    uint8_t i2s_num;
+    i2s_config_t i2s_config;
+    media_hal_t *media_hal_cfg;
+} i2s_stream_config_t;
+
+typedef struct i2s_stream {
+    audio_stream_t base;
+    i2s_stream_config_t cfg;
+} i2s_stream_t;
+
+i2s_stream_t *i2s_reader_stream_create(i2s_stream_config_t *cfg);
+esp_err_t i2s_stream_destroy(i2s_stream_t *stream);
+void i2s_stream_set_stack_size(i2s_stream_t *stream, ssize_t stack_size);
+
+esp_err_t audio_stream_init(audio_stream_t *stream, const char *label, audio_io_fn_arg_t *stream_io, audio_event_fn_arg_t *event_func);
+esp_err_t audio_stream_start(audio_stream_t *stream);
+esp_err_t audio_stream_stop(audio_stream_t *stream);
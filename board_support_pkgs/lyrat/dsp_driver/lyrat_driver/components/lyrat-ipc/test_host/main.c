@@ -0,0 +1,476 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Replays WAV captures through the lyrat capture path (lyrat_init.c, the ring
+ * buffers, the resample task and the wake word task) on the host, as fast as
+ * the pipeline can consume them.
+ *
+ *   ./replay_wwe [-d detector] [-c first_channel] [-x expected] [-v] file.wav
+ *   ./replay_wwe -g fixture.wav [-n bursts]
+ *
+ * The input must be 16 bit PCM at 48kHz, the rate the pipeline captures at.
+ * Two channels starting at `first_channel` are fed, mono files are duplicated.
+ * With -x the exit status tells whether the detection count matched.
+ */
+
+#include <malloc.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <ringbuf.h>
+#include <i2s_stream.h>
+#include <audio_board.h>
+#include <va_dsp.h>
+#include <va_latency.h>
+#include <lyrat_init.h>
+#include "replay.h"
+
+#define REPLAY_SAMP_RATE    48000
+#define REPLAY_BLOCK_MS     20
+#define REPLAY_BLOCK_FRAMES (REPLAY_SAMP_RATE * REPLAY_BLOCK_MS / 1000)
+#define REPLAY_MAX_RB       4
+#define REPLAY_IDLE_MS      50
+
+int replay_verbose;
+
+static audio_stream_t *replay_stream;
+
+static struct {
+    ringbuf_t *rb;
+    ssize_t peak;
+} replay_rb[REPLAY_MAX_RB];
+static int replay_num_rb;
+
+static pthread_mutex_t replay_heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t replay_heap_cur;
+static size_t replay_heap_peak;
+
+/* Board and stream stand-ins used by lyrat_init() */
+
+media_hal_t *media_hal_get_handle(void)
+{
+    return NULL;
+}
+
+void audio_board_i2s_init_default(i2s_config_t *i2s_config)
+{
+    i2s_config->sample_rate = REPLAY_SAMP_RATE;
+    i2s_config->bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+}
+
+esp_err_t i2s_set_clk(i2s_port_t i2s_num, uint32_t rate, i2s_bits_per_sample_t bits, i2s_channel_t ch)
+{
+    if (rate != REPLAY_SAMP_RATE || bits != I2S_BITS_PER_SAMPLE_16BIT || ch != I2S_CHANNEL_STEREO) {
+        ESP_LOGE("replay", "Capture path asks for %u Hz/%d bit/%d ch, the replay only feeds %d Hz/16 bit/2 ch",
+                 rate, bits, ch, REPLAY_SAMP_RATE);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void va_dsp_tap_to_talk_start(void)
+{
+    replay_stats.tap_to_talk++;
+}
+
+void va_latency_mark(va_latency_stage_t stage)
+{
+}
+
+i2s_stream_t *i2s_reader_stream_create(i2s_stream_config_t *cfg)
+{
+    i2s_stream_t *stream = calloc(1, sizeof(i2s_stream_t));
+    if (stream) {
+        stream->cfg = *cfg;
+    }
+    return stream;
+}
+
+esp_err_t i2s_stream_destroy(i2s_stream_t *stream)
+{
+    free(stream);
+    return ESP_OK;
+}
+
+void i2s_stream_set_stack_size(i2s_stream_t *stream, ssize_t stack_size)
+{
+}
+
+esp_err_t audio_stream_init(audio_stream_t *stream, const char *label, audio_io_fn_arg_t *stream_io, audio_event_fn_arg_t *event_func)
+{
+    stream->label = label;
+    stream->stream_output = *stream_io;
+    stream->event_func = *event_func;
+    replay_stream = stream;
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_start(audio_stream_t *stream)
+{
+    stream->running = true;
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_stop(audio_stream_t *stream)
+{
+    stream->running = false;
+    return ESP_OK;
+}
+
+/* Ring buffer and heap accounting, hooked in with the linker's --wrap */
+
+ringbuf_t *__real_rb_init(const char *rb_name, uint32_t size);
+int __real_rb_write(ringbuf_t *rb, const uint8_t *buf, int len, uint32_t ticks_to_wait);
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+ringbuf_t *__wrap_rb_init(const char *rb_name, uint32_t size)
+{
+    ringbuf_t *rb = __real_rb_init(rb_name, size);
+    if (rb && replay_num_rb < REPLAY_MAX_RB) {
+        replay_rb[replay_num_rb++].rb = rb;
+    }
+    return rb;
+}
+
+int __wrap_rb_write(ringbuf_t *rb, const uint8_t *buf, int len, uint32_t ticks_to_wait)
+{
+    int ret = __real_rb_write(rb, buf, len, ticks_to_wait);
+    int i;
+
+    for (i = 0; i < replay_num_rb; i++) {
+        if (replay_rb[i].rb == rb) {
+            /* fill_cnt is read unlocked, good enough for a high-water mark */
+            if (rb->fill_cnt > replay_rb[i].peak) {
+                replay_rb[i].peak = rb->fill_cnt;
+            }
+            break;
+        }
+    }
+    replay_stats.progress++;
+    return ret;
+}
+
+static void replay_heap_account(void *old_ptr, void *new_ptr)
+{
+    size_t old_sz = old_ptr ? malloc_usable_size(old_ptr) : 0;
+    size_t new_sz = new_ptr ? malloc_usable_size(new_ptr) : 0;
+
+    pthread_mutex_lock(&replay_heap_lock);
+    replay_heap_cur = (replay_heap_cur + new_sz > old_sz) ? replay_heap_cur + new_sz - old_sz : 0;
+    if (replay_heap_cur > replay_heap_peak) {
+        replay_heap_peak = replay_heap_cur;
+    }
+    pthread_mutex_unlock(&replay_heap_lock);
+}
+
+void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    replay_heap_account(NULL, ptr);
+    return ptr;
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    void *ptr = __real_calloc(n, size);
+    replay_heap_account(NULL, ptr);
+    return ptr;
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    size_t old_sz = ptr ? malloc_usable_size(ptr) : 0;
+    void *new_ptr = __real_realloc(ptr, size);
+
+    if (new_ptr || size == 0) {
+        pthread_mutex_lock(&replay_heap_lock);
+        replay_heap_cur = (replay_heap_cur > old_sz) ? replay_heap_cur - old_sz : 0;
+        pthread_mutex_unlock(&replay_heap_lock);
+        replay_heap_account(NULL, new_ptr);
+    }
+    return new_ptr;
+}
+
+void __wrap_free(void *ptr)
+{
+    replay_heap_account(ptr, NULL);
+    __real_free(ptr);
+}
+
+/* WAV files */
+
+typedef struct {
+    FILE *fp;
+    int channels;
+    int sample_rate;
+    int bits;
+    uint32_t data_len;
+} replay_wav_t;
+
+static uint32_t rd_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t rd_le16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static int replay_wav_open(replay_wav_t *wav, const char *path)
+{
+    uint8_t hdr[16];
+    bool have_fmt = false;
+
+    memset(wav, 0, sizeof(*wav));
+    wav->fp = fopen(path, "rb");
+    if (!wav->fp) {
+        perror(path);
+        return -1;
+    }
+    if (fread(hdr, 1, 12, wav->fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+        goto err;
+    }
+    while (fread(hdr, 1, 8, wav->fp) == 8) {
+        uint32_t len = rd_le32(hdr + 4);
+        if (!memcmp(hdr, "fmt ", 4)) {
+            if (len < 16 || fread(hdr, 1, 16, wav->fp) != 16) {
+                break;
+            }
+            if (rd_le16(hdr) != 1 && rd_le16(hdr) != 0xfffe) {
+                fprintf(stderr, "%s: only PCM is supported\n", path);
+                goto err;
+            }
+            wav->channels = rd_le16(hdr + 2);
+            wav->sample_rate = rd_le32(hdr + 4);
+            wav->bits = rd_le16(hdr + 14);
+            have_fmt = true;
+            fseek(wav->fp, len - 16 + (len & 1), SEEK_CUR);
+        } else if (!memcmp(hdr, "data", 4)) {
+            if (!have_fmt) {
+                break;
+            }
+            wav->data_len = len;
+            return 0;
+        } else {
+            fseek(wav->fp, len + (len & 1), SEEK_CUR);
+        }
+    }
+    fprintf(stderr, "%s: no fmt/data chunk\n", path);
+err:
+    fclose(wav->fp);
+    wav->fp = NULL;
+    return -1;
+}
+
+static void wr_le32(FILE *fp, uint32_t v)
+{
+    uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+    fwrite(b, 1, 4, fp);
+}
+
+static void wr_le16(FILE *fp, uint16_t v)
+{
+    uint8_t b[2] = {v, v >> 8};
+    fwrite(b, 1, 2, fp);
+}
+
+/* Fixture: 48kHz stereo, low noise with `bursts` 600ms tones, one every 2s starting at 1s */
+static int replay_gen_fixture(const char *path, int bursts)
+{
+    int frames = REPLAY_SAMP_RATE * (2 * bursts + 2);
+    uint32_t seed = 1;
+    FILE *fp = fopen(path, "wb");
+    int i;
+
+    if (!fp) {
+        perror(path);
+        return -1;
+    }
+    fwrite("RIFF", 1, 4, fp);
+    wr_le32(fp, 36 + frames * 4);
+    fwrite("WAVEfmt ", 1, 8, fp);
+    wr_le32(fp, 16);
+    wr_le16(fp, 1);
+    wr_le16(fp, 2);
+    wr_le32(fp, REPLAY_SAMP_RATE);
+    wr_le32(fp, REPLAY_SAMP_RATE * 4);
+    wr_le16(fp, 4);
+    wr_le16(fp, 16);
+    fwrite("data", 1, 4, fp);
+    wr_le32(fp, frames * 4);
+
+    for (i = 0; i < frames; i++) {
+        int ms = (int) ((int64_t) i * 1000 / REPLAY_SAMP_RATE);
+        int16_t s;
+        seed = seed * 1103515245 + 12345;
+        s = (int16_t) ((int) ((seed >> 16) & 0xff) - 128);
+        if (ms >= 1000 && ms < 1000 + 2000 * bursts && ((ms - 1000) % 2000) < 600) {
+            s += (int16_t) (8000 * sin(2 * M_PI * 1000 * i / REPLAY_SAMP_RATE));
+        }
+        wr_le16(fp, s);
+        wr_le16(fp, s);
+    }
+    fclose(fp);
+    return 0;
+}
+
+static double replay_wall_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Done when nothing moved for a while and the ring buffers cannot satisfy another read */
+static void replay_wait_drained(void)
+{
+    unsigned long last = replay_stats.progress;
+    double idle_since = replay_wall_ms();
+
+    while (1) {
+        usleep(1000);
+        if (replay_stats.progress != last || replay_stats.in_detect) {
+            last = replay_stats.progress;
+            idle_since = replay_wall_ms();
+        } else if (replay_wall_ms() - idle_since > REPLAY_IDLE_MS) {
+            return;
+        }
+    }
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-d detector] [-c first_channel] [-x expected] [-v] file.wav\n", prog);
+    fprintf(stderr, "       %s -g fixture.wav [-n bursts]\n", prog);
+    fprintf(stderr, "detectors:");
+    replay_wwe_list(stderr);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+    const char *gen_path = NULL;
+    int bursts = 3, first_ch = 0, expected = -1;
+    replay_wav_t wav;
+    int16_t *in, *out;
+    uint64_t frames_fed = 0;
+    double wall_start, wall_ms, feed_cpu_ms, audio_s;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "d:c:x:g:n:vh")) != -1) {
+        switch (opt) {
+        case 'd':
+            if (replay_wwe_select(optarg) != ESP_OK) {
+                fprintf(stderr, "unknown detector '%s'\n", optarg);
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'c':
+            first_ch = atoi(optarg);
+            break;
+        case 'x':
+            expected = atoi(optarg);
+            break;
+        case 'g':
+            gen_path = optarg;
+            break;
+        case 'n':
+            bursts = atoi(optarg);
+            break;
+        case 'v':
+            replay_verbose++;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (gen_path) {
+        return replay_gen_fixture(gen_path, bursts) ? 1 : 0;
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (replay_wav_open(&wav, argv[optind]) != 0) {
+        return 2;
+    }
+    if (wav.bits != 16 || wav.sample_rate != REPLAY_SAMP_RATE || first_ch < 0 ||
+        first_ch + (wav.channels > 1 ? 2 : 1) > wav.channels) {
+        fprintf(stderr, "%s: %d Hz/%d bit/%d ch, need %d Hz/16 bit and channels %d..%d\n", argv[optind],
+                wav.sample_rate, wav.bits, wav.channels, REPLAY_SAMP_RATE, first_ch, first_ch + 1);
+        return 2;
+    }
+
+    lyrat_init();
+    if (!replay_stream || !replay_stream->running) {
+        fprintf(stderr, "capture path did not start its reader stream\n");
+        return 1;
+    }
+
+    /* Harness buffers stay out of the heap figures */
+    in = __real_malloc(REPLAY_BLOCK_FRAMES * wav.channels * sizeof(int16_t));
+    out = __real_malloc(REPLAY_BLOCK_FRAMES * 2 * sizeof(int16_t));
+    assert(in && out);
+
+    wall_start = replay_wall_ms();
+    feed_cpu_ms = replay_thread_cpu_ms();
+    while (1) {
+        size_t n = fread(in, wav.channels * sizeof(int16_t), REPLAY_BLOCK_FRAMES, wav.fp);
+        size_t f;
+        if (n == 0) {
+            break;
+        }
+        for (f = 0; f < n; f++) {
+            out[f * 2] = in[f * wav.channels + first_ch];
+            out[f * 2 + 1] = in[f * wav.channels + first_ch + (wav.channels > 1 ? 1 : 0)];
+        }
+        replay_stream->stream_output.func(replay_stream->stream_output.arg, out, n * 2 * sizeof(int16_t), portMAX_DELAY);
+        frames_fed += n;
+    }
+    feed_cpu_ms = replay_thread_cpu_ms() - feed_cpu_ms;
+    replay_wait_drained();
+    wall_ms = replay_wall_ms() - wall_start - REPLAY_IDLE_MS;
+    audio_s = (double) frames_fed / REPLAY_SAMP_RATE;
+
+    printf("replay: %s, %.2f s of audio in %.2f s (%.1fx real time), detector %s\n", argv[optind],
+           audio_s, wall_ms / 1000.0, wall_ms > 0 ? audio_s * 1000.0 / wall_ms : 0, replay_stats.wwe->name);
+    printf("detections: %d, tap-to-talk: %d\n", replay_stats.num_detections, replay_stats.tap_to_talk);
+    for (i = 0; i < replay_stats.num_detections; i++) {
+        printf("  %8.2f s  output %d\n", replay_stats.detections[i].ts, replay_stats.detections[i].output);
+    }
+    printf("cpu:\n");
+    printf("  %-20s %9.2f ms\n", "feeder", feed_cpu_ms);
+    for (i = 0; i < host_task_count(); i++) {
+        printf("  %-20s %9.2f ms\n", host_task_name(i), host_task_cpu_ms(i));
+    }
+    printf("  %-20s %9.2f ms, %lu chunks, avg %.1f us, max %.1f us\n", "esp_wwe_detect", replay_stats.detect_cpu_ms,
+           replay_stats.chunks, replay_stats.chunks ? replay_stats.detect_cpu_ms * 1000.0 / replay_stats.chunks : 0,
+           replay_stats.detect_max_us);
+    printf("memory:\n");
+    printf("  %-20s %9zu bytes peak\n", "heap", replay_heap_peak);
+    for (i = 0; i < replay_num_rb; i++) {
+        printf("  %-20s %9zd / %zd bytes peak\n", replay_rb[i].rb->name, replay_rb[i].peak, replay_rb[i].rb->size);
+    }
+    printf("result: detections=%d audio_s=%.2f speedup=%.1f heap_peak=%zu\n", replay_stats.num_detections,
+           audio_s, wall_ms > 0 ? audio_s * 1000.0 / wall_ms : 0, replay_heap_peak);
+
+    fclose(wav.fp);
+    if (expected >= 0 && expected != replay_stats.num_detections) {
+        fprintf(stderr, "expected %d detections, got %d\n", expected, replay_stats.num_detections);
+        return 1;
+    }
+    return 0;
+}
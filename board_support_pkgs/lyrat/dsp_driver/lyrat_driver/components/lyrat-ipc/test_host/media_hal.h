@@ -0,0 +1,5 @@
+#pragma once
+
+typedef struct media_hal media_hal_t;
+
+media_hal_t *media_hal_get_handle(void);
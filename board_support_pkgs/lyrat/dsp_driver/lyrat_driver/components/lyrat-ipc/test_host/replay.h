@@ -0,0 +1,49 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @brief Wake word detector plugged in behind esp_wwe.h
+ *
+ * libesp_wwe.a is Xtensa only, so the replay links one of these instead.
+ * To try another detector, either add it to the table in wwe_host.c or
+ * define `replay_wwe_user` in an object passed through EXTRA_OBJS and
+ * select it with `-d user`.
+ */
+typedef struct {
+    const char *name;
+    esp_err_t (*init)(void);
+    int sample_rate;
+    int chunksize;                  /* samples per esp_wwe_detect() call */
+    int (*detect)(int16_t *buf);    /* non-zero on detection */
+} replay_wwe_t;
+
+extern const replay_wwe_t replay_wwe_user __attribute__((weak));
+
+typedef struct {
+    double ts;                      /* seconds of audio, from the chunk count */
+    int output;
+} replay_detection_t;
+
+#define REPLAY_MAX_DETECTIONS 256
+
+typedef struct {
+    const replay_wwe_t *wwe;
+    volatile unsigned long progress;    /* bumped on every pipeline step, to detect a drained pipeline */
+    volatile int in_detect;
+    unsigned long chunks;
+    double detect_cpu_ms;
+    double detect_max_us;
+    int num_detections;
+    replay_detection_t detections[REPLAY_MAX_DETECTIONS];
+    int tap_to_talk;
+} replay_stats_t;
+
+extern replay_stats_t replay_stats;
+
+esp_err_t replay_wwe_select(const char *name);
+void replay_wwe_list(FILE *out);
+double replay_thread_cpu_ms(void);
@@ -0,0 +1,72 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host stand-in for the resampler in libcodecs.a, which is only built for Xtensa.
+ * Only integer-ratio downsampling is supported, which is all the capture path uses.
+ * Each output frame is the average of `ratio` input frames, so the numbers are close
+ * to, but not bit exact with, the target.
+ */
+
+#include <resampling.h>
+
+int audio_resample(short *in_buf, short *out_buf, int in_freq, int out_freq, int in_buf_size, int out_buf_size, int ch_num, audio_resample_config_t *resample_cfg)
+{
+    int ratio, frames, ch, i, j;
+
+    if (!in_buf || !out_buf || ch_num < 1 || ch_num > 2 || out_freq <= 0 || in_freq % out_freq) {
+        return 0;
+    }
+    ratio = in_freq / out_freq;
+    frames = in_buf_size / (ch_num * ratio);
+    if (frames * ch_num > out_buf_size) {
+        frames = out_buf_size / ch_num;
+    }
+    /* Output index never passes the input index, so in place is fine */
+    for (i = 0; i < frames; i++) {
+        for (ch = 0; ch < ch_num; ch++) {
+            int acc = 0;
+            for (j = 0; j < ratio; j++) {
+                acc += in_buf[(i * ratio + j) * ch_num + ch];
+            }
+            out_buf[i * ch_num + ch] = acc / ratio;
+        }
+    }
+    resample_cfg->innum += frames * ratio * ch_num;
+    resample_cfg->outnum += frames * ch_num;
+    return frames * ch_num;
+}
+
+int audio_resample_down_channel(short *in_buf, short *out_buf, int in_freq, int out_freq, int in_buf_size, int out_buf_size, int index, audio_resample_config_t *resample_cfg)
+{
+    int frames = in_buf_size / 2;
+    int i;
+
+    if (!in_buf || !out_buf || index < 0 || index > 1 || in_freq != out_freq) {
+        return 0;
+    }
+    if (frames > out_buf_size) {
+        frames = out_buf_size;
+    }
+    for (i = 0; i < frames; i++) {
+        out_buf[i] = in_buf[i * 2 + index];
+    }
+    return frames;
+}
+
+int audio_resample_up_channel(short *in_buf, short *out_buf, int in_freq, int out_freq, int in_buf_size, int out_buf_size, audio_resample_config_t *resample_cfg)
+{
+    int frames = in_buf_size;
+    int i;
+
+    if (!in_buf || !out_buf || in_freq != out_freq) {
+        return 0;
+    }
+    if (frames * 2 > out_buf_size) {
+        frames = out_buf_size / 2;
+    }
+    /* Walk backwards so that in place works */
+    for (i = frames - 1; i >= 0; i--) {
+        out_buf[i * 2] = out_buf[i * 2 + 1] = in_buf[i];
+    }
+    return frames * 2;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdio.h>
+#include <errno.h>
+
+#define esp_err_t int
+
+#define ESP_ERR_INVALID_ARG -1
+#define ESP_ERR_NO_MEM      -2
+#define ESP_FAIL            -1
+#define ESP_OK              0
+
+#define CONFIG_ESP32_PTHREAD_TASK_PRIO_DEFAULT 5
+
+extern int replay_verbose;
+
+#define ESP_LOGD(TAG, ...) do { if (replay_verbose > 1) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } } while (0)
+#define ESP_LOGI(TAG, ...) do { if (replay_verbose > 0) { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } } while (0)
+#define ESP_LOGW(TAG, ...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
+#define ESP_LOGE(TAG, ...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
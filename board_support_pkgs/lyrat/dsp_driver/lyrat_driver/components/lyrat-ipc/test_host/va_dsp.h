@@ -0,0 +1,3 @@
+#pragma once
+
+void va_dsp_tap_to_talk_start(void);
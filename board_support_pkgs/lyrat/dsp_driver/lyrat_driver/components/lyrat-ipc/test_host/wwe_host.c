@@ -0,0 +1,177 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "replay.h"
+#include <esp_wwe.h>
+
+#define WWE_SAMP_RATE   16000
+#define WWE_CHUNKSIZE   320             /* 20ms, same cadence as the capture path */
+
+/* Reference detector: fires when the chunk energy stays `thresh_db` above a
+ * tracked noise floor for `min_chunks` chunks. It has nothing to do with
+ * keyword spotting, but it gives repeatable detections for fixtures with
+ * known bursts, which is what pipeline regressions need.
+ */
+static struct {
+    float floor_db;
+    float thresh_db;
+    int min_chunks;
+    int refractory_chunks;
+    int above;
+    int since_trigger;
+    bool primed;
+} energy;
+
+static esp_err_t energy_init(void)
+{
+    const char *env;
+
+    memset(&energy, 0, sizeof(energy));
+    energy.thresh_db = 15.0f;
+    energy.min_chunks = 15;
+    energy.refractory_chunks = 50;
+    if ((env = getenv("REPLAY_WWE_THRESH_DB")) != NULL) {
+        energy.thresh_db = atof(env);
+    }
+    if ((env = getenv("REPLAY_WWE_MIN_MS")) != NULL) {
+        energy.min_chunks = atoi(env) / 20;
+    }
+    energy.since_trigger = energy.refractory_chunks;
+    return ESP_OK;
+}
+
+static int energy_detect(int16_t *buf)
+{
+    double acc = 0;
+    float db;
+    int i;
+
+    for (i = 0; i < WWE_CHUNKSIZE; i++) {
+        acc += (double) buf[i] * buf[i];
+    }
+    db = 10.0f * log10f((float) (acc / WWE_CHUNKSIZE) + 1.0f);
+    if (!energy.primed) {
+        energy.floor_db = db;
+        energy.primed = true;
+    }
+
+    if (energy.since_trigger < energy.refractory_chunks) {
+        energy.since_trigger++;
+    }
+    if (db > energy.floor_db + energy.thresh_db) {
+        energy.above++;
+        /* Let the floor creep up slowly so a stationary loud source is eventually ignored */
+        energy.floor_db += (db - energy.floor_db) * 0.002f;
+        if (energy.above == energy.min_chunks && energy.since_trigger >= energy.refractory_chunks) {
+            energy.since_trigger = 0;
+            return 1;
+        }
+    } else {
+        energy.above = 0;
+        energy.floor_db += (db - energy.floor_db) * (db < energy.floor_db ? 0.5f : 0.05f);
+    }
+    return 0;
+}
+
+static esp_err_t null_init(void)
+{
+    return ESP_OK;
+}
+
+static int null_detect(int16_t *buf)
+{
+    return 0;
+}
+
+static const replay_wwe_t replay_detectors[] = {
+    {"energy", energy_init, WWE_SAMP_RATE, WWE_CHUNKSIZE, energy_detect},
+    {"null", null_init, WWE_SAMP_RATE, WWE_CHUNKSIZE, null_detect},
+};
+
+replay_stats_t replay_stats = {
+    .wwe = &replay_detectors[0],
+};
+
+esp_err_t replay_wwe_select(const char *name)
+{
+    int i;
+
+    if (strcmp(name, "user") == 0) {
+        if (&replay_wwe_user == NULL) {
+            return ESP_FAIL;
+        }
+        replay_stats.wwe = &replay_wwe_user;
+        return ESP_OK;
+    }
+    for (i = 0; i < sizeof(replay_detectors) / sizeof(replay_detectors[0]); i++) {
+        if (strcmp(name, replay_detectors[i].name) == 0) {
+            replay_stats.wwe = &replay_detectors[i];
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+void replay_wwe_list(FILE *out)
+{
+    int i;
+
+    for (i = 0; i < sizeof(replay_detectors) / sizeof(replay_detectors[0]); i++) {
+        fprintf(out, " %s", replay_detectors[i].name);
+    }
+    if (&replay_wwe_user != NULL) {
+        fprintf(out, " user(%s)", replay_wwe_user.name);
+    }
+}
+
+double replay_thread_cpu_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+esp_err_t esp_wwe_init()
+{
+    return replay_stats.wwe->init();
+}
+
+int esp_wwe_get_sample_chunksize()
+{
+    return replay_stats.wwe->chunksize;
+}
+
+int esp_wwe_get_sample_rate()
+{
+    return replay_stats.wwe->sample_rate;
+}
+
+int esp_wwe_detect(int16_t *buf)
+{
+    const replay_wwe_t *wwe = replay_stats.wwe;
+    double start, spent;
+    int r;
+
+    replay_stats.in_detect = 1;
+    start = replay_thread_cpu_ms();
+    r = wwe->detect(buf);
+    spent = replay_thread_cpu_ms() - start;
+
+    replay_stats.detect_cpu_ms += spent;
+    if (spent * 1000.0 > replay_stats.detect_max_us) {
+        replay_stats.detect_max_us = spent * 1000.0;
+    }
+    if (r && replay_stats.num_detections < REPLAY_MAX_DETECTIONS) {
+        replay_detection_t *d = &replay_stats.detections[replay_stats.num_detections++];
+        d->ts = (double) replay_stats.chunks * wwe->chunksize / wwe->sample_rate;
+        d->output = r;
+    }
+    replay_stats.chunks++;
+    replay_stats.progress++;
+    replay_stats.in_detect = 0;
+    return r;
+}
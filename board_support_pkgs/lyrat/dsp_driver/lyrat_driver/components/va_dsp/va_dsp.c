@@ -17,6 +17,7 @@
 #include <va_nvs_utils.h>
 #include <va_dsp.h>
 #include <lyrat_init.h>
+#include <va_latency.h>
 
 #define AUDIO_BUF_SIZE (320)
 
@@ -132,6 +133,7 @@ static void va_dsp_thread(void *arg)
                             break;
                         }
                         if (va_dsp_data.va_dsp_recognize_cb(phrase_length, WAKEWORD) == 0) {
+                            va_latency_mark(VA_LATENCY_RECOGNIZE);
                             struct dsp_event_data new_event = {
                                 .event = GET_AUDIO
                             };
@@ -145,6 +147,7 @@ static void va_dsp_thread(void *arg)
                     }
                     case TAP_TO_TALK:
                         if (va_dsp_data.va_dsp_recognize_cb(0, TAP) == 0) {
+                            va_latency_mark(VA_LATENCY_RECOGNIZE);
                             _va_dsp_start_streaming();
                             struct dsp_event_data new_event = {
                                 .event = GET_AUDIO
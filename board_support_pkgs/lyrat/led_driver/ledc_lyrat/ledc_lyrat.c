@@ -45,6 +45,9 @@ esp_err_t ledc_lyrat_init()
         ledc_channel_config(&ledc_channel[ch]);
     }
 
+    // Hardware fades for keyframe animations
+    ret |= ledc_fade_func_install(0);
+
     return ret;
 }
 
@@ -58,4 +61,15 @@ void va_led_set_pwm(const uint32_t * ui_led_v)
     ledc_update_duty(ledc_channel[0].speed_mode, ledc_channel[0].channel);
     ledc_set_duty(ledc_channel[1].speed_mode, ledc_channel[1].channel, red_led_val);
     ledc_update_duty(ledc_channel[1].speed_mode, ledc_channel[1].channel);
-}
\ No newline at end of file
+}
+
+void ledc_lyrat_set_fade(const uint32_t * ui_led_v, int fade_ms)
+{
+    uint8_t red_led_val, green_led_val;
+    green_led_val  = 0xFF & (ui_led_v[0]);
+    red_led_val = 0xFF & (ui_led_v[0] >> 8);
+    ledc_set_fade_with_time(ledc_channel[0].speed_mode, ledc_channel[0].channel, green_led_val, fade_ms);
+    ledc_fade_start(ledc_channel[0].speed_mode, ledc_channel[0].channel, LEDC_FADE_NO_WAIT);
+    ledc_set_fade_with_time(ledc_channel[1].speed_mode, ledc_channel[1].channel, red_led_val, fade_ms);
+    ledc_fade_start(ledc_channel[1].speed_mode, ledc_channel[1].channel, LEDC_FADE_NO_WAIT);
+}
@@ -21,4 +21,6 @@
 
 esp_err_t ledc_lyrat_init();
 
+void ledc_lyrat_set_fade(const uint32_t * ui_led_v, int fade_ms);
+
 #endif /* __LEDC_LYRAT_H__ */
\ No newline at end of file
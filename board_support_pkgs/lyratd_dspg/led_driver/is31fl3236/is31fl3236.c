@@ -36,6 +36,13 @@ SemaphoreHandle_t is31fl3236_led_mux ;
 #define I2C_MASTER_RX_BUF_DISABLE   0  /*!< I2C master do not need buffer */
 #define I2C_MASTER_FREQ_HZ    100000   /*!< I2C master clock frequency */
 
+/* Unchanged channels up to this many are rewritten rather than starting a new burst */
+#define IS31FL3236_BURST_MAX_GAP    3
+
+static uint8_t is31fl3236_shadow[IS31FL3236_CH_NUM_MAX];       /* next frame */
+static uint8_t is31fl3236_committed[IS31FL3236_CH_NUM_MAX];    /* frame on the chip */
+static bool is31fl3236_committed_valid;
+
 
 typedef struct {
  //   i2c_bus_handle_t bus;
@@ -142,20 +149,79 @@ esp_err_t is31fl3236_init()
     return res;
 }
 
+void is31fl3236_frame_set(uint8_t ch, uint8_t pwm)
+{
+    if (ch < IS31FL3236_CH_NUM_MAX) {
+        is31fl3236_shadow[ch] = pwm;
+    }
+}
+
+static bool is31fl3236_ch_changed(int ch)
+{
+    return !is31fl3236_committed_valid || is31fl3236_shadow[ch] != is31fl3236_committed[ch];
+}
+
+esp_err_t is31fl3236_frame_commit()
+{
+    int res = 0;
+    int ch = 0, start, end, gap, num_burst = 0;
+
+    xSemaphoreTake(is31fl3236_led_mux, portMAX_DELAY);
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    while (ch < IS31FL3236_CH_NUM_MAX) {
+        if (!is31fl3236_ch_changed(ch)) {
+            ch++;
+            continue;
+        }
+        start = ch;
+        end = ch + 1;
+        while (end < IS31FL3236_CH_NUM_MAX) {
+            if (is31fl3236_ch_changed(end)) {
+                end++;
+                continue;
+            }
+            for (gap = 0; (end + gap < IS31FL3236_CH_NUM_MAX) && !is31fl3236_ch_changed(end + gap); gap++);
+            if ((gap > IS31FL3236_BURST_MAX_GAP) || (end + gap == IS31FL3236_CH_NUM_MAX)) {
+                break;
+            }
+            end += gap;
+        }
+        res |= i2c_master_start(cmd);
+        res |= i2c_master_write_byte(cmd, IS31FL3236_ADDRESS, 1 /*ACK_CHECK_EN*/);
+        res |= i2c_master_write_byte(cmd, IS31FL3236_PWM_REG_BASE + start, 1 /*ACK_CHECK_EN*/);
+        res |= i2c_master_write(cmd, &is31fl3236_shadow[start], end - start, 1 /*ACK_CHECK_EN*/);
+        num_burst++;
+        ch = end;
+    }
+    if (num_burst == 0) {
+        i2c_cmd_link_delete(cmd);
+        xSemaphoreGive(is31fl3236_led_mux);
+        return ESP_OK;
+    }
+    res |= i2c_master_start(cmd);
+    res |= i2c_master_write_byte(cmd, IS31FL3236_ADDRESS, 1 /*ACK_CHECK_EN*/);
+    res |= i2c_master_write_byte(cmd, IS31FL3236_PWM_REG_UPDATE, 1 /*ACK_CHECK_EN*/);
+    res |= i2c_master_write_byte(cmd, 0x00, 1 /*ACK_CHECK_EN*/);
+    res |= i2c_master_stop(cmd);
+    res |= i2c_master_cmd_begin(0, cmd, 1000 / portTICK_RATE_MS);
+    i2c_cmd_link_delete(cmd);
+    if (res == 0) {
+        memcpy(is31fl3236_committed, is31fl3236_shadow, sizeof(is31fl3236_committed));
+        is31fl3236_committed_valid = true;
+    }
+    xSemaphoreGive(is31fl3236_led_mux);
+    LED_ASSERT(res, "is31fl3236_frame_commit error", -1);
+    return res;
+}
+
 void va_led_set_pwm(const uint32_t * va_led_v)
 {
     int i;
-    uint8_t red_led_val, blue_led_val, green_led_val;
     for (i = 0; i < 12; i++) {
-        blue_led_val  = 0xFF & (va_led_v[i]);
-        green_led_val = 0xFF & (va_led_v[i] >> 8);
-        red_led_val   = 0xFF & (va_led_v[i] >> 16);
-        is31fl3236_write_reg(IS31FL3236_ADDRESS, ((i * 3) + 0x01), red_led_val);
-        //is31fl3236_write_reg(IS31FL3236_ADDRESS, 0x25, 0x00);
-        is31fl3236_write_reg(IS31FL3236_ADDRESS, ((i * 3) + 0x02), green_led_val);
-        //is31fl3236_write_reg(IS31FL3236_ADDRESS, 0x25, 0x00);
-        is31fl3236_write_reg(IS31FL3236_ADDRESS, ((i * 3) + 0x03), blue_led_val);    
+        is31fl3236_frame_set((i * 3), 0xFF & (va_led_v[i] >> 16));      /* red */
+        is31fl3236_frame_set((i * 3) + 1, 0xFF & (va_led_v[i] >> 8));   /* green */
+        is31fl3236_frame_set((i * 3) + 2, 0xFF & (va_led_v[i]));        /* blue */
     }
-    is31fl3236_write_reg(IS31FL3236_ADDRESS, 0x25, 0x00);
+    is31fl3236_frame_commit();
 }
 
@@ -32,6 +32,9 @@
 #define IS31FL3236_REG_STATE       0x08   //store the state of OUT9~OUT16 as the input port(read only)
 #define IS31FL3236_REG_ADC_RATE    0x09   //set the ADC sample rate of the input signal
 
+#define IS31FL3236_PWM_REG_BASE    0x01   //PWM registers of OUT1~OUT36, auto-increment
+#define IS31FL3236_PWM_REG_UPDATE  0x25   //load the PWM registers
+
 typedef enum {
     IS31FL3236_PWR_NORMAL = 0,   //normal operation
     IS31FL3236_PWR_SHUTDOWN,     //software shutdown
@@ -168,4 +171,22 @@ typedef struct {
     is31fl3216_channel_op_t channel_op;
 } is31fl3216_config_t;
 
+esp_err_t is31fl3236_init();
+
+/**
+ * @brief Set the PWM of a channel in the next frame
+ *
+ * Only the shadow register file is updated, see is31fl3236_frame_commit().
+ */
+void is31fl3236_frame_set(uint8_t ch, uint8_t pwm);
+
+/**
+ * @brief Send the next frame to the chip
+ *
+ * The shadow register file is diffed against the last committed frame and
+ * the changed channel ranges are written as auto-increment bursts, followed
+ * by the update register, in a single I2C transaction.
+ */
+esp_err_t is31fl3236_frame_commit();
+
 #endif /* _IS31FL3236_H_ */
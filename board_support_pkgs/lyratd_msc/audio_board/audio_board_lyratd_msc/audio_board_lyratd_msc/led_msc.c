@@ -3,208 +3,200 @@
 
 #include "led_msc.h"
 #include "va_led.h"
+/*
+ * Patterns are keyframes. The IS31FL3216 has no fades of its own, so va_led
+ * renders them frame by frame.
+ */
 
-const va_led_specs_t led_msc_ww_active[] = {
-    {100, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}, 0},
-};
-
-const va_led_specs_t led_msc_ww_ongoing[] = {
-    {100, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}, 0},
-};
-
-const va_led_specs_t led_msc_speaking[] = {
-    {30, {0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F}, 1},
-    {30, {0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F}, 1},
-    {30, {0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00001F}, 1},
-    {30, {0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F}, 1},
-    {30, {0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F}, 1},
-    {30, {0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F}, 1},
-    {30, {0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F}, 1},
-    {30, {0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F}, 1},
-    {30, {0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F}, 1},
-    {30, {0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F}, 1},
-    {30, {0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF}, 1},
-    {30, {0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF}, 1},
-    {30, {0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF}, 1},
-    {30, {0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF}, 1},
-    {30, {0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF}, 1},
-    {30, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}, 1},
-    {30, {0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF,0x0000EF}, 1},
-    {30, {0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF}, 1},
-    {30, {0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF,0x0000CF}, 1},
-    {30, {0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF}, 1},
-    {30, {0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF,0x0000AF}, 1},
-    {30, {0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F}, 1},
-    {30, {0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F,0x00008F}, 1},
-    {30, {0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F}, 1},
-    {30, {0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F,0x00006F}, 1},
-    {30, {0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F}, 1},
-    {30, {0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F,0x00004F}, 1},
-    {30, {0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F}, 1},
-    {30, {0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00002F,0x00001F}, 1},
-    {30, {0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F}, 1},
-};
-
-const va_led_specs_t led_msc_mic_off_end[] = {
-    {11, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+static const va_led_keyframe_t led_msc_ww_active_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}},
 };
 
-const va_led_specs_t led_msc_mic_off_on[] = {
-    {66, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_ww_active = {led_msc_ww_active_kf, sizeof(led_msc_ww_active_kf) / sizeof(led_msc_ww_active_kf[0]), 100, 0, false};
+
+static const va_led_keyframe_t led_msc_ww_ongoing_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}},
 };
 
-const va_led_specs_t led_msc_mic_off_start[] = {
-    {33, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_ww_ongoing = {led_msc_ww_ongoing_kf, sizeof(led_msc_ww_ongoing_kf) / sizeof(led_msc_ww_ongoing_kf[0]), 100, 0, false};
+
+static const va_led_keyframe_t led_msc_speaking_kf[] = {
+    {0, VA_LED_EASE_LINEAR, {0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F}},
+    {450, VA_LED_EASE_LINEAR, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}},
+    {870, VA_LED_EASE_STEP, {0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F}},
 };
 
-const va_led_specs_t led_msc_ww_deactive[] = {
-    {33, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_speaking = {led_msc_speaking_kf, sizeof(led_msc_speaking_kf) / sizeof(led_msc_speaking_kf[0]), 900, 0, true};
+
+static const va_led_keyframe_t led_msc_mic_off_end_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_error[] = {
-    {66, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 1},
+const va_led_anim_t led_msc_mic_off_end = {led_msc_mic_off_end_kf, sizeof(led_msc_mic_off_end_kf) / sizeof(led_msc_mic_off_end_kf[0]), 11, 0, false};
+
+static const va_led_keyframe_t led_msc_mic_off_on_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_btconnect[] = {
-    {75, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_mic_off_on = {led_msc_mic_off_on_kf, sizeof(led_msc_mic_off_on_kf) / sizeof(led_msc_mic_off_on_kf[0]), 66, 0, false};
+
+static const va_led_keyframe_t led_msc_mic_off_start_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_btdisconnect[] = {
-    {75, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_mic_off_start = {led_msc_mic_off_start_kf, sizeof(led_msc_mic_off_start_kf) / sizeof(led_msc_mic_off_start_kf[0]), 33, 0, false};
+
+static const va_led_keyframe_t led_msc_ww_deactive_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_ntf_queued[] = {
-    {60, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 1},
+const va_led_anim_t led_msc_ww_deactive = {led_msc_ww_deactive_kf, sizeof(led_msc_ww_deactive_kf) / sizeof(led_msc_ww_deactive_kf[0]), 33, 0, false};
+
+static const va_led_keyframe_t led_msc_error_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_ntf_incoming[] = {
-    {50, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_error = {led_msc_error_kf, sizeof(led_msc_error_kf) / sizeof(led_msc_error_kf[0]), 66, 0, true};
+
+static const va_led_keyframe_t led_msc_btconnect_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_thinking[] = {
-    {10, {0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000}, 0},
-    {10, {0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000}, 0},
-    {10, {0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000}, 0},
-    {10, {0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000}, 0},
-    {10, {0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF}, 0},
-    {10, {0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF}, 0},
-    {10, {0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF}, 0},
-    {10, {0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F}, 0},
-    {10, {0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F}, 0},
-    {10, {0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F}, 0},
-    {10, {0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F}, 0},
-    {10, {0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F}, 0},
+const va_led_anim_t led_msc_btconnect = {led_msc_btconnect_kf, sizeof(led_msc_btconnect_kf) / sizeof(led_msc_btconnect_kf[0]), 75, 0, false};
+
+static const va_led_keyframe_t led_msc_btdisconnect_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_alrt_short[] = {
-    {100, {0x0000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 1},
+const va_led_anim_t led_msc_btdisconnect = {led_msc_btdisconnect_kf, sizeof(led_msc_btdisconnect_kf) / sizeof(led_msc_btdisconnect_kf[0]), 75, 0, false};
 
+static const va_led_keyframe_t led_msc_ntf_queued_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_alrt[] = {
-    {50, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 1},
+const va_led_anim_t led_msc_ntf_queued = {led_msc_ntf_queued_kf, sizeof(led_msc_ntf_queued_kf) / sizeof(led_msc_ntf_queued_kf[0]), 60, 0, true};
+
+static const va_led_keyframe_t led_msc_ntf_incoming_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_bootup_1[] = {
-    {70, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
-    {70, {0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F,0x00000F}, 0},
-    {70, {0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F}, 0},
-    {70, {0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F,0x00003F}, 0},
-    {70, {0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F,0x00005F}, 0},
-    {70, {0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F,0x00007F}, 0},
-    {70, {0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F,0x00009F}, 0},
-    {70, {0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF,0x0000BF}, 0},
-    {70, {0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF}, 0},  
+const va_led_anim_t led_msc_ntf_incoming = {led_msc_ntf_incoming_kf, sizeof(led_msc_ntf_incoming_kf) / sizeof(led_msc_ntf_incoming_kf[0]), 50, 0, false};
+
+static const va_led_keyframe_t led_msc_thinking_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000}},
+    {10, VA_LED_EASE_STEP, {0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000}},
+    {20, VA_LED_EASE_STEP, {0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000}},
+    {30, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000}},
+    {40, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF}},
+    {50, VA_LED_EASE_STEP, {0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF}},
+    {60, VA_LED_EASE_STEP, {0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF}},
+    {70, VA_LED_EASE_STEP, {0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F,0x00009F}},
+    {80, VA_LED_EASE_STEP, {0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F,0x00007F}},
+    {90, VA_LED_EASE_STEP, {0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F,0x00005F}},
+    {100, VA_LED_EASE_STEP, {0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F,0x00003F}},
+    {110, VA_LED_EASE_STEP, {0x00003F,0x00005F,0x00007F,0x00009F,0x0000BF,0x0000DF,0x0000FF,0x000000,0x000000,0x000000,0x000000,0x00001F}},
 };
 
-const va_led_specs_t led_msc_bootup_2[] = {
-    {100, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 1},
-    {100, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}, 1},
+/* A step every 10ms, faster than the default frame rate */
+const va_led_anim_t led_msc_thinking = {led_msc_thinking_kf, sizeof(led_msc_thinking_kf) / sizeof(led_msc_thinking_kf[0]), 120, 10, false};
+
+static const va_led_keyframe_t led_msc_alrt_short_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_speaker_mute[] = {
-    {22, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_alrt_short = {led_msc_alrt_short_kf, sizeof(led_msc_alrt_short_kf) / sizeof(led_msc_alrt_short_kf[0]), 100, 0, true};
+
+static const va_led_keyframe_t led_msc_alrt_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_speaker_vol[] = {
-    {11, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_alrt = {led_msc_alrt_kf, sizeof(led_msc_alrt_kf) / sizeof(led_msc_alrt_kf[0]), 50, 0, true};
+
+static const va_led_keyframe_t led_msc_bootup_1_kf[] = {
+    {0, VA_LED_EASE_LINEAR, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
+    {140, VA_LED_EASE_LINEAR, {0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F,0x00001F}},
+    {560, VA_LED_EASE_STEP, {0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF,0x0000DF}},
+};
+
+const va_led_anim_t led_msc_bootup_1 = {led_msc_bootup_1_kf, sizeof(led_msc_bootup_1_kf) / sizeof(led_msc_bootup_1_kf[0]), 630, 0, false};
+
+static const va_led_keyframe_t led_msc_bootup_2_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
+    {100, VA_LED_EASE_STEP, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}},
 };
 
-const va_led_specs_t led_msc_off[] = {
-    {10, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
+const va_led_anim_t led_msc_bootup_2 = {led_msc_bootup_2_kf, sizeof(led_msc_bootup_2_kf) / sizeof(led_msc_bootup_2_kf[0]), 200, 0, true};
+
+static const va_led_keyframe_t led_msc_speaker_mute_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
 };
 
-const va_led_specs_t led_msc_factory_rst[] = {
-    {233, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 1},
-    {233, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}, 1},
+const va_led_anim_t led_msc_speaker_mute = {led_msc_speaker_mute_kf, sizeof(led_msc_speaker_mute_kf) / sizeof(led_msc_speaker_mute_kf[0]), 22, 0, false};
+
+static const va_led_keyframe_t led_msc_off_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
+};
+
+const va_led_anim_t led_msc_off = {led_msc_off_kf, sizeof(led_msc_off_kf) / sizeof(led_msc_off_kf[0]), 10, 0, false};
+
+static const va_led_keyframe_t led_msc_factory_rst_kf[] = {
+    {0, VA_LED_EASE_STEP, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}},
+    {233, VA_LED_EASE_STEP, {0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF,0x0000FF}},
+};
+
+const va_led_anim_t led_msc_factory_rst = {led_msc_factory_rst_kf, sizeof(led_msc_factory_rst_kf) / sizeof(led_msc_factory_rst_kf[0]), 466, 0, true};
+
+/* Indexed by volume level, so kept as frames */
+const va_led_specs_t led_msc_speaker_vol[] = {
+    {11, {0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000,0x000000}, 0},
 };
 
 va_led_config_t led_msc_pattern_conf[VA_LED_PATTERN_MAX];
 
 void led_msc_pattern_init(va_led_config_t **va_led_msc_pat)
 {
-    led_msc_pattern_conf[VA_LED_BOOTUP_1].va_led_state_sz = sizeof(led_msc_bootup_1) / sizeof(led_msc_bootup_1[0]);
-    led_msc_pattern_conf[VA_LED_BOOTUP_1].va_led_state_st = (va_led_specs_t *)led_msc_bootup_1;
+    led_msc_pattern_conf[VA_LED_BOOTUP_1].va_led_anim = &led_msc_bootup_1;
 
-    led_msc_pattern_conf[VA_LED_BOOTUP_2].va_led_state_sz = sizeof(led_msc_bootup_2) / sizeof(led_msc_bootup_2[0]);
-    led_msc_pattern_conf[VA_LED_BOOTUP_2].va_led_state_st = (va_led_specs_t *)led_msc_bootup_2;
+    led_msc_pattern_conf[VA_LED_BOOTUP_2].va_led_anim = &led_msc_bootup_2;
 
-    led_msc_pattern_conf[VA_LED_WW_ACTIVE].va_led_state_sz = sizeof(led_msc_ww_active) / sizeof(led_msc_ww_active[0]);
-    led_msc_pattern_conf[VA_LED_WW_ACTIVE].va_led_state_st = (va_led_specs_t *)led_msc_ww_active;
+    led_msc_pattern_conf[VA_LED_WW_ACTIVE].va_led_anim = &led_msc_ww_active;
 
-    led_msc_pattern_conf[VA_LED_WW_ONGOING].va_led_state_sz = sizeof(led_msc_ww_ongoing) / sizeof(led_msc_ww_ongoing[0]);
-    led_msc_pattern_conf[VA_LED_WW_ONGOING].va_led_state_st = (va_led_specs_t *)led_msc_ww_ongoing;
+    led_msc_pattern_conf[VA_LED_WW_ONGOING].va_led_anim = &led_msc_ww_ongoing;
 
-    led_msc_pattern_conf[VA_LED_WW_DEACTIVATE].va_led_state_sz = sizeof(led_msc_ww_deactive) / sizeof(led_msc_ww_deactive[0]);
-    led_msc_pattern_conf[VA_LED_WW_DEACTIVATE].va_led_state_st = (va_led_specs_t *)led_msc_ww_deactive;
+    led_msc_pattern_conf[VA_LED_WW_DEACTIVATE].va_led_anim = &led_msc_ww_deactive;
 
     led_msc_pattern_conf[VA_LED_SPEAKER_VOL].va_led_state_sz = sizeof(led_msc_speaker_vol) / sizeof(led_msc_speaker_vol[0]);
     led_msc_pattern_conf[VA_LED_SPEAKER_VOL].va_led_state_st = (va_led_specs_t *)led_msc_speaker_vol;
 
-    led_msc_pattern_conf[VA_LED_SPEAKER_MUTE].va_led_state_sz = sizeof(led_msc_speaker_mute) / sizeof(led_msc_speaker_mute[0]);
-    led_msc_pattern_conf[VA_LED_SPEAKER_MUTE].va_led_state_st = (va_led_specs_t *)led_msc_speaker_mute;
+    led_msc_pattern_conf[VA_LED_SPEAKER_MUTE].va_led_anim = &led_msc_speaker_mute;
 
-    led_msc_pattern_conf[VA_LED_SPEAKING].va_led_state_sz = sizeof(led_msc_speaking) / sizeof(led_msc_speaking[0]);
-    led_msc_pattern_conf[VA_LED_SPEAKING].va_led_state_st = (va_led_specs_t *)led_msc_speaking;
+    led_msc_pattern_conf[VA_LED_SPEAKING].va_led_anim = &led_msc_speaking;
 
-    led_msc_pattern_conf[VA_LED_MIC_OFF_END].va_led_state_sz = sizeof(led_msc_mic_off_end) / sizeof(led_msc_mic_off_end[0]);
-    led_msc_pattern_conf[VA_LED_MIC_OFF_END].va_led_state_st = (va_led_specs_t *)led_msc_mic_off_end;
+    led_msc_pattern_conf[VA_LED_MIC_OFF_END].va_led_anim = &led_msc_mic_off_end;
 
-    led_msc_pattern_conf[VA_LED_MIC_OFF_ON].va_led_state_sz = sizeof(led_msc_mic_off_on) / sizeof(led_msc_mic_off_on[0]);
-    led_msc_pattern_conf[VA_LED_MIC_OFF_ON].va_led_state_st = (va_led_specs_t *)led_msc_mic_off_on;
+    led_msc_pattern_conf[VA_LED_MIC_OFF_ON].va_led_anim = &led_msc_mic_off_on;
 
-    led_msc_pattern_conf[VA_LED_MIC_OFF_START].va_led_state_sz = sizeof(led_msc_mic_off_start) / sizeof(led_msc_mic_off_start[0]);
-    led_msc_pattern_conf[VA_LED_MIC_OFF_START].va_led_state_st = (va_led_specs_t *)led_msc_mic_off_start;
+    led_msc_pattern_conf[VA_LED_MIC_OFF_START].va_led_anim = &led_msc_mic_off_start;
 
-    led_msc_pattern_conf[VA_LED_ERROR].va_led_state_sz = sizeof(led_msc_error) / sizeof(led_msc_error[0]);
-    led_msc_pattern_conf[VA_LED_ERROR].va_led_state_st = (va_led_specs_t *)led_msc_error;
+    led_msc_pattern_conf[VA_LED_ERROR].va_led_anim = &led_msc_error;
 
-    led_msc_pattern_conf[VA_LED_BTCONNECT].va_led_state_sz = sizeof(led_msc_btconnect) / sizeof(led_msc_btconnect[0]);
-    led_msc_pattern_conf[VA_LED_BTCONNECT].va_led_state_st = (va_led_specs_t *)led_msc_btconnect;
+    led_msc_pattern_conf[VA_LED_BTCONNECT].va_led_anim = &led_msc_btconnect;
 
-    led_msc_pattern_conf[VA_LED_BTDISCONNECT].va_led_state_sz = sizeof(led_msc_btdisconnect) / sizeof(led_msc_btdisconnect[0]);
-    led_msc_pattern_conf[VA_LED_BTDISCONNECT].va_led_state_st = (va_led_specs_t *)led_msc_btdisconnect;
+    led_msc_pattern_conf[VA_LED_BTDISCONNECT].va_led_anim = &led_msc_btdisconnect;
 
-    led_msc_pattern_conf[VA_LED_NTF_QUEUED].va_led_state_sz = sizeof(led_msc_ntf_queued) / sizeof(led_msc_ntf_queued[0]);
-    led_msc_pattern_conf[VA_LED_NTF_QUEUED].va_led_state_st = (va_led_specs_t *)led_msc_ntf_queued;
+    led_msc_pattern_conf[VA_LED_NTF_QUEUED].va_led_anim = &led_msc_ntf_queued;
 
-    led_msc_pattern_conf[VA_LED_NTF_INCOMING].va_led_state_sz = sizeof(led_msc_ntf_incoming) / sizeof(led_msc_ntf_incoming[0]);
-    led_msc_pattern_conf[VA_LED_NTF_INCOMING].va_led_state_st = (va_led_specs_t *)led_msc_ntf_incoming;
+    led_msc_pattern_conf[VA_LED_NTF_INCOMING].va_led_anim = &led_msc_ntf_incoming;
 
-    led_msc_pattern_conf[VA_LED_THINKING].va_led_state_sz = sizeof(led_msc_thinking) / sizeof(led_msc_thinking[0]);
-    led_msc_pattern_conf[VA_LED_THINKING].va_led_state_st = (va_led_specs_t *)led_msc_thinking;
+    led_msc_pattern_conf[VA_LED_THINKING].va_led_anim = &led_msc_thinking;
 
-    led_msc_pattern_conf[VA_LED_ALERT_SHORT].va_led_state_sz = sizeof(led_msc_alrt_short) / sizeof(led_msc_alrt_short[0]);
-    led_msc_pattern_conf[VA_LED_ALERT_SHORT].va_led_state_st = (va_led_specs_t *)led_msc_alrt_short;
+    led_msc_pattern_conf[VA_LED_ALERT_SHORT].va_led_anim = &led_msc_alrt_short;
 
-    led_msc_pattern_conf[VA_LED_ALERT].va_led_state_sz = sizeof(led_msc_alrt) / sizeof(led_msc_alrt[0]);
-    led_msc_pattern_conf[VA_LED_ALERT].va_led_state_st = (va_led_specs_t *)led_msc_alrt;
+    led_msc_pattern_conf[VA_LED_ALERT].va_led_anim = &led_msc_alrt;
 
-    led_msc_pattern_conf[VA_LED_FACTORY_RESET].va_led_state_sz = sizeof(led_msc_factory_rst) / sizeof(led_msc_factory_rst[0]);
-    led_msc_pattern_conf[VA_LED_FACTORY_RESET].va_led_state_st = (va_led_specs_t *)led_msc_factory_rst;
+    led_msc_pattern_conf[VA_LED_FACTORY_RESET].va_led_anim = &led_msc_factory_rst;
 
-    led_msc_pattern_conf[VA_LED_OFF].va_led_state_sz = sizeof(led_msc_off) / sizeof(led_msc_off[0]);
-    led_msc_pattern_conf[VA_LED_OFF].va_led_state_st = (va_led_specs_t *)led_msc_off;
+    led_msc_pattern_conf[VA_LED_OFF].va_led_anim = &led_msc_off;
 
     (*va_led_msc_pat) = led_msc_pattern_conf;
 }
@@ -17,6 +17,7 @@
 #include <resampling.h>
 #include <va_dsp.h>
 #include <lyrat_init.h>
+#include <va_latency.h>
 
 #define WWE_TASK_STACK (8 * 1024)
 #define RB_TASK_STACK (8 * 1024)
@@ -59,6 +60,7 @@ static void ww_detection_task(void *arg)
             lyrat_stream_audio((uint8_t *)buffer, (audio_chunksize * sizeof(int16_t)), portMAX_DELAY);
             int r = esp_wwe_detect(buffer);
             if (r && dd.detect_wakeword) {
+                va_latency_mark(VA_LATENCY_WAKE);
                 int new_ms = (chunks*audio_chunksize*1000)/frequency;
                 printf("%.2f: Neural network detection triggered output %d.\n", (float)new_ms/1000.0, r);
                 int x = (new_ms - priv_ms);
@@ -83,6 +83,13 @@
 #define TWOLF_MBCMDREG_SPINWAIT  10000
 #define TWOLF_MAILBOX_SPINWAIT  1000
 
+/*Define this macro to 0 to fall back to the word by word HBI boot loader*/
+#ifndef TWOLF_HBI_BURST_BOOT
+#define TWOLF_HBI_BURST_BOOT 1
+#endif
+#define TWOLF_BURST_MAX_WORDS   126   /*same limit as VprocTwolfHbiWrite()*/
+#define TWOLF_PAGE255_BYTES     256
+
 /*--------------------------------------------------------------------*/
 /* VprocTwolfMailboxAcquire(): use this function to
 *   check for the availability of the mailbox
@@ -340,6 +347,63 @@ TwolfHbiPage255Write(
     return VPROC_STATUS_SUCCESS;
 } /* TwolfHbiPagedWrite() */
 
+/* TwolfHbiBurstQueue()- build the HBI command for a block of words and queue
+ * the command and the data as a single SPI transaction.
+ * The transfer completes asynchronously, see VprocHALBurstFlush()
+ *  \param[in]
+ *                .addr      the 16-bit HBI address
+ *                .numwords  the number of words to write (1-126)
+ *                .pData     the words to write
+ *
+ *  return ::status
+ */
+static VprocStatusType TwolfHbiBurstQueue(uint16 addr, uint8 numwords, const uint16* pData)
+{
+    uint16 frame[TWOLF_BURST_MAX_WORDS + 1];
+    uint16 cmd;
+    uint8 page = addr >> 8;
+    uint8 offset = (addr & 0xFF) / 2;
+
+    if ((numwords == 0) || (numwords > TWOLF_BURST_MAX_WORDS)) {
+        return VPROC_STATUS_INVALID_ARG;
+    }
+    if (page == 0) { /*Direct page access*/
+        frame[0] = HBI_DIRECT_WRITE(offset, numwords - 1);
+    } else {
+        /*indirect page access*/
+        if (page != 0xFF) {
+            page  -=  1;
+        }
+        cmd = HBI_SELECT_PAGE(page);
+        if (VprocHALBurstWrite(&cmd, 1) != 0) {
+            return VPROC_STATUS_ERR_HBI;
+        }
+        frame[0] = HBI_PAGED_WRITE(offset, numwords - 1);
+    }
+    memcpy(&frame[1], pData, numwords * sizeof(uint16));
+    if (VprocHALBurstWrite(frame, numwords + 1) != 0) {
+        return VPROC_STATUS_ERR_HBI;
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+
+/* TwolfHbiBurstRead()- read back a block of words within a single SPI
+ * transaction once all the queued writes are on the device
+ */
+static VprocStatusType TwolfHbiBurstRead(uint16 addr, uint8 numwords, uint16* pData)
+{
+    if (VprocHALBurstFlush() != 0) {
+        return VPROC_STATUS_ERR_HBI;
+    }
+    if (spis_tw_hbi_rd16_cmd(addr, numwords) != 0) {
+        return VPROC_STATUS_RD_FAILED;
+    }
+    if (VprocHALBurstRead(pData, numwords) != 0) {
+        return VPROC_STATUS_RD_FAILED;
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+
 /*------------------------------------------------------
  * Higher level functions - Can be called by a host application
  *------------------------------------------------------*/
@@ -456,6 +520,29 @@ VprocStatusType VprocTwolfLoadConfig(dataArr* pCr2Buf, unsigned short numElement
     unsigned short i, buf;
     /*stop the current firmware but do not reset the device and do not go to boot mode*/
 
+#if TWOLF_HBI_BURST_BOOT
+    /*send runs of consecutive registers of the same page in one transaction*/
+    uint16 words[TWOLF_BURST_MAX_WORDS];
+    uint8 numwords;
+    i = 0;
+    while (i < numElements) {
+        uint16 reg = pCr2Buf[i].reg;
+        numwords = 0;
+        do {
+            words[numwords++] = pCr2Buf[i++].value;
+        } while ((i < numElements) && (numwords < TWOLF_BURST_MAX_WORDS) &&
+                 (pCr2Buf[i].reg == reg + 2 * numwords) &&
+                 ((pCr2Buf[i].reg >> 8) == (reg >> 8)));
+        status = TwolfHbiBurstQueue(reg, numwords, words);
+        if (status != VPROC_STATUS_SUCCESS) {
+            return VPROC_STATUS_ERR_HBI;
+        }
+    }
+    if (VprocHALBurstFlush() != 0) {
+        return VPROC_STATUS_ERR_HBI;
+    }
+    (void)buf;
+#else
     /*send the config to the device RAM*/
     for (i = 0; i < numElements; i++) {
         buf = pCr2Buf[i].value;
@@ -465,10 +552,12 @@ VprocStatusType VprocTwolfLoadConfig(dataArr* pCr2Buf, unsigned short numElement
         }
 
     }
+#endif
 
     return status;
 }
 
+#if !TWOLF_HBI_BURST_BOOT
 /* HbiSrecBoot_alt() Use this alternate method to load the st_twFirmware.c
  *(converted *.s3 to c code) to the device
  */
@@ -538,6 +627,177 @@ static VprocStatusType HbiSrecBoot_alt(twFirmware* st_firmware)
     DEBUG_LOGI(TAG_SPI, "DONE\n");
     return VPROC_STATUS_SUCCESS;
 }
+#endif /* !TWOLF_HBI_BURST_BOOT */
+
+#if TWOLF_HBI_BURST_BOOT
+/* TwolfFwrNextBurst() - gather the firmware blocks starting at *pIndex that
+ * continue each other within the same page 255 window into one burst.
+ * A block that moves the page 255 base always starts a new burst, so the
+ * device sees exactly the same base/offset sequence as HbiSrecBoot_alt().
+ * A block longer than what is left of the burst is split, *pWord is where
+ * the next burst resumes within block *pIndex.
+ *
+ * Return: ::VPROC_STATUS_SUCCESS with the number of words gathered in pBurst
+ * in *pNumwords (0 at the end of the image), ::VPROC_STATUS_ERR_IMAGE if a
+ * block does not fit in its page 255 window
+ */
+static VprocStatusType TwolfFwrNextBurst(twFirmware* st_firmware, uint16* pIndex, uint16* pWord,
+                                         uint16* pBurst, uint8* pNumwords, uint8* pUseBase, uint32* pAddr)
+{
+    twFwr* blk;
+    uint16 index = *pIndex;
+    uint16 word = *pWord;
+    uint16 take;
+    uint8 numwords = 0;
+    uint32 offset;
+
+    /*skip empty blocks, the base still has to follow them*/
+    while ((index < st_firmware->twFirmwareStreamLen) &&
+           (st_firmware->st_Fwr[index].numWords == 0)) {
+        index++;
+    }
+    *pNumwords = 0;
+    if (index >= st_firmware->twFirmwareStreamLen) {
+        *pIndex = index;
+        return VPROC_STATUS_SUCCESS;
+    }
+    blk = &st_firmware->st_Fwr[index];
+    /*the rest of a split block goes through the base already set for it*/
+    *pUseBase = (word == 0) && blk->useTargetAddr;
+    *pAddr = blk->targetAddr + word * 2;
+    offset = *pAddr & 0xFF;
+
+    while (index < st_firmware->twFirmwareStreamLen) {
+        blk = &st_firmware->st_Fwr[index];
+        if (word == 0) {
+            if ((numwords != 0) &&
+                (blk->useTargetAddr || ((blk->targetAddr & 0xFF) != offset))) {
+                break;
+            }
+            if ((blk->targetAddr & 0xFF) + blk->numWords * 2 > TWOLF_PAGE255_BYTES) {
+                DEBUG_LOGE(TAG_SPI, "Block %d at 0x%08x, numWords = %d crosses the page 255 window\n",
+                           index, blk->targetAddr, blk->numWords);
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+        }
+        take = blk->numWords - word;
+        if (take > TWOLF_BURST_MAX_WORDS - numwords) {
+            take = TWOLF_BURST_MAX_WORDS - numwords;
+        }
+        if (take == 0) {
+            break;
+        }
+        memcpy(&pBurst[numwords], &blk->buf[word], take * sizeof(uint16));
+        numwords += take;
+        offset += take * 2;
+        word += take;
+        if (word < blk->numWords) {
+            break;
+        }
+        word = 0;
+        index++;
+    }
+    *pIndex = index;
+    *pWord = word;
+    *pNumwords = numwords;
+    return VPROC_STATUS_SUCCESS;
+}
+
+static uint16 TwolfChecksum(const uint16* pData, uint8 numwords)
+{
+    uint16 sum = 0;
+    while (numwords--) {
+        sum += *pData++;
+    }
+    return sum;
+}
+
+/* Write (verify == 0) or read back and check (verify == 1) the firmware image
+ * through the page 255 window, one burst at a time
+ */
+static VprocStatusType TwolfFwrBurstPass(twFirmware* st_firmware, uint8 verify)
+{
+    VprocStatusType status = VPROC_STATUS_SUCCESS;
+    uint16 burst[TWOLF_BURST_MAX_WORDS];
+    uint16 readBack[TWOLF_BURST_MAX_WORDS];
+    uint16 gTargetAddr[2] = {0, 0};
+    uint16 index = 0, word = 0;
+    uint8 numwords, useBase = 0;
+    uint32 addr = 0;
+    uint16 cmdWrd;
+
+    while (1) {
+        status = TwolfFwrNextBurst(st_firmware, &index, &word, burst, &numwords, &useBase, &addr);
+        if (status != VPROC_STATUS_SUCCESS) {
+            return status;
+        }
+        if (numwords == 0) {
+            break;
+        }
+        if (useBase) {
+            gTargetAddr[0] = (uint16)((addr & 0xFFFF0000) >> 16);
+            gTargetAddr[1] = (uint16)(addr & 0x0000FFFF);
+            status = TwolfHbiBurstQueue(PAGE_255_BASE_HI_REG, 2, gTargetAddr);
+            if (status != VPROC_STATUS_SUCCESS) {
+                DEBUG_LOGE(TAG_SPI, "Unable to set gTargetAddr = 0x%08x\n", addr);
+                return VPROC_STATUS_ERR_HBI;
+            }
+        }
+        cmdWrd = (uint16)(0xFF << 8) | (uint16)(addr & 0xFF);
+        if (!verify) {
+            status = TwolfHbiBurstQueue(cmdWrd, numwords, burst);
+        } else {
+            status = TwolfHbiBurstRead(cmdWrd, numwords, readBack);
+            if ((status == VPROC_STATUS_SUCCESS) &&
+                (TwolfChecksum(burst, numwords) != TwolfChecksum(readBack, numwords))) {
+                DEBUG_LOGE(TAG_SPI, "Checksum mismatch at 0x%08x, numWords = %d\n", addr, numwords);
+                return VPROC_STATUS_ERR_VERIFY;
+            }
+        }
+        if (status != VPROC_STATUS_SUCCESS) {
+            DEBUG_LOGE(TAG_SPI, "status = %d, numWords = %d: \n", status, numwords);
+            return status;
+        }
+    }
+    if (VprocHALBurstFlush() != 0) {
+        return VPROC_STATUS_ERR_HBI;
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+
+/* HbiSrecBoot_burst() Same as HbiSrecBoot_alt() but the converted image is
+ * transferred in page 255 bursts queued to the SPI DMA, then read back and
+ * checked before the execution address is programmed
+ */
+static VprocStatusType HbiSrecBoot_burst(twFirmware* st_firmware)
+{
+    VprocStatusType status = VPROC_STATUS_SUCCESS;
+    uint16 gTargetAddr[2] = {0, 0};
+
+    status = TwolfFwrBurstPass(st_firmware, 0);
+    if (status != VPROC_STATUS_SUCCESS) {
+        return status;
+    }
+    status = TwolfFwrBurstPass(st_firmware, 1);
+    if (status != VPROC_STATUS_SUCCESS) {
+        return status;
+    }
+
+    /* program the program's execution start register */
+    gTargetAddr[0] = (uint16)((st_firmware->execAddr & 0xFFFF0000) >> 16);
+    gTargetAddr[1] = (uint16)(st_firmware->execAddr & 0x0000FFFF);
+    status = VprocTwolfHbiWrite(0x12C, 2, gTargetAddr);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, " unable to program page 1 execution address\n");
+        return status;
+    }
+
+    DEBUG_LOGI(TAG_SPI, "prgmBase 0x%08x\n", st_firmware->prgmBase);
+    DEBUG_LOGI(TAG_SPI, "execAddr 0x%08x\n", st_firmware->execAddr);
+    DEBUG_LOGI(TAG_SPI, "DONE\n");
+    return VPROC_STATUS_SUCCESS;
+}
+#endif /* TWOLF_HBI_BURST_BOOT */
 
 /*VprocTwolfHbiBoot_alt - use this function to bootload the firmware
  * into the device
@@ -574,7 +834,11 @@ VprocStatusType VprocTwolfHbiBoot_alt(twFirmware* st_firmware)
         return VPROC_STATUS_ERR_HBI;
     }
     /*Transfer the image*/
+#if TWOLF_HBI_BURST_BOOT
+    status =  HbiSrecBoot_burst(st_firmware);
+#else
     status =  HbiSrecBoot_alt(st_firmware);
+#endif
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -16,9 +16,23 @@
 #include "driver/gpio.h"
 #include "mbedtls/net.h"
 #include "lwip/def.h"
+#include "esp_heap_caps.h"
+
+#define VPROC_HAL_DMA_CHAN      1
+#define VPROC_HAL_QUEUE_SIZE    6
 
 static spi_device_handle_t g_spi = NULL;
 
+/* DMA capable slots backing the queued burst transactions. A slot is owned by
+ * the SPI driver from spi_device_queue_trans() until its result is collected.
+ */
+static struct {
+    spi_transaction_t trans[VPROC_HAL_QUEUE_SIZE];
+    unsigned short *buf[VPROC_HAL_QUEUE_SIZE];
+    int head;       /* next slot to queue */
+    int inflight;   /* slots queued but not yet collected */
+} g_burst;
+
 int VprocHALInit(void)
 {
     /*if the customer audio_board requires any init
@@ -32,20 +46,21 @@ int VprocHALInit(void)
         .mosi_io_num = GPIO_NUM_33,
         .sclk_io_num = GPIO_NUM_32,
         .quadwp_io_num = -1,
-        .quadhd_io_num = -1
+        .quadhd_io_num = -1,
+        .max_transfer_sz = VPROC_HAL_BURST_MAX_WORDS * sizeof(unsigned short)
     };
 
     spi_device_interface_config_t devcfg = {
         .clock_speed_hz = 1000000,              // Clock out at 10 MHz
         .mode = 0,                              // SPI mode 0
         .spics_io_num = GPIO_NUM_0,             // CS pin
-        .queue_size = 6,                        //queue 7 transactions at a time
+        .queue_size = VPROC_HAL_QUEUE_SIZE,     //queue 6 transactions at a time
     };
     //Initialize the SPI bus
     if (g_spi) {
         return ret;
     }
-    ret = spi_bus_initialize(HSPI_HOST, &buscfg, 0);
+    ret = spi_bus_initialize(HSPI_HOST, &buscfg, VPROC_HAL_DMA_CHAN);
     assert(ret == ESP_OK);
     ret = spi_bus_add_device(HSPI_HOST, &devcfg, &g_spi);
     assert(ret == ESP_OK);
@@ -66,10 +81,16 @@ void VprocHALcleanup(void)
     * Otherwise the implementation of this function is complete
     */
     int ret = 0;
+    VprocHALBurstFlush();
+    for (int i = 0; i < VPROC_HAL_QUEUE_SIZE; i++) {
+        heap_caps_free(g_burst.buf[i]);
+        g_burst.buf[i] = NULL;
+    }
     ret = spi_bus_remove_device(g_spi);
     assert(ret == ESP_OK);
     ret = spi_bus_free(HSPI_HOST);
     assert(ret == ESP_OK);
+    g_spi = NULL;
 }
 /*Note - These functions are audio_board SPECIFIC- They must be modified
  *       accordingly
@@ -110,6 +131,7 @@ int VprocHALWrite(unsigned short val)
     esp_err_t ret;
     spi_transaction_t t;
     unsigned short data = 0;
+    VprocHALBurstFlush();                  //Drain any queued burst first
     memset(&t, 0, sizeof(t));              //Zero out the transaction
     t.length = sizeof(unsigned short) * 8; //Len is in bytes, transaction length is in bits.
 #if BIGENDIAN
@@ -134,6 +156,7 @@ int VprocHALRead(unsigned short* pVal)
     spi_transaction_t t;
     unsigned short data = 0;
 
+    VprocHALBurstFlush();               //Drain any queued burst first
     memset(&t, 0, sizeof(t));           //Zero out the transaction
     t.length = sizeof(unsigned short) * 8;
     t.rxlength = sizeof(unsigned short) * 8; //len is in bytes, transaction length is in bits.
@@ -150,3 +173,110 @@ int VprocHALRead(unsigned short* pVal)
     return 0;
 }
 
+
+/* Collect the result of the oldest queued burst transaction */
+static int VprocHALBurstCollect(void)
+{
+    spi_transaction_t *t = NULL;
+    if (spi_device_get_trans_result(g_spi, &t, portMAX_DELAY) != ESP_OK) {
+        return -1;
+    }
+    g_burst.inflight--;
+    return 0;
+}
+
+/* This is the audio_board dependant low level spi function to write a block
+ * of 16-bit words to the ZL380xx device within a single chip select.
+ * The transfer is queued to the SPI driver and the function returns as soon
+ * as a DMA slot is available, so the caller can prepare the next block while
+ * the current one is on the wire. Call VprocHALBurstFlush() before any other
+ * VprocHALWrite()/VprocHALRead() access.
+ */
+int VprocHALBurstWrite(const unsigned short* pVal, unsigned short numwords)
+{
+    spi_transaction_t *t;
+    unsigned short *buf;
+    int i;
+
+    if ((pVal == NULL) || (numwords == 0) || (numwords > VPROC_HAL_BURST_MAX_WORDS)) {
+        return -1;
+    }
+    if (g_burst.inflight == VPROC_HAL_QUEUE_SIZE) {
+        if (VprocHALBurstCollect() != 0) {
+            return -1;
+        }
+    }
+    /* Slots complete in order, so the one at head is free by now */
+    buf = g_burst.buf[g_burst.head];
+    if (buf == NULL) {
+        buf = heap_caps_malloc(VPROC_HAL_BURST_MAX_WORDS * sizeof(unsigned short), MALLOC_CAP_DMA);
+        if (buf == NULL) {
+            return -1;
+        }
+        g_burst.buf[g_burst.head] = buf;
+    }
+    for (i = 0; i < numwords; i++) {
+#if BIGENDIAN
+        buf[i] = htons(pVal[i]);
+#else
+        buf[i] = pVal[i];
+#endif
+    }
+    t = &g_burst.trans[g_burst.head];
+    memset(t, 0, sizeof(*t));
+    t->length = numwords * sizeof(unsigned short) * 8;
+    t->tx_buffer = buf;
+    if (spi_device_queue_trans(g_spi, t, portMAX_DELAY) != ESP_OK) {
+        return -1;
+    }
+    g_burst.head = (g_burst.head + 1) % VPROC_HAL_QUEUE_SIZE;
+    g_burst.inflight++;
+    return 0;
+}
+
+/* Wait for all the queued burst transactions to complete */
+int VprocHALBurstFlush(void)
+{
+    while (g_burst.inflight > 0) {
+        if (VprocHALBurstCollect() != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* This is the audio_board dependent low level spi function to read a block
+ * of 16-bit words from the ZL380xx device within a single chip select.
+ */
+int VprocHALBurstRead(unsigned short* pVal, unsigned short numwords)
+{
+    esp_err_t ret;
+    spi_transaction_t t;
+    unsigned short *buf;
+    int i;
+
+    if ((pVal == NULL) || (numwords == 0) || (numwords > VPROC_HAL_BURST_MAX_WORDS)) {
+        return -1;
+    }
+    if (VprocHALBurstFlush() != 0) {
+        return -1;
+    }
+    buf = heap_caps_malloc(numwords * sizeof(unsigned short), MALLOC_CAP_DMA);
+    if (buf == NULL) {
+        return -1;
+    }
+    memset(&t, 0, sizeof(t));
+    t.length = numwords * sizeof(unsigned short) * 8;
+    t.rxlength = t.length;
+    t.rx_buffer = buf;
+    ret = spi_device_transmit(g_spi, &t);
+    for (i = 0; i < numwords; i++) {
+#if BIGENDIAN
+        pVal[i] = ntohs(buf[i]);
+#else
+        pVal[i] = buf[i];
+#endif
+    }
+    heap_caps_free(buf);
+    return (ret == ESP_OK) ? 0 : -1;
+}
@@ -28,6 +28,11 @@
 
 #define TAG_SPI "SPI"
 
+/*Maximum number of 16-bit words in a single burst SPI transaction
+ *(HBI command word + one full page-255 window of 128 data words)
+ */
+#define VPROC_HAL_BURST_MAX_WORDS 130
+
 /* external defines */
 #undef VPROC_DEBUG
 
@@ -112,4 +117,7 @@ extern void Vproc_msDelay(unsigned short time);
 extern void VprocWait(unsigned long int time);
 extern int VprocHALWrite(unsigned short val);
 extern int VprocHALRead(unsigned short* pVal);
+extern int VprocHALBurstWrite(const unsigned short* pVal, unsigned short numwords);
+extern int VprocHALBurstFlush(void);
+extern int VprocHALBurstRead(unsigned short* pVal, unsigned short numwords);
 #endif /* VPROC_COMMON_H */
@@ -36,6 +36,15 @@ SemaphoreHandle_t is31fl3216_led_mux ;
 #define I2C_MASTER_RX_BUF_DISABLE   0  /*!< I2C master do not need buffer */
 #define I2C_MASTER_FREQ_HZ    100000   /*!< I2C master clock frequency */
 
+#define IS31FL3216_NUM_LEDS         12
+#define IS31FL3216_LED_REGS         12      /* registers written per LED */
+#define IS31FL3216_LED_REG(led)     (0x26 + ((led) * 18))
+#define IS31FL3216_REG_LATCH        0x25
+
+static uint8_t is31fl3216_shadow[IS31FL3216_NUM_LEDS][IS31FL3216_LED_REGS];   /* next frame */
+static uint8_t is31fl3216_committed[IS31FL3216_NUM_LEDS];                     /* frame on the chip */
+static bool is31fl3216_committed_valid;
+
 /**
  * @brief Initialization function for i2c
  */
@@ -159,15 +168,58 @@ esp_err_t is31fl3216_init()
     return res;
 }
 
-void va_led_set_pwm(const uint32_t * va_led_v)
+void is31fl3216_frame_set_led(uint8_t led, uint8_t pwm)
+{
+    if (led < IS31FL3216_NUM_LEDS) {
+        memset(is31fl3216_shadow[led], pwm, IS31FL3216_LED_REGS);
+    }
+}
+
+esp_err_t is31fl3216_frame_commit()
 {
-    int i, j;
-    uint8_t blue_led_val;
-    for (i = 0; i < 12; i++) {
-        blue_led_val  = 0xFF & (va_led_v[i]);
-        for(j = 0; j < 12; j++) {
-         is31fl3216_write_reg(IS31FL3216_ADDRESS, ((i * 18) + 0x26 + j), blue_led_val);
+    int res = 0;
+    int led, num_burst = 0;
+
+    xSemaphoreTake(is31fl3216_led_mux, portMAX_DELAY);
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    for (led = 0; led < IS31FL3216_NUM_LEDS; led++) {
+        if (is31fl3216_committed_valid && is31fl3216_committed[led] == is31fl3216_shadow[led][0]) {
+            continue;
+        }
+        res |= i2c_master_start(cmd);
+        res |= i2c_master_write_byte(cmd, IS31FL3216_ADDRESS, 1 /*ACK_CHECK_EN*/);
+        res |= i2c_master_write_byte(cmd, IS31FL3216_LED_REG(led), 1 /*ACK_CHECK_EN*/);
+        res |= i2c_master_write(cmd, is31fl3216_shadow[led], IS31FL3216_LED_REGS, 1 /*ACK_CHECK_EN*/);
+        num_burst++;
+    }
+    if (num_burst == 0) {
+        i2c_cmd_link_delete(cmd);
+        xSemaphoreGive(is31fl3216_led_mux);
+        return ESP_OK;
+    }
+    res |= i2c_master_start(cmd);
+    res |= i2c_master_write_byte(cmd, IS31FL3216_ADDRESS, 1 /*ACK_CHECK_EN*/);
+    res |= i2c_master_write_byte(cmd, IS31FL3216_REG_LATCH, 1 /*ACK_CHECK_EN*/);
+    res |= i2c_master_write_byte(cmd, 0x00, 1 /*ACK_CHECK_EN*/);
+    res |= i2c_master_stop(cmd);
+    res |= i2c_master_cmd_begin(0, cmd, 1000 / portTICK_RATE_MS);
+    i2c_cmd_link_delete(cmd);
+    if (res == 0) {
+        for (led = 0; led < IS31FL3216_NUM_LEDS; led++) {
+            is31fl3216_committed[led] = is31fl3216_shadow[led][0];
         }
-        is31fl3216_write_reg(IS31FL3216_ADDRESS, 0x25, 0x00);
+        is31fl3216_committed_valid = true;
+    }
+    xSemaphoreGive(is31fl3216_led_mux);
+    LED_ASSERT(res, "is31fl3216_frame_commit error", -1);
+    return res;
+}
+
+void va_led_set_pwm(const uint32_t * va_led_v)
+{
+    int i;
+    for (i = 0; i < IS31FL3216_NUM_LEDS; i++) {
+        is31fl3216_frame_set_led(i, 0xFF & (va_led_v[i]));     /* blue */
     }
+    is31fl3216_frame_commit();
 }
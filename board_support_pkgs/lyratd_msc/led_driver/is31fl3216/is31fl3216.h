@@ -168,4 +168,21 @@ typedef struct {
     is31fl3216_channel_op_t channel_op;
 } is31fl3216_config_t;
 
+esp_err_t is31fl3216_init();
+
+/**
+ * @brief Set the PWM of an LED in the next frame
+ *
+ * Only the shadow register file is updated, see is31fl3216_frame_commit().
+ */
+void is31fl3216_frame_set_led(uint8_t led, uint8_t pwm);
+
+/**
+ * @brief Send the next frame to the chip
+ *
+ * Only the LEDs that changed since the last committed frame are written, each
+ * as one auto-increment burst, all within a single I2C transaction.
+ */
+esp_err_t is31fl3216_frame_commit();
+
 #endif /* _IS31FL3216_H_ */
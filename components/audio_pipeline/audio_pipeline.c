@@ -26,6 +26,8 @@
 #include <esp_err.h>
 #include <esp_log.h>
 #include <esp_system.h>
+#include <va_trace.h>
+#include <va_latency.h>
 
 #define ap_d(...) \
         ESP_LOGI("AudioPipeline", ##__VA_ARGS__)
@@ -33,6 +35,30 @@
 #define ap_e(...) \
         ESP_LOGE("AudioPipeline", ##__VA_ARGS__)
 
+/* Room for resamplers producing a few samples more than the exact ratio */
+#define FILTER_OUT_SLACK 64
+#define AUDIO_PIPE_MIN_RB_SIZE 1024
+
+/* Longest a filter task waits for input before checking whether it was stopped */
+#define FILTER_READ_WAIT_MS 100
+
+struct audio_pipe_group {
+    audio_pipe_block_t *first;
+    audio_pipe_block_t *last;
+    audio_io_fn_arg_t input;
+    audio_io_fn_arg_t output;
+    /* Filters alternate between these unless working in place */
+    uint8_t *buf[2];
+    int chunk;
+    TaskHandle_t thread;
+    SemaphoreHandle_t ctrl_sem;
+
+    /* Control variables */
+    volatile uint8_t _run: 1;
+    volatile uint8_t _destroy: 1;
+    volatile uint8_t _destroyed: 1;
+};
+
 static esp_err_t audio_pipe_event_cb(void *arg, int event, void *data)
 {
     audio_pipe_t *p = (audio_pipe_t *) arg;
@@ -65,6 +91,7 @@ static esp_err_t audio_pipe_event_cb(void *arg, int event, void *data)
         break;
     case CODEC_EVENT_SET_FREQ: {
         unlock(p->lock);
+        va_latency_mark(VA_LATENCY_DECODE);
         if (p->event_func.func) {
             p->event_func.func(p->event_func.arg, AUDIO_PIPE_CHANGE_FREQ, data);
         }
@@ -111,7 +138,7 @@ static audio_pipe_t *audio_pipe_alloc(const char *name)
     return p;
 }
 
-static void _create_insert_block(audio_pipe_t *p, void *cfg, block_type_t type, ringbuf_t *rb, size_t rb_size, bool head)
+static audio_pipe_block_t *_create_insert_block(audio_pipe_t *p, void *cfg, block_type_t type, ringbuf_t *rb, size_t rb_size, bool head)
 {
     audio_pipe_block_t *b = calloc(1, sizeof(audio_pipe_block_t));
     assert(b);
@@ -130,7 +157,278 @@ static void _create_insert_block(audio_pipe_t *p, void *cfg, block_type_t type,
     p->cnt++;
     unlock(p->lock);
 
-    return;
+    return b;
+}
+
+static ssize_t audio_pipe_group_process(audio_pipe_group_t *g, ssize_t len, uint8_t **out)
+{
+    uint8_t *in = g->buf[0];
+    int cur = 0;
+
+    for (audio_pipe_block_t *b = g->first; ; b = STAILQ_NEXT(b, next)) {
+        audio_pipe_filter_t *f = (audio_pipe_filter_t *) b->block_cfg;
+        uint8_t *dst = f->in_place ? in : g->buf[cur ^ 1];
+        VA_TRACE_BEGIN("filter_process", len);
+        len = f->process(f, in, len, dst);
+        VA_TRACE_END("filter_process", len);
+        if (len < 0) {
+            ap_e("Filter %s failed %d", f->label, len);
+            return len;
+        }
+        if (dst != in) {
+            cur ^= 1;
+        }
+        in = dst;
+        if (b == g->last || len == 0) {
+            break;
+        }
+    }
+    *out = in;
+    return len;
+}
+
+/* Read the next chunk of input into buf[0]
+ *
+ * A filter with a frame size gets whole frames, except at the end of stream.
+ * Returns 0 once the group is stopped, < 0 at the end of stream.
+ */
+static ssize_t audio_pipe_group_read(audio_pipe_group_t *g)
+{
+    bool framed = ((audio_pipe_filter_t *) g->first->block_cfg)->frame_size != 0;
+    int got = 0;
+
+    while (g->_run && !g->_destroy) {
+        ssize_t len = g->input.func(g->input.arg, g->buf[0] + got, g->chunk - got,
+                                    FILTER_READ_WAIT_MS / portTICK_PERIOD_MS);
+        if (len < 0 && len != RB_READER_UNBLOCK) {
+            // Hand over the short last frame before the end of stream
+            return got ? got : len;
+        }
+        if (len > 0) {
+            got += len;
+        }
+        if (got == g->chunk || (got && !framed)) {
+            return got;
+        }
+    }
+    return 0;
+}
+
+static void audio_pipe_group_task(void *arg)
+{
+    audio_pipe_group_t *g = (audio_pipe_group_t *) arg;
+    audio_pipe_block_t *b;
+
+    while (1) {
+        xSemaphoreTake(g->ctrl_sem, portMAX_DELAY);
+        if (g->_destroy) {
+            break;
+        }
+        if (!g->_run) {
+            continue;
+        }
+
+        bool opened = true;
+        for (b = g->first; ; b = STAILQ_NEXT(b, next)) {
+            audio_pipe_filter_t *f = (audio_pipe_filter_t *) b->block_cfg;
+            if (f->open && f->open(f) != ESP_OK) {
+                ap_e("Failed to open filter %s", f->label);
+                opened = false;
+            }
+            if (b == g->last) {
+                break;
+            }
+        }
+
+        while (opened && g->_run && !g->_destroy) {
+            uint8_t *out;
+            ssize_t len = audio_pipe_group_read(g);
+            if (len == 0) {
+                continue;
+            }
+            if (len < 0) {
+                // Upstream finished or aborted
+                break;
+            }
+            len = audio_pipe_group_process(g, len, &out);
+            if (len < 0) {
+                break;
+            }
+            if (len > 0 && g->output.func(g->output.arg, out, len, portMAX_DELAY) < 0) {
+                break;
+            }
+        }
+        g->_run = 0;
+
+        for (b = g->first; ; b = STAILQ_NEXT(b, next)) {
+            audio_pipe_filter_t *f = (audio_pipe_filter_t *) b->block_cfg;
+            if (f->close) {
+                f->close(f);
+            }
+            if (b == g->last) {
+                break;
+            }
+        }
+        if (g->_destroy) {
+            break;
+        }
+        // Propagate end of stream, as streams and codecs do
+        g->output.func(g->output.arg, NULL, 0, portMAX_DELAY);
+    }
+
+    g->thread = NULL;
+    g->_destroyed = 1;
+    vTaskDelete(NULL);
+}
+
+static void audio_pipe_group_destroy(audio_pipe_group_t *g)
+{
+    if (g->thread) {
+        g->_destroy = 1;
+        g->_run = 0;
+        xSemaphoreGive(g->ctrl_sem);
+        while (!g->_destroyed) {
+            vTaskDelay(10 / portTICK_PERIOD_MS);
+        }
+    }
+    if (g->ctrl_sem) {
+        vSemaphoreDelete(g->ctrl_sem);
+    }
+    free(g->buf[0]);
+    free(g->buf[1]);
+    free(g);
+}
+
+/* Bytes per second, 0 if not known or compressed */
+static uint32_t port_byte_rate(const audio_pipe_port_t *port)
+{
+    return port->rate * (port->bits / 8) * port->channels;
+}
+
+static void port_inherit(audio_pipe_port_t *dst, const audio_pipe_port_t *src)
+{
+    if (!dst->rate) {
+        dst->rate = src->rate;
+    }
+    if (!dst->bits) {
+        dst->bits = src->bits;
+    }
+    if (!dst->channels) {
+        dst->channels = src->channels;
+    }
+}
+
+static bool port_compatible(const audio_pipe_port_t *a, const audio_pipe_port_t *b)
+{
+    return (!a->rate || !b->rate || a->rate == b->rate) &&
+           (!a->bits || !b->bits || a->bits == b->bits) &&
+           (!a->channels || !b->channels || a->channels == b->channels);
+}
+
+/* Largest output of a filter for `len` bytes of input */
+static int filter_out_size(const audio_pipe_filter_t *f, int len)
+{
+    uint32_t in_rate = port_byte_rate(&f->in);
+    uint32_t out_rate = port_byte_rate(&f->out);
+    if (!in_rate || !out_rate || in_rate == out_rate) {
+        return len;
+    }
+    return (int) (((uint64_t) len * out_rate + in_rate - 1) / in_rate) + FILTER_OUT_SLACK;
+}
+
+static audio_pipe_group_t *audio_pipe_group_create(audio_pipe_block_t *first, audio_pipe_block_t *last, int priority)
+{
+    audio_pipe_group_t *g = calloc(1, sizeof(audio_pipe_group_t));
+    if (!g) {
+        return NULL;
+    }
+    g->first = first;
+    g->last = last;
+
+    audio_pipe_filter_t *f = (audio_pipe_filter_t *) first->block_cfg;
+    g->chunk = f->frame_size ? f->frame_size : AUDIO_PIPE_FILTER_CHUNK;
+    int size = g->chunk, max = g->chunk;
+    for (audio_pipe_block_t *b = first; ; b = STAILQ_NEXT(b, next)) {
+        size = filter_out_size((audio_pipe_filter_t *) b->block_cfg, size);
+        if (size > max) {
+            max = size;
+        }
+        if (b == last) {
+            break;
+        }
+    }
+    g->buf[0] = malloc(max);
+    g->buf[1] = malloc(max);
+    g->ctrl_sem = xSemaphoreCreateCounting(1, 0);
+    if (!g->buf[0] || !g->buf[1] || !g->ctrl_sem) {
+        ap_e("Failed to allocate filter task buffers");
+        audio_pipe_group_destroy(g);
+        return NULL;
+    }
+
+    if (xTaskCreatePinnedToCore(audio_pipe_group_task, f->label ? f->label : "filter", AUDIO_PIPE_FILTER_TASK_STACK, g,
+                                priority, &g->thread, 0) != pdPASS) {
+        ap_e("Error creating filter task");
+        g->thread = NULL;
+        audio_pipe_group_destroy(g);
+        return NULL;
+    }
+    return g;
+}
+
+/* Input of block b, as seen by the block before it */
+static const audio_pipe_port_t *block_in_port(audio_pipe_block_t *b)
+{
+    if (b->btype == FILTER_BLOCK) {
+        return &((audio_pipe_filter_t *) b->block_cfg)->in;
+    } else if (b->btype == STREAM_BLOCK) {
+        return &b->port;
+    }
+    // Codecs take compressed data
+    return NULL;
+}
+
+/* Bytes block b reads at a time */
+static int block_in_chunk(audio_pipe_block_t *b)
+{
+    if (b->btype == FILTER_BLOCK) {
+        return b->group->chunk;
+    } else if (b->btype == STREAM_BLOCK) {
+        return ((audio_stream_t *) b->block_cfg)->cfg.buf_size;
+    }
+    return 0;
+}
+
+static size_t link_rb_size(audio_pipe_block_t *b, audio_pipe_block_t *next, uint32_t buf_ms)
+{
+    if (b->rb_size) {
+        return b->rb_size;
+    }
+    uint32_t rate = port_byte_rate(&b->port);
+    if (!rate) {
+        return RINGBUF1_DEFAULT_SIZE;
+    }
+    size_t size = (uint64_t) rate * buf_ms / 1000;
+    if (size < 2 * block_in_chunk(next)) {
+        size = 2 * block_in_chunk(next);
+    }
+    return size < AUDIO_PIPE_MIN_RB_SIZE ? AUDIO_PIPE_MIN_RB_SIZE : size;
+}
+
+/* Point the block after b to new input, while the pipeline is not running */
+static void audio_pipe_set_next_input(audio_pipe_block_t *b, audio_io_fn_arg_t *io)
+{
+    audio_pipe_block_t *n = STAILQ_NEXT(b, next);
+    if (n == NULL) {
+        return;
+    }
+    if (n->btype == CODEC_BLOCK) {
+        audio_codec_modify_input_cb(n->block_cfg, io);
+    } else if (n->btype == FILTER_BLOCK) {
+        n->group->input = *io;
+    } else if (n->btype == STREAM_BLOCK) {
+        ((audio_stream_t *) n->block_cfg)->op.stream_input = *io;
+    }
 }
 
 static esp_err_t audio_pipe_replace_stream(audio_pipe_t *p, audio_pipe_block_t *b, audio_stream_t *new_stream)
@@ -199,6 +497,11 @@ static int _audio_pipe_stop(audio_pipe_t *p)
         } else if (b->btype == CODEC_BLOCK) {
             audio_codec_stop(b->block_cfg);
             break;
+        } else if (b->btype == FILTER_BLOCK) {
+            // Fed by a callback, the filter task ends the stream downstream.
+            // It sees this within FILTER_READ_WAIT_MS even if no input comes.
+            b->group->_run = 0;
+            break;
         }
     }
     return ESP_OK;
@@ -208,14 +511,21 @@ static int _audio_pipe_start(audio_pipe_t *p)
 {
     audio_pipe_block_t *b;
 
+    // A filter group writes to the ring of its last block, which may come
+    // after the block that starts it
     STAILQ_FOREACH(b, &p->pb, next) {
         if (b->rb) {
             rb_reset(b->rb);
         }
+    }
+    STAILQ_FOREACH(b, &p->pb, next) {
         if (b->btype == STREAM_BLOCK) {
             audio_stream_start(b->block_cfg);
         } else if (b->btype == CODEC_BLOCK) {
             audio_codec_start(b->block_cfg);
+        } else if (b->btype == FILTER_BLOCK && b->group->first == b) {
+            b->group->_run = 1;
+            xSemaphoreGive(b->group->ctrl_sem);
         }
     }
     return ESP_OK;
@@ -297,14 +607,27 @@ esp_err_t audio_pipe_destroy(audio_pipe_t *p)
     unlock(p->lock);
 
     audio_pipe_block_t *b, *save;
-    STAILQ_FOREACH_SAFE(b, &p->pb, next, save) {
+    // Unblock all tasks before stopping them
+    STAILQ_FOREACH(b, &p->pb, next) {
         if (b->rb) {
-            rb_cleanup(b->rb);
+            rb_abort(b->rb);
+        }
+    }
+    STAILQ_FOREACH(b, &p->pb, next) {
+        if (!b->linked) {
+            continue;
         }
         if (b->btype == STREAM_BLOCK) {
             audio_stream_destroy(b->block_cfg);
         } else if (b->btype == CODEC_BLOCK) {
             audio_codec_destroy(b->block_cfg);
+        } else if (b->btype == FILTER_BLOCK && b->group && b->group->last == b) {
+            audio_pipe_group_destroy(b->group);
+        }
+    }
+    STAILQ_FOREACH_SAFE(b, &p->pb, next, save) {
+        if (b->rb) {
+            rb_cleanup(b->rb);
         }
         free(b);
     }
@@ -373,82 +696,272 @@ static ssize_t rb_write_cb(void *h, void *data, int len, uint32_t wait)
     return rb_write((ringbuf_t *) h, data, len, wait);
 }
 
-audio_pipe_t *_audio_pipe_create(const char *name, audio_stream_t *istream, size_t rb1_size,
-                                 audio_io_fn_arg_t *io_cb, audio_codec_t *codec, size_t rb2_size,
-                                 audio_stream_t *ostream)
+audio_pipe_t *audio_pipe_new(const char *name)
 {
-    ringbuf_t *rb1 = NULL, *rb2 = NULL;
-    audio_io_fn_arg_t stream_io;
-    audio_io_fn_arg_t codec_input, codec_output;
+    return audio_pipe_alloc(name);
+}
 
-    audio_pipe_t *pipe = audio_pipe_alloc(name);
-    if (pipe == NULL) {
-        ap_e("failed to create audio pipe");
-        return NULL;
+static esp_err_t audio_pipe_check_add(audio_pipe_t *p, const void *block)
+{
+    if (p == NULL || block == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (p->linked) {
+        ap_e("Pipeline %s already linked", p->name);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipe_add_stream(audio_pipe_t *p, audio_stream_t *stream, const audio_pipe_port_t *port,
+                                size_t rb_size)
+{
+    esp_err_t ret = audio_pipe_check_add(p, stream);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_pipe_block_t *b = _create_insert_block(p, stream, STREAM_BLOCK, NULL, rb_size, false);
+    if (port) {
+        b->port = *port;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipe_add_input_cb(audio_pipe_t *p, audio_io_fn_arg_t *io_cb, const audio_pipe_port_t *port,
+                                  size_t rb_size)
+{
+    esp_err_t ret = audio_pipe_check_add(p, io_cb);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_pipe_block_t *b = _create_insert_block(p, NULL, CUSTOM_BLOCK, NULL, rb_size, false);
+    b->io_cb = *io_cb;
+    if (port) {
+        b->port = *port;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipe_add_codec(audio_pipe_t *p, audio_codec_t *codec, const audio_pipe_port_t *out,
+                               size_t rb_size)
+{
+    esp_err_t ret = audio_pipe_check_add(p, codec);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_pipe_block_t *b = _create_insert_block(p, codec, CODEC_BLOCK, NULL, rb_size, false);
+    if (out) {
+        b->port = *out;
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipe_add_filter(audio_pipe_t *p, audio_pipe_filter_t *filter)
+{
+    esp_err_t ret = audio_pipe_check_add(p, filter);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (filter->process == NULL) {
+        ap_e("Filter %s has no process function", filter->label);
+        return ESP_ERR_INVALID_ARG;
+    }
+    _create_insert_block(p, filter, FILTER_BLOCK, NULL, 0, false);
+    return ESP_OK;
+}
+
+/* Resolve and check port formats from input to output */
+static esp_err_t audio_pipe_link_ports(audio_pipe_t *p)
+{
+    audio_pipe_block_t *b, *prev = NULL;
+    int idx = 0;
+
+    STAILQ_FOREACH(b, &p->pb, next) {
+        if (prev) {
+            const audio_pipe_port_t *in = block_in_port(b);
+            if (in && !port_compatible(&prev->port, in)) {
+                ap_e("Format mismatch before block %d: %u Hz %u bits %u ch vs %u Hz %u bits %u ch",
+                     idx, prev->port.rate, prev->port.bits, prev->port.channels,
+                     in->rate, in->bits, in->channels);
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        if (b->btype == FILTER_BLOCK) {
+            audio_pipe_filter_t *f = (audio_pipe_filter_t *) b->block_cfg;
+            if (prev) {
+                port_inherit(&f->in, &prev->port);
+            }
+            port_inherit(&f->out, &f->in);
+            b->port = f->out;
+        } else if (b->btype == STREAM_BLOCK && prev) {
+            port_inherit(&b->port, &prev->port);
+        }
+        prev = b;
+        idx++;
+    }
+    return ESP_OK;
+}
+
+/* Fuse runs of adjacent stateless filters onto one task */
+static esp_err_t audio_pipe_link_groups(audio_pipe_t *p, int priority)
+{
+    audio_pipe_block_t *b = STAILQ_FIRST(&p->pb);
+
+    while (b) {
+        if (b->btype != FILTER_BLOCK) {
+            b = STAILQ_NEXT(b, next);
+            continue;
+        }
+        audio_pipe_block_t *last = b, *n;
+        if (((audio_pipe_filter_t *) b->block_cfg)->stateless) {
+            while ((n = STAILQ_NEXT(last, next)) && n->btype == FILTER_BLOCK) {
+                audio_pipe_filter_t *f = (audio_pipe_filter_t *) n->block_cfg;
+                if (!f->stateless || f->frame_size) {
+                    break;
+                }
+                last = n;
+            }
+        }
+        audio_pipe_group_t *g = audio_pipe_group_create(b, last, priority);
+        if (!g) {
+            return ESP_ERR_NO_MEM;
+        }
+        for (n = b; ; n = STAILQ_NEXT(n, next)) {
+            n->group = g;
+            n->linked = true;
+            if (n == last) {
+                break;
+            }
+        }
+        b = STAILQ_NEXT(last, next);
+    }
+    return ESP_OK;
+}
+
+esp_err_t audio_pipe_link(audio_pipe_t *p, uint32_t buf_ms)
+{
+    audio_pipe_block_t *b;
+    audio_io_fn_arg_t input = { 0 };
+    audio_io_fn_arg_t output;
+
+    if (p == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (p->linked) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (buf_ms == 0) {
+        buf_ms = AUDIO_PIPE_DEFAULT_BUF_MS;
+    }
+
+    audio_pipe_block_t *first = STAILQ_FIRST(&p->pb);
+    audio_pipe_block_t *last = STAILQ_LAST(&p->pb, audio_pipe_block, next);
+    if (!first || first == last || last->btype != STREAM_BLOCK ||
+            ((audio_stream_t *) last->block_cfg)->type != STREAM_TYPE_WRITER ||
+            (first->btype != CUSTOM_BLOCK && (first->btype != STREAM_BLOCK ||
+            ((audio_stream_t *) first->block_cfg)->type != STREAM_TYPE_READER))) {
+        ap_e("Pipeline needs an input stream or callback, and an output stream");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = audio_pipe_link_ports(p);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    // Filters run at the priority of the output they feed
+    ret = audio_pipe_link_groups(p, ((audio_stream_t *) last->block_cfg)->cfg.task_priority);
+    if (ret != ESP_OK) {
+        return ret;
     }
 
     audio_event_fn_arg_t event_func = {
         .func = audio_pipe_event_cb,
-        .arg = pipe
+        .arg = p
     };
 
-    if (istream != NULL) {
-        rb1 = rb_init("rb1", rb1_size);
-        if (!rb1) {
-            ap_e("Error creating ring buffer");
-            goto err;
+    STAILQ_FOREACH(b, &p->pb, next) {
+        audio_pipe_block_t *n = STAILQ_NEXT(b, next);
+        if (b->btype == FILTER_BLOCK && b->group->first == b) {
+            b->group->input = input;
         }
-
-        // Add input stream to pipeline
-        stream_io.func = rb_write_cb;
-        stream_io.arg = rb1;
-        if (audio_stream_init(istream, "ipstream", &stream_io, &event_func) != ESP_OK) {
-            ap_d("Error initializing audio stream");
-            goto err;
+        if (b->btype == CUSTOM_BLOCK) {
+            if (!b->rb_size) {
+                b->rb_size = link_rb_size(b, n, buf_ms);
+            }
+            b->linked = true;
+            input = b->io_cb;
+            continue;
+        }
+        if (b == last) {
+            if (audio_stream_init(b->block_cfg, "opstream", &input, &event_func) != ESP_OK) {
+                ap_d("Error initializing audio stream");
+                return ESP_FAIL;
+            }
+            b->linked = true;
+            break;
+        }
+        if (b->btype == FILTER_BLOCK && b->group->last != b) {
+            // Fused with the next filter, no buffer in between
+            continue;
         }
-        _create_insert_block(pipe, istream, STREAM_BLOCK, rb1, rb1_size, true);
-        codec_input.func = rb_read_cb;
-        codec_input.arg = rb1;
-    } else {
-        // Add input callback to pipeline
-        codec_input.func = io_cb->func;
-        codec_input.arg = io_cb->arg;
-        _create_insert_block(pipe, istream, CUSTOM_BLOCK, NULL, rb1_size, true);
-    }
 
-    // Add codec to audio pipeline
-    if (codec != NULL) {
-        rb2 = rb_init("rb2", rb2_size);
-        if (!rb2) {
+        b->rb_size = link_rb_size(b, n, buf_ms);
+        b->rb = rb_init(b == first ? "rb1" : "rb2", b->rb_size);
+        if (!b->rb) {
             ap_e("Error creating ring buffer");
-            goto err;
+            return ESP_ERR_NO_MEM;
         }
+        output.func = rb_write_cb;
+        output.arg = b->rb;
 
-        codec_output.func = rb_write_cb;
-        codec_output.arg = rb2;
-        if (audio_codec_init(codec, "codec", &codec_input, &codec_output, &event_func) != ESP_OK) {
-            ap_d("Error initializing audio codec");
-            goto err;
+        if (b->btype == STREAM_BLOCK) {
+            if (audio_stream_init(b->block_cfg, "ipstream", &output, &event_func) != ESP_OK) {
+                ap_d("Error initializing audio stream");
+                return ESP_FAIL;
+            }
+            b->linked = true;
+        } else if (b->btype == CODEC_BLOCK) {
+            if (audio_codec_init(b->block_cfg, "codec", &input, &output, &event_func) != ESP_OK) {
+                ap_d("Error initializing audio codec");
+                return ESP_FAIL;
+            }
+            b->linked = true;
+        } else {
+            b->group->output = output;
         }
-        _create_insert_block(pipe, codec, CODEC_BLOCK, rb2, rb2_size, false);
-        stream_io.func = rb_read_cb;
-        stream_io.arg = rb2;
-    } else {
-        stream_io.func = rb_read_cb;
-        stream_io.arg = rb1;
+        input.func = rb_read_cb;
+        input.arg = b->rb;
     }
 
-    // Add output stream to pipeline
-    if (audio_stream_init(ostream, "opstream", &stream_io, &event_func) != ESP_OK) {
-        ap_d("Error initializing audio stream");
-        goto err;
+    p->linked = true;
+    return ESP_OK;
+}
+
+audio_pipe_t *_audio_pipe_create(const char *name, audio_stream_t *istream, size_t rb1_size,
+                                 audio_io_fn_arg_t *io_cb, audio_codec_t *codec, size_t rb2_size,
+                                 audio_stream_t *ostream)
+{
+    audio_pipe_t *pipe = audio_pipe_new(name);
+    if (pipe == NULL) {
+        ap_e("failed to create audio pipe");
+        return NULL;
+    }
+
+    if (istream != NULL) {
+        audio_pipe_add_stream(pipe, istream, NULL, rb1_size);
+    } else {
+        audio_pipe_add_input_cb(pipe, io_cb, NULL, rb1_size);
+    }
+    if (codec != NULL) {
+        audio_pipe_add_codec(pipe, codec, NULL, rb2_size);
     }
-    _create_insert_block(pipe, ostream, STREAM_BLOCK, NULL, 0, false);
+    audio_pipe_add_stream(pipe, ostream, NULL, 0);
 
+    if (audio_pipe_link(pipe, AUDIO_PIPE_DEFAULT_BUF_MS) != ESP_OK) {
+        audio_pipe_destroy(pipe);
+        return NULL;
+    }
     return pipe;
-err:
-    audio_pipe_destroy(pipe);
-    return NULL;
 }
 
 audio_pipe_t *audio_pipe_create(const char *name, audio_stream_t *istream, size_t rb1_size,
@@ -567,10 +1080,8 @@ esp_err_t audio_pipe_set_input_stream(audio_pipe_t *p, audio_stream_t *new_strea
         b->block_cfg = new_stream;
         b->btype = STREAM_BLOCK;
         audio_io_fn_arg_t io_cb = { .func = rb_read_cb, .arg = b->rb };
-        b = get_codec_block(p);
-        if (b != NULL) {
-            audio_codec_modify_input_cb(b->block_cfg, &io_cb);
-        }
+        audio_pipe_set_next_input(b, &io_cb);
+        ret = ESP_OK;
     }
     return ret;
 }
@@ -617,10 +1128,8 @@ esp_err_t audio_pipe_set_input_cb(audio_pipe_t *p, audio_io_fn_arg_t *io_cb)
         b->rb = NULL;
         b->btype = CUSTOM_BLOCK;
     }
+    b->io_cb = *io_cb;
 
-    b = get_codec_block(p);
-    if (b != NULL) {
-        audio_codec_modify_input_cb(b->block_cfg, io_cb);
-    }
+    audio_pipe_set_next_input(b, io_cb);
     return ESP_OK;
 }
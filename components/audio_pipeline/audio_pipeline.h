@@ -31,6 +31,7 @@
 #include <rom/queue.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <stdbool.h>
 #include <audio_stream.h>
 #include <audio_codec.h>
 #include <audio_common.h>
@@ -44,6 +45,13 @@ extern "C" {
 #define RINGBUF1_DEFAULT_SIZE (8 * 1024)
 #define RINGBUF2_DEFAULT_SIZE (8 * 1024)
 
+/** Default amount of audio buffered between blocks with a known PCM format */
+#define AUDIO_PIPE_DEFAULT_BUF_MS 100
+
+/** Bytes read per iteration by a filter task, unless the filter asks for a frame size */
+#define AUDIO_PIPE_FILTER_CHUNK 1024
+#define AUDIO_PIPE_FILTER_TASK_STACK (3 * 1024)
+
 /** Private members */
 typedef enum {
     AUDIO_PIPE_INITED = 1,
@@ -60,13 +68,75 @@ typedef enum {
     STREAM_BLOCK = 1,
     CODEC_BLOCK,
     CUSTOM_BLOCK,
+    FILTER_BLOCK,
 } block_type_t;
 
+/** Format of the data on a block port
+ *
+ * Zero fields are not known in advance, and are taken from the block upstream
+ * when linking. Compressed data has `bits` set to 0.
+ */
+typedef struct {
+    uint32_t rate;
+    uint8_t bits;
+    uint8_t channels;
+} audio_pipe_port_t;
+
+#define FILTER_BASE(x) (&x->base)
+
+typedef struct audio_pipe_filter audio_pipe_filter_t;
+
+/** PCM processing block (gain, equalizer, resampler, channel mapping, level meter...)
+ *
+ * Filters do not have a task of their own. Each run of adjacent stateless
+ * filters is fused onto one task which reads from the ring buffer before the
+ * first filter, calls every filter in turn on the same buffers and writes the
+ * result to the ring buffer after the last one. Other filters get a task
+ * each.
+ *
+ * To be filled by the derived filter, which embeds this as `base`.
+ */
+struct audio_pipe_filter {
+    const char *label;
+    /** Input and output formats. Zero output fields are the same as input. */
+    audio_pipe_port_t in;
+    audio_pipe_port_t out;
+    /** Only works on the buffer given, without blocking or pacing of its own */
+    bool stateless;
+    /** process() can write its output over its input */
+    bool in_place;
+    /** Input bytes per process() call, 0 for any. Such a filter starts a task
+     * of its own. The last call before end of stream may be shorter. */
+    int frame_size;
+
+    /** Called from the filter task whenever the pipeline starts, with the
+     * ports resolved. Optional. */
+    esp_err_t (*open)(audio_pipe_filter_t *filter);
+    /** Process `len` bytes from `in` into `out`
+     *
+     * @return Bytes written to `out`, or < 0 on failure, which ends the stream
+     */
+    ssize_t (*process)(audio_pipe_filter_t *filter, const void *in, int len, void *out);
+    /** Called from the filter task when the pipeline stops. Optional. */
+    void (*close)(audio_pipe_filter_t *filter);
+};
+
+/* Filters fused onto one task */
+typedef struct audio_pipe_group audio_pipe_group_t;
+
 typedef struct audio_pipe_block {
     block_type_t btype;
     void *block_cfg;
+    /* Output of this block, NULL for the last block and callbacks */
     ringbuf_t *rb;
     size_t rb_size;
+    /* Output format, input format for the output stream */
+    audio_pipe_port_t port;
+    /* Valid for CUSTOM_BLOCK */
+    audio_io_fn_arg_t io_cb;
+    /* Valid for FILTER_BLOCK */
+    audio_pipe_group_t *group;
+    bool linked;
     STAILQ_ENTRY(audio_pipe_block) next;
 } audio_pipe_block_t;
 
@@ -75,6 +145,7 @@ typedef struct {
     audio_pipe_state_t state;
     audio_pipe_state_t old_state;
     int cnt;
+    bool linked;
     audio_event_fn_arg_t event_func;
     xSemaphoreHandle lock;
     STAILQ_HEAD( , audio_pipe_block) pb;
@@ -92,6 +163,59 @@ typedef struct {
  */
 esp_err_t audio_pipe_destroy(audio_pipe_t *p);
 
+/** Create an empty audio pipeline
+ *
+ * Blocks are added in order from input to output with the audio_pipe_add_*()
+ * APIs, and then connected with \ref audio_pipe_link. The first block is an
+ * input (reader) stream or callback, the last one an output (writer) stream.
+ */
+audio_pipe_t *audio_pipe_new(const char *name);
+
+/** Add a stream to a pipeline
+ *
+ * @param[in] p        Pipeline handle
+ * @param[in] stream   Reader stream as first block, or writer stream as last block
+ * @param[in] port     Format of the stream data, NULL if not known
+ * @param[in] rb_size  Size of the ring buffer after a reader stream, 0 to size it from `port`
+ * @return ESP_OK, ESP_ERR_INVALID_ARG or ESP_ERR_INVALID_STATE if already linked
+ */
+esp_err_t audio_pipe_add_stream(audio_pipe_t *p, audio_stream_t *stream, const audio_pipe_port_t *port,
+                                size_t rb_size);
+
+/** Add an input callback as first block of a pipeline
+ *
+ * `rb_size` is used if the callback is later replaced by a stream with
+ * \ref audio_pipe_set_input_stream.
+ */
+esp_err_t audio_pipe_add_input_cb(audio_pipe_t *p, audio_io_fn_arg_t *io_cb, const audio_pipe_port_t *port,
+                                  size_t rb_size);
+
+/** Add a codec to a pipeline
+ *
+ * @param[in] p        Pipeline handle
+ * @param[in] codec    Codec
+ * @param[in] out      Format of the codec output, NULL if not known
+ * @param[in] rb_size  Size of the ring buffer after the codec, 0 to size it from `out`
+ */
+esp_err_t audio_pipe_add_codec(audio_pipe_t *p, audio_codec_t *codec, const audio_pipe_port_t *out,
+                               size_t rb_size);
+
+/** Add a filter to a pipeline */
+esp_err_t audio_pipe_add_filter(audio_pipe_t *p, audio_pipe_filter_t *filter);
+
+/** Connect the blocks of a pipeline
+ *
+ * Checks that the formats of adjacent ports agree, fills in the unknown ones
+ * from upstream, and connects the blocks with ring buffers sized for `buf_ms`
+ * of audio where the format is known. Streams and codecs are initialized, and
+ * filter tasks are created. On failure the pipeline is to be destroyed.
+ *
+ * @param[in] p       Pipeline handle
+ * @param[in] buf_ms  Audio to buffer between blocks, 0 for \ref AUDIO_PIPE_DEFAULT_BUF_MS
+ * @return ESP_OK, ESP_ERR_INVALID_ARG on format mismatch or ESP_FAIL
+ */
+esp_err_t audio_pipe_link(audio_pipe_t *p, uint32_t buf_ms);
+
 /** Create audio player
  *
  * Create audio pipeline with input and output streams (codec is optional).
@@ -0,0 +1,24 @@
+#pragma once
+
+/* Minimal FreeRTOS API on top of pthreads, enough to run filter tasks on the host.
+ * One tick is one millisecond and task priorities are ignored.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/types.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY       ((TickType_t) 0xffffffffUL)
+#define portTICK_RATE_MS    1
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t) (ms))
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
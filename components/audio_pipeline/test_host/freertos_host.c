@@ -0,0 +1,154 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#define HOST_MAX_TASKS 16
+
+struct host_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned int count;
+    unsigned int max_count;
+};
+
+struct host_task {
+    pthread_t thread;
+    char name[32];
+    TaskFunction_t fn;
+    void *arg;
+};
+
+static struct host_task host_tasks[HOST_MAX_TASKS];
+static int host_num_tasks;
+static pthread_mutex_t host_task_lock = PTHREAD_MUTEX_INITIALIZER;
+
+SemaphoreHandle_t host_sem_create(unsigned int max_count, unsigned int initial_count)
+{
+    struct host_sem *sem = calloc(1, sizeof(*sem));
+    if (!sem) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = initial_count;
+    sem->max_count = max_count;
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait)
+{
+    struct timespec deadline;
+    BaseType_t ret = pdTRUE;
+
+    if (ticks_to_wait != portMAX_DELAY) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += ticks_to_wait / 1000;
+        deadline.tv_nsec += (long) (ticks_to_wait % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0) {
+        if (ticks_to_wait == 0) {
+            ret = pdFALSE;
+            break;
+        } else if (ticks_to_wait == portMAX_DELAY) {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        } else if (pthread_cond_timedwait(&sem->cond, &sem->lock, &deadline) != 0) {
+            ret = sem->count ? pdTRUE : pdFALSE;
+            break;
+        }
+    }
+    if (ret == pdTRUE) {
+        sem->count--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max_count) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
+
+static void *host_task_entry(void *arg)
+{
+    struct host_task *task = arg;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    struct host_task *task;
+
+    pthread_mutex_lock(&host_task_lock);
+    if (host_num_tasks == HOST_MAX_TASKS) {
+        pthread_mutex_unlock(&host_task_lock);
+        return pdFAIL;
+    }
+    task = &host_tasks[host_num_tasks];
+    strncpy(task->name, name, sizeof(task->name) - 1);
+    task->fn = fn;
+    task->arg = arg;
+    if (pthread_create(&task->thread, NULL, host_task_entry, task) != 0) {
+        pthread_mutex_unlock(&host_task_lock);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    host_num_tasks++;
+    pthread_mutex_unlock(&host_task_lock);
+
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep(ticks * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (TickType_t) (now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
@@ -0,0 +1,329 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of the filter tasks of audio_pipeline.c.
+ *
+ *   ./test_pipeline  run the tests, the exit status tells whether they passed
+ *
+ * The pipelines are an input callback, filters and an output stream. Filter
+ * tasks run on pthreads, and the output stream is a stub which leaves the
+ * ring buffer before it to the test to read.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <audio_pipeline.h>
+#include <va_latency.h>
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Streams, codecs and latency marks, as far as a pipeline of filters needs them */
+
+esp_err_t audio_stream_init(audio_stream_t *stream, const char *label, audio_io_fn_arg_t *stream_io,
+                            audio_event_fn_arg_t *event_func)
+{
+    stream->label = label;
+    stream->event_func = *event_func;
+    if (stream->type == STREAM_TYPE_READER) {
+        stream->op.stream_output = *stream_io;
+    } else {
+        stream->op.stream_input = *stream_io;
+    }
+    return ESP_OK;
+}
+
+/* Events come from the stream task, once the pipeline lock is released */
+esp_err_t audio_stream_start(audio_stream_t *stream)
+{
+    stream->_run = 1;
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_stop(audio_stream_t *stream)
+{
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_pause(audio_stream_t *stream)
+{
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_resume(audio_stream_t *stream)
+{
+    return ESP_OK;
+}
+
+esp_err_t audio_stream_destroy(audio_stream_t *stream)
+{
+    return ESP_OK;
+}
+
+audio_stream_identifier_t audio_stream_get_identifier(audio_stream_t *stream)
+{
+    return stream->identifier;
+}
+
+esp_err_t audio_codec_init(audio_codec_t *codec, const char *label, audio_io_fn_arg_t *codec_input,
+                           audio_io_fn_arg_t *codec_output, audio_event_fn_arg_t *event_func)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t audio_codec_modify_input_cb(audio_codec_t *codec, audio_io_fn_arg_t *codec_input)
+{
+    return ESP_FAIL;
+}
+
+audio_codec_type_t audio_codec_get_identifier(audio_codec_t *codec)
+{
+    return codec->identifier;
+}
+
+esp_err_t audio_codec_start(audio_codec_t *codec)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t audio_codec_stop(audio_codec_t *codec)
+{
+    return ESP_FAIL;
+}
+
+esp_err_t audio_codec_destroy(audio_codec_t *codec)
+{
+    return ESP_FAIL;
+}
+
+void va_latency_mark(va_latency_stage_t stage)
+{
+}
+
+/* Filters */
+
+typedef struct {
+    audio_pipe_filter_t base;
+    int opened;
+    int closed;
+    int calls;
+    int bad_len;
+    uint8_t add;
+    uint8_t mul;
+} test_filter_t;
+
+static esp_err_t test_filter_open(audio_pipe_filter_t *filter)
+{
+    ((test_filter_t *) filter)->opened++;
+    return ESP_OK;
+}
+
+static void test_filter_close(audio_pipe_filter_t *filter)
+{
+    ((test_filter_t *) filter)->closed++;
+}
+
+static ssize_t test_filter_process(audio_pipe_filter_t *filter, const void *in, int len, void *out)
+{
+    test_filter_t *f = (test_filter_t *) filter;
+    const uint8_t *src = in;
+    uint8_t *dst = out;
+
+    f->calls++;
+    if (f->base.frame_size && len != f->base.frame_size) {
+        f->bad_len++;
+    }
+    for (int i = 0; i < len; i++) {
+        dst[i] = (uint8_t) ((src[i] + f->add) * f->mul);
+    }
+    return len;
+}
+
+static void test_filter_setup(test_filter_t *f, const char *label, uint8_t add, uint8_t mul)
+{
+    memset(f, 0, sizeof(*f));
+    f->base.label = label;
+    f->base.stateless = true;
+    f->base.open = test_filter_open;
+    f->base.process = test_filter_process;
+    f->base.close = test_filter_close;
+    f->add = add;
+    f->mul = mul;
+}
+
+/* Input: `total` bytes counting up, `piece` at a time. Once they are sent,
+ * either the end of stream, or nothing for as long as the caller waits. */
+
+typedef struct {
+    int sent;
+    int total;
+    int piece;
+    bool idle_forever;
+    SemaphoreHandle_t never;
+} test_input_t;
+
+static ssize_t test_input_read(void *arg, void *data, int len, uint32_t wait)
+{
+    test_input_t *in = arg;
+    uint8_t *buf = data;
+
+    if (in->sent == in->total) {
+        if (!in->idle_forever) {
+            return -1;
+        }
+        xSemaphoreTake(in->never, wait);
+        return 0;
+    }
+    if (len > in->piece) {
+        len = in->piece;
+    }
+    if (len > in->total - in->sent) {
+        len = in->total - in->sent;
+    }
+    for (int i = 0; i < len; i++) {
+        buf[i] = (uint8_t) (in->sent + i);
+    }
+    in->sent += len;
+    return len;
+}
+
+static audio_pipe_t *test_pipe_create(test_input_t *in, test_filter_t *f, int num_filters, audio_stream_t *out)
+{
+    audio_io_fn_arg_t io_cb = { .func = test_input_read, .arg = in };
+
+    memset(out, 0, sizeof(*out));
+    out->type = STREAM_TYPE_WRITER;
+    in->never = xSemaphoreCreateBinary();
+
+    audio_pipe_t *p = audio_pipe_new("test");
+    audio_pipe_add_input_cb(p, &io_cb, NULL, 0);
+    for (int i = 0; i < num_filters; i++) {
+        audio_pipe_add_filter(p, &f[i].base);
+    }
+    audio_pipe_add_stream(p, out, NULL, 0);
+    if (audio_pipe_link(p, 0) != ESP_OK) {
+        printf("FAIL: could not link the pipeline\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void test_pipe_destroy(audio_pipe_t *p, test_input_t *in)
+{
+    audio_pipe_destroy(p);
+    vSemaphoreDelete(in->never);
+}
+
+/* Read the output ring to the end of stream, checking the bytes */
+static int read_output(audio_stream_t *out, uint8_t add0, uint8_t mul0, uint8_t add1, uint8_t mul1)
+{
+    uint8_t buf[512];
+    int total = 0, bad = 0;
+    ssize_t len;
+
+    while ((len = out->op.stream_input.func(out->op.stream_input.arg, buf, sizeof(buf), 2000)) > 0) {
+        for (int i = 0; i < len; i++, total++) {
+            uint8_t want = (uint8_t) (((uint8_t) (((uint8_t) total + add0) * mul0) + add1) * mul1);
+            bad += buf[i] != want;
+        }
+    }
+    CHECK(len == RB_WRITER_FINISHED, "output ended with %d, not end of stream", (int) len);
+    CHECK(bad == 0, "%d of %d bytes wrong", bad, total);
+    return total;
+}
+
+/* Two stateless filters fused onto one task, between the input callback and a ring */
+static void test_two_filters()
+{
+    test_input_t in = { .total = 10000, .piece = 700 };
+    test_filter_t f[2];
+    audio_stream_t out;
+
+    test_filter_setup(&f[0], "add", 1, 1);
+    test_filter_setup(&f[1], "mul", 0, 2);
+    f[0].base.in_place = true;
+    audio_pipe_t *p = test_pipe_create(&in, f, 2, &out);
+
+    audio_pipe_block_t *b = STAILQ_NEXT(STAILQ_FIRST(&p->pb), next);
+    CHECK(b->group && b->group == STAILQ_NEXT(b, next)->group, "filters not fused");
+    CHECK(b->rb == NULL && STAILQ_NEXT(b, next)->rb, "ring not after the group");
+
+    audio_pipe_start(p);
+    int n = read_output(&out, 1, 1, 0, 2);
+    CHECK(n == in.total, "%d of %d bytes came out", n, in.total);
+    for (int i = 0; i < 2; i++) {
+        CHECK(f[i].opened == 1 && f[i].closed == 1, "%s opened %d closed %d times", f[i].base.label,
+              f[i].opened, f[i].closed);
+    }
+    test_pipe_destroy(p, &in);
+}
+
+/* A filter with a frame size gets whole frames from an input that returns
+ * less, and the short remainder at the end */
+static void test_frames()
+{
+    test_input_t in = { .total = 256 * 10 + 100, .piece = 100 };
+    test_filter_t f[2];
+    audio_stream_t out;
+
+    test_filter_setup(&f[0], "frames", 3, 1);
+    test_filter_setup(&f[1], "mul", 0, 3);
+    f[0].base.frame_size = 256;
+    audio_pipe_t *p = test_pipe_create(&in, f, 2, &out);
+
+    audio_pipe_start(p);
+    int n = read_output(&out, 3, 1, 0, 3);
+    CHECK(n == in.total, "%d of %d bytes came out", n, in.total);
+    CHECK(f[0].calls == 11 && f[0].bad_len == 1, "%d calls, %d not a frame", f[0].calls, f[0].bad_len);
+    test_pipe_destroy(p, &in);
+}
+
+/* Stop reaches the filter task while the input callback has nothing to give */
+static void test_stop_idle()
+{
+    test_input_t in = { .total = 3000, .piece = 1000, .idle_forever = true };
+    test_filter_t f[2];
+    audio_stream_t out;
+
+    test_filter_setup(&f[0], "add", 5, 1);
+    test_filter_setup(&f[1], "mul", 0, 2);
+    audio_pipe_t *p = test_pipe_create(&in, f, 2, &out);
+
+    audio_pipe_start(p);
+    out.event_func.func(out.event_func.arg, STREAM_EVENT_STARTED, &out);
+    usleep(50 * 1000);
+    CHECK(in.sent == in.total, "sent %d of %d", in.sent, in.total);
+    CHECK(audio_pipe_stop(p) == ESP_OK, "stop failed");
+
+    for (int ms = 0; ms < 1000 && !f[1].closed; ms += 10) {
+        usleep(10 * 1000);
+    }
+    if (!f[0].closed || !f[1].closed) {
+        // The filter task is stuck and would hang the destroy
+        printf("FAIL %s: filters not closed after stop\n", __func__);
+        exit(1);
+    }
+    CHECK(read_output(&out, 5, 1, 0, 2) == in.total, "data before the stop lost");
+    test_pipe_destroy(p, &in);
+}
+
+int main()
+{
+    test_two_filters();
+    test_frames();
+    test_stop_idle();
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+/* The BSD queue macros the ROM header provides, from the C library where it has them */
+
+#include <stddef.h>
+#include <sys/queue.h>
+
+#ifndef STAILQ_LAST
+#define STAILQ_LAST(head, type, field) \
+    (STAILQ_EMPTY((head)) ? NULL : \
+     (struct type *) ((char *) ((head)->stqh_last) - offsetof(struct type, field)))
+#endif
+
+#ifndef STAILQ_FOREACH_SAFE
+#define STAILQ_FOREACH_SAFE(var, head, field, tvar) \
+    for ((var) = STAILQ_FIRST((head)); (var) && ((tvar) = STAILQ_NEXT((var), field), 1); (var) = (tvar))
+#endif
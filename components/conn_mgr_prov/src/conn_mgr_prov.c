@@ -29,6 +29,14 @@
 
 #define MAX_SCAN_RESULTS 10
 
+/* Background passive scans keep the results fresh while the client is
+ * still picking a network */
+#define SCAN_REFRESH_PERIOD_MS    30000
+#define SCAN_REFRESH_GROUP        4
+#define SCAN_REFRESH_CHANNEL_MS   120
+/* Networks not seen in this many scans are dropped */
+#define SCAN_MAX_MISSED_ROUNDS    2
+
 static const char *TAG = "[conn_mgr_prov]";
 
 static void conn_mgr_prov_extra_mem_release();
@@ -60,10 +68,26 @@ struct wifi_prov_data {
     bool scanning;
     uint8_t channels_per_group;
     uint16_t curr_channel;
-    uint16_t ap_list_len[14];
-    wifi_ap_record_t *ap_list[14];
-    wifi_ap_record_t *ap_list_sorted[MAX_SCAN_RESULTS];
     wifi_scan_config_t scan_cfg;
+    esp_timer_handle_t scan_refresh_timer;
+    bool sta_configured;
+
+    /* Scan results, one entry per SSID (strongest BSSID), sorted by RSSI.
+     * Kept across scans, so that results are available right away and
+     * later scans only refresh them. */
+    struct scan_cache_entry {
+        uint8_t ssid[32];
+        uint8_t bssid[6];
+        uint8_t ssid_len;
+        uint8_t channel;
+        int8_t rssi;
+        uint8_t auth;
+        uint8_t seen_round;
+    } scan_cache[MAX_SCAN_RESULTS];
+    uint16_t scan_cache_len;
+    /* Incremented per scan, and per change of the cache */
+    uint8_t scan_round;
+    uint32_t scan_generation;
 };
 
 /* Pointer to provisioning application data */
@@ -166,6 +190,9 @@ void conn_mgr_prov_endpoint_remove(const char *ep_name)
 
 void conn_mgr_prov_mem_release()
 {
+    /* Scan result pages kept for the provisioning client */
+    wifi_prov_scan_cache_free();
+
 #if CONFIG_BT_ENABLED
     esp_err_t err;
 /* This is used in esp-alexa */
@@ -215,6 +242,8 @@ static void conn_mgr_prov_stop_service(void)
     g_prov->prov.delete_config(g_prov->prov_mode_config);
     /* Delete protocomm instance */
     protocomm_delete(g_prov->pc);
+    /* No more scan result requests to serve */
+    wifi_prov_scan_cache_free();
 
     if (g_prov->prov.event_cb) {
         g_prov->prov.event_cb(g_prov->prov.cb_user_data, CM_PROV_END);
@@ -235,14 +264,10 @@ static void stop_prov_task(void * arg)
     esp_timer_delete(timer);
     g_prov->timer = NULL;
 
-    /* Delete all scan results */
-    ESP_LOGD(TAG, "Taking in %s", __func__);
-    xSemaphoreTake(g_prov_lock, portMAX_DELAY);
-    for (uint16_t channel = 0; channel < 14; channel++) {
-        free(g_prov->ap_list[channel]);
-    }
-    xSemaphoreGive(g_prov_lock);
-    ESP_LOGD(TAG, "Releasing in %s", __func__);
+    /* No more background scans */
+    esp_timer_stop(g_prov->scan_refresh_timer);
+    esp_timer_delete(g_prov->scan_refresh_timer);
+    g_prov->scan_refresh_timer = NULL;
 
     /* Free provisioning process data */
     free((void *)g_prov->pop.data);
@@ -267,6 +292,79 @@ esp_err_t wifi_prov_done()
     return ESP_OK;
 }
 
+/* Remove entry at index, keeping the rest in order */
+static void scan_cache_remove(uint16_t index)
+{
+    memmove(&g_prov->scan_cache[index], &g_prov->scan_cache[index + 1],
+            (g_prov->scan_cache_len - index - 1) * sizeof(g_prov->scan_cache[0]));
+    g_prov->scan_cache_len--;
+}
+
+/* Merge a scan record into the cache. Called with g_prov_lock held. */
+static void scan_cache_add(const wifi_ap_record_t *rec)
+{
+    struct scan_cache_entry entry;
+    uint16_t i;
+
+    entry.ssid_len = strnlen((const char *) rec->ssid, sizeof(entry.ssid));
+    if (entry.ssid_len == 0) {
+        /* Hidden networks cannot be picked from a list anyway */
+        return;
+    }
+    memcpy(entry.ssid, rec->ssid, entry.ssid_len);
+    memcpy(entry.bssid, rec->bssid, sizeof(entry.bssid));
+    entry.channel = rec->primary;
+    entry.rssi = rec->rssi;
+    entry.auth = rec->authmode;
+    entry.seen_round = g_prov->scan_round;
+
+    for (i = 0; i < g_prov->scan_cache_len; i++) {
+        struct scan_cache_entry *e = &g_prov->scan_cache[i];
+        if (e->ssid_len == entry.ssid_len && memcmp(e->ssid, entry.ssid, entry.ssid_len) == 0) {
+            break;
+        }
+    }
+    if (i < g_prov->scan_cache_len) {
+        /* Same SSID already seen in this scan from a stronger BSSID */
+        if (g_prov->scan_cache[i].seen_round == entry.seen_round &&
+                g_prov->scan_cache[i].rssi >= entry.rssi) {
+            return;
+        }
+        scan_cache_remove(i);
+    }
+
+    /* Insert sorted by RSSI, dropping the weakest one when full */
+    for (i = 0; i < g_prov->scan_cache_len; i++) {
+        if (entry.rssi > g_prov->scan_cache[i].rssi) {
+            break;
+        }
+    }
+    if (i >= MAX_SCAN_RESULTS) {
+        return;
+    }
+    if (g_prov->scan_cache_len == MAX_SCAN_RESULTS) {
+        g_prov->scan_cache_len--;
+    }
+    memmove(&g_prov->scan_cache[i + 1], &g_prov->scan_cache[i],
+            (g_prov->scan_cache_len - i) * sizeof(g_prov->scan_cache[0]));
+    g_prov->scan_cache[i] = entry;
+    g_prov->scan_cache_len++;
+    g_prov->scan_generation++;
+}
+
+/* Drop networks that have not shown up for a while. Called with g_prov_lock held. */
+static void scan_cache_prune(void)
+{
+    for (uint16_t i = 0; i < g_prov->scan_cache_len; ) {
+        if ((uint8_t) (g_prov->scan_round - g_prov->scan_cache[i].seen_round) >= SCAN_MAX_MISSED_ROUNDS) {
+            scan_cache_remove(i);
+            g_prov->scan_generation++;
+            continue;
+        }
+        i++;
+    }
+}
+
 static esp_err_t update_wifi_scan_results(void)
 {
     ESP_LOGI(TAG, "Scan finished");
@@ -274,86 +372,64 @@ static esp_err_t update_wifi_scan_results(void)
     esp_err_t ret = ESP_FAIL;
     uint16_t count = 0;
     uint16_t curr_channel = g_prov->curr_channel;
-
-    ESP_LOGD(TAG, "Taking in %s", __func__);
-    xSemaphoreTake(g_prov_lock, portMAX_DELAY);
-    if (g_prov->ap_list[curr_channel]) {
-        free(g_prov->ap_list[curr_channel]);
-        g_prov->ap_list[curr_channel] = NULL;
-        g_prov->ap_list_len[curr_channel] = 0;
-    }
-    xSemaphoreGive(g_prov_lock);
-    ESP_LOGD(TAG, "Releasing in %s", __func__);
+    wifi_ap_record_t *ap_list = NULL;
 
     if (esp_wifi_scan_get_ap_num(&count) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to get count of scanned APs");
+        ESP_LOGD(TAG, "Taking in %s", __func__);
+        xSemaphoreTake(g_prov_lock, portMAX_DELAY);
         goto exit;
     }
 
-    if (!count) {
+    if (count) {
+        /* The driver hands out all records at once, they only live
+         * here until merged into the compact cache */
+        ap_list = (wifi_ap_record_t *) calloc(count, sizeof(wifi_ap_record_t));
+        if (!ap_list) {
+            ESP_LOGE(TAG, "Failed to allocate memory for AP list");
+        } else if (esp_wifi_scan_get_ap_records(&count, ap_list) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to get scanned AP records");
+            free(ap_list);
+            ap_list = NULL;
+        }
+    } else {
         ESP_LOGW(TAG, "Scan result empty");
-        ret = ESP_OK;
-        goto exit;
     }
 
     ESP_LOGD(TAG, "Taking in %s", __func__);
     xSemaphoreTake(g_prov_lock, portMAX_DELAY);
-    g_prov->ap_list[curr_channel] = (wifi_ap_record_t *) calloc(count, sizeof(wifi_ap_record_t));
-    if (!g_prov->ap_list[curr_channel]) {
-        ESP_LOGE(TAG, "Failed to allocate memory for AP list");
+    if (count && !ap_list) {
         goto exit;
     }
-    if (esp_wifi_scan_get_ap_records(&count, g_prov->ap_list[curr_channel]) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get scanned AP records");
-        goto exit;
-    }
-    g_prov->ap_list_len[curr_channel] = count;
 
     printf("%s: Scan results", TAG);
     if (g_prov->channels_per_group) {
         printf(" for channel %d", curr_channel);
     }
     printf(":\n    S.N. %-32s %s\n", "SSID", "RSSI");
-    for (uint8_t i = 0; i < g_prov->ap_list_len[curr_channel]; i++) {
-        printf("    [%2d] %-32s %4d\n", i,
-               g_prov->ap_list[curr_channel][i].ssid,
-               g_prov->ap_list[curr_channel][i].rssi);
+    for (uint16_t i = 0; i < count; i++) {
+        printf("    [%2d] %-32s %4d\n", i, ap_list[i].ssid, ap_list[i].rssi);
+        scan_cache_add(&ap_list[i]);
     }
+    free(ap_list);
     ret = ESP_OK;
 
-    /* Store results in sorted list */
-    {
-        int8_t rc = MAX_SCAN_RESULTS > count ? count : MAX_SCAN_RESULTS;
-        int8_t is = MAX_SCAN_RESULTS - rc - 1;
-        while (rc > 0 && is >= 0) {
-            if (g_prov->ap_list_sorted[is]) {
-                if (g_prov->ap_list_sorted[is]->rssi > g_prov->ap_list[curr_channel][rc - 1].rssi) {
-                    g_prov->ap_list_sorted[is + rc] = &g_prov->ap_list[curr_channel][rc - 1];
-                    rc--;
-                    continue;
-                }
-                g_prov->ap_list_sorted[is + rc] = g_prov->ap_list_sorted[is];
-            }
-            is--;
-        }
-        while (rc > 0) {
-            g_prov->ap_list_sorted[rc - 1] = &g_prov->ap_list[curr_channel][rc - 1];
-            rc--;
-        }
-    }
-
     exit:
 
     if (!g_prov->channels_per_group) {
         /* All channel scan was performed
          * so nothing more to do */
         g_prov->scanning = false;
+        scan_cache_prune();
         goto final;
     }
 
     curr_channel = g_prov->curr_channel = (g_prov->curr_channel + 1) % 14;
     if (ret != ESP_OK || curr_channel == 0) {
         g_prov->scanning = false;
+        if (ret == ESP_OK) {
+            scan_cache_prune();
+        }
         goto final;
     }
 
@@ -446,6 +522,11 @@ esp_err_t conn_mgr_prov_event_handler(void *ctx, system_event_t *event)
             g_prov->wifi_state = WIFI_PROV_STA_CONNECTING;
             esp_wifi_connect();
         }
+        if (g_prov->wifi_state == WIFI_PROV_STA_DISCONNECTED) {
+            /* Given up on these credentials. Let background scans resume,
+             * so that the client picks from fresh results for its retry */
+            g_prov->sta_configured = false;
+        }
         break;
 
     default:
@@ -475,11 +556,6 @@ esp_err_t wifi_prov_wifi_scan_start(bool blocking, bool passive,
         return ESP_OK;
     }
 
-    /* Clear sorted list for new entries */
-    for (uint8_t i = 0; i < MAX_SCAN_RESULTS; i++) {
-        g_prov->ap_list_sorted[i] = NULL;
-    }
-
     if (passive) {
         g_prov->scan_cfg.scan_type = WIFI_SCAN_TYPE_PASSIVE;
         g_prov->scan_cfg.scan_time.passive = period_ms;
@@ -509,6 +585,11 @@ esp_err_t wifi_prov_wifi_scan_start(bool blocking, bool passive,
 
     g_prov->scanning = true;
     g_prov->curr_channel = g_prov->scan_cfg.channel;
+    /* Previous results stay available and get refreshed as channels
+     * are scanned. Round 0 means no scan was ever requested. */
+    if (++g_prov->scan_round == 0) {
+        g_prov->scan_round = 1;
+    }
 
     xSemaphoreGive(g_prov_lock);
     ESP_LOGD(TAG, "Releasing in %s", __func__);
@@ -560,11 +641,34 @@ uint16_t wifi_prov_wifi_scan_result_count(void)
     ESP_LOGD(TAG, "Taking in %s", __func__);
     xSemaphoreTake(g_prov_lock, portMAX_DELAY);
 
-    while (rval < MAX_SCAN_RESULTS) {
-        if (!g_prov->ap_list_sorted[rval]) {
-            break;
-        }
-        rval++;
+    rval = g_prov->scan_cache_len;
+
+    xSemaphoreGive(g_prov_lock);
+    ESP_LOGD(TAG, "Releasing in %s", __func__);
+
+    return rval;
+}
+
+esp_err_t wifi_prov_wifi_scan_result(uint16_t index, wifi_prov_scan_result_t *result)
+{
+    if (!g_prov) {
+        return ESP_FAIL;
+    }
+
+    esp_err_t rval = ESP_FAIL;
+
+    ESP_LOGD(TAG, "Taking in %s", __func__);
+    xSemaphoreTake(g_prov_lock, portMAX_DELAY);
+
+    if (index < g_prov->scan_cache_len) {
+        const struct scan_cache_entry *e = &g_prov->scan_cache[index];
+        memset(result->ssid, 0, sizeof(result->ssid));
+        memcpy(result->ssid, e->ssid, e->ssid_len);
+        memcpy(result->bssid, e->bssid, sizeof(e->bssid));
+        result->channel = e->channel;
+        result->rssi = e->rssi;
+        result->auth = e->auth;
+        rval = ESP_OK;
     }
 
     xSemaphoreGive(g_prov_lock);
@@ -573,18 +677,18 @@ uint16_t wifi_prov_wifi_scan_result_count(void)
     return rval;
 }
 
-const wifi_ap_record_t *wifi_prov_wifi_scan_result(uint16_t index)
+uint32_t wifi_prov_wifi_scan_generation(void)
 {
     if (!g_prov) {
-        return NULL;
+        return 0;
     }
 
-    const wifi_ap_record_t *rval = NULL;
+    uint32_t rval = 0;
 
     ESP_LOGD(TAG, "Taking in %s", __func__);
     xSemaphoreTake(g_prov_lock, portMAX_DELAY);
 
-    rval = g_prov->ap_list_sorted[index];
+    rval = g_prov->scan_generation;
 
     xSemaphoreGive(g_prov_lock);
     ESP_LOGD(TAG, "Releasing in %s", __func__);
@@ -592,6 +696,20 @@ const wifi_ap_record_t *wifi_prov_wifi_scan_result(uint16_t index)
     return rval;
 }
 
+/* Callback to be invoked by the scan refresh timer */
+static void _scan_refresh_cb(void * arg)
+{
+    /* Only once a client has asked for results, and not while the
+     * station is trying to connect with the received credentials */
+    if (!g_prov || g_prov->scan_round == 0 || g_prov->sta_configured) {
+        return;
+    }
+    if (wifi_prov_wifi_scan_finished()) {
+        ESP_LOGD(TAG, "Background scan refresh");
+        wifi_prov_wifi_scan_start(false, true, SCAN_REFRESH_GROUP, SCAN_REFRESH_CHANNEL_MS);
+    }
+}
+
 esp_err_t wifi_prov_get_wifi_state(wifi_prov_sta_state_t* state)
 {
     if (g_prov == NULL || state == NULL) {
@@ -686,6 +804,7 @@ esp_err_t wifi_prov_configure_sta(wifi_config_t *wifi_cfg)
 
     /* Reset wifi station state for provisioning app */
     g_prov->wifi_state = WIFI_PROV_STA_CONNECTING;
+    g_prov->sta_configured = true;
     return ESP_OK;
 }
 
@@ -738,6 +857,21 @@ esp_err_t conn_mgr_prov_start_provisioning(conn_mgr_prov_t prov, int security, c
         return err;
     }
 
+    esp_timer_create_args_t scan_timer_conf = {
+        .callback = _scan_refresh_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "scan_refresh_tm"
+    };
+    err = esp_timer_create(&scan_timer_conf, &g_prov->scan_refresh_timer);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create scan refresh timer");
+        esp_timer_delete(g_prov->timer);
+        free((void *)g_prov->pop.data);
+        free(g_prov);
+        return err;
+    }
+
     /* Initialize WiFi with default config */
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     if (esp_wifi_init(&cfg) != ESP_OK) {
@@ -773,9 +907,11 @@ esp_err_t conn_mgr_prov_start_provisioning(conn_mgr_prov_t prov, int security, c
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Provisioning failed to start");
         esp_timer_delete(g_prov->timer);
+        esp_timer_delete(g_prov->scan_refresh_timer);
         free((void *)g_prov->pop.data);
         free(g_prov);
         return err;
     }
+    esp_timer_start_periodic(g_prov->scan_refresh_timer, SCAN_REFRESH_PERIOD_MS * 1000U);
     return ESP_OK;
 }
@@ -150,20 +150,18 @@ static esp_err_t scan_result(uint16_t result_index,
                       wifi_prov_scan_result_t *result,
                       wifi_prov_scan_ctx_t **ctx)
 {
-    const wifi_ap_record_t *record = wifi_prov_wifi_scan_result(result_index);
-    if (!record) {
-        return ESP_FAIL;
-    }
-    memcpy(result->ssid, record->ssid, sizeof(record->ssid));
-    result->channel = record->primary;
-    result->rssi = record->rssi;
-    result->auth = record->authmode;
-    return ESP_OK;
+    return wifi_prov_wifi_scan_result(result_index, result);
+}
+
+static uint32_t scan_generation(wifi_prov_scan_ctx_t **ctx)
+{
+    return wifi_prov_wifi_scan_generation();
 }
 
 wifi_prov_scan_handlers_t wifi_scan_handlers = {
     .scan_start = scan_start,
     .scan_status = scan_status,
     .scan_result = scan_result,
-    .ctx = NULL
+    .ctx = NULL,
+    .scan_generation = scan_generation
 };
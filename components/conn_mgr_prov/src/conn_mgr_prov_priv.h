@@ -14,6 +14,7 @@
 #include <protocomm.h>
 #include <protocomm_security.h>
 #include <wifi_provisioning/wifi_config.h>
+#include <wifi_provisioning/wifi_scan.h>
 
 /**
  * @brief   Start WiFi AP Scan
@@ -52,12 +53,24 @@ uint16_t wifi_prov_wifi_scan_result_count(void);
 /**
  * @brief   Get AP record for a particular index in the scan list result
  *
- * @param[out] index  Index of the result to fetch
+ * Results are sorted by signal strength, with one entry per SSID.
+ *
+ * @param[in]  index   Index of the result to fetch
+ * @param[out] result  Copy of the entry
+ *
+ * @return
+ *  - ESP_OK    : Success
+ *  - ESP_FAIL  : Index out of range or provisioning app not running
+ */
+esp_err_t wifi_prov_wifi_scan_result(uint16_t index, wifi_prov_scan_result_t *result);
+
+/**
+ * @brief   Get the generation of the scan list
  *
  * @return
- *  - result : Pointer to AP record
+ *  - generation : Changes whenever the scan list changes
  */
-const wifi_ap_record_t *wifi_prov_wifi_scan_result(uint16_t index);
+uint32_t wifi_prov_wifi_scan_generation(void);
 
 /**
  * @brief   Get state of WiFi Station during provisioning
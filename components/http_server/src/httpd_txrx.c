@@ -231,6 +231,67 @@ esp_err_t httpd_resp_set_type(httpd_req_t *r, const char *type)
     return ESP_OK;
 }
 
+/* Response builder which gathers the status line, headers, chunk framing and
+ * small bodies in the scratch buffer, so that they go out in as few sends as
+ * possible. Data that doesn't fit in the scratch buffer is sent as is.
+ */
+struct httpd_resp_buf {
+    httpd_req_t *r;
+    char        *buf;
+    size_t       size;
+    size_t       len;
+};
+
+static void httpd_resp_buf_init(struct httpd_resp_buf *b, httpd_req_t *r, size_t len)
+{
+    struct httpd_req_aux *ra = r->aux;
+    b->r    = r;
+    b->buf  = ra->scratch;
+    b->size = sizeof(ra->scratch);
+    b->len  = len;
+}
+
+static esp_err_t httpd_resp_buf_flush(struct httpd_resp_buf *b)
+{
+    esp_err_t ret = ESP_OK;
+    if (b->len) {
+        ret = httpd_send_all(b->r, b->buf, b->len);
+        b->len = 0;
+    }
+    return ret;
+}
+
+static esp_err_t httpd_resp_buf_append(struct httpd_resp_buf *b, const char *data, size_t len)
+{
+    if (b->len + len > b->size) {
+        if (httpd_resp_buf_flush(b) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (len > b->size) {
+            return httpd_send_all(b->r, data, len);
+        }
+    }
+    memcpy(b->buf + b->len, data, len);
+    b->len += len;
+    return ESP_OK;
+}
+
+/* Appends the additional headers set with httpd_resp_set_hdr() and the end of the header section */
+static esp_err_t httpd_resp_buf_append_hdrs(struct httpd_resp_buf *b)
+{
+    struct httpd_req_aux *ra = b->r->aux;
+
+    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
+        if (httpd_resp_buf_append(b, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK ||
+            httpd_resp_buf_append(b, ": ", 2) != ESP_OK ||
+            httpd_resp_buf_append(b, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK ||
+            httpd_resp_buf_append(b, "\r\n", 2) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    return httpd_resp_buf_append(b, "\r\n", 2);
+}
+
 esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, size_t buf_len)
 {
     if (r == NULL) {
@@ -242,55 +303,32 @@ esp_err_t httpd_resp_send(httpd_req_t *r, const char *buf, size_t buf_len)
     }
 
     struct httpd_req_aux *ra = r->aux;
+    struct httpd_resp_buf b;
     const char *httpd_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
 
     /* Size of essential headers is limited by scratch buffer size */
-    if (snprintf(ra->scratch, sizeof(ra->scratch), httpd_hdr_str,
-                 ra->status, ra->content_type, buf_len) >= sizeof(ra->scratch)) {
+    int hdr_len = snprintf(ra->scratch, sizeof(ra->scratch), httpd_hdr_str,
+                           ra->status, ra->content_type, buf_len);
+    if (hdr_len >= sizeof(ra->scratch)) {
         return ESP_ERR_HTTPD_RESP_HDR;
     }
 
-    /* Sending essential headers */
-    if (httpd_send_all(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
+    /* Headers and, if it fits, the content go out in a single send */
+    httpd_resp_buf_init(&b, r, hdr_len);
+    if (httpd_resp_buf_append_hdrs(&b) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
-
-    /* Sending additional headers based on set_header */
-    for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-        /* Send header field */
-        if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send ': ' */
-        if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send header value */
-        if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-        /* Send CR + LF */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    if (buf && buf_len) {
+        if (httpd_resp_buf_append(&b, buf, buf_len) != ESP_OK) {
             return ESP_ERR_HTTPD_RESP_SEND;
         }
     }
-
-    /* End header section */
-    if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+    if (httpd_resp_buf_flush(&b) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
-
-    /* Sending content */
-    if (buf && buf_len) {
-        if (httpd_send_all(r, buf, buf_len) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-    }
     return ESP_OK;
 }
 
@@ -305,69 +343,43 @@ esp_err_t httpd_resp_send_chunk(httpd_req_t *r, const char *buf, size_t buf_len)
     }
 
     struct httpd_req_aux *ra = r->aux;
+    struct httpd_resp_buf b;
     const char *httpd_chunked_hdr_str = "HTTP/1.1 %s\r\nContent-Type: %s\r\nTransfer-Encoding: chunked\r\n";
-    const char *colon_separator = ": ";
-    const char *cr_lf_seperator = "\r\n";
 
     /* Request headers are no longer available */
     ra->req_hdrs_count = 0;
 
+    httpd_resp_buf_init(&b, r, 0);
     if (!ra->first_chunk_sent) {
         /* Size of essential headers is limited by scratch buffer size */
-        if (snprintf(ra->scratch, sizeof(ra->scratch), httpd_chunked_hdr_str,
-                     ra->status, ra->content_type) >= sizeof(ra->scratch)) {
+        int hdr_len = snprintf(ra->scratch, sizeof(ra->scratch), httpd_chunked_hdr_str,
+                               ra->status, ra->content_type);
+        if (hdr_len >= sizeof(ra->scratch)) {
             return ESP_ERR_HTTPD_RESP_HDR;
         }
-
-        /* Sending essential headers */
-        if (httpd_send_all(r, ra->scratch, strlen(ra->scratch)) != ESP_OK) {
-            return ESP_ERR_HTTPD_RESP_SEND;
-        }
-
-        /* Sending additional headers based on set_header */
-        for (unsigned i = 0; i < ra->resp_hdrs_count; i++) {
-            /* Send header field */
-            if (httpd_send_all(r, ra->resp_hdrs[i].field, strlen(ra->resp_hdrs[i].field)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send ': ' */
-            if (httpd_send_all(r, colon_separator, strlen(colon_separator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send header value */
-            if (httpd_send_all(r, ra->resp_hdrs[i].value, strlen(ra->resp_hdrs[i].value)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-            /* Send CR + LF */
-            if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
-                return ESP_ERR_HTTPD_RESP_SEND;
-            }
-        }
-
-        /* End header section */
-        if (httpd_send_all(r, cr_lf_seperator, strlen(cr_lf_seperator)) != ESP_OK) {
+        b.len = hdr_len;
+        if (httpd_resp_buf_append_hdrs(&b) != ESP_OK) {
             return ESP_ERR_HTTPD_RESP_SEND;
         }
-        ra->first_chunk_sent = true;
     }
 
-    /* Sending chunked content */
+    /* Chunk size, data and end of chunk are framed into one send when they fit */
     char len_str[10];
     snprintf(len_str, sizeof(len_str), "%x\r\n", buf_len);
-    if (httpd_send_all(r, len_str, strlen(len_str)) != ESP_OK) {
+    if (httpd_resp_buf_append(&b, len_str, strlen(len_str)) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
-
     if (buf) {
-        if (httpd_send_all(r, buf, buf_len) != ESP_OK) {
+        if (httpd_resp_buf_append(&b, buf, buf_len) != ESP_OK) {
             return ESP_ERR_HTTPD_RESP_SEND;
         }
     }
-
-    /* Indicate end of chunk */
-    if (httpd_send_all(r, "\r\n", strlen("\r\n")) != ESP_OK) {
+    if (httpd_resp_buf_append(&b, "\r\n", 2) != ESP_OK ||
+        httpd_resp_buf_flush(&b) != ESP_OK) {
         return ESP_ERR_HTTPD_RESP_SEND;
     }
+    /* Only now are the headers known to be out */
+    ra->first_chunk_sent = true;
     return ESP_OK;
 }
 
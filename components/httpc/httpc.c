@@ -23,8 +23,11 @@
 static const char *TAG = "httpc";
 #ifdef ESP_PLATFORM
 #include <esp_log.h>
+#include <va_trace.h>
 #else
 #include "mbedtls/esp_debug.h"
+#define VA_TRACE_BEGIN(name, arg)
+#define VA_TRACE_END(name, arg)
 #endif
 
 static int get_port(const char *url, struct http_parser_url *u)
@@ -83,20 +86,18 @@ void http_connection_set_keepalive_and_recv_timeout(httpc_conn_t *httpc)
     setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
 }
 
+/* Do one read from the connection into buf and feed it to the parser. Body
+ * bytes are moved down to the start of buf as they are parsed, so that on
+ * return buf holds nothing but body. Returns the number of body bytes.
+ */
 static int http_response_read_and_parse(httpc_conn_t *httpc, char *buf, size_t buf_len,
                                         bool discard_buf)
 {
-    if (discard_buf == true) {
-        httpc->request.out_buf = NULL;
-        httpc->request.out_buf_len = 0;
-        httpc->request.out_buf_index = 0;
-    } else {
-        httpc->request.out_buf = buf;
-        httpc->request.out_buf_len = buf_len;
-        httpc->request.out_buf_index = 0;
-    }
+    httpc->body_dst = discard_buf ? NULL : buf;
     /* Read data.*/
+    VA_TRACE_BEGIN("http_read", buf_len);
     int data_read = esp_tls_conn_read(httpc->tls, buf, buf_len);
+    VA_TRACE_END("http_read", data_read);
     if (data_read < 0) {
         if ((httpc->is_tls && data_read == MBEDTLS_ERR_SSL_WANT_READ) || errno == EAGAIN) {
             /* Currently this is only supported if the timeout is set AFTER the headers are already parsed */
@@ -111,13 +112,41 @@ static int http_response_read_and_parse(httpc_conn_t *httpc, char *buf, size_t b
         ESP_LOGE(TAG, "Error in parsing parsed:%d data_read:%d\n", parsed, data_read);
         return -1 ;
     }
+    return discard_buf ? 0 : httpc->body_dst - buf;
+}
+
+static int http_rx_buf_alloc(httpc_conn_t *httpc)
+{
+    if (!httpc->rx_buf) {
+        httpc->rx_buf = (char *) malloc(HTTPC_RX_BUF_SIZE);
+        if (!httpc->rx_buf) {
+            ESP_LOGE(TAG, "Could not allocate rx buffer. Line = %d", __LINE__);
+            return -1;
+        }
+    }
     return 0;
 }
 
-static int header_parser(httpc_conn_t *httpc, char *buf, size_t buf_len)
+/* Read into the read-ahead buffer. Only to be called once the buffered body is used up. */
+static int http_rx_buf_read(httpc_conn_t *httpc)
 {
+    int status = http_response_read_and_parse(httpc, httpc->rx_buf, HTTPC_RX_BUF_SIZE, false);
+    if (status < 0) {
+        return status;
+    }
+    httpc->rx_body_off = 0;
+    httpc->rx_body_len = status;
+    return status;
+}
+
+static int header_parser(httpc_conn_t *httpc)
+{
+    if (http_rx_buf_alloc(httpc) != 0) {
+        return -1;
+    }
+    /* Whatever body arrives along with the headers stays in the buffer */
     while (httpc->state < ESP_HTTP_RESP_HDR_RECEIVED) {
-        int status = http_response_read_and_parse(httpc, buf, buf_len, false);
+        int status = http_rx_buf_read(httpc);
         if (status < 0) {
             return status;
         }
@@ -125,6 +154,21 @@ static int header_parser(httpc_conn_t *httpc, char *buf, size_t buf_len)
     return 0;
 }
 
+/* Returns the number of buffered body bytes, reading more if there are none */
+static int http_rx_buf_fill(httpc_conn_t *httpc)
+{
+    while (httpc->rx_body_off == httpc->rx_body_len) {
+        if (httpc->state >= ESP_HTTP_RESP_BDY_RECEIVED) {
+            return 0;
+        }
+        int status = http_rx_buf_read(httpc);
+        if (status < 0) {
+            return status;
+        }
+    }
+    return httpc->rx_body_len - httpc->rx_body_off;
+}
+
 httpc_conn_t *http_connection_new(const char *url, esp_tls_cfg_t *tls_cfg)
 {
     if (!url) {
@@ -146,8 +190,10 @@ httpc_conn_t *http_connection_new(const char *url, esp_tls_cfg_t *tls_cfg)
     struct esp_tls *tls;
     bool is_tls = is_url_tls(url, u);
 
+    VA_TRACE_BEGIN("tls_handshake", is_tls);
     tls = esp_tls_conn_new(&url[u->field_data[UF_HOST].off], u->field_data[UF_HOST].len,
                            get_port(url, u), is_tls ? tls_cfg : NULL);
+    VA_TRACE_END("tls_handshake", tls != NULL);
     if (!tls) {
         ESP_LOGE(TAG, "Failed to create a new TLS connection");
         goto error;
@@ -268,6 +314,9 @@ void http_connection_delete(httpc_conn_t *httpc)
     if (httpc->host) {
         free(httpc->host);
     }
+    if (httpc->rx_buf) {
+        free(httpc->rx_buf);
+    }
     esp_tls_conn_delete(httpc->tls);
     free(httpc);
 }
@@ -501,22 +550,20 @@ static int http_get_hdr_value(http_parser *parser, const char *p, size_t len)
 static int http_get_body(http_parser *parser, const char *p, size_t len)
 {
     httpc_conn_t *h = parser->data;
-    if (!h->request.out_buf) {
+    if (!h->body_dst) {
         /* We just have to flush the data out, the user isn't interested in getting
          * a copy of the data. So do nothing...
          */
         return 0;
     }
 
-    if (len + h->request.out_buf_index > h->request.out_buf_len) {
-        /* How is this possible, we ensured that we will never read more than
-         * the user's buffer length.
-         */
-        ESP_LOGE(TAG, "ASSERT: This shouldn't happen\n");
-        return -1;
+    /* body_dst trails p within the buffer being parsed, and everything below
+     * p has been consumed by the parser, so the move is safe.
+     */
+    if (h->body_dst != p) {
+        memmove(h->body_dst, p, len);
     }
-    memcpy(h->request.out_buf + h->request.out_buf_index, p, len);
-    h->request.out_buf_index += len;
+    h->body_dst += len;
 
     return 0;
 }
@@ -583,9 +630,12 @@ int http_request_new(httpc_conn_t *httpc, httpc_ops_t op, const char *url)
          * the same socket, flush it out so that the next request works
          * properly.
          */
-        char buf[50];
+        httpc->rx_body_off = httpc->rx_body_len = 0;
+        if (http_rx_buf_alloc(httpc) != 0) {
+            return -1;
+        }
         while (httpc->state < ESP_HTTP_RESP_BDY_RECEIVED) {
-            int status = http_response_read_and_parse(httpc, buf, sizeof(buf), true);
+            int status = http_response_read_and_parse(httpc, httpc->rx_buf, HTTPC_RX_BUF_SIZE, true);
             if (status == -EAGAIN) {
                 continue;
             }
@@ -630,9 +680,6 @@ bool http_connection_new_needed(httpc_conn_t *httpc, const char *url)
 
 void http_request_delete(httpc_conn_t *httpc)
 {
-    if (httpc->request.hdr_overflow_buf) {
-        free(httpc->request.hdr_overflow_buf);
-    }
     if (httpc->request.url) {
         free((void *)httpc->request.url);
     }
@@ -645,7 +692,7 @@ void http_request_delete(httpc_conn_t *httpc)
      */
 }
 
-int http_response_recv(httpc_conn_t *httpc, char *buf, size_t buf_len)
+static int http_response_start(httpc_conn_t *httpc)
 {
     /* This could either be called AFTER a header parsing API, or immediately
      * after sending the request. If the headers aren't parsed, we need to parse
@@ -654,82 +701,68 @@ int http_response_recv(httpc_conn_t *httpc, char *buf, size_t buf_len)
     if (httpc->state < ESP_HTTP_RESP_STARTED) {
         httpc->state = ESP_HTTP_RESP_STARTED;
     }
-    if ( httpc->state < ESP_HTTP_RESP_HDR_RECEIVED ) {
-        int status = header_parser(httpc, buf, buf_len);
-        if (status < 0) {
-            return status;
-        }
-        /* At this point it is likely that the on-body received was already called
-         * and some data was copied into the user buffers. If that is the case,
-         * just return the data right from here.
-         */
-        if (httpc->request.out_buf_index) {
-            return httpc->request.out_buf_index;
-        }
+    if (httpc->state < ESP_HTTP_RESP_HDR_RECEIVED) {
+        return header_parser(httpc);
     }
+    return 0;
+}
 
-    /* If httpc->request.body_read_in_header is set as true it implies that
-     * http_header_fetch() API call was made before http_response_recv() API call
-     * and there is dynamically allocated buffer which contains some bits of the
-     * body which needs to be emptied.
-     */
-    if (httpc->request.hdr_overflow_buf) {
-        int total_len = httpc->request.hdr_overflow_buf_len -
-                        httpc->request.hdr_overflow_buf_index;
-        int  copy_len = buf_len <= total_len ? buf_len : total_len;
-        memcpy(buf, httpc->request.hdr_overflow_buf +
-               httpc->request.hdr_overflow_buf_index,
-               copy_len);
-        if (copy_len == total_len) {
-            free(httpc->request.hdr_overflow_buf);
-            httpc->request.hdr_overflow_buf = NULL;
-        } else {
-            httpc->request.hdr_overflow_buf_index += copy_len;
-        }
-        return copy_len;
+int http_response_recv(httpc_conn_t *httpc, char *buf, size_t buf_len)
+{
+    int status = http_response_start(httpc);
+    if (status < 0) {
+        return status;
     }
-    while (1) {
-        if (httpc->state < ESP_HTTP_RESP_BDY_RECEIVED) {
-            int status  = http_response_read_and_parse(httpc, buf, buf_len, false);
-            if (status < 0) {
-                return status;
-            }
-            if (httpc->request.out_buf_index) {
-                return httpc->request.out_buf_index;
-            } else {
-                /* We tried to read data, but mostly read meta-data
-                 * (like metadata fields in chunked encoding,
-                 * reattempt reading more data
+
+    if (httpc->rx_body_off == httpc->rx_body_len && buf_len >= HTTPC_RX_BUF_SIZE) {
+        /* Nothing buffered and the caller's buffer is at least as big as ours:
+         * read straight into it, so that the body is copied only once.
+         */
+        while (httpc->state < ESP_HTTP_RESP_BDY_RECEIVED) {
+            status = http_response_read_and_parse(httpc, buf, buf_len, false);
+            if (status != 0) {
+                /* Either an error, or body data. Reads with only meta-data
+                 * (like chunk headers in chunked encoding) are retried.
                  */
-                continue;
+                return status;
             }
-        } else {
-            /* Message is now complete, we just break */
-            break;
         }
+        /* End of data */
+        return 0;
     }
-    /* End of data */
-    return 0;
+
+    status = http_rx_buf_fill(httpc);
+    if (status <= 0) {
+        return status;
+    }
+    int copy_len = buf_len <= status ? buf_len : status;
+    memcpy(buf, httpc->rx_buf + httpc->rx_body_off, copy_len);
+    httpc->rx_body_off += copy_len;
+    return copy_len;
 }
 
-int http_header_fetch(httpc_conn_t *httpc)
+int http_response_peek(httpc_conn_t *httpc, const char **data)
 {
-    if (httpc->state < ESP_HTTP_RESP_STARTED) {
-        httpc->state = ESP_HTTP_RESP_STARTED;
-        httpc->request.hdr_overflow_buf = (char *)malloc(HTTPC_BUF_SIZE);
-        int status =  header_parser(httpc, httpc->request.hdr_overflow_buf, HTTPC_BUF_SIZE);
-        if (status < 0) {
-            return status;
-        }
-        if (httpc->request.out_buf_index) {
-            httpc->request.hdr_overflow_buf_len = httpc->request.out_buf_index;
-            httpc->request.hdr_overflow_buf_index = 0;
-        } else {
-            free(httpc->request.hdr_overflow_buf);
-            httpc->request.hdr_overflow_buf = NULL;
-        }
+    int status = http_response_start(httpc);
+    if (status < 0) {
+        return status;
     }
-    return 0;
+    status = http_rx_buf_fill(httpc);
+    if (status > 0) {
+        *data = httpc->rx_buf + httpc->rx_body_off;
+    }
+    return status;
+}
+
+void http_response_consume(httpc_conn_t *httpc, size_t len)
+{
+    int avail = httpc->rx_body_len - httpc->rx_body_off;
+    httpc->rx_body_off += len <= avail ? len : avail;
+}
+
+int http_header_fetch(httpc_conn_t *httpc)
+{
+    return http_response_start(httpc);
 }
 
 int http_send_chunk(httpc_conn_t *httpc, const char *data, size_t data_len)
@@ -22,7 +22,14 @@
 extern "C" {
 #endif
 
-#define HTTPC_BUF_SIZE 50
+/* Size of the per connection read-ahead buffer. Sizing it to a full TLS
+ * record (16K) gets every record in a single read.
+ */
+#ifdef ESP_PLATFORM
+#define HTTPC_RX_BUF_SIZE CONFIG_HTTP_CLIENT_RX_BUF_SIZE
+#else
+#define HTTPC_RX_BUF_SIZE 2048
+#endif
 
 typedef enum {
     ESP_HTTP_GET,
@@ -82,18 +89,28 @@ typedef struct httpc_conn {
             httpc_response_header_cb response_hdr_cb;
 	    void *response_hdr_cb_arg;
         } parser_state;
-        /* Pointer to user buffer to copy data into */
-        char *out_buf;
-        size_t out_buf_len;
-        int out_buf_index;
-        /* Pointer to allocate extra body content read in
-         * http_header_fetch API call
+        /* No longer used. The prebuilt libraries read this structure through
+         * the inline accessors below, so fields keep their offsets.
          */
-        char *hdr_overflow_buf;
-        int hdr_overflow_buf_len;
-        int hdr_overflow_buf_index;
+        char *reserved_out_buf;
+        size_t reserved_out_buf_len;
+        int reserved_out_buf_index;
+        char *reserved_hdr_overflow_buf;
+        int reserved_hdr_overflow_buf_len;
+        int reserved_hdr_overflow_buf_index;
         char response_content_type[MAX_HDR_VAL_LEN];
     } request;
+
+    /* New fields go below this line only, see above */
+
+    /* Read-ahead buffer, allocated on first use. Response body that is not
+     * yet handed to the caller is at rx_buf[rx_body_off, rx_body_len)
+     */
+    char *rx_buf;
+    int rx_body_off;
+    int rx_body_len;
+    /* Body bytes are moved down to here as they are parsed, NULL to discard */
+    char *body_dst;
 } httpc_conn_t;
 
 httpc_conn_t *http_connection_new(const char *url, esp_tls_cfg_t *tls_cfg);
@@ -118,6 +135,21 @@ void http_request_delete(httpc_conn_t *httpc);
 int http_header_fetch(httpc_conn_t *h);
 int http_request_send(httpc_conn_t *httpc, const char *data, size_t data_len);
 int http_response_recv(httpc_conn_t *httpc, char *data, size_t data_len);
+
+/**
+ * Get the next span of response body without copying it.
+ *
+ * Parses the headers first if that wasn't done yet. The span points into the
+ * connection's read-ahead buffer and stays valid until http_response_consume()
+ * or any other call on this connection.
+ *
+ * Returns the number of bytes available at *data, 0 once the body is complete,
+ * -EAGAIN on receive timeout and -1 on error.
+ */
+int http_response_peek(httpc_conn_t *httpc, const char **data);
+
+/* Mark len bytes of the span returned by http_response_peek() as used. */
+void http_response_consume(httpc_conn_t *httpc, size_t len);
 void http_response_set_header_cb(httpc_conn_t *httpc, httpc_response_header_cb cb, void *arg);
 
 static inline int http_response_get_code(httpc_conn_t *httpc)
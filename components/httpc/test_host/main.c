@@ -268,6 +268,39 @@ static int test_postman_get_multi_with_header_fetch()
         printf("Success\n");
         http_request_delete(h);
     }
+
+    {
+        printf("test:       - GET /get (peek/consume 7 bytes at a time) ....");
+        http_request_new(h, ESP_HTTP_GET, "/get");
+        http_request_send(h, NULL, 0);
+        http_header_fetch(h);
+        int current_index = 0;
+        while (1) {
+            const char *data;
+            int data_read = http_response_peek(h, &data);
+            if (data_read == 0) {
+                break;
+            }
+            if (data_read < 0) {
+                return -1;
+            }
+            if (validate_status_code(h, 200)) {
+                return -1;
+            }
+            if (data_read > 7) {
+                data_read = 7;
+            }
+
+            char *expected_result = "{\"args\":{},\"headers\":{\"x-forwarded-proto\":\"https\",\"host\":\"postman-echo.com\",\"user-agent\":\"ESP32 HTTP Client/1.0\",\"x-forwarded-port\":\"443\"},\"url\":\"https://postman-echo.com/get\"}";
+            if (validate_data(current_index, expected_result, data, data_read)) {
+                return -1;
+            }
+            http_response_consume(h, data_read);
+            current_index += data_read;
+        }
+        printf("Success\n");
+        http_request_delete(h);
+    }
     http_connection_delete(h);
 
     return 0;
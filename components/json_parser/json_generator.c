@@ -0,0 +1,390 @@
+// Copyright 2017-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <json_generator.h>
+
+/* Values at or beyond this are printed through snprintf, everything
+ * else goes through the integer based formatter below */
+#define JSON_GEN_FLOAT_FAST_MAX     1e15
+#define JSON_GEN_FLOAT_FRAC_SCALE   1000000
+#define JSON_GEN_FLOAT_FRAC_DIGITS  6
+
+static int json_gen_flush(json_gen_str_t *jstr)
+{
+    if (!jstr->flush_cb) {
+        /* Document does not fit the buffer */
+        return -OS_FAIL;
+    }
+    if (jstr->offset && jstr->flush_cb(jstr->buf, jstr->offset, jstr->priv) != OS_SUCCESS) {
+        return -OS_FAIL;
+    }
+    jstr->offset = 0;
+    return OS_SUCCESS;
+}
+
+static int json_gen_put(json_gen_str_t *jstr, const char *data, int len)
+{
+    if (jstr->failed) {
+        return -OS_FAIL;
+    }
+    while (len) {
+        if (jstr->offset == jstr->buf_size && json_gen_flush(jstr) != OS_SUCCESS) {
+            jstr->failed = true;
+            return -OS_FAIL;
+        }
+        int chunk = jstr->buf_size - jstr->offset;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(jstr->buf + jstr->offset, data, chunk);
+        jstr->offset += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return OS_SUCCESS;
+}
+
+static inline int json_gen_putc(json_gen_str_t *jstr, char c)
+{
+    if (!jstr->failed && jstr->offset < jstr->buf_size) {
+        jstr->buf[jstr->offset++] = c;
+        return OS_SUCCESS;
+    }
+    return json_gen_put(jstr, &c, 1);
+}
+
+static int json_gen_put_string(json_gen_str_t *jstr, const char *str)
+{
+    const char *run = str;
+    const char *p;
+    char ubuf[6] = {'\\', 'u', '0', '0'};
+    static const char hex[] = "0123456789abcdef";
+
+    json_gen_putc(jstr, '"');
+    for (p = str; *p; p++) {
+        unsigned char c = *p;
+        const char *esc;
+        int esc_len = 2;
+
+        switch (c) {
+            case '"':  esc = "\\\""; break;
+            case '\\': esc = "\\\\"; break;
+            case '\n': esc = "\\n"; break;
+            case '\r': esc = "\\r"; break;
+            case '\t': esc = "\\t"; break;
+            case '\b': esc = "\\b"; break;
+            case '\f': esc = "\\f"; break;
+            default:
+                if (c >= 0x20) {
+                    continue;
+                }
+                ubuf[4] = hex[c >> 4];
+                ubuf[5] = hex[c & 0xf];
+                esc = ubuf;
+                esc_len = sizeof(ubuf);
+                break;
+        }
+        json_gen_put(jstr, run, p - run);
+        json_gen_put(jstr, esc, esc_len);
+        run = p + 1;
+    }
+    json_gen_put(jstr, run, p - run);
+    return json_gen_putc(jstr, '"');
+}
+
+/* Digits are produced backwards from the end of tmp */
+static int json_gen_fmt_u32(char *end, uint32_t val)
+{
+    char *p = end;
+    do {
+        *--p = '0' + (val % 10);
+        val /= 10;
+    } while (val);
+    return end - p;
+}
+
+static int json_gen_put_int64(json_gen_str_t *jstr, int64_t val)
+{
+    char tmp[21];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    uint64_t u = val < 0 ? -(uint64_t) val : (uint64_t) val;
+
+    /* 64 bit division is done in software, so only use it for the
+     * upper digits */
+    while (u > UINT32_MAX) {
+        *--p = '0' + (u % 10);
+        u /= 10;
+    }
+    p -= json_gen_fmt_u32(p, (uint32_t) u);
+    if (val < 0) {
+        *--p = '-';
+    }
+    return json_gen_put(jstr, p, end - p);
+}
+
+static int json_gen_put_int(json_gen_str_t *jstr, int val)
+{
+    char tmp[12];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    uint32_t u = val < 0 ? -(uint32_t) val : (uint32_t) val;
+
+    p -= json_gen_fmt_u32(p, u);
+    if (val < 0) {
+        *--p = '-';
+    }
+    return json_gen_put(jstr, p, end - p);
+}
+
+static int json_gen_put_float(json_gen_str_t *jstr, float val)
+{
+    char tmp[32];
+
+    if (isnan(val) || isinf(val)) {
+        /* Not representable in JSON */
+        return json_gen_put(jstr, "null", 4);
+    }
+
+    double v = val < 0 ? -(double) val : (double) val;
+    if (v >= JSON_GEN_FLOAT_FAST_MAX) {
+        int len = snprintf(tmp, sizeof(tmp), "%.7g", val);
+        return json_gen_put(jstr, tmp, len);
+    }
+
+    uint64_t ipart = (uint64_t) v;
+    uint32_t frac = (uint32_t) ((v - ipart) * JSON_GEN_FLOAT_FRAC_SCALE + 0.5);
+    if (frac >= JSON_GEN_FLOAT_FRAC_SCALE) {
+        ipart++;
+        frac -= JSON_GEN_FLOAT_FRAC_SCALE;
+    }
+
+    if (val < 0 && (ipart || frac)) {
+        json_gen_putc(jstr, '-');
+    }
+    json_gen_put_int64(jstr, (int64_t) ipart);
+    if (frac) {
+        char *end = tmp + JSON_GEN_FLOAT_FRAC_DIGITS;
+        int digits = json_gen_fmt_u32(end, frac);
+        memset(tmp, '0', JSON_GEN_FLOAT_FRAC_DIGITS - digits);
+        while (end[-1] == '0') {
+            end--;
+        }
+        json_gen_putc(jstr, '.');
+        json_gen_put(jstr, tmp, end - tmp);
+    }
+    return jstr->failed ? -OS_FAIL : OS_SUCCESS;
+}
+
+/* Comma separation for the element about to be added at the current level */
+static int json_gen_elem(json_gen_str_t *jstr)
+{
+    uint64_t bit = 1ULL << jstr->depth;
+    if (jstr->comma_mask & bit) {
+        return json_gen_putc(jstr, ',');
+    }
+    jstr->comma_mask |= bit;
+    return jstr->failed ? -OS_FAIL : OS_SUCCESS;
+}
+
+static int json_gen_name(json_gen_str_t *jstr, const char *name)
+{
+    json_gen_elem(jstr);
+    json_gen_put_string(jstr, name);
+    return json_gen_putc(jstr, ':');
+}
+
+static int json_gen_open(json_gen_str_t *jstr, char c)
+{
+    if (jstr->depth >= JSON_GEN_MAX_DEPTH) {
+        jstr->failed = true;
+        return -OS_FAIL;
+    }
+    json_gen_putc(jstr, c);
+    jstr->depth++;
+    jstr->comma_mask &= ~(1ULL << jstr->depth);
+    return jstr->failed ? -OS_FAIL : OS_SUCCESS;
+}
+
+static int json_gen_close(json_gen_str_t *jstr, char c)
+{
+    if (jstr->depth == 0) {
+        jstr->failed = true;
+        return -OS_FAIL;
+    }
+    jstr->depth--;
+    return json_gen_putc(jstr, c);
+}
+
+void json_gen_str_start(json_gen_str_t *jstr, char *buf, int buf_size,
+                        json_gen_flush_cb_t flush_cb, void *priv)
+{
+    memset(jstr, 0, sizeof(*jstr));
+    jstr->buf = buf;
+    jstr->buf_size = buf_size;
+    jstr->flush_cb = flush_cb;
+    jstr->priv = priv;
+}
+
+int json_gen_str_end(json_gen_str_t *jstr)
+{
+    if (jstr->failed || jstr->depth != 0) {
+        return -OS_FAIL;
+    }
+    if (jstr->flush_cb) {
+        return json_gen_flush(jstr);
+    }
+    if (jstr->offset >= jstr->buf_size) {
+        /* No room for the NUL */
+        jstr->failed = true;
+        return -OS_FAIL;
+    }
+    jstr->buf[jstr->offset] = '\0';
+    return OS_SUCCESS;
+}
+
+int json_gen_start_object(json_gen_str_t *jstr)
+{
+    json_gen_elem(jstr);
+    return json_gen_open(jstr, '{');
+}
+
+int json_gen_end_object(json_gen_str_t *jstr)
+{
+    return json_gen_close(jstr, '}');
+}
+
+int json_gen_start_array(json_gen_str_t *jstr)
+{
+    json_gen_elem(jstr);
+    return json_gen_open(jstr, '[');
+}
+
+int json_gen_end_array(json_gen_str_t *jstr)
+{
+    return json_gen_close(jstr, ']');
+}
+
+int json_gen_push_object(json_gen_str_t *jstr, const char *name)
+{
+    json_gen_name(jstr, name);
+    return json_gen_open(jstr, '{');
+}
+
+int json_gen_pop_object(json_gen_str_t *jstr)
+{
+    return json_gen_close(jstr, '}');
+}
+
+int json_gen_push_array(json_gen_str_t *jstr, const char *name)
+{
+    json_gen_name(jstr, name);
+    return json_gen_open(jstr, '[');
+}
+
+int json_gen_pop_array(json_gen_str_t *jstr)
+{
+    return json_gen_close(jstr, ']');
+}
+
+int json_gen_obj_set_bool(json_gen_str_t *jstr, const char *name, bool val)
+{
+    json_gen_name(jstr, name);
+    return val ? json_gen_put(jstr, "true", 4) : json_gen_put(jstr, "false", 5);
+}
+
+int json_gen_obj_set_int(json_gen_str_t *jstr, const char *name, int val)
+{
+    json_gen_name(jstr, name);
+    return json_gen_put_int(jstr, val);
+}
+
+int json_gen_obj_set_int64(json_gen_str_t *jstr, const char *name, int64_t val)
+{
+    json_gen_name(jstr, name);
+    return json_gen_put_int64(jstr, val);
+}
+
+int json_gen_obj_set_float(json_gen_str_t *jstr, const char *name, float val)
+{
+    json_gen_name(jstr, name);
+    return json_gen_put_float(jstr, val);
+}
+
+int json_gen_obj_set_string(json_gen_str_t *jstr, const char *name, const char *val)
+{
+    json_gen_name(jstr, name);
+    return val ? json_gen_put_string(jstr, val) : json_gen_put(jstr, "null", 4);
+}
+
+int json_gen_obj_set_null(json_gen_str_t *jstr, const char *name)
+{
+    json_gen_name(jstr, name);
+    return json_gen_put(jstr, "null", 4);
+}
+
+int json_gen_obj_set_raw(json_gen_str_t *jstr, const char *name, const char *val, int len)
+{
+    json_gen_name(jstr, name);
+    return json_gen_put(jstr, val, len);
+}
+
+int json_gen_arr_set_bool(json_gen_str_t *jstr, bool val)
+{
+    json_gen_elem(jstr);
+    return val ? json_gen_put(jstr, "true", 4) : json_gen_put(jstr, "false", 5);
+}
+
+int json_gen_arr_set_int(json_gen_str_t *jstr, int val)
+{
+    json_gen_elem(jstr);
+    return json_gen_put_int(jstr, val);
+}
+
+int json_gen_arr_set_int64(json_gen_str_t *jstr, int64_t val)
+{
+    json_gen_elem(jstr);
+    return json_gen_put_int64(jstr, val);
+}
+
+int json_gen_arr_set_float(json_gen_str_t *jstr, float val)
+{
+    json_gen_elem(jstr);
+    return json_gen_put_float(jstr, val);
+}
+
+int json_gen_arr_set_string(json_gen_str_t *jstr, const char *val)
+{
+    json_gen_elem(jstr);
+    return val ? json_gen_put_string(jstr, val) : json_gen_put(jstr, "null", 4);
+}
+
+int json_gen_arr_set_null(json_gen_str_t *jstr)
+{
+    json_gen_elem(jstr);
+    return json_gen_put(jstr, "null", 4);
+}
+
+int json_gen_arr_set_raw(json_gen_str_t *jstr, const char *val, int len)
+{
+    json_gen_elem(jstr);
+    return json_gen_put(jstr, val, len);
+}
@@ -0,0 +1,101 @@
+// Copyright 2017-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef _JSON_GENERATOR_H_
+#define _JSON_GENERATOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <json_parser.h>
+
+/*
+ * Streaming JSON writer.
+ *
+ * The document is produced into a small caller provided buffer. Whenever
+ * it fills up, the flush callback gets the buffered bytes, so the output
+ * can go straight to the transport while the rest is still being built,
+ * e.g.:
+ *
+ *     static int flush_to_httpc(const char *buf, int len, void *priv)
+ *     {
+ *         return http_send_chunk((httpc_conn_t *)priv, buf, len) < 0 ? -OS_FAIL : OS_SUCCESS;
+ *     }
+ *
+ * For pull style consumers (sh2lib data providers) flush into a rope_t
+ * instead and let the provider drain it. Without a flush callback the
+ * whole document, and its terminating NUL, must fit in the buffer.
+ *
+ * Nesting is tracked in a fixed bitmask, so the writer never allocates.
+ * Once an error occurs (nesting too deep, flush failure, no room) all
+ * further calls fail, and json_gen_str_end() reports it.
+ */
+
+#define JSON_GEN_MAX_DEPTH  32
+
+typedef int (*json_gen_flush_cb_t)(const char *buf, int len, void *priv);
+
+typedef struct {
+    char *buf;
+    int buf_size;
+    int offset;
+    json_gen_flush_cb_t flush_cb;
+    void *priv;
+    /* Bit n set: level n already has an element, next one needs a comma.
+     * Level 0 is the root, so JSON_GEN_MAX_DEPTH levels take one bit more */
+    uint64_t comma_mask;
+    int depth;
+    bool failed;
+} json_gen_str_t;
+
+void json_gen_str_start(json_gen_str_t *jstr, char *buf, int buf_size,
+                        json_gen_flush_cb_t flush_cb, void *priv);
+/* Flushes whatever is left, or NUL-terminates the buffer when there is no
+ * flush callback. Returns OS_SUCCESS only if the complete document was
+ * produced */
+int json_gen_str_end(json_gen_str_t *jstr);
+/* Length of the document in the buffer, when not using a flush callback */
+static inline int json_gen_str_len(json_gen_str_t *jstr)
+{
+    return jstr->offset;
+}
+
+int json_gen_start_object(json_gen_str_t *jstr);
+int json_gen_end_object(json_gen_str_t *jstr);
+int json_gen_start_array(json_gen_str_t *jstr);
+int json_gen_end_array(json_gen_str_t *jstr);
+
+int json_gen_push_object(json_gen_str_t *jstr, const char *name);
+int json_gen_pop_object(json_gen_str_t *jstr);
+int json_gen_push_array(json_gen_str_t *jstr, const char *name);
+int json_gen_pop_array(json_gen_str_t *jstr);
+
+int json_gen_obj_set_bool(json_gen_str_t *jstr, const char *name, bool val);
+int json_gen_obj_set_int(json_gen_str_t *jstr, const char *name, int val);
+int json_gen_obj_set_int64(json_gen_str_t *jstr, const char *name, int64_t val);
+int json_gen_obj_set_float(json_gen_str_t *jstr, const char *name, float val);
+int json_gen_obj_set_string(json_gen_str_t *jstr, const char *name, const char *val);
+int json_gen_obj_set_null(json_gen_str_t *jstr, const char *name);
+/* val is copied as is, it must already be valid JSON */
+int json_gen_obj_set_raw(json_gen_str_t *jstr, const char *name, const char *val, int len);
+
+int json_gen_arr_set_bool(json_gen_str_t *jstr, bool val);
+int json_gen_arr_set_int(json_gen_str_t *jstr, int val);
+int json_gen_arr_set_int64(json_gen_str_t *jstr, int64_t val);
+int json_gen_arr_set_float(json_gen_str_t *jstr, float val);
+int json_gen_arr_set_string(json_gen_str_t *jstr, const char *val);
+int json_gen_arr_set_null(json_gen_str_t *jstr);
+int json_gen_arr_set_raw(json_gen_str_t *jstr, const char *val, int len);
+
+#endif /* _JSON_GENERATOR_H_ */
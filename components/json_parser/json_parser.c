@@ -444,27 +444,67 @@ int json_arr_get_strlen(jparse_ctx_t *jctx, uint32_t index, int *strlen)
     return OS_SUCCESS;
 }
 
-int json_parse_start(jparse_ctx_t *jctx, char *js, int len)
+/* Initial token array size, doubled whenever jsmn runs out */
+#define JSON_TOK_INIT_CAP       16
+
+static int json_tokens_grow(jparse_ctx_t *jctx, int *tok_cap)
 {
-    memset(jctx, 0, sizeof(jparse_ctx_t));
-    __jsmn_init(&jctx->parser);
-    int num_tokens = __jsmn_parse(&jctx->parser, js, len, NULL, 0);
-    if (num_tokens <= 0) {
+    int cap = *tok_cap ? *tok_cap * 2 : JSON_TOK_INIT_CAP;
+    json_tok_t *tokens = realloc(jctx->tokens, cap * sizeof(json_tok_t));
+    if (!tokens) {
         return -OS_FAIL;
     }
-    jctx->num_tokens = num_tokens;
-    jctx->tokens = calloc(num_tokens, sizeof(json_tok_t));
-    if (!jctx->tokens) {
+    jctx->tokens = tokens;
+    *tok_cap = cap;
+    return OS_SUCCESS;
+}
+
+/* Tokenise js[0, len) in a single pass, growing the token array as needed
+ * instead of counting the tokens first */
+static int json_tokenize(jparse_ctx_t *jctx, int len, int *tok_cap)
+{
+    int ret;
+
+    /* Without a token array jsmn would only count tokens */
+    if (json_tokens_grow(jctx, tok_cap) != OS_SUCCESS) {
         return -OS_FAIL;
     }
-    jctx->js = js;
-    __jsmn_init(&jctx->parser);
-    int ret = __jsmn_parse(&jctx->parser, js, len, jctx->tokens, jctx->num_tokens);
+    while (1) {
+        ret = __jsmn_parse(&jctx->parser, jctx->js, len, jctx->tokens, *tok_cap);
+        if (ret != JSMN_ERROR_NOMEM) {
+            break;
+        }
+        /* The parser backs off to the token it could not store */
+        if (json_tokens_grow(jctx, tok_cap) != OS_SUCCESS) {
+            return -OS_FAIL;
+        }
+    }
     if (ret <= 0) {
+        return -OS_FAIL;
+    }
+    jctx->num_tokens = ret;
+    return OS_SUCCESS;
+}
+
+int json_parse_start(jparse_ctx_t *jctx, char *js, int len)
+{
+    int tok_cap = 0;
+
+    memset(jctx, 0, sizeof(jparse_ctx_t));
+    __jsmn_init(&jctx->parser);
+    jctx->js = js;
+    if (json_tokenize(jctx, len, &tok_cap) != OS_SUCCESS) {
         free(jctx->tokens);
         memset(jctx, 0, sizeof(jparse_ctx_t));
         return -OS_FAIL;
     }
+    if (tok_cap > jctx->num_tokens) {
+        /* Give back the slack from growing in steps */
+        json_tok_t *tokens = realloc(jctx->tokens, jctx->num_tokens * sizeof(json_tok_t));
+        if (tokens) {
+            jctx->tokens = tokens;
+        }
+    }
     jctx->cur = jctx->tokens;
     return OS_SUCCESS;
 }
@@ -0,0 +1,3 @@
+#pragma once
+
+/* The board build options are not needed by the tests */
@@ -0,0 +1,381 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of json_parser.c and json_generator.c.
+ *
+ *   ./test_json      run the tests, the exit status tells whether they passed
+ *
+ * The generator tests try every buffer size against the flush callback, so
+ * each flush boundary is hit somewhere.
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <json_parser.h>
+#include <json_generator.h>
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static const char doc[] = "{\"a\":1,\"list\":[10,20,30],\"obj\":{\"s\":\"text\"}}";
+
+static void check_doc(jparse_ctx_t *jctx)
+{
+    int val = 0, num = 0;
+    char s[8] = "";
+
+    CHECK(json_obj_get_int(jctx, "a", &val) == OS_SUCCESS && val == 1, "a = %d", val);
+    CHECK(json_obj_get_array(jctx, "list", &num) == OS_SUCCESS && num == 3, "list has %d", num);
+    CHECK(json_arr_get_int(jctx, 2, &val) == OS_SUCCESS && val == 30, "list[2] = %d", val);
+    json_obj_leave_array(jctx);
+    CHECK(json_obj_get_object(jctx, "obj") == OS_SUCCESS, "no obj");
+    CHECK(json_obj_get_string(jctx, "s", s, sizeof(s)) == OS_SUCCESS && strcmp(s, "text") == 0, "s = %s", s);
+    json_obj_leave_object(jctx);
+}
+
+static void test_parse()
+{
+    jparse_ctx_t jctx;
+    char buf[sizeof(doc)];
+
+    memcpy(buf, doc, sizeof(doc));
+    CHECK(json_parse_start(&jctx, buf, strlen(buf)) == OS_SUCCESS, "parse failed");
+    CHECK(jctx.num_tokens == 12, "%d tokens", jctx.num_tokens);
+    check_doc(&jctx);
+    json_parse_end(&jctx);
+}
+
+/* Enough tokens for the array to grow several times */
+static void test_parse_grow()
+{
+    static char big[4096];
+    jparse_ctx_t jctx;
+    int len = 0, num = 0, val = 0;
+
+    len += snprintf(big + len, sizeof(big) - len, "{\"n\":[");
+    for (int i = 0; i < 300; i++) {
+        len += snprintf(big + len, sizeof(big) - len, i ? ",%d" : "%d", i);
+    }
+    len += snprintf(big + len, sizeof(big) - len, "],\"last\":7}");
+
+    CHECK(json_parse_start(&jctx, big, len) == OS_SUCCESS, "parse failed");
+    CHECK(jctx.num_tokens == 305, "%d tokens", jctx.num_tokens);
+    CHECK(json_obj_get_array(&jctx, "n", &num) == OS_SUCCESS && num == 300, "n has %d", num);
+    CHECK(json_arr_get_int(&jctx, 299, &val) == OS_SUCCESS && val == 299, "n[299] = %d", val);
+    json_obj_leave_array(&jctx);
+    CHECK(json_obj_get_int(&jctx, "last", &val) == OS_SUCCESS && val == 7, "last = %d", val);
+    json_parse_end(&jctx);
+}
+
+static void test_parse_invalid()
+{
+    static const char *bad[] = { "", "{\"a\":", "{\"a\":1", "{\"a\":1}\r\n--boundary", "[1,2" };
+    jparse_ctx_t jctx;
+    char buf[64];
+
+    for (int i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        strcpy(buf, bad[i]);
+        CHECK(json_parse_start(&jctx, buf, strlen(buf)) != OS_SUCCESS, "parsed \"%s\"", bad[i]);
+        CHECK(jctx.tokens == NULL && jctx.cur == NULL, "\"%s\": context not cleared", bad[i]);
+    }
+}
+
+/* Generator */
+
+#define GEN_OUT_SIZE    1024
+
+static char gen_out[GEN_OUT_SIZE];
+static int gen_out_len;
+static int gen_flushes;
+static int gen_fail_after;
+
+static int gen_flush(const char *buf, int len, void *priv)
+{
+    if (gen_fail_after && gen_flushes++ >= gen_fail_after) {
+        return -OS_FAIL;
+    }
+    if (len <= 0 || gen_out_len + len > GEN_OUT_SIZE) {
+        return -OS_FAIL;
+    }
+    memcpy(gen_out + gen_out_len, buf, len);
+    gen_out_len += len;
+    return OS_SUCCESS;
+}
+
+static void gen_doc(json_gen_str_t *jstr)
+{
+    json_gen_start_object(jstr);
+    json_gen_obj_set_string(jstr, "name", "say \"hi\"\n");
+    json_gen_obj_set_int(jstr, "int", -1234567);
+    json_gen_obj_set_int64(jstr, "int64", 1234567890123LL);
+    json_gen_obj_set_float(jstr, "float", 2.5);
+    json_gen_obj_set_bool(jstr, "yes", true);
+    json_gen_obj_set_null(jstr, "none");
+    json_gen_push_array(jstr, "list");
+    json_gen_arr_set_int(jstr, 1);
+    json_gen_arr_set_string(jstr, "two");
+    json_gen_start_object(jstr);
+    json_gen_obj_set_raw(jstr, "raw", "[true]", 6);
+    json_gen_end_object(jstr);
+    json_gen_arr_set_bool(jstr, false);
+    json_gen_pop_array(jstr);
+    json_gen_push_object(jstr, "empty");
+    json_gen_pop_object(jstr);
+    json_gen_end_object(jstr);
+}
+
+static const char gen_expected[] = "{\"name\":\"say \\\"hi\\\"\\n\",\"int\":-1234567,\"int64\":1234567890123,"
+                                   "\"float\":2.5,\"yes\":true,\"none\":null,"
+                                   "\"list\":[1,\"two\",{\"raw\":[true]},false],\"empty\":{}}";
+
+/* Generate a single value in an array into a fixed buffer */
+static const char *gen_value(void (*set)(json_gen_str_t *jstr, void *arg), void *arg)
+{
+    static char buf[128];
+    json_gen_str_t jstr;
+
+    json_gen_str_start(&jstr, buf, sizeof(buf), NULL, NULL);
+    json_gen_start_array(&jstr);
+    set(&jstr, arg);
+    json_gen_end_array(&jstr);
+    if (json_gen_str_end(&jstr) != OS_SUCCESS) {
+        return "(failed)";
+    }
+    return buf;
+}
+
+static void set_string(json_gen_str_t *jstr, void *arg)
+{
+    json_gen_arr_set_string(jstr, arg);
+}
+
+static void set_int(json_gen_str_t *jstr, void *arg)
+{
+    json_gen_arr_set_int(jstr, *(int *) arg);
+}
+
+static void set_int64(json_gen_str_t *jstr, void *arg)
+{
+    json_gen_arr_set_int64(jstr, *(int64_t *) arg);
+}
+
+static void set_float(json_gen_str_t *jstr, void *arg)
+{
+    json_gen_arr_set_float(jstr, *(float *) arg);
+}
+
+static void test_gen_escape()
+{
+    static const struct {
+        const char *in;
+        const char *out;
+    } cases[] = {
+        { "", "[\"\"]" },
+        { "plain / text", "[\"plain / text\"]" },
+        { "\"\\", "[\"\\\"\\\\\"]" },
+        { "a\nb\rc\td\be\ff", "[\"a\\nb\\rc\\td\\be\\ff\"]" },
+        { "\x01x\x1f", "[\"\\u0001x\\u001f\"]" },
+        /* UTF-8 goes through as is */
+        { "caf\xc3\xa9", "[\"caf\xc3\xa9\"]" },
+    };
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const char *out = gen_value(set_string, (void *) cases[i].in);
+        CHECK(strcmp(out, cases[i].out) == 0, "string %d: %s", i, out);
+    }
+    CHECK(strcmp(gen_value(set_string, NULL), "[null]") == 0, "NULL string");
+}
+
+static void test_gen_numbers()
+{
+    static const struct {
+        int in;
+        const char *out;
+    } ints[] = {
+        { 0, "[0]" }, { 7, "[7]" }, { -1, "[-1]" },
+        { INT_MAX, "[2147483647]" }, { INT_MIN, "[-2147483648]" },
+    };
+    static const struct {
+        int64_t in;
+        const char *out;
+    } ints64[] = {
+        { 0, "[0]" }, { 4294967296LL, "[4294967296]" }, { -4294967295LL, "[-4294967295]" },
+        { INT64_MAX, "[9223372036854775807]" }, { INT64_MIN, "[-9223372036854775808]" },
+    };
+    static const struct {
+        float in;
+        const char *out;
+    } floats[] = {
+        { 0, "[0]" }, { -0.0f, "[0]" }, { 1, "[1]" }, { -2.25f, "[-2.25]" },
+        { 0.1f, "[0.1]" }, { 0.000001f, "[0.000001]" }, { 0.0000004f, "[0]" }, { -0.0000004f, "[0]" },
+        { 0.9999996f, "[1]" }, { 16777216.0f, "[16777216]" }, { 1e20f, "[1e+20]" }, { -1e20f, "[-1e+20]" },
+    };
+
+    for (int i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+        const char *out = gen_value(set_int, (void *) &ints[i].in);
+        CHECK(strcmp(out, ints[i].out) == 0, "int %d: %s", ints[i].in, out);
+    }
+    for (int i = 0; i < sizeof(ints64) / sizeof(ints64[0]); i++) {
+        const char *out = gen_value(set_int64, (void *) &ints64[i].in);
+        CHECK(strcmp(out, ints64[i].out) == 0, "int64 %d: %s", i, out);
+    }
+    for (int i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) {
+        const char *out = gen_value(set_float, (void *) &floats[i].in);
+        CHECK(strcmp(out, floats[i].out) == 0, "float %g: %s", floats[i].in, out);
+    }
+    float special[] = { NAN, INFINITY, -INFINITY };
+    for (int i = 0; i < sizeof(special) / sizeof(special[0]); i++) {
+        CHECK(strcmp(gen_value(set_float, &special[i]), "[null]") == 0, "float %g", special[i]);
+    }
+
+    /* Whatever is printed reads back as the same float */
+    for (float f = -1000; f < 1000; f += 0.37f) {
+        jparse_ctx_t jctx;
+        char buf[128];
+        float back = 0;
+        strcpy(buf, gen_value(set_float, &f));
+        CHECK(json_parse_start(&jctx, buf, strlen(buf)) == OS_SUCCESS &&
+              json_arr_get_float(&jctx, 0, &back) == OS_SUCCESS && fabsf(back - f) < 0.000001f,
+              "%.9g printed as %s", f, buf);
+        json_parse_end(&jctx);
+    }
+}
+
+static void test_gen_nesting()
+{
+    char buf[256];
+    char expected[256];
+    json_gen_str_t jstr;
+
+    json_gen_str_start(&jstr, buf, sizeof(buf), NULL, NULL);
+    for (int i = 0; i < JSON_GEN_MAX_DEPTH; i++) {
+        CHECK(json_gen_start_array(&jstr) == OS_SUCCESS, "level %d refused", i + 1);
+        json_gen_arr_set_int(&jstr, i);
+    }
+    for (int i = 0; i < JSON_GEN_MAX_DEPTH; i++) {
+        json_gen_end_array(&jstr);
+    }
+    CHECK(json_gen_str_end(&jstr) == OS_SUCCESS, "%d levels failed", JSON_GEN_MAX_DEPTH);
+
+    int len = 0;
+    for (int i = 0; i < JSON_GEN_MAX_DEPTH; i++) {
+        len += sprintf(expected + len, "%s[%d", i ? "," : "", i);
+    }
+    memset(expected + len, ']', JSON_GEN_MAX_DEPTH);
+    expected[len + JSON_GEN_MAX_DEPTH] = '\0';
+    CHECK(strcmp(buf, expected) == 0, "nested: %s", buf);
+
+    /* One more level fails, and so does everything after it */
+    json_gen_str_start(&jstr, buf, sizeof(buf), NULL, NULL);
+    for (int i = 0; i < JSON_GEN_MAX_DEPTH; i++) {
+        json_gen_start_object(&jstr);
+        json_gen_obj_set_int(&jstr, "a", i);
+        json_gen_push_object(&jstr, "o");
+        json_gen_pop_object(&jstr);
+    }
+    CHECK(json_gen_push_array(&jstr, "deep") != OS_SUCCESS, "level %d accepted", JSON_GEN_MAX_DEPTH + 1);
+    CHECK(json_gen_obj_set_int(&jstr, "late", 1) != OS_SUCCESS, "write after the error accepted");
+    for (int i = 0; i < JSON_GEN_MAX_DEPTH; i++) {
+        json_gen_end_object(&jstr);
+    }
+    CHECK(json_gen_str_end(&jstr) != OS_SUCCESS, "too deep document reported complete");
+
+    /* Unbalanced either way */
+    json_gen_str_start(&jstr, buf, sizeof(buf), NULL, NULL);
+    json_gen_start_object(&jstr);
+    CHECK(json_gen_str_end(&jstr) != OS_SUCCESS, "unclosed object reported complete");
+    json_gen_str_start(&jstr, buf, sizeof(buf), NULL, NULL);
+    CHECK(json_gen_end_array(&jstr) != OS_SUCCESS, "close without open accepted");
+    CHECK(json_gen_str_end(&jstr) != OS_SUCCESS, "close without open reported complete");
+}
+
+static void test_gen_flush()
+{
+    int len = strlen(gen_expected);
+    char buf[GEN_OUT_SIZE];
+    json_gen_str_t jstr;
+
+    /* Every buffer size puts the flush somewhere else, inside names,
+     * escapes and numbers alike */
+    for (int size = 1; size <= len + 1; size++) {
+        gen_out_len = gen_flushes = gen_fail_after = 0;
+        json_gen_str_start(&jstr, buf, size, gen_flush, NULL);
+        gen_doc(&jstr);
+        CHECK(json_gen_str_end(&jstr) == OS_SUCCESS, "size %d: failed", size);
+        CHECK(gen_out_len == len && memcmp(gen_out, gen_expected, len) == 0,
+              "size %d: %.*s", size, gen_out_len, gen_out);
+    }
+
+    /* A failing flush fails the document */
+    gen_out_len = gen_flushes = 0;
+    gen_fail_after = 2;
+    json_gen_str_start(&jstr, buf, 16, gen_flush, NULL);
+    gen_doc(&jstr);
+    CHECK(json_gen_str_end(&jstr) != OS_SUCCESS, "flush failure not reported");
+    CHECK(gen_out_len == 32, "%d bytes out after the failure", gen_out_len);
+    gen_fail_after = 0;
+}
+
+static void test_gen_fixed()
+{
+    int len = strlen(gen_expected);
+    char buf[GEN_OUT_SIZE];
+    json_gen_str_t jstr;
+
+    memset(buf, 'x', sizeof(buf));
+    json_gen_str_start(&jstr, buf, len + 1, NULL, NULL);
+    gen_doc(&jstr);
+    CHECK(json_gen_str_end(&jstr) == OS_SUCCESS, "document with room for the NUL failed");
+    CHECK(json_gen_str_len(&jstr) == len && strcmp(buf, gen_expected) == 0, "fixed: %s", buf);
+
+    /* Fits, but the NUL does not */
+    memset(buf, 'x', sizeof(buf));
+    json_gen_str_start(&jstr, buf, len, NULL, NULL);
+    gen_doc(&jstr);
+    CHECK(json_gen_str_end(&jstr) != OS_SUCCESS, "unterminated document reported complete");
+    CHECK(buf[len] == 'x', "wrote past the buffer");
+
+    memset(buf, 'x', sizeof(buf));
+    json_gen_str_start(&jstr, buf, len - 1, NULL, NULL);
+    gen_doc(&jstr);
+    CHECK(json_gen_str_end(&jstr) != OS_SUCCESS, "truncated document reported complete");
+    CHECK(buf[len - 1] == 'x', "wrote past the buffer");
+
+    /* What comes out parses */
+    jparse_ctx_t jctx;
+    char s[16];
+    int num = 0;
+    json_gen_str_start(&jstr, buf, sizeof(buf), NULL, NULL);
+    gen_doc(&jstr);
+    json_gen_str_end(&jstr);
+    CHECK(json_parse_start(&jctx, buf, json_gen_str_len(&jstr)) == OS_SUCCESS, "does not parse");
+    CHECK(json_obj_get_string(&jctx, "name", s, sizeof(s)) == OS_SUCCESS, "no name");
+    CHECK(json_obj_get_array(&jctx, "list", &num) == OS_SUCCESS && num == 4, "list has %d", num);
+    json_parse_end(&jctx);
+}
+
+int main(int argc, char **argv)
+{
+    test_parse();
+    test_parse_grow();
+    test_parse_invalid();
+    test_gen_escape();
+    test_gen_numbers();
+    test_gen_nesting();
+    test_gen_flush();
+    test_gen_fixed();
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
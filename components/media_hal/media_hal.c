@@ -21,6 +21,7 @@
 #include "esp_log.h"
 #include <media_hal.h>
 #include <media_hal_codec_init.h>
+#include "media_hal_playback.h"
 
 #define HAL_TAG "MEDIA_HAL"
 
@@ -56,6 +57,11 @@ media_hal_t* media_hal_init(media_hal_config_t *media_hal_conf)
         assert(media_hal->media_hal_lock);
         media_hal_codec_init(media_hal, media_hal_conf);
         volume_prv = MEDIA_HAL_VOL_DEFAULT;
+#ifdef CONFIG_MEDIA_HAL_SOFT_VOLUME
+        /* Volume is applied to the samples, see media_hal_playback_set_volume() */
+        media_hal->audio_codec_control_volume(100);
+        media_hal_playback_set_volume(volume_prv);
+#endif
         media_hal_handle = media_hal;
     } else {
         ESP_LOGW(HAL_TAG, "Codec already initialized, returning initialized handle");
@@ -177,6 +183,10 @@ esp_err_t media_hal_control_volume(media_hal_t* media_hal, uint8_t volume)
         return ESP_FAIL;
     }
     volume_prv = volume;
+#ifdef CONFIG_MEDIA_HAL_SOFT_VOLUME
+    media_hal_playback_set_volume(volume);
+    return ESP_OK;
+#else
     esp_err_t ret;
     mutex_lock(media_hal->media_hal_lock);
     if (volume == 0) {
@@ -186,6 +196,7 @@ esp_err_t media_hal_control_volume(media_hal_t* media_hal, uint8_t volume)
     }
     mutex_unlock(media_hal->media_hal_lock);
     return ret;
+#endif
 }
 
 esp_err_t media_hal_set_mute(media_hal_t* media_hal, bool mute)
@@ -199,11 +210,16 @@ esp_err_t media_hal_set_mute(media_hal_t* media_hal, bool mute)
     if (!media_hal) {
         return ESP_FAIL;
     }
+#ifdef CONFIG_MEDIA_HAL_SOFT_VOLUME
+    media_hal_playback_set_mute(mute);
+    return ESP_OK;
+#else
     esp_err_t ret;
     mutex_lock(media_hal->media_hal_lock);
     ret = media_hal->audio_codec_set_mute(mute);
     mutex_unlock(media_hal->media_hal_lock);
     return ret;
+#endif
 }
 
 esp_err_t media_hal_get_volume(media_hal_t* media_hal, uint8_t *volume)
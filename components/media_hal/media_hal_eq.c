@@ -0,0 +1,355 @@
+#include <esp_log.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "media_hal_eq.h"
+
+/* Coefficients are Q28, which covers the +/-4 a peaking filter at +12dB needs */
+#define EQ_COEF_BITS 28
+#define EQ_COEF_ONE (1 << EQ_COEF_BITS)
+#define EQ_ROUND (1 << (EQ_COEF_BITS - 1))
+/* Samples are processed at Q27: int16 << 12 */
+#define EQ_SAMPLE_SHIFT 12
+/* Frames processed per channel and band in one go, coefficients are stepped
+ * once per block while gliding */
+#define EQ_BLOCK_FRAMES 32
+#define EQ_MAX_CHANNELS 2
+#define EQ_RATE_CACHE 2
+
+#define EQ_MIN_FREQ 31.25f
+#define EQ_MAX_FREQ 16000.0f
+
+static const char *TAG = "[media_hal_eq]";
+
+/* a1 and a2 are stored negated, so the filter only adds */
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+} eq_coefs_t;
+
+typedef struct {
+    int32_t x1, x2, y1, y2;
+} eq_state_t;
+
+/* What the coefficients of a band at a sample rate need, whatever the gain */
+typedef struct {
+    int sample_rate;
+    uint32_t last_used;
+    float cos_w0[MEDIA_HAL_EQ_MAX_BANDS];
+    float alpha[MEDIA_HAL_EQ_MAX_BANDS];
+} eq_layout_t;
+
+struct media_hal_eq {
+    int num_bands;
+    float freq[MEDIA_HAL_EQ_MAX_BANDS];
+    float q;
+
+    /* Written by media_hal_eq_set_band_gain(), from any task */
+    int8_t new_gain[MEDIA_HAL_EQ_MAX_BANDS];
+    uint32_t gen;
+
+    /* Owned by the processing task */
+    uint32_t seen_gen;
+    int8_t gain[MEDIA_HAL_EQ_MAX_BANDS];
+    eq_layout_t *layout;
+    eq_coefs_t cur[MEDIA_HAL_EQ_MAX_BANDS];
+    eq_coefs_t target[MEDIA_HAL_EQ_MAX_BANDS];
+    eq_coefs_t step[MEDIA_HAL_EQ_MAX_BANDS];
+    int ramp_blocks;
+    /* Bands that are not flat, or are gliding */
+    uint32_t active;
+    eq_state_t state[EQ_MAX_CHANNELS][MEDIA_HAL_EQ_MAX_BANDS];
+    eq_layout_t cache[EQ_RATE_CACHE];
+    uint32_t use_count;
+    int32_t work[EQ_BLOCK_FRAMES];
+};
+
+static const eq_coefs_t eq_flat = { EQ_COEF_ONE, 0, 0, 0, 0 };
+
+media_hal_eq_t *media_hal_eq_create(int num_bands)
+{
+    if (num_bands <= 0 || num_bands > MEDIA_HAL_EQ_MAX_BANDS) {
+        ESP_LOGE(TAG, "Invalid number of bands %d", num_bands);
+        return NULL;
+    }
+    media_hal_eq_t *eq = calloc(1, sizeof(media_hal_eq_t));
+    if (!eq) {
+        ESP_LOGE(TAG, "Failed to allocate equalizer");
+        return NULL;
+    }
+    eq->num_bands = num_bands;
+    if (num_bands == 1) {
+        eq->freq[0] = 1000.0f;
+        eq->q = 0.7f;
+    } else {
+        /* Bandwidth in octaves, 1 for 10 bands */
+        float bw = log2f(EQ_MAX_FREQ / EQ_MIN_FREQ) / (num_bands - 1);
+        for (int i = 0; i < num_bands; i++) {
+            eq->freq[i] = EQ_MIN_FREQ * exp2f(bw * i);
+        }
+        eq->q = sqrtf(exp2f(bw)) / (exp2f(bw) - 1.0f);
+    }
+    for (int i = 0; i < num_bands; i++) {
+        eq->cur[i] = eq_flat;
+        eq->target[i] = eq_flat;
+    }
+    return eq;
+}
+
+void media_hal_eq_delete(media_hal_eq_t *eq)
+{
+    free(eq);
+}
+
+esp_err_t media_hal_eq_set_band_gain(media_hal_eq_t *eq, int band, int gain_db)
+{
+    if (!eq || band < 0 || band >= eq->num_bands) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (gain_db > MEDIA_HAL_EQ_MAX_GAIN_DB) {
+        gain_db = MEDIA_HAL_EQ_MAX_GAIN_DB;
+    } else if (gain_db < -MEDIA_HAL_EQ_MAX_GAIN_DB) {
+        gain_db = -MEDIA_HAL_EQ_MAX_GAIN_DB;
+    }
+    __atomic_store_n(&eq->new_gain[band], (int8_t) gain_db, __ATOMIC_RELAXED);
+    /* Publishes the gain to the processing task */
+    __atomic_add_fetch(&eq->gen, 1, __ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+int media_hal_eq_get_band_freq(media_hal_eq_t *eq, int band)
+{
+    if (!eq || band < 0 || band >= eq->num_bands) {
+        return 0;
+    }
+    return (int) eq->freq[band];
+}
+
+static eq_layout_t *eq_get_layout(media_hal_eq_t *eq, int sample_rate)
+{
+    eq_layout_t *layout = &eq->cache[0];
+    for (int i = 0; i < EQ_RATE_CACHE; i++) {
+        if (eq->cache[i].sample_rate == sample_rate) {
+            layout = &eq->cache[i];
+            layout->last_used = ++eq->use_count;
+            return layout;
+        }
+        if (eq->cache[i].last_used < layout->last_used) {
+            layout = &eq->cache[i];
+        }
+    }
+
+    layout->sample_rate = sample_rate;
+    layout->last_used = ++eq->use_count;
+    for (int i = 0; i < eq->num_bands; i++) {
+        if (eq->freq[i] >= 0.45f * sample_rate) {
+            /* Too close to Nyquist to do anything useful, stays flat */
+            layout->alpha[i] = 0;
+            continue;
+        }
+        float w0 = 2.0f * (float) M_PI * eq->freq[i] / sample_rate;
+        layout->cos_w0[i] = cosf(w0);
+        layout->alpha[i] = sinf(w0) / (2.0f * eq->q);
+    }
+    return layout;
+}
+
+static int32_t eq_coef(float v)
+{
+    return (int32_t) lrintf(v * EQ_COEF_ONE);
+}
+
+/* Peaking filter, as in the Audio EQ Cookbook. At 0dB this is still the
+ * full filter, with zeros cancelling the poles, so that gliding from or to
+ * 0dB stays a peaking filter all the way. */
+static void eq_calc_coefs(eq_coefs_t *c, const eq_layout_t *layout, int band, int gain_db)
+{
+    float alpha = layout->alpha[band];
+    if (alpha == 0) {
+        *c = eq_flat;
+        return;
+    }
+    float a = powf(10.0f, gain_db / 40.0f);
+    float a0 = 1.0f + alpha / a;
+    c->b0 = eq_coef((1.0f + alpha * a) / a0);
+    c->b1 = eq_coef(-2.0f * layout->cos_w0[band] / a0);
+    c->b2 = eq_coef((1.0f - alpha * a) / a0);
+    c->a1 = -c->b1;
+    c->a2 = eq_coef(-(1.0f - alpha / a) / a0);
+}
+
+/* Zeros cancel the poles exactly */
+static bool eq_is_unity(const eq_coefs_t *c)
+{
+    return c->b0 == EQ_COEF_ONE && c->b1 == -c->a1 && c->b2 == -c->a2;
+}
+
+static void eq_update_active(media_hal_eq_t *eq)
+{
+    uint32_t active = 0;
+    for (int i = 0; i < eq->num_bands; i++) {
+        if (!eq_is_unity(&eq->cur[i]) || !eq_is_unity(&eq->target[i])) {
+            active |= 1 << i;
+        } else if (eq->active & (1 << i)) {
+            /* A unity filter with zeroed history passes its input through
+             * exactly, which is how the band comes back in without a click */
+            for (int ch = 0; ch < EQ_MAX_CHANNELS; ch++) {
+                memset(&eq->state[ch][i], 0, sizeof(eq_state_t));
+            }
+        }
+    }
+    eq->active = active;
+}
+
+static void eq_update(media_hal_eq_t *eq, int sample_rate)
+{
+    uint32_t gen = __atomic_load_n(&eq->gen, __ATOMIC_ACQUIRE);
+    bool rate_changed = !eq->layout || eq->layout->sample_rate != sample_rate;
+
+    if (gen == eq->seen_gen && !rate_changed) {
+        return;
+    }
+    eq->seen_gen = gen;
+    for (int i = 0; i < eq->num_bands; i++) {
+        eq->gain[i] = __atomic_load_n(&eq->new_gain[i], __ATOMIC_RELAXED);
+    }
+    if (rate_changed) {
+        eq->layout = eq_get_layout(eq, sample_rate);
+    }
+    for (int i = 0; i < eq->num_bands; i++) {
+        eq_calc_coefs(&eq->target[i], eq->layout, i, eq->gain[i]);
+    }
+
+    if (rate_changed) {
+        /* New stream, nothing to glide from */
+        memcpy(eq->cur, eq->target, sizeof(eq->cur));
+        memset(eq->state, 0, sizeof(eq->state));
+        eq->ramp_blocks = 0;
+        eq_update_active(eq);
+        return;
+    }
+
+    int blocks = sample_rate * MEDIA_HAL_EQ_RAMP_MS / 1000 / EQ_BLOCK_FRAMES;
+    eq->ramp_blocks = blocks > 0 ? blocks : 1;
+    for (int i = 0; i < eq->num_bands; i++) {
+        eq_coefs_t *c = &eq->cur[i], *t = &eq->target[i], *s = &eq->step[i];
+        s->b0 = (t->b0 - c->b0) / eq->ramp_blocks;
+        s->b1 = (t->b1 - c->b1) / eq->ramp_blocks;
+        s->b2 = (t->b2 - c->b2) / eq->ramp_blocks;
+        s->a1 = (t->a1 - c->a1) / eq->ramp_blocks;
+        s->a2 = (t->a2 - c->a2) / eq->ramp_blocks;
+    }
+    eq_update_active(eq);
+}
+
+static void eq_ramp_step(media_hal_eq_t *eq)
+{
+    if (--eq->ramp_blocks == 0) {
+        /* Land exactly, whatever the rounding of the steps */
+        memcpy(eq->cur, eq->target, sizeof(eq->cur));
+        eq_update_active(eq);
+        return;
+    }
+    for (int i = 0; i < eq->num_bands; i++) {
+        eq_coefs_t *c = &eq->cur[i], *s = &eq->step[i];
+        c->b0 += s->b0;
+        c->b1 += s->b1;
+        c->b2 += s->b2;
+        c->a1 += s->a1;
+        c->a2 += s->a2;
+    }
+}
+
+/* Direct form I over one block, with the history and coefficients held in
+ * registers across the loop. Each tap is a MULL/MULSH pair into a 64 bit
+ * accumulator, rounded once per sample: rounding every product instead is
+ * cheaper, but the poles of the low bands amplify that noise by ~60dB. */
+static void eq_biquad_block(int32_t *x, int n, const eq_coefs_t *c, eq_state_t *st)
+{
+    int32_t b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+    int32_t x1 = st->x1, x2 = st->x2, y1 = st->y1, y2 = st->y2;
+
+    for (int i = 0; i < n; i++) {
+        int32_t in = x[i];
+        int64_t acc = (int64_t) b0 * in + (int64_t) b1 * x1 + (int64_t) b2 * x2 +
+                      (int64_t) a1 * y1 + (int64_t) a2 * y2;
+        int32_t out = (int32_t) ((acc + EQ_ROUND) >> EQ_COEF_BITS);
+        x2 = x1;
+        x1 = in;
+        y2 = y1;
+        y1 = out;
+        x[i] = out;
+    }
+    st->x1 = x1;
+    st->x2 = x2;
+    st->y1 = y1;
+    st->y2 = y2;
+}
+
+/* Straight from the difference equation */
+static void eq_biquad_block_reference(int32_t *x, int n, const eq_coefs_t *c, eq_state_t *st)
+{
+    for (int i = 0; i < n; i++) {
+        int64_t acc = (int64_t) c->b0 * x[i] + (int64_t) c->b1 * st->x1 + (int64_t) c->b2 * st->x2 +
+                      (int64_t) c->a1 * st->y1 + (int64_t) c->a2 * st->y2;
+        int32_t out = (int32_t) ((acc + EQ_ROUND) >> EQ_COEF_BITS);
+        st->x2 = st->x1;
+        st->x1 = x[i];
+        st->y2 = st->y1;
+        st->y1 = out;
+        x[i] = out;
+    }
+}
+
+typedef void (*eq_block_fn_t)(int32_t *x, int n, const eq_coefs_t *c, eq_state_t *st);
+
+static int eq_process(media_hal_eq_t *eq, int16_t *buf, int len, int sample_rate, int channels,
+                      eq_block_fn_t block_fn)
+{
+    if (!eq || channels < 1 || channels > EQ_MAX_CHANNELS || sample_rate <= 0) {
+        return 0;
+    }
+    eq_update(eq, sample_rate);
+
+    int frames = len / (2 * channels);
+    for (int done = 0; done < frames; done += EQ_BLOCK_FRAMES) {
+        int n = frames - done < EQ_BLOCK_FRAMES ? frames - done : EQ_BLOCK_FRAMES;
+        if (eq->ramp_blocks) {
+            eq_ramp_step(eq);
+        }
+        if (!eq->active) {
+            continue;
+        }
+        int16_t *block = buf + done * channels;
+        for (int ch = 0; ch < channels; ch++) {
+            for (int i = 0; i < n; i++) {
+                eq->work[i] = (int32_t) block[i * channels + ch] << EQ_SAMPLE_SHIFT;
+            }
+            for (int band = 0; band < eq->num_bands; band++) {
+                if (eq->active & (1 << band)) {
+                    block_fn(eq->work, n, &eq->cur[band], &eq->state[ch][band]);
+                }
+            }
+            for (int i = 0; i < n; i++) {
+                int32_t v = (eq->work[i] + (1 << (EQ_SAMPLE_SHIFT - 1))) >> EQ_SAMPLE_SHIFT;
+                if (v > INT16_MAX) {
+                    v = INT16_MAX;
+                } else if (v < INT16_MIN) {
+                    v = INT16_MIN;
+                }
+                block[i * channels + ch] = v;
+            }
+        }
+    }
+    return frames * 2 * channels;
+}
+
+int media_hal_eq_process(media_hal_eq_t *eq, int16_t *buf, int len, int sample_rate, int channels)
+{
+    return eq_process(eq, buf, len, sample_rate, channels, eq_biquad_block);
+}
+
+int media_hal_eq_process_reference(media_hal_eq_t *eq, int16_t *buf, int len, int sample_rate, int channels)
+{
+    return eq_process(eq, buf, len, sample_rate, channels, eq_biquad_block_reference);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+/**
+ * Cascaded biquad equalizer.
+ *
+ * One peaking filter per band, with centers log spaced from 31.25Hz to 16KHz,
+ * which for 10 bands are the usual octave bands. Everything runs in fixed
+ * point: samples are processed at Q27, which leaves 24dB of headroom, with
+ * Q28 coefficients. Bands at 0dB are skipped, so a flat equalizer costs
+ * next to nothing.
+ *
+ * Gains can be changed from any task while audio is being processed, without
+ * locking. The processing side picks the change up at its next block and
+ * glides the coefficients to the new ones over `MEDIA_HAL_EQ_RAMP_MS`, so a
+ * change does not click.
+ *
+ * Coefficients are cached per sample rate, a stream at another rate than the
+ * previous one does not need them to be recomputed.
+ */
+
+#define MEDIA_HAL_EQ_MAX_BANDS      16
+/** Gains are clamped to +/- this many dB */
+#define MEDIA_HAL_EQ_MAX_GAIN_DB    12
+#define MEDIA_HAL_EQ_RAMP_MS        20
+
+typedef struct media_hal_eq media_hal_eq_t;
+
+/**
+ * Create an equalizer with `num_bands` bands, all at 0dB.
+ *
+ * Return: Equalizer handle, NULL on error.
+ */
+media_hal_eq_t *media_hal_eq_create(int num_bands);
+
+/**
+ * Delete an equalizer.
+ *
+ * Must not be called while the equalizer is processing.
+ */
+void media_hal_eq_delete(media_hal_eq_t *eq);
+
+/**
+ * Set the gain of a band.
+ *
+ * Can be called from any task, also while processing.
+ *
+ * Return: ESP_OK on success, ESP_ERR_INVALID_ARG if there is no such band.
+ */
+esp_err_t media_hal_eq_set_band_gain(media_hal_eq_t *eq, int band, int gain_db);
+
+/**
+ * Get the center frequency of a band in Hz.
+ */
+int media_hal_eq_get_band_freq(media_hal_eq_t *eq, int band);
+
+/**
+ * Equalize 16 bit interleaved audio in place.
+ *
+ * Only one task may process through an equalizer.
+ *
+ * Return: Number of bytes processed.
+ */
+int media_hal_eq_process(media_hal_eq_t *eq, int16_t *buf, int len, int sample_rate, int channels);
+
+/**
+ * Same as `media_hal_eq_process`, with the filter written plainly.
+ *
+ * Portable reference for the optimized inner loop. Both give bit exact
+ * results, see test_host.
+ */
+int media_hal_eq_process_reference(media_hal_eq_t *eq, int16_t *buf, int len, int sample_rate, int channels);
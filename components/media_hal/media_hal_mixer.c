@@ -0,0 +1,440 @@
+#include <esp_log.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <resampling.h>
+#include <ringbuf.h>
+#include "media_hal_mixer.h"
+
+#define MIXER_MAX_INPUTS 4
+/* Output is always 16 bit stereo, as with media_hal_playback */
+#define MIXER_FRAME_BYTES 4
+/* Frames mixed per round */
+#define MIXER_PERIOD_FRAMES 256
+#define MIXER_IDLE_WAIT_MS 10
+#define MIXER_TASK_STACK (3 * 1024)
+/* Around 20ms at 48kHz, all of which is still heard after a stop unless
+ * the input is flushed */
+#define MIXER_DEFAULT_BUF_SIZE (4 * 1024)
+#define CONVERT_BUF_SIZE 1024
+
+/* Gains are Q16, 65536 being unity */
+#define GAIN_ONE (1 << 16)
+#define GAIN_FROM_PCT(x) (((x) * GAIN_ONE) / 100)
+
+/* An input that ducks others and runs dry stops doing so after this long,
+ * unless marked done earlier */
+#define DUCK_HOLD_MS 300
+
+struct media_hal_mixer_input {
+    const char *name;
+    bool ducks_others;
+    ringbuf_t *rb;
+    audio_resample_config_t resample;
+    short *convert_buf;
+    /* Input of other sample widths, made 16 bit */
+    short *pcm_buf;
+
+    /* Written by the producer */
+    volatile bool active;
+    volatile bool done;
+
+    /* Gain applied by the mixer task */
+    int32_t user_gain;
+    int32_t gain;
+    int32_t target;
+    int32_t step;
+    int ramp_left;
+    int ramp_ms;
+    TickType_t idle_since;
+};
+
+static const char *TAG = "[media_hal_mixer]";
+
+static struct {
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+    volatile bool run;
+    int sample_rate;
+    media_hal_mixer_input_t *inputs[MIXER_MAX_INPUTS];
+    media_hal_mixer_input_t *main_input;
+    int32_t duck_gain;
+    int duck_ms;
+    int restore_ms;
+    bool ducking;
+    int32_t acc[MIXER_PERIOD_FRAMES * 2];
+    int16_t buf[MIXER_PERIOD_FRAMES * 2];
+} mixer = {
+    .duck_gain = GAIN_FROM_PCT(25),
+    .duck_ms = 50,
+    .restore_ms = 300,
+};
+
+static void mixer_start_ramp(media_hal_mixer_input_t *in, int32_t target, int ramp_ms)
+{
+    int frames = (int) ((int64_t) mixer.sample_rate * ramp_ms / 1000);
+    in->target = target;
+    if (frames <= 0) {
+        in->gain = target;
+        in->ramp_left = 0;
+        return;
+    }
+    in->step = (target - in->gain) / frames;
+    in->ramp_left = frames;
+}
+
+static inline void mixer_ramp_advance(media_hal_mixer_input_t *in, int frames)
+{
+    if (in->ramp_left <= frames) {
+        in->gain = in->target;
+        in->ramp_left = 0;
+    } else {
+        in->gain += in->step * frames;
+        in->ramp_left -= frames;
+    }
+}
+
+/* Accumulate `frames` frames of an input, fading sample by sample */
+static void mixer_accumulate(media_hal_mixer_input_t *in, const int16_t *samples, int frames)
+{
+    int32_t *acc = mixer.acc;
+
+    for (int i = 0; i < frames; i++) {
+        if (in->ramp_left) {
+            mixer_ramp_advance(in, 1);
+        }
+        int32_t g = in->gain;
+        acc[2 * i] += ((int32_t) samples[2 * i] * g) >> 16;
+        acc[2 * i + 1] += ((int32_t) samples[2 * i + 1] * g) >> 16;
+    }
+}
+
+static void mixer_update_gains(media_hal_mixer_input_t *in, bool ducking)
+{
+    int32_t target = in->user_gain;
+    if (ducking && !in->ducks_others) {
+        target = (int32_t) (((int64_t) target * mixer.duck_gain) >> 16);
+    }
+    if (target != in->target) {
+        int ramp_ms = in->ramp_ms;
+        if (ducking != mixer.ducking) {
+            ramp_ms = ducking ? mixer.duck_ms : mixer.restore_ms;
+        }
+        mixer_start_ramp(in, target, ramp_ms);
+    }
+}
+
+/* Inputs that have nothing buffered sit the round out. Fades go on, and an
+ * input that ducks others stops doing so once it has been dry long enough */
+static void mixer_input_idle(media_hal_mixer_input_t *in)
+{
+    mixer_ramp_advance(in, MIXER_PERIOD_FRAMES);
+    if (in->active) {
+        TickType_t now = xTaskGetTickCount();
+        if (!in->idle_since) {
+            in->idle_since = now;
+        }
+        if (in->done || (now - in->idle_since) >= DUCK_HOLD_MS / portTICK_PERIOD_MS) {
+            in->active = false;
+            in->idle_since = 0;
+        }
+    }
+}
+
+/* Returns number of frames mixed */
+static int mixer_mix_round()
+{
+    int16_t *samples = mixer.buf;
+    int frames = MIXER_PERIOD_FRAMES;
+    int num_playing = 0;
+    bool playing[MIXER_MAX_INPUTS] = { false };
+    bool ducking = false;
+
+    xSemaphoreTake(mixer.lock, portMAX_DELAY);
+    for (int i = 0; i < MIXER_MAX_INPUTS; i++) {
+        media_hal_mixer_input_t *in = mixer.inputs[i];
+        if (!in) {
+            continue;
+        }
+        if (in->ducks_others && in->active) {
+            ducking = true;
+        }
+        /* Only mix as much as every input with data can supply, the rest
+         * stays buffered for the next round instead of an input getting
+         * silence for the remainder of the period */
+        int avail = rb_filled(in->rb) / MIXER_FRAME_BYTES;
+        if (avail > 0) {
+            playing[i] = true;
+            num_playing++;
+            if (avail < frames) {
+                frames = avail;
+            }
+        }
+    }
+    if (ducking != mixer.ducking) {
+        ESP_LOGI(TAG, "%s", ducking ? "Ducking" : "Restoring");
+    }
+    if (!num_playing) {
+        frames = 0;
+    }
+
+    memset(mixer.acc, 0, frames * 2 * sizeof(int32_t));
+    for (int i = 0; i < MIXER_MAX_INPUTS; i++) {
+        media_hal_mixer_input_t *in = mixer.inputs[i];
+        if (!in) {
+            continue;
+        }
+        mixer_update_gains(in, ducking);
+        if (!playing[i] || rb_read(in->rb, (uint8_t *) samples, frames * MIXER_FRAME_BYTES, 0) <= 0) {
+            mixer_input_idle(in);
+            continue;
+        }
+        in->idle_since = 0;
+        mixer_accumulate(in, samples, frames);
+    }
+    mixer.ducking = ducking;
+    xSemaphoreGive(mixer.lock);
+
+    /* Saturate */
+    for (int i = 0; i < frames * 2; i++) {
+        int32_t s = mixer.acc[i];
+        samples[i] = s > INT16_MAX ? INT16_MAX : (s < INT16_MIN ? INT16_MIN : s);
+    }
+    return frames;
+}
+
+static void mixer_task(void *arg)
+{
+    while (mixer.run) {
+        int frames = mixer_mix_round();
+        if (frames == 0) {
+            vTaskDelay(MIXER_IDLE_WAIT_MS / portTICK_PERIOD_MS);
+            continue;
+        }
+        /* Paced by the writer */
+        media_hal_playback_write(mixer.buf, frames * MIXER_FRAME_BYTES);
+    }
+    mixer.task = NULL;
+    vTaskDelete(NULL);
+}
+
+media_hal_mixer_input_t *media_hal_mixer_add_input(const media_hal_mixer_input_cfg_t *cfg)
+{
+    if (!mixer.lock || !cfg) {
+        return NULL;
+    }
+    media_hal_mixer_input_t *in = calloc(1, sizeof(media_hal_mixer_input_t));
+    if (!in) {
+        return NULL;
+    }
+    in->name = cfg->name;
+    in->ducks_others = cfg->ducks_others;
+    in->user_gain = in->gain = in->target = GAIN_ONE;
+    in->rb = rb_init((char *) cfg->name, cfg->buf_size ? cfg->buf_size : MIXER_DEFAULT_BUF_SIZE);
+    in->convert_buf = malloc(CONVERT_BUF_SIZE * 2);
+    in->pcm_buf = malloc(CONVERT_BUF_SIZE / 2);
+    if (!in->rb || !in->convert_buf || !in->pcm_buf) {
+        ESP_LOGE(TAG, "Failed to allocate input %s", cfg->name);
+        goto err;
+    }
+
+    xSemaphoreTake(mixer.lock, portMAX_DELAY);
+    for (int i = 0; i < MIXER_MAX_INPUTS; i++) {
+        if (!mixer.inputs[i]) {
+            mixer.inputs[i] = in;
+            xSemaphoreGive(mixer.lock);
+            return in;
+        }
+    }
+    xSemaphoreGive(mixer.lock);
+    ESP_LOGE(TAG, "No free input for %s", cfg->name);
+
+err:
+    if (in->rb) {
+        rb_cleanup(in->rb);
+    }
+    free(in->convert_buf);
+    free(in->pcm_buf);
+    free(in);
+    return NULL;
+}
+
+void media_hal_mixer_remove_input(media_hal_mixer_input_t *in)
+{
+    if (!in || !mixer.lock) {
+        return;
+    }
+    /* Unblock the producer */
+    rb_abort(in->rb);
+    xSemaphoreTake(mixer.lock, portMAX_DELAY);
+    for (int i = 0; i < MIXER_MAX_INPUTS; i++) {
+        if (mixer.inputs[i] == in) {
+            mixer.inputs[i] = NULL;
+        }
+    }
+    xSemaphoreGive(mixer.lock);
+    rb_cleanup(in->rb);
+    free(in->convert_buf);
+    free(in->pcm_buf);
+    free(in);
+}
+
+/* Same as i2s_write_expand() takes them: 8 bit samples are signed, and
+ * 32 bit ones keep their high half */
+static void mixer_to_16bit(short *dst, const void *src, int samples, int bytes_per_sample)
+{
+    if (bytes_per_sample == 1) {
+        const int8_t *s8 = src;
+        for (int i = 0; i < samples; i++) {
+            dst[i] = (short) (s8[i] * 256);
+        }
+    } else {
+        const int32_t *s32 = src;
+        for (int i = 0; i < samples; i++) {
+            dst[i] = (short) (s32[i] >> 16);
+        }
+    }
+}
+
+int media_hal_mixer_write(media_hal_mixer_input_t *in, media_hal_audio_info_t *audio_info, void *buf, int len)
+{
+    int block_len, consumed = 0;
+    int bytes_per_sample = audio_info->bits_per_sample / 8;
+
+    if (!in) {
+        in = mixer.main_input;
+    }
+    if (!in) {
+        return -1;
+    }
+    if (bytes_per_sample != 1 && bytes_per_sample != 2 && bytes_per_sample != 4) {
+        ESP_LOGE(TAG, "%d bit audio not supported", audio_info->bits_per_sample);
+        return -1;
+    }
+    /* Samples per block. Mono is doubled up after resampling, so leave room for it */
+    block_len = audio_info->channels == 1 ? CONVERT_BUF_SIZE / 8 : CONVERT_BUF_SIZE / 4;
+
+    in->done = false;
+    in->active = true;
+    while (consumed < len) {
+        int cur = (len - consumed) < block_len * bytes_per_sample ? (len - consumed) : block_len * bytes_per_sample;
+        short *pcm = (short *) ((char *) buf + consumed);
+        if (bytes_per_sample != 2) {
+            mixer_to_16bit(in->pcm_buf, pcm, cur / bytes_per_sample, bytes_per_sample);
+            pcm = in->pcm_buf;
+        }
+        int conv_len = audio_resample(pcm, in->convert_buf, audio_info->sample_rate, mixer.sample_rate,
+                                      cur / bytes_per_sample, CONVERT_BUF_SIZE, audio_info->channels, &in->resample);
+        if (audio_info->channels == 1) {
+            conv_len = audio_resample_up_channel(in->convert_buf, in->convert_buf, mixer.sample_rate,
+                                                 mixer.sample_rate, conv_len, CONVERT_BUF_SIZE, &in->resample);
+        }
+        if (rb_write(in->rb, (uint8_t *) in->convert_buf, conv_len * 2, portMAX_DELAY) < 0) {
+            return consumed ? consumed : -1;
+        }
+        consumed += cur;
+    }
+    return consumed;
+}
+
+void media_hal_mixer_input_flush(media_hal_mixer_input_t *in)
+{
+    if (!in) {
+        in = mixer.main_input;
+    }
+    if (!in || !mixer.lock) {
+        return;
+    }
+    xSemaphoreTake(mixer.lock, portMAX_DELAY);
+    rb_reset(in->rb);
+    /* rb_reset() leaves a producer waiting on the full ring asleep */
+    xSemaphoreGive(in->rb->can_write);
+    memset(&in->resample, 0, sizeof(in->resample));
+    /* Nothing left to duck others for */
+    in->active = false;
+    in->idle_since = 0;
+    xSemaphoreGive(mixer.lock);
+}
+
+void media_hal_mixer_input_done(media_hal_mixer_input_t *in)
+{
+    if (in) {
+        in->done = true;
+    }
+}
+
+void media_hal_mixer_set_gain(media_hal_mixer_input_t *in, int gain, int ramp_ms)
+{
+    if (!in || !mixer.lock) {
+        return;
+    }
+    gain = gain < 0 ? 0 : (gain > 100 ? 100 : gain);
+    xSemaphoreTake(mixer.lock, portMAX_DELAY);
+    in->user_gain = GAIN_FROM_PCT(gain);
+    in->ramp_ms = ramp_ms;
+    xSemaphoreGive(mixer.lock);
+}
+
+void media_hal_mixer_set_ducking(int gain, int duck_ms, int restore_ms)
+{
+    gain = gain < 0 ? 0 : (gain > 100 ? 100 : gain);
+    mixer.duck_gain = GAIN_FROM_PCT(gain);
+    mixer.duck_ms = duck_ms;
+    mixer.restore_ms = restore_ms;
+}
+
+bool media_hal_mixer_is_running()
+{
+    return mixer.run;
+}
+
+esp_err_t media_hal_mixer_start(int task_priority)
+{
+    if (mixer.run) {
+        return ESP_OK;
+    }
+    mixer.sample_rate = media_hal_playback_get_sample_rate();
+    if (mixer.sample_rate <= 0) {
+        ESP_LOGE(TAG, "Playback not initialized");
+        return ESP_FAIL;
+    }
+    if (!mixer.lock) {
+        mixer.lock = xSemaphoreCreateMutex();
+        if (!mixer.lock) {
+            return ESP_FAIL;
+        }
+    }
+
+    media_hal_mixer_input_cfg_t cfg = {
+        .name = "mix_main",
+    };
+    mixer.main_input = media_hal_mixer_add_input(&cfg);
+    if (!mixer.main_input) {
+        return ESP_FAIL;
+    }
+
+    mixer.run = true;
+    if (xTaskCreate(mixer_task, "mixer", MIXER_TASK_STACK, NULL, task_priority, &mixer.task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create mixer task");
+        mixer.run = false;
+        media_hal_mixer_remove_input(mixer.main_input);
+        mixer.main_input = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void media_hal_mixer_stop()
+{
+    if (!mixer.run) {
+        return;
+    }
+    mixer.run = false;
+    while (mixer.task) {
+        vTaskDelay(MIXER_IDLE_WAIT_MS / portTICK_PERIOD_MS);
+    }
+    media_hal_mixer_remove_input(mixer.main_input);
+    mixer.main_input = NULL;
+}
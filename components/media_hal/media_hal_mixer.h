@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdbool.h>
+#include <esp_err.h>
+#include "media_hal_playback.h"
+
+/**
+ * Software mixer in front of the playback writer.
+ *
+ * Every source (music, TTS, alerts...) gets an input. Inputs take data in
+ * their own format, which is converted to the playback sample rate (16 bit
+ * stereo) as it is written. A mixer task sums all inputs with per-input
+ * gains, saturates the result and hands it to the playback writer and
+ * equalizer set up through `media_hal_init_playback`.
+ *
+ * While an input created with `ducks_others` plays, all other inputs are
+ * faded down to the ducking level, and faded back up once it is drained.
+ * Fades are ramped per sample. A ducked source keeps playing from its own
+ * buffer, so nothing needs to be stopped, re-fetched or re-buffered around
+ * a prompt.
+ *
+ * Once started, `media_hal_playback` feeds the main input of the mixer.
+ * With CONFIG_MEDIA_HAL_MIXER, `media_hal_init_playback` starts it.
+ */
+
+#define MEDIA_HAL_MIXER_TASK_PRIORITY 5
+
+typedef struct media_hal_mixer_input media_hal_mixer_input_t;
+
+typedef struct {
+    const char *name;
+    /** Bytes of converted audio buffered, 0 for default */
+    int buf_size;
+    /** Duck the other inputs while this one plays (TTS, alerts) */
+    bool ducks_others;
+} media_hal_mixer_input_cfg_t;
+
+/**
+ * Start the mixer.
+ *
+ * Must be called after `media_hal_init_playback`.
+ *
+ * Return: ESP_OK on success, ESP_FAIL on error.
+ */
+esp_err_t media_hal_mixer_start(int task_priority);
+
+/**
+ * Stop the mixer.
+ *
+ * Inputs other than the main one must have been removed.
+ */
+void media_hal_mixer_stop();
+
+/**
+ * Check whether the mixer is running.
+ */
+bool media_hal_mixer_is_running();
+
+/**
+ * Add an input to the mixer.
+ *
+ * Return: Input handle, NULL on error.
+ */
+media_hal_mixer_input_t *media_hal_mixer_add_input(const media_hal_mixer_input_cfg_t *cfg);
+
+/**
+ * Remove an input from the mixer.
+ *
+ * Any buffered audio of the input is dropped.
+ */
+void media_hal_mixer_remove_input(media_hal_mixer_input_t *input);
+
+/**
+ * Write data to an input.
+ *
+ * Blocks while the input buffer is full. `input` NULL selects the main input.
+ *
+ * 8, 16 and 32 bit samples are taken, as by the playback writer.
+ *
+ * Return: Number of bytes consumed from `buf`, -1 on error.
+ */
+int media_hal_mixer_write(media_hal_mixer_input_t *input, media_hal_audio_info_t *audio_info, void *buf, int len);
+
+/**
+ * Drop the audio buffered by an input.
+ *
+ * For stop, pause or barge-in, so that what was buffered is not heard
+ * afterwards. A producer blocked on the full buffer is let go, the rest of
+ * its current write still goes in. `input` NULL selects the main input.
+ */
+void media_hal_mixer_input_flush(media_hal_mixer_input_t *input);
+
+/**
+ * Mark the end of the current content of an input.
+ *
+ * An input ducking others stops doing so as soon as it has been drained,
+ * instead of after a short idle time.
+ */
+void media_hal_mixer_input_done(media_hal_mixer_input_t *input);
+
+/**
+ * Set the gain of an input.
+ *
+ * @param gain     Gain in percent (0-100)
+ * @param ramp_ms  Fade time to the new gain
+ */
+void media_hal_mixer_set_gain(media_hal_mixer_input_t *input, int gain, int ramp_ms);
+
+/**
+ * Configure ducking.
+ *
+ * @param gain        Gain of ducked inputs in percent (default 25)
+ * @param duck_ms     Fade time down to the ducking level (default 50)
+ * @param restore_ms  Fade time back up (default 300)
+ */
+void media_hal_mixer_set_ducking(int gain, int duck_ms, int restore_ms);
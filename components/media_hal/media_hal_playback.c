@@ -1,9 +1,14 @@
 #include <esp_log.h>
+#include <math.h>
 #include <string.h>
 #include <resampling.h>
 #include <audio_board.h>
 #include <esp_equalizer.h>
 #include "media_hal_playback.h"
+#include "media_hal_mixer.h"
+#include "media_hal_eq.h"
+#include <va_trace.h>
+#include <va_latency.h>
 
 #define POP_NOISE_FIX
 
@@ -11,7 +16,13 @@
 #define BUF_SZ (CONVERT_BUF_SIZE * 2)
 static uint8_t convert_buf[BUF_SZ];
 
+#ifdef CONFIG_MEDIA_HAL_LIB_EQUALIZER
 static void *eq_handle = NULL; /* equalizer handle */
+#else
+/* Never freed once created, so processing needs no lock */
+static media_hal_eq_t *eq_handle = NULL;
+static volatile bool eq_enabled;
+#endif
 static xSemaphoreHandle eq_mutex = NULL; /* To protect eq_handle */
 
 static media_hal_playback_cfg_t playback_cfg;
@@ -19,11 +30,51 @@ static media_hal_playback_cfg_t playback_cfg;
 static const char *TAG = "[media_hal_playback]";
 static bool first_sound_flag = false;
 
+/* Gains are Q16, 65536 being unity */
+#define GAIN_ONE (1 << 16)
+/* 1% of volume is this far below 100% */
+#define VOLUME_RANGE_DB 50
+#define VOLUME_RAMP_MS 10
+
+/**
+ * Parameters of the playback kernel. Control paths publish them under a
+ * seqlock, and the kernel takes a consistent copy at the start of every
+ * block: setting them never waits for playback, and playback never waits.
+ */
+typedef struct {
+    int volume;
+    bool mute;
+    /* Of the volume, worked out by the writer */
+    int32_t gain;
+} playback_params_t;
+
+static struct {
+    uint32_t seq;
+    playback_params_t p;
+} params = {
+    .p = { .volume = 100, .gain = GAIN_ONE },
+};
+/* Serializes writers only */
+static portMUX_TYPE params_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Owned by the kernel */
+static struct {
+    int32_t gain;
+    int32_t target;
+    int32_t step;
+    int ramp_left;
+} gain_state = {
+    .gain = GAIN_ONE,
+    .target = GAIN_ONE,
+};
+
 static int default_write_callback(int port_num, void *buf, size_t len, int src_bps, int dst_pbs)
 {
     unsigned int sent_len = 0;
     if (dst_pbs == src_bps) {
+        VA_TRACE_BEGIN("i2s_write", len);
         i2s_write((i2s_port_t) port_num, (char *) buf, len, &sent_len, portMAX_DELAY);
+        VA_TRACE_END("i2s_write", sent_len);
     } else {
         if (dst_pbs > src_bps) {
             if (dst_pbs % src_bps != 0) {
@@ -34,11 +85,15 @@ static int default_write_callback(int port_num, void *buf, size_t len, int src_b
             ESP_LOGE(TAG, "destination bits need to greater then and multiple of source bits");
             return -1;
         }
+        VA_TRACE_BEGIN("i2s_write", len);
         i2s_write_expand((i2s_port_t) port_num, (char *) buf, len, src_bps, dst_pbs, &sent_len, portMAX_DELAY);
+        VA_TRACE_END("i2s_write", sent_len);
     }
+    va_latency_mark(VA_LATENCY_AUDIO_OUT);
     return sent_len;
 }
 
+#ifdef CONFIG_MEDIA_HAL_LIB_EQUALIZER
 static int default_equalizer_callback(char *buffer, int len, int sample_rate, int channels)
 {
     int ret = 0;
@@ -50,6 +105,57 @@ static int default_equalizer_callback(char *buffer, int len, int sample_rate, in
     return ret;
 }
 
+static void *equalizer_create()
+{
+    return esp_equalizer_init(playback_cfg.channels, playback_cfg.sample_rate, MEDIA_HAL_EQ_BANDS /* number of bands */, true);
+}
+
+static void equalizer_set_band_vals(const int8_t *gain_vals)
+{
+    for (int i = 0; i < MEDIA_HAL_EQ_BANDS; i++) { /* 10 bands */
+        /* For two channels */
+        esp_equalizer_set_band_value(eq_handle, gain_vals[i], i, 0);
+        esp_equalizer_set_band_value(eq_handle, gain_vals[i], i, 1);
+    }
+}
+
+static void equalizer_destroy()
+{
+    esp_equalizer_deinit(eq_handle);
+    eq_handle = NULL;
+}
+#else
+static int default_equalizer_callback(char *buffer, int len, int sample_rate, int channels)
+{
+    if (!eq_enabled) {
+        return 0;
+    }
+    return media_hal_eq_process(eq_handle, (int16_t *) buffer, len, sample_rate, channels);
+}
+
+static media_hal_eq_t *equalizer_create()
+{
+    return media_hal_eq_create(MEDIA_HAL_EQ_BANDS);
+}
+
+static void equalizer_set_band_vals(const int8_t *gain_vals)
+{
+    for (int i = 0; i < MEDIA_HAL_EQ_BANDS; i++) {
+        media_hal_eq_set_band_gain(eq_handle, i, gain_vals[i]);
+    }
+}
+
+static void equalizer_destroy()
+{
+    /* Playback may be in the middle of processing. Keep the equalizer, and
+     * have it start from flat next time. */
+    eq_enabled = false;
+    for (int i = 0; i < MEDIA_HAL_EQ_BANDS; i++) {
+        media_hal_eq_set_band_gain(eq_handle, i, 0);
+    }
+}
+#endif
+
 esp_err_t media_hal_equalizer_set_band_vals(const int8_t *gain_vals)
 {
     if (__builtin_expect(playback_cfg.equalizer_callback != default_equalizer_callback, false)) {
@@ -62,11 +168,7 @@ esp_err_t media_hal_equalizer_set_band_vals(const int8_t *gain_vals)
         xSemaphoreGive(eq_mutex);
         return ESP_FAIL;
     }
-    for (int i = 0; i < MEDIA_HAL_EQ_BANDS; i++) { /* 10 bands */
-        /* For two channels */
-        esp_equalizer_set_band_value(eq_handle, gain_vals[i], i, 0);
-        esp_equalizer_set_band_value(eq_handle, gain_vals[i], i, 1);
-    }
+    equalizer_set_band_vals(gain_vals);
     xSemaphoreGive(eq_mutex);
     return ESP_OK;
 }
@@ -92,13 +194,16 @@ esp_err_t media_hal_enable_equalizer()
     esp_err_t ret = ESP_OK;
     xSemaphoreTake(eq_mutex, portMAX_DELAY);
     if (!eq_handle) {
-        eq_handle = esp_equalizer_init(playback_cfg.channels, playback_cfg.sample_rate, MEDIA_HAL_EQ_BANDS /* number of bands */, true);
+        eq_handle = equalizer_create();
     }
     if (!eq_handle) {
-        ESP_LOGE(TAG, "esp_equalizer_init failed.");
+        ESP_LOGE(TAG, "Equalizer init failed.");
         xSemaphoreGive(eq_mutex);
         ret = ESP_FAIL;
     }
+#ifndef CONFIG_MEDIA_HAL_LIB_EQUALIZER
+    eq_enabled = eq_handle != NULL;
+#endif
     xSemaphoreGive(eq_mutex);
     return ret;
 }
@@ -112,13 +217,104 @@ void media_hal_disable_equalizer()
     xSemaphoreTake(eq_mutex, portMAX_DELAY);
     if (!eq_handle) {
         ESP_LOGW(TAG, "EQ not initialized yet");
+    } else {
+        equalizer_destroy();
     }
-    esp_equalizer_deinit(eq_handle);
-    eq_handle = NULL;
     playback_cfg.equalizer_callback = NULL;
     xSemaphoreGive(eq_mutex);
 }
 
+static void playback_params_write_begin()
+{
+    portENTER_CRITICAL(&params_lock);
+    __atomic_store_n(&params.seq, params.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void playback_params_write_end()
+{
+    __atomic_store_n(&params.seq, params.seq + 1, __ATOMIC_RELEASE);
+    portEXIT_CRITICAL(&params_lock);
+}
+
+static void playback_params_read(playback_params_t *p)
+{
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&params.seq, __ATOMIC_ACQUIRE);
+        *p = *(volatile playback_params_t *) &params.p;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(&params.seq, __ATOMIC_RELAXED));
+}
+
+static int32_t volume_to_gain(int volume)
+{
+    if (volume <= 0) {
+        return 0;
+    }
+    return (int32_t) (GAIN_ONE * powf(10.0f, (float) (volume - 100) * VOLUME_RANGE_DB / 100 / 20));
+}
+
+void media_hal_playback_set_volume(int volume)
+{
+    if (volume < 0) {
+        volume = 0;
+    } else if (volume > 100) {
+        volume = 100;
+    }
+    int32_t gain = volume_to_gain(volume);
+
+    playback_params_write_begin();
+    params.p.volume = volume;
+    params.p.gain = gain;
+    playback_params_write_end();
+}
+
+int media_hal_playback_get_volume()
+{
+    playback_params_t p;
+    playback_params_read(&p);
+    return p.volume;
+}
+
+void media_hal_playback_set_mute(bool mute)
+{
+    playback_params_write_begin();
+    params.p.mute = mute;
+    playback_params_write_end();
+}
+
+/* Applies volume and mute to 16 bit audio in the output format */
+static void playback_apply_gain(int16_t *buf, int len)
+{
+    playback_params_t p;
+    playback_params_read(&p);
+    int32_t target = p.mute ? 0 : p.gain;
+
+    if (target != gain_state.target) {
+        int frames = playback_cfg.sample_rate * VOLUME_RAMP_MS / 1000;
+        gain_state.target = target;
+        gain_state.ramp_left = frames > 0 ? frames : 1;
+        gain_state.step = (target - gain_state.gain) / gain_state.ramp_left;
+    }
+    if (!gain_state.ramp_left && gain_state.gain == GAIN_ONE) {
+        return;
+    }
+
+    int channels = playback_cfg.channels > 0 ? playback_cfg.channels : 2;
+    int frames = len / (2 * channels);
+    int32_t gain = gain_state.gain;
+    for (int i = 0; i < frames; i++) {
+        if (gain_state.ramp_left) {
+            gain = --gain_state.ramp_left ? gain + gain_state.step : gain_state.target;
+        }
+        for (int ch = 0; ch < channels; ch++) {
+            buf[i * channels + ch] = (buf[i * channels + ch] * gain) >> 16;
+        }
+    }
+    gain_state.gain = gain;
+}
+
 void media_hal_init_playback(media_hal_playback_cfg_t *cfg)
 {
     if (!eq_mutex) {
@@ -131,19 +327,20 @@ void media_hal_init_playback(media_hal_playback_cfg_t *cfg)
     if (playback_cfg.write_callback == NULL) {
         playback_cfg.write_callback = default_write_callback;
     }
+#ifdef CONFIG_MEDIA_HAL_MIXER
+    if (media_hal_mixer_start(MEDIA_HAL_MIXER_TASK_PRIORITY) != ESP_OK) {
+        ESP_LOGE(TAG, "Mixer not started, playing directly");
+    }
+#endif
 }
 
-int media_hal_playback(media_hal_audio_info_t *audio_info, void *buf, int len)
+int media_hal_playback_get_sample_rate()
 {
-    //printf("%s: [resample-cb] %d spiram %d\n", TAG, heap_caps_get_free_size_sram(), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
-    memset(convert_buf, 0, BUF_SZ);
-    static audio_resample_config_t resample = {0};
-    int current_convert_block_len;
-    int convert_block_len = 0;
-    int send_offset = 0;
-    size_t sent_len = 0;
-    int conv_len = 0;
+    return playback_cfg.sample_rate;
+}
 
+static inline void playback_pop_noise_fix(void *buf)
+{
 #ifdef POP_NOISE_FIX
     /**
      * Just check if first sample is zero and replace it with -1, a very small value.
@@ -154,6 +351,36 @@ int media_hal_playback(media_hal_audio_info_t *audio_info, void *buf, int len)
         *x = 0xffffffff;
     }
 #endif
+}
+
+int media_hal_playback_write(void *buf, int len)
+{
+    /* The mixer output goes to the same codec */
+    playback_pop_noise_fix(buf);
+    if (playback_cfg.equalizer_callback) {
+        playback_cfg.equalizer_callback((char *) buf, len, playback_cfg.sample_rate, playback_cfg.channels);
+    }
+    playback_apply_gain((int16_t *) buf, len);
+    return playback_cfg.write_callback((int) playback_cfg.i2s_port_num, buf, len,
+                                       16, playback_cfg.bits_per_sample);
+}
+
+int media_hal_playback(media_hal_audio_info_t *audio_info, void *buf, int len)
+{
+    if (media_hal_mixer_is_running()) {
+        return media_hal_mixer_write(NULL, audio_info, buf, len);
+    }
+
+    //printf("%s: [resample-cb] %d spiram %d\n", TAG, heap_caps_get_free_size_sram(), heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    memset(convert_buf, 0, BUF_SZ);
+    static audio_resample_config_t resample = {0};
+    int current_convert_block_len;
+    int convert_block_len = 0;
+    int send_offset = 0;
+    size_t sent_len = 0;
+    int conv_len = 0;
+
+    playback_pop_noise_fix(buf);
 
     if (audio_info->channels == 1) {
         /* If mono recording, we need to up-sample, so need half the buffer empty, also uint16_t data*/
@@ -165,6 +392,7 @@ int media_hal_playback(media_hal_audio_info_t *audio_info, void *buf, int len)
 
     while (len) {
         current_convert_block_len = (convert_block_len > len) ? len : convert_block_len;
+        VA_TRACE_BEGIN("pcm_frame", current_convert_block_len);
         if (current_convert_block_len & 1) {
             printf("%s: Odd bytes in up sampling data, this should be backed up\n", TAG);
         }
@@ -187,8 +415,10 @@ int media_hal_playback(media_hal_audio_info_t *audio_info, void *buf, int len)
         if (playback_cfg.equalizer_callback) {
             playback_cfg.equalizer_callback((void *) convert_buf, conv_len * 2, playback_cfg.sample_rate, playback_cfg.channels);
         }
+        playback_apply_gain((int16_t *) convert_buf, conv_len * 2);
         playback_cfg.write_callback((int) playback_cfg.i2s_port_num, (void *) convert_buf, conv_len * 2,
                                     audio_info->bits_per_sample, playback_cfg.bits_per_sample);
+        VA_TRACE_END("pcm_frame", conv_len * 2);
     }
     return sent_len;
 }
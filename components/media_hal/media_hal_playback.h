@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <esp_err.h>
 
 /**
@@ -69,6 +70,45 @@ typedef struct {
  */
 int media_hal_playback(media_hal_audio_info_t *audio_info, void *buf, int len);
 
+/**
+ * Playback data already in the output format.
+ *
+ * Data in `buf` must be 16 bit stereo at the configured sample rate. It only goes through
+ * the equalizer and the writer. This is what the mixer (`media_hal_mixer.h`) outputs to.
+ *
+ * Return: Number of bytes written.
+ */
+int media_hal_playback_write(void *buf, int len);
+
+/**
+ * Get the configured output sample rate.
+ */
+int media_hal_playback_get_sample_rate();
+
+/**
+ * Set the digital playback volume.
+ *
+ * Applied in software from the next block on, with a short ramp so that
+ * changes don't click. Never blocks, can be called from any task.
+ *
+ * @param volume  Volume in percent, 0 mutes. 1% is 50dB below 100%.
+ *
+ * Note: With CONFIG_MEDIA_HAL_SOFT_VOLUME, `media_hal_control_volume` ends up here.
+ */
+void media_hal_playback_set_volume(int volume);
+
+/**
+ * Get the digital playback volume in percent.
+ */
+int media_hal_playback_get_volume();
+
+/**
+ * Mute or unmute playback, keeping the volume.
+ *
+ * Same as `media_hal_playback_set_volume`, this ramps and never blocks.
+ */
+void media_hal_playback_set_mute(bool mute);
+
 /**
  * Enable audio equalizer.
  *
@@ -95,6 +135,7 @@ void media_hal_disable_equalizer();
  * 10 gain values are given to the equalizer. Equalizer will apply effects using these values.
  * Can be called anytime when equalizer is running/enabled state.
  * Same will be used for both the channels.
+ * Unless CONFIG_MEDIA_HAL_LIB_EQUALIZER is set, changes glide in over a few ms (see `media_hal_eq.h`).
  *
  * Return: ESP_OK on success, ESP_FAIL on error.
  * Note: 1. Equalizer must be enabled first using `media_hal_enable_equalizer` before setting gain values.
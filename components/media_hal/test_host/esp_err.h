@@ -0,0 +1,8 @@
+#pragma once
+
+#define esp_err_t int
+
+#define ESP_OK              0
+#define ESP_FAIL            -1
+#define ESP_ERR_NO_MEM      0x101
+#define ESP_ERR_INVALID_ARG 0x102
@@ -0,0 +1,23 @@
+#pragma once
+
+/* Just enough FreeRTOS for the mixer host test. Everything runs in the one
+ * test thread: locks never block and tasks are not started. Ticks are
+ * milliseconds and move only when the test says so.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define portMAX_DELAY       ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS  1
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+
+extern TickType_t host_ticks;
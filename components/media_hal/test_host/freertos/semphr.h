@@ -0,0 +1,12 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef int *SemaphoreHandle_t;
+typedef SemaphoreHandle_t xSemaphoreHandle;
+
+static int host_sem;
+
+#define xSemaphoreCreateMutex()             (&host_sem)
+#define xSemaphoreTake(sem, ticks_to_wait)  pdTRUE
+#define xSemaphoreGive(sem)                 pdTRUE
@@ -0,0 +1,307 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests and benchmark of the biquad equalizer (media_hal_eq.c).
+ *
+ *   ./test_eq        run the tests, the exit status tells whether they passed
+ *   ./test_eq -b     benchmark as well
+ *
+ * The benchmark processes 48kHz stereo through 10 bands at the gains
+ * alexa_equalizer sets for the movie mode, with the optimized and the
+ * reference inner loop, and with esp_equalizer_process() when built with
+ * ESP_EQUALIZER_LIB (see the Makefile).
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <media_hal_eq.h>
+#ifdef WITH_ESP_EQUALIZER
+#include <esp_equalizer.h>
+#endif
+
+#define TEST_RATE       48000
+#define TEST_BANDS      10
+#define TEST_CHUNK      1024    /* bytes per call, as media_hal_playback does */
+#define BENCH_SECONDS   10
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Movie mode of alexa_equalizer: 2 on all three controls, less 3dB */
+static const int movie_gains[TEST_BANDS] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+static const int mixed_gains[TEST_BANDS] = { 3, 3, 3, -3, -3, -3, -3, 6, 6, 6 };
+
+typedef int (*process_fn_t)(media_hal_eq_t *eq, int16_t *buf, int len, int sample_rate, int channels);
+
+/* Log sweep from 20Hz to 20KHz plus some noise, at -6dBFS */
+static int16_t *make_signal(int frames, int channels)
+{
+    int16_t *buf = malloc(frames * channels * sizeof(int16_t));
+    double phase = 0;
+    srand(1);
+    for (int i = 0; i < frames; i++) {
+        double f = 20.0 * pow(1000.0, (double) i / frames);
+        phase += 2 * M_PI * f / TEST_RATE;
+        double v = 0.45 * sin(phase) + 0.05 * ((double) rand() / RAND_MAX - 0.5);
+        for (int ch = 0; ch < channels; ch++) {
+            buf[i * channels + ch] = (int16_t) lrint(v * 32767 * (ch ? -1 : 1));
+        }
+    }
+    return buf;
+}
+
+static int16_t *make_sine(int frames, double freq, double amp)
+{
+    int16_t *buf = malloc(frames * 2 * sizeof(int16_t));
+    for (int i = 0; i < frames; i++) {
+        buf[i * 2] = buf[i * 2 + 1] = (int16_t) lrint(amp * 32767 * sin(2 * M_PI * freq * i / TEST_RATE));
+    }
+    return buf;
+}
+
+static void run(media_hal_eq_t *eq, process_fn_t fn, int16_t *buf, int frames, int channels)
+{
+    int len = frames * channels * sizeof(int16_t);
+    for (int off = 0; off < len; off += TEST_CHUNK) {
+        int n = len - off < TEST_CHUNK ? len - off : TEST_CHUNK;
+        fn(eq, (int16_t *) ((char *) buf + off), n, TEST_RATE, channels);
+    }
+}
+
+static media_hal_eq_t *make_eq(const int *gains)
+{
+    media_hal_eq_t *eq = media_hal_eq_create(TEST_BANDS);
+    for (int i = 0; gains && i < TEST_BANDS; i++) {
+        media_hal_eq_set_band_gain(eq, i, gains[i]);
+    }
+    return eq;
+}
+
+static double peak(const int16_t *buf, int from, int to)
+{
+    int m = 0;
+    for (int i = from; i < to; i++) {
+        int v = abs(buf[i * 2]);
+        m = v > m ? v : m;
+    }
+    return m;
+}
+
+static void test_flat_is_bit_exact(void)
+{
+    int frames = TEST_RATE;
+    int16_t *in = make_signal(frames, 2);
+    int16_t *out = malloc(frames * 4);
+
+    process_fn_t fns[] = { media_hal_eq_process, media_hal_eq_process_reference };
+    for (int f = 0; f < 2; f++) {
+        media_hal_eq_t *eq = make_eq(NULL);
+        memcpy(out, in, frames * 4);
+        run(eq, fns[f], out, frames, 2);
+        CHECK(memcmp(in, out, frames * 4) == 0, "flat equalizer altered audio (%s)", f ? "reference" : "optimized");
+        media_hal_eq_delete(eq);
+    }
+
+    /* Back to flat after a change, once the glide is over */
+    media_hal_eq_t *eq = make_eq(mixed_gains);
+    memcpy(out, in, frames * 4);
+    run(eq, media_hal_eq_process, out, frames / 2, 2);
+    for (int i = 0; i < TEST_BANDS; i++) {
+        media_hal_eq_set_band_gain(eq, i, 0);
+    }
+    run(eq, media_hal_eq_process, out + frames, frames / 2, 2);
+    int tail = TEST_RATE / 10;
+    CHECK(memcmp(in + (frames - tail) * 2, out + (frames - tail) * 2, tail * 4) == 0,
+          "equalizer set back to flat still alters audio");
+    media_hal_eq_delete(eq);
+    free(in);
+    free(out);
+}
+
+static void test_optimized_matches_reference(void)
+{
+    int frames = TEST_RATE * 2;
+    int16_t *a = make_signal(frames, 2);
+    int16_t *b = malloc(frames * 4);
+    memcpy(b, a, frames * 4);
+
+    media_hal_eq_t *eq_a = make_eq(mixed_gains);
+    media_hal_eq_t *eq_b = make_eq(mixed_gains);
+    run(eq_a, media_hal_eq_process, a, frames, 2);
+    run(eq_b, media_hal_eq_process_reference, b, frames, 2);
+
+    int max_diff = 0;
+    for (int i = 0; i < frames * 2; i++) {
+        int d = abs(a[i] - b[i]);
+        max_diff = d > max_diff ? d : max_diff;
+    }
+    CHECK(max_diff == 0, "optimized and reference differ by %d LSB", max_diff);
+    media_hal_eq_delete(eq_a);
+    media_hal_eq_delete(eq_b);
+    free(a);
+    free(b);
+}
+
+static void test_band_gain(void)
+{
+    /* A band boosted by 6dB doubles a sine at its center */
+    for (int band = 1; band < TEST_BANDS; band += 3) {
+        int frames = TEST_RATE;
+        media_hal_eq_t *eq = media_hal_eq_create(TEST_BANDS);
+        double freq = media_hal_eq_get_band_freq(eq, band);
+        int16_t *buf = make_sine(frames, freq, 0.25);
+        double in_peak = peak(buf, frames / 2, frames);
+
+        media_hal_eq_set_band_gain(eq, band, 6);
+        run(eq, media_hal_eq_process, buf, frames, 2);
+        double gain_db = 20 * log10(peak(buf, frames / 2, frames) / in_peak);
+        printf("band %d (%.0fHz) at +6dB: %+.2fdB\n", band, freq, gain_db);
+        CHECK(fabs(gain_db - 6) < 0.3, "band %d boosted by %.2fdB instead of 6", band, gain_db);
+        media_hal_eq_delete(eq);
+        free(buf);
+    }
+}
+
+static void test_gain_change_glides(void)
+{
+    int frames = TEST_RATE / 2;
+    double freq = 1000;
+    int16_t *buf = make_sine(frames, freq, 0.2);
+    media_hal_eq_t *eq = media_hal_eq_create(TEST_BANDS);
+
+    /* 1KHz is band 5; step it from 0 to +12dB halfway */
+    run(eq, media_hal_eq_process, buf, frames / 2, 2);
+    media_hal_eq_set_band_gain(eq, 5, 12);
+    run(eq, media_hal_eq_process, buf + frames, frames / 2, 2);
+
+    /* Largest jump from one sample to the next, against what the louder sine
+     * does anyway. A coefficient switch shows up as a step. */
+    int max_step = 0;
+    for (int i = 1; i < frames; i++) {
+        int d = abs(buf[i * 2] - buf[(i - 1) * 2]);
+        max_step = d > max_step ? d : max_step;
+    }
+    double final_peak = peak(buf, frames - TEST_RATE / 20, frames);
+    double sine_step = final_peak * 2 * sin(M_PI * freq / TEST_RATE);
+    printf("gain step: largest sample step %d, sine at final level %.0f\n", max_step, sine_step);
+    CHECK(max_step < sine_step * 1.1, "gain change stepped by %d, more than the sine's %.0f", max_step, sine_step);
+    CHECK(peak(buf, frames / 2, frames) < final_peak * 1.1, "gain change overshot");
+    media_hal_eq_delete(eq);
+    free(buf);
+}
+
+static void test_sample_rates(void)
+{
+    /* Bands above Nyquist stay flat, and switching rates back and forth works */
+    int rates[] = { 16000, 22050, 44100, 48000, 16000 };
+    media_hal_eq_t *eq = make_eq(mixed_gains);
+    int16_t *src = make_signal(4096, 1);
+    int16_t *buf = malloc(4096 * 2);
+    for (int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        for (int j = 0; j < 4096; j++) {
+            /* Keep the +6dB bands away from clipping */
+            buf[j] = src[j] / 4;
+        }
+        int len = media_hal_eq_process(eq, buf, 4096 * 2, rates[i], 1);
+        CHECK(len == 4096 * 2, "processed %d bytes at %d", len, rates[i]);
+        int sane = 1;
+        for (int j = 0; j < 4096; j++) {
+            sane &= abs(buf[j]) < 16384;
+        }
+        CHECK(sane, "output blew up at %d", rates[i]);
+    }
+    CHECK(media_hal_eq_create(0) == NULL && media_hal_eq_create(MEDIA_HAL_EQ_MAX_BANDS + 1) == NULL,
+          "invalid band counts accepted");
+    CHECK(media_hal_eq_set_band_gain(eq, TEST_BANDS, 0) != ESP_OK, "invalid band accepted");
+    media_hal_eq_delete(eq);
+    free(src);
+    free(buf);
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_one(const char *name, process_fn_t fn, int16_t *buf, int frames)
+{
+    media_hal_eq_t *eq = make_eq(movie_gains);
+    double t = now_s();
+    run(eq, fn, buf, frames, 2);
+    t = now_s() - t;
+    printf("%-22s %8.2f ms, %6.1f ns/frame, %7.0fx realtime\n", name, t * 1000, t * 1e9 / frames,
+           BENCH_SECONDS / t);
+    media_hal_eq_delete(eq);
+}
+
+static void bench(void)
+{
+    int frames = TEST_RATE * BENCH_SECONDS;
+    int16_t *src = make_signal(frames, 2);
+    int16_t *buf = malloc(frames * 4);
+
+    printf("%d s of %dHz stereo, %d bands:\n", BENCH_SECONDS, TEST_RATE, TEST_BANDS);
+    memcpy(buf, src, frames * 4);
+    bench_one("media_hal_eq", media_hal_eq_process, buf, frames);
+    memcpy(buf, src, frames * 4);
+    bench_one("media_hal_eq reference", media_hal_eq_process_reference, buf, frames);
+
+#ifdef WITH_ESP_EQUALIZER
+    void *handle = esp_equalizer_init(2, TEST_RATE, TEST_BANDS, 0);
+    for (int i = 0; i < TEST_BANDS; i++) {
+        esp_equalizer_set_band_value(handle, movie_gains[i], i, 0);
+        esp_equalizer_set_band_value(handle, movie_gains[i], i, 1);
+    }
+    memcpy(buf, src, frames * 4);
+    double t = now_s();
+    for (int off = 0; off < frames * 4; off += TEST_CHUNK) {
+        esp_equalizer_process(handle, (unsigned char *) buf + off, TEST_CHUNK, TEST_RATE, 2);
+    }
+    t = now_s() - t;
+    printf("%-22s %8.2f ms, %6.1f ns/frame, %7.0fx realtime\n", "esp_equalizer", t * 1000, t * 1e9 / frames,
+           BENCH_SECONDS / t);
+    esp_equalizer_deinit(handle);
+#endif
+    free(src);
+    free(buf);
+}
+
+int main(int argc, char **argv)
+{
+    int do_bench = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "b")) != -1) {
+        if (opt == 'b') {
+            do_bench = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    test_flat_is_bit_exact();
+    test_optimized_matches_reference();
+    test_band_gain();
+    test_gain_change_glides();
+    test_sample_rates();
+    if (do_bench) {
+        bench();
+    }
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,396 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of the software mixer (media_hal_mixer.c).
+ *
+ *   ./test_mixer     run the tests, the exit status tells whether they passed
+ *
+ * The mixer is built into this file so that the tests can run its rounds
+ * one at a time instead of through the mixer task. Playback is at 48kHz and
+ * every input is written at that rate, so the resampler stub below only has
+ * to copy, and double up mono.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../media_hal_mixer.c"
+
+#define TEST_RATE       48000
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+TickType_t host_ticks = 1;
+
+/* Playback, as the mixer sees it */
+
+int media_hal_playback_get_sample_rate()
+{
+    return TEST_RATE;
+}
+
+int media_hal_playback_write(void *buf, int len)
+{
+    return len;
+}
+
+/* Resampler, for equal rates only */
+
+int audio_resample(short *in_buf, short *out_buf, int in_freq, int out_freq, int in_buf_size, int out_buf_size,
+                   int ch_num, audio_resample_config_t *resample_cfg)
+{
+    if (in_freq != out_freq || in_buf_size > out_buf_size) {
+        return 0;
+    }
+    memmove(out_buf, in_buf, in_buf_size * sizeof(short));
+    return in_buf_size;
+}
+
+int audio_resample_up_channel(short *in_buf, short *out_buf, int in_freq, int out_freq, int in_buf_size,
+                              int out_buf_size, audio_resample_config_t *resample_cfg)
+{
+    if (in_buf_size * 2 > out_buf_size) {
+        return 0;
+    }
+    for (int i = in_buf_size - 1; i >= 0; i--) {
+        out_buf[2 * i] = out_buf[2 * i + 1] = in_buf[i];
+    }
+    return in_buf_size * 2;
+}
+
+/* Ring buffer that never blocks, a write that does not fit fails */
+
+ringbuf_t *rb_init(const char *rb_name, uint32_t size)
+{
+    ringbuf_t *rb = calloc(1, sizeof(ringbuf_t));
+    if (!rb) {
+        return NULL;
+    }
+    rb->base = rb->readptr = rb->writeptr = malloc(size);
+    rb->size = size;
+    if (!rb->base) {
+        free(rb);
+        return NULL;
+    }
+    return rb;
+}
+
+void rb_cleanup(ringbuf_t *rb)
+{
+    free(rb->base);
+    free(rb);
+}
+
+void rb_abort(ringbuf_t *rb)
+{
+    rb->abort_read = rb->abort_write = 1;
+}
+
+void rb_reset(ringbuf_t *rb)
+{
+    rb->readptr = rb->writeptr = rb->base;
+    rb->fill_cnt = 0;
+}
+
+ssize_t rb_filled(ringbuf_t *rb)
+{
+    return rb->fill_cnt;
+}
+
+int rb_read(ringbuf_t *rb, uint8_t *buf, int len, uint32_t ticks_to_wait)
+{
+    if (len > rb->fill_cnt) {
+        len = rb->fill_cnt;
+    }
+    for (int i = 0; i < len; i++) {
+        buf[i] = *rb->readptr++;
+        if (rb->readptr == rb->base + rb->size) {
+            rb->readptr = rb->base;
+        }
+    }
+    rb->fill_cnt -= len;
+    return len;
+}
+
+int rb_write(ringbuf_t *rb, const uint8_t *buf, int len, uint32_t ticks_to_wait)
+{
+    if (rb->abort_write || len > rb->size - rb->fill_cnt) {
+        return RB_FAIL;
+    }
+    for (int i = 0; i < len; i++) {
+        *rb->writeptr++ = buf[i];
+        if (rb->writeptr == rb->base + rb->size) {
+            rb->writeptr = rb->base;
+        }
+    }
+    rb->fill_cnt += len;
+    return len;
+}
+
+/* Helpers */
+
+static media_hal_audio_info_t stereo16 = { TEST_RATE, 2, 16 };
+
+static media_hal_mixer_input_t *test_start(void)
+{
+    mixer.ducking = false;
+    media_hal_mixer_set_ducking(25, 50, 300);
+    if (media_hal_mixer_start(0) != ESP_OK) {
+        printf("Mixer did not start\n");
+        exit(1);
+    }
+    return mixer.main_input;
+}
+
+static media_hal_mixer_input_t *test_add(const char *name, bool ducks_others)
+{
+    media_hal_mixer_input_cfg_t cfg = {
+        .name = name,
+        .ducks_others = ducks_others,
+    };
+    return media_hal_mixer_add_input(&cfg);
+}
+
+/* Write `frames` frames of a constant 16 bit stereo value */
+static int test_feed(media_hal_mixer_input_t *in, int16_t value, int frames)
+{
+    int16_t buf[frames * 2];
+    for (int i = 0; i < frames * 2; i++) {
+        buf[i] = value;
+    }
+    return media_hal_mixer_write(in, &stereo16, buf, sizeof(buf));
+}
+
+/* Whether all samples of the last round are `value` */
+static bool test_round_is(int frames, int16_t value)
+{
+    for (int i = 0; i < frames * 2; i++) {
+        if (mixer.buf[i] != value) {
+            printf("  sample %d is %d, expected %d\n", i, mixer.buf[i], value);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Tests */
+
+static void test_mix(void)
+{
+    media_hal_mixer_input_t *music = test_start();
+    media_hal_mixer_input_t *alert = test_add("alert", false);
+
+    CHECK(mixer_mix_round() == 0, "round without data mixed something");
+
+    test_feed(music, 1000, 300);
+    test_feed(alert, -3000, 100);
+    int frames = mixer_mix_round();
+    CHECK(frames == 100, "mixed %d frames, the alert only had 100", frames);
+    CHECK(test_round_is(frames, -2000), "sum of both inputs");
+    CHECK(rb_filled(music->rb) == 200 * MIXER_FRAME_BYTES, "music not kept for the next round");
+
+    /* The alert is dry, the music goes on alone */
+    frames = mixer_mix_round();
+    CHECK(frames == 200, "mixed %d frames of music", frames);
+    CHECK(test_round_is(frames, 1000), "music alone");
+
+    /* A round is at most a period */
+    test_feed(music, 1000, MIXER_PERIOD_FRAMES + 10);
+    CHECK(mixer_mix_round() == MIXER_PERIOD_FRAMES, "round longer than a period");
+    CHECK(mixer_mix_round() == 10, "rest of the music");
+
+    /* Gain set without a ramp applies at once */
+    media_hal_mixer_set_gain(alert, 50, 0);
+    test_feed(music, 1000, 100);
+    test_feed(alert, 3000, 100);
+    frames = mixer_mix_round();
+    CHECK(test_round_is(frames, 2500), "alert at half");
+
+    media_hal_mixer_remove_input(alert);
+    media_hal_mixer_stop();
+}
+
+static void test_saturation(void)
+{
+    media_hal_mixer_input_t *music = test_start();
+    media_hal_mixer_input_t *alert = test_add("alert", false);
+
+    test_feed(music, 30000, 50);
+    test_feed(alert, 30000, 50);
+    int frames = mixer_mix_round();
+    CHECK(frames == 50 && test_round_is(frames, INT16_MAX), "positive overflow not clipped");
+
+    test_feed(music, -30000, 50);
+    test_feed(alert, -30000, 50);
+    frames = mixer_mix_round();
+    CHECK(frames == 50 && test_round_is(frames, INT16_MIN), "negative overflow not clipped");
+
+    test_feed(music, INT16_MIN, 50);
+    test_feed(alert, INT16_MAX, 50);
+    frames = mixer_mix_round();
+    CHECK(frames == 50 && test_round_is(frames, -1), "full scale inputs that cancel out");
+
+    media_hal_mixer_remove_input(alert);
+    media_hal_mixer_stop();
+}
+
+static void test_ducking(void)
+{
+    media_hal_mixer_input_t *music = test_start();
+    media_hal_mixer_input_t *tts = test_add("tts", true);
+    /* Frames in the ducking and restoring fades */
+    int duck_frames = TEST_RATE * 50 / 1000;
+    int restore_frames = TEST_RATE * 300 / 1000;
+    int mixed = 0, frames;
+    int16_t last;
+
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    test_feed(tts, 0, MIXER_PERIOD_FRAMES);
+    frames = mixer_mix_round();
+    CHECK(mixer.ducking, "not ducking while the tts plays");
+    CHECK(mixer.buf[0] < 10000 && mixer.buf[0] > 9000, "fade does not start at once: %d", mixer.buf[0]);
+    last = mixer.buf[0];
+    for (int i = 1; i < frames; i++) {
+        CHECK(mixer.buf[2 * i] <= last, "fade down goes up at %d", i);
+        last = mixer.buf[2 * i];
+    }
+    mixed += frames;
+
+    while (mixed < duck_frames) {
+        test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+        test_feed(tts, 0, MIXER_PERIOD_FRAMES);
+        mixed += mixer_mix_round();
+    }
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    test_feed(tts, 1000, MIXER_PERIOD_FRAMES);
+    frames = mixer_mix_round();
+    CHECK(test_round_is(frames, 2500 + 1000), "music not at the ducking level after %d frames", mixed);
+
+    /* Dry but not done: the tts keeps the music down for a while */
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    mixer_mix_round();
+    host_ticks += DUCK_HOLD_MS / 2;
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    frames = mixer_mix_round();
+    CHECK(mixer.ducking && test_round_is(frames, 2500), "restored before the hold time");
+    host_ticks += DUCK_HOLD_MS / 2;
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    mixer_mix_round();
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    frames = mixer_mix_round();
+    CHECK(!mixer.ducking, "still ducking after the hold time");
+    CHECK(mixer.buf[2 * (frames - 1)] > 2500, "no fade up");
+
+    mixed = frames;
+    while (mixed < restore_frames) {
+        test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+        mixed += mixer_mix_round();
+    }
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    frames = mixer_mix_round();
+    CHECK(test_round_is(frames, 10000), "music not restored after %d frames", mixed);
+
+    /* Done restores as soon as the tts runs dry */
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    test_feed(tts, 0, MIXER_PERIOD_FRAMES);
+    mixer_mix_round();
+    CHECK(mixer.ducking, "not ducking for the second prompt");
+    media_hal_mixer_input_done(tts);
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    mixer_mix_round();
+    test_feed(music, 10000, MIXER_PERIOD_FRAMES);
+    mixer_mix_round();
+    CHECK(!mixer.ducking, "still ducking once the tts is done");
+
+    media_hal_mixer_remove_input(tts);
+    media_hal_mixer_stop();
+}
+
+static void test_flush(void)
+{
+    media_hal_mixer_input_t *music = test_start();
+    media_hal_mixer_input_t *tts = test_add("tts", true);
+
+    test_feed(music, 1000, 500);
+    media_hal_mixer_input_flush(NULL);
+    CHECK(rb_filled(music->rb) == 0, "main input not flushed");
+    CHECK(mixer_mix_round() == 0, "flushed audio mixed");
+
+    /* A flushed prompt no longer ducks */
+    test_feed(tts, 1000, 500);
+    media_hal_mixer_input_flush(tts);
+    test_feed(music, 1000, MIXER_PERIOD_FRAMES);
+    mixer_mix_round();
+    CHECK(!mixer.ducking, "ducking for a flushed prompt");
+
+    /* The input takes data again */
+    CHECK(test_feed(tts, 1000, 10) == 40, "write after flush");
+
+    media_hal_mixer_remove_input(tts);
+    media_hal_mixer_stop();
+    /* Stopped mixer, nothing to flush */
+    media_hal_mixer_input_flush(NULL);
+}
+
+static void test_formats(void)
+{
+    int frames;
+
+    test_start();
+    int8_t mono8[100];
+    media_hal_audio_info_t info8 = { TEST_RATE, 1, 8 };
+    memset(mono8, -3, sizeof(mono8));
+    CHECK(media_hal_mixer_write(NULL, &info8, mono8, sizeof(mono8)) == sizeof(mono8), "8 bit mono write");
+    frames = mixer_mix_round();
+    CHECK(frames == 100 && test_round_is(frames, -3 * 256), "8 bit mono");
+
+    int32_t stereo32[2 * 300];
+    media_hal_audio_info_t info32 = { TEST_RATE, 2, 32 };
+    for (int i = 0; i < 2 * 300; i++) {
+        stereo32[i] = 0x12345678;
+    }
+    CHECK(media_hal_mixer_write(NULL, &info32, stereo32, sizeof(stereo32)) == sizeof(stereo32), "32 bit write");
+    frames = mixer_mix_round() + mixer_mix_round();
+    CHECK(frames == 300 && test_round_is(300 - MIXER_PERIOD_FRAMES, 0x1234), "32 bit stereo");
+
+    int16_t mono16[700];
+    media_hal_audio_info_t info16 = { TEST_RATE, 1, 16 };
+    for (int i = 0; i < 700; i++) {
+        mono16[i] = i;
+    }
+    CHECK(media_hal_mixer_write(NULL, &info16, mono16, sizeof(mono16)) == sizeof(mono16), "16 bit mono write");
+    frames = mixer_mix_round();
+    frames += mixer_mix_round();
+    CHECK(mixer.buf[0] == MIXER_PERIOD_FRAMES && mixer.buf[1] == MIXER_PERIOD_FRAMES,
+          "mono not doubled up in order across blocks: %d %d", mixer.buf[0], mixer.buf[1]);
+    frames += mixer_mix_round();
+    CHECK(frames == 700, "mixed %d of 700 mono frames", frames);
+
+    media_hal_audio_info_t info24 = { TEST_RATE, 2, 24 };
+    CHECK(media_hal_mixer_write(NULL, &info24, mono8, 96) == -1, "24 bit taken");
+
+    media_hal_mixer_stop();
+    CHECK(media_hal_mixer_write(NULL, &stereo16, mono16, 64) == -1, "write to a stopped mixer");
+}
+
+int main(int argc, char **argv)
+{
+    test_mix();
+    test_saturation();
+    test_ducking();
+    test_flush();
+    test_formats();
+
+    printf("%s\n", failures ? "FAILED" : "OK");
+    return failures ? 1 : 0;
+}
@@ -1,14 +0,0 @@
-// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
-// All rights reserved.
-
-#ifndef _LED_SINGLE_H_
-#define _LED_SINGLE_H_
-
-#include <stdint.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include "va_led.h"
-
-void led_single_init(va_led_config_t **va_led_sin12);
-
-#endif /* _LED_SINGLE_H_ */
@@ -0,0 +1,264 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <rope.h>
+#include <va_mem_utils.h>
+#include <esp_log.h>
+
+static const char *TAG = "[rope]";
+
+struct rope_seg {
+    rope_seg_t *next;
+    size_t len;
+    /* One byte of each segment is kept spare, for rope_flatten() to be able
+     * to NUL-terminate a single segment rope in place */
+    size_t size;
+    char data[];
+};
+
+/* Formatted appends which do not fit the last segment are rendered here
+ * first, if small enough, instead of a temporary heap buffer */
+#define ROPE_FMT_STACK_BUF  128
+
+static rope_seg_t *rope_seg_new(size_t size)
+{
+    rope_seg_t *seg = va_mem_alloc(sizeof(rope_seg_t) + size, VA_MEM_EXTERNAL);
+    if (!seg) {
+        ESP_LOGE(TAG, "Failed to allocate segment of %d bytes", size);
+        return NULL;
+    }
+    seg->next = NULL;
+    seg->len = 0;
+    seg->size = size;
+    return seg;
+}
+
+static inline size_t rope_seg_avail(const rope_seg_t *seg)
+{
+    return seg->size - 1 - seg->len;
+}
+
+static void rope_seg_free_chain(rope_seg_t *seg)
+{
+    while (seg) {
+        rope_seg_t *next = seg->next;
+        va_mem_free(seg);
+        seg = next;
+    }
+}
+
+rope_t *rope_new(size_t seg_size)
+{
+    rope_t *rope = va_mem_alloc(sizeof(rope_t), VA_MEM_EXTERNAL);
+    if (!rope) {
+        ESP_LOGE(TAG, "Failed to allocate rope");
+        return NULL;
+    }
+    rope->head = rope->tail = NULL;
+    rope->len = 0;
+    /* Segment must have room for at least one byte besides the spare one */
+    rope->seg_size = seg_size > 1 ? seg_size : ROPE_DEFAULT_SEG_SIZE;
+    return rope;
+}
+
+void rope_delete(rope_t *rope)
+{
+    if (!rope) {
+        return;
+    }
+    rope_seg_free_chain(rope->head);
+    va_mem_free(rope);
+}
+
+void rope_reset(rope_t *rope)
+{
+    if (rope->head) {
+        rope_seg_free_chain(rope->head->next);
+        rope->head->next = NULL;
+        rope->head->len = 0;
+    }
+    rope->tail = rope->head;
+    rope->len = 0;
+}
+
+int rope_append(rope_t *rope, const char *data, size_t len)
+{
+    size_t remaining = len;
+
+    while (remaining) {
+        if (!rope->tail || rope_seg_avail(rope->tail) == 0) {
+            rope_seg_t *seg = rope_seg_new(rope->seg_size);
+            if (!seg) {
+                return -1;
+            }
+            if (rope->tail) {
+                rope->tail->next = seg;
+            } else {
+                rope->head = seg;
+            }
+            rope->tail = seg;
+        }
+        size_t chunk = rope_seg_avail(rope->tail);
+        if (chunk > remaining) {
+            chunk = remaining;
+        }
+        memcpy(rope->tail->data + rope->tail->len, data, chunk);
+        rope->tail->len += chunk;
+        rope->len += chunk;
+        data += chunk;
+        remaining -= chunk;
+    }
+    return len;
+}
+
+int rope_vappendf(rope_t *rope, const char *fmt, va_list args)
+{
+    size_t avail = 0;
+    char *dst = NULL;
+    va_list args_copy;
+
+    if (rope->tail) {
+        avail = rope_seg_avail(rope->tail);
+        dst = rope->tail->data + rope->tail->len;
+    }
+
+    /* Try formatting straight into the last segment. The spare byte takes
+     * the NUL, which is not counted in the length */
+    va_copy(args_copy, args);
+    int formatted_bytes = vsnprintf(dst, dst ? avail + 1 : 0, fmt, args_copy);
+    va_end(args_copy);
+    if (formatted_bytes < 0) {
+        ESP_LOGE(TAG, "Error in vsnprintf");
+        return -1;
+    }
+    if (formatted_bytes <= avail) {
+        if (rope->tail) {
+            rope->tail->len += formatted_bytes;
+            rope->len += formatted_bytes;
+        }
+        return formatted_bytes;
+    }
+
+    /* Output spans segments, render it elsewhere and copy it over */
+    char stack_buf[ROPE_FMT_STACK_BUF];
+    char *buf = stack_buf;
+    if (formatted_bytes >= sizeof(stack_buf)) {
+        buf = va_mem_alloc(formatted_bytes + 1, VA_MEM_EXTERNAL);
+        if (!buf) {
+            ESP_LOGE(TAG, "Failed to allocate format buffer");
+            return -1;
+        }
+    }
+    vsnprintf(buf, formatted_bytes + 1, fmt, args);
+    int ret = rope_append(rope, buf, formatted_bytes);
+    if (buf != stack_buf) {
+        va_mem_free(buf);
+    }
+    return ret;
+}
+
+int rope_appendf(rope_t *rope, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int ret = rope_vappendf(rope, fmt, args);
+    va_end(args);
+    return ret;
+}
+
+char *rope_flatten(rope_t *rope)
+{
+    if (rope->head && rope->head == rope->tail) {
+        rope->head->data[rope->head->len] = '\0';
+        return rope->head->data;
+    }
+
+    rope_seg_t *flat = rope_seg_new(rope->len + 1);
+    if (!flat) {
+        return NULL;
+    }
+    for (rope_seg_t *seg = rope->head; seg; seg = seg->next) {
+        memcpy(flat->data + flat->len, seg->data, seg->len);
+        flat->len += seg->len;
+    }
+    flat->data[flat->len] = '\0';
+
+    rope_seg_free_chain(rope->head);
+    rope->head = rope->tail = flat;
+    return flat->data;
+}
+
+void rope_cursor_init(const rope_t *rope, rope_cursor_t *cur)
+{
+    cur->seg = rope->head;
+    cur->off = 0;
+}
+
+size_t rope_cursor_peek(rope_cursor_t *cur, const char **data)
+{
+    while (cur->seg && cur->off >= cur->seg->len) {
+        cur->seg = cur->seg->next;
+        cur->off = 0;
+    }
+    if (!cur->seg) {
+        *data = NULL;
+        return 0;
+    }
+    *data = cur->seg->data + cur->off;
+    return cur->seg->len - cur->off;
+}
+
+void rope_cursor_advance(rope_cursor_t *cur, size_t len)
+{
+    while (len && cur->seg) {
+        size_t step = cur->seg->len - cur->off;
+        if (step > len) {
+            step = len;
+        }
+        cur->off += step;
+        len -= step;
+        if (cur->off >= cur->seg->len) {
+            cur->seg = cur->seg->next;
+            cur->off = 0;
+        }
+    }
+}
+
+size_t rope_cursor_read(rope_cursor_t *cur, char *buf, size_t len)
+{
+    size_t copied = 0;
+    const char *data;
+    size_t avail;
+
+    while (copied < len && (avail = rope_cursor_peek(cur, &data)) > 0) {
+        if (avail > len - copied) {
+            avail = len - copied;
+        }
+        memcpy(buf + copied, data, avail);
+        rope_cursor_advance(cur, avail);
+        copied += avail;
+    }
+    return copied;
+}
@@ -0,0 +1,92 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+/*
+ * Rope: a string/blob built out of fixed-size segments in external RAM.
+ *
+ * Appends fill the last segment and chain a new one when it is full, so
+ * data once written is never moved. This keeps building a payload out of
+ * N pieces at O(N), unlike realloc() based growth. Readers walk the rope
+ * with a cursor and get each segment's data in place. Callers that truly
+ * need one contiguous string can ask for it with rope_flatten().
+ */
+
+#define ROPE_DEFAULT_SEG_SIZE   1024
+
+typedef struct rope_seg rope_seg_t;
+
+typedef struct {
+    rope_seg_t *head;
+    rope_seg_t *tail;
+    size_t len;
+    size_t seg_size;
+} rope_t;
+
+typedef struct {
+    const rope_seg_t *seg;
+    size_t off;
+} rope_cursor_t;
+
+/* seg_size of 0 selects ROPE_DEFAULT_SEG_SIZE */
+rope_t *rope_new(size_t seg_size);
+void rope_delete(rope_t *rope);
+/* Drop the contents, keeping the first segment for reuse */
+void rope_reset(rope_t *rope);
+
+static inline size_t rope_len(const rope_t *rope)
+{
+    return rope->len;
+}
+
+/* All appends return the number of bytes appended, or -1 on failure */
+int rope_append(rope_t *rope, const char *data, size_t len);
+int rope_appendf(rope_t *rope, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+int rope_vappendf(rope_t *rope, const char *fmt, va_list args);
+
+/* Contiguous, NUL-terminated copy of the contents. The rope is collapsed
+ * into a single segment (a no-op if it already is one), and the returned
+ * pointer stays valid until the rope is next modified */
+char *rope_flatten(rope_t *rope);
+
+/*
+ * Zero-copy reading:
+ *
+ *     rope_cursor_init(rope, &cur);
+ *     while ((len = rope_cursor_peek(&cur, &data)) > 0) {
+ *         int sent = http_request_send(httpc, data, len);
+ *         ...
+ *         rope_cursor_advance(&cur, sent);
+ *     }
+ *
+ * rope_cursor_read() copies instead, for pull style consumers like the
+ * sh2lib data callbacks.
+ */
+void rope_cursor_init(const rope_t *rope, rope_cursor_t *cur);
+size_t rope_cursor_peek(rope_cursor_t *cur, const char **data);
+void rope_cursor_advance(rope_cursor_t *cur, size_t len);
+size_t rope_cursor_read(rope_cursor_t *cur, char *buf, size_t len);
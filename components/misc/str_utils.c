@@ -24,6 +24,7 @@
 #include <str_utils.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <va_mem_utils.h>
 #include <esp_log.h>
 
@@ -37,11 +38,8 @@ void blob_create_or_append(char **current_data, size_t current_size, const char
         *current_data = (char *) va_mem_realloc(*current_data, current_size + size + 1, VA_MEM_EXTERNAL);
     }
     if (*current_data) {
-        for (int i = 0; i < size; i++) {
-            (*current_data)[current_size] = data[i];
-            current_size++;
-        }
-        (*current_data)[current_size] = '\0';
+        memcpy(*current_data + current_size, data, size);
+        (*current_data)[current_size + size] = '\0';
     } else {
         ESP_LOGE(TAG, "Memory not allocated");
     }
@@ -49,29 +47,35 @@ void blob_create_or_append(char **current_data, size_t current_size, const char
 
 int estr_append(estr_t *estr, const char *str, ...)
 {
-    short available_len = estr->buf_size - estr->offset - 1;
-    va_list args;
+    int available_len = estr->buf_size - estr->offset - 1;
+    va_list args, args_copy;
     va_start(args, str);
-    /* Get total length of string that'll be formed */
-    short formatted_bytes = vsnprintf(NULL, 0, str, args);
+    /* Get total length of string that'll be formed. The va_list is walked
+     * twice, so measure on a copy */
+    va_copy(args_copy, args);
+    int formatted_bytes = vsnprintf(NULL, 0, str, args_copy);
+    va_end(args_copy);
     if (formatted_bytes < 0) {
         ESP_LOGE(TAG, "Error in vsnprintf");
+        va_end(args);
         return -1;
     }
     if (formatted_bytes > available_len) {
-        short overflow = formatted_bytes - available_len;
+        int overflow = formatted_bytes - available_len;
         /* Calculate multiple of realloc_block_size to be added */
-        short additional_blocks = (overflow / estr->realloc_block_size) + 1;
-        short new_size = estr->buf_size + (additional_blocks * estr->realloc_block_size);
-        estr->buf = va_mem_realloc(estr->buf, new_size, VA_MEM_EXTERNAL);
-        if (!estr->buf) {
+        int additional_blocks = (overflow / estr->realloc_block_size) + 1;
+        size_t new_size = estr->buf_size + (additional_blocks * estr->realloc_block_size);
+        char *new_buf = va_mem_realloc(estr->buf, new_size, VA_MEM_EXTERNAL);
+        if (!new_buf) {
             ESP_LOGE(TAG, "Failed to realloc estr");
+            va_end(args);
             return -1;
         }
+        estr->buf = new_buf;
         estr->buf_size = new_size;
         available_len = estr->buf_size - estr->offset - 1;
     }
-    formatted_bytes = vsnprintf(estr->buf + estr->offset, available_len, str, args);
+    formatted_bytes = vsnprintf(estr->buf + estr->offset, available_len + 1, str, args);
     va_end(args);
     estr->offset += formatted_bytes;
     return formatted_bytes;
@@ -39,6 +39,8 @@ typedef struct {
 estr_t *estr_new(size_t size, size_t realloc_block_size);
 void estr_delete(estr_t *estr);
 int estr_append(estr_t *estr, const char *str, ...);
+/* Reallocates the whole blob on every call. For payloads assembled out of
+ * many pieces, use rope_t from rope.h instead */
 void blob_create_or_append(char **current_data, size_t current_len, const char *data, int size);
 char *estr_get_buf_ptr(estr_t *estr);
 static inline void str_create_or_append(char **current_data, const char *data, int size)
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdio.h>
+
+#define ESP_LOGD(TAG, ...) do { } while (0)
+#define ESP_LOGI(TAG, ...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
+#define ESP_LOGW(TAG, ...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
+#define ESP_LOGE(TAG, ...) do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
@@ -0,0 +1,302 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of the rope buffer (rope.c).
+ *
+ *   ./test_rope      run the tests, the exit status tells whether they passed
+ *
+ * Ropes are built with tiny segments, so that every append, formatted append
+ * and cursor step crosses segment boundaries, and are checked against the
+ * same data built in a flat buffer.
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rope.h>
+#include <va_mem_utils.h>
+
+#define REF_SIZE        8192
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Allocations left before va_mem_alloc() starts failing, -1 for never */
+static int allocs_left = -1;
+static int allocated;
+
+void *va_mem_alloc(size_t size, enum va_mem_region region)
+{
+    if (allocs_left == 0) {
+        return NULL;
+    }
+    if (allocs_left > 0) {
+        allocs_left--;
+    }
+    allocated++;
+    return malloc(size);
+}
+
+void va_mem_free(void *ptr)
+{
+    if (ptr) {
+        allocated--;
+    }
+    free(ptr);
+}
+
+static uint32_t rng_state = 2463534242u;
+
+static uint32_t rng()
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* Flat copy of what the rope should hold */
+typedef struct {
+    char data[REF_SIZE];
+    size_t len;
+} ref_t;
+
+static void ref_append(ref_t *ref, const char *data, size_t len)
+{
+    memcpy(ref->data + ref->len, data, len);
+    ref->len += len;
+}
+
+static void ref_appendf(ref_t *ref, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    ref->len += vsnprintf(ref->data + ref->len, REF_SIZE - ref->len, fmt, args);
+    va_end(args);
+}
+
+/* Compare by walking the rope in place, in steps of random size */
+static int rope_equals(const rope_t *rope, const ref_t *ref)
+{
+    rope_cursor_t cur;
+    const char *data;
+    size_t len, off = 0;
+
+    if (rope_len(rope) != ref->len) {
+        printf("length %zu, expected %zu\n", rope_len(rope), ref->len);
+        return 0;
+    }
+    rope_cursor_init(rope, &cur);
+    while ((len = rope_cursor_peek(&cur, &data)) > 0) {
+        size_t step = 1 + rng() % len;
+        if (off + step > ref->len || memcmp(data, ref->data + off, step) != 0) {
+            printf("differs at %zu\n", off);
+            return 0;
+        }
+        rope_cursor_advance(&cur, step);
+        off += step;
+    }
+    return off == ref->len;
+}
+
+static void test_append()
+{
+    rope_t *rope = rope_new(8);
+    static ref_t ref;
+    char piece[64];
+
+    ref.len = 0;
+    CHECK(rope && rope_len(rope) == 0, "new rope not empty");
+
+    /* Empty, within a segment, exactly to its end, and across several */
+    for (int len = 0; len < sizeof(piece); len++) {
+        for (int i = 0; i < len; i++) {
+            piece[i] = 'a' + (len + i) % 26;
+        }
+        CHECK(rope_append(rope, piece, len) == len, "append of %d", len);
+        ref_append(&ref, piece, len);
+    }
+    CHECK(rope_equals(rope, &ref), "appended data");
+
+    rope_reset(rope);
+    ref.len = 0;
+    CHECK(rope_len(rope) == 0 && rope_equals(rope, &ref), "reset");
+    CHECK(rope_append(rope, "again", 5) == 5, "append after reset");
+    ref_append(&ref, "again", 5);
+    CHECK(rope_equals(rope, &ref), "data after reset");
+    rope_delete(rope);
+}
+
+static void test_appendf()
+{
+    rope_t *rope = rope_new(16);
+    static ref_t ref;
+    char big[300];
+
+    ref.len = 0;
+    /* Into a rope with no segment yet */
+    CHECK(rope_appendf(rope, "%d", 42) == 2, "first appendf");
+    ref_appendf(&ref, "%d", 42);
+
+    for (int i = 0; i < 50; i++) {
+        int ret = rope_appendf(rope, "{\"i\":%d,\"s\":\"%s\"}", i, i % 3 ? "x" : "longer value");
+        int expected = snprintf(NULL, 0, "{\"i\":%d,\"s\":\"%s\"}", i, i % 3 ? "x" : "longer value");
+        CHECK(ret == expected, "appendf %d returned %d, expected %d", i, ret, expected);
+        ref_appendf(&ref, "{\"i\":%d,\"s\":\"%s\"}", i, i % 3 ? "x" : "longer value");
+    }
+
+    /* Larger than the stack buffer used for spanning output */
+    memset(big, 'z', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    CHECK(rope_appendf(rope, "<%s>", big) == sizeof(big) + 1, "large appendf");
+    ref_appendf(&ref, "<%s>", big);
+    CHECK(rope_appendf(rope, "%s", "") == 0, "empty appendf");
+    CHECK(rope_equals(rope, &ref), "formatted data");
+    rope_delete(rope);
+}
+
+static void test_cursor_read()
+{
+    rope_t *rope = rope_new(10);
+    static ref_t ref;
+    char buf[REF_SIZE];
+
+    ref.len = 0;
+    for (int i = 0; i < 200; i++) {
+        ref_appendf(&ref, "%d,", i);
+    }
+    rope_append(rope, ref.data, ref.len);
+
+    /* Pull it out in reads of every size from 1 to 40 */
+    for (size_t chunk = 1; chunk <= 40; chunk++) {
+        rope_cursor_t cur;
+        size_t off = 0, got;
+        rope_cursor_init(rope, &cur);
+        while ((got = rope_cursor_read(&cur, buf + off, chunk)) > 0) {
+            CHECK(got == chunk || off + got == ref.len, "short read of %zu at %zu", got, off);
+            off += got;
+        }
+        CHECK(off == ref.len && memcmp(buf, ref.data, off) == 0, "read in chunks of %zu", chunk);
+    }
+
+    /* Advancing past the end just ends the rope */
+    rope_cursor_t cur;
+    const char *data;
+    rope_cursor_init(rope, &cur);
+    rope_cursor_advance(&cur, ref.len + 100);
+    CHECK(rope_cursor_peek(&cur, &data) == 0 && data == NULL, "peek past end");
+    CHECK(rope_cursor_read(&cur, buf, sizeof(buf)) == 0, "read past end");
+    rope_delete(rope);
+}
+
+static void test_flatten()
+{
+    rope_t *rope = rope_new(0);
+    static ref_t ref;
+
+    /* Single segment: in place, and the same pointer every time */
+    rope_append(rope, "hello", 5);
+    char *flat = rope_flatten(rope);
+    CHECK(flat && strcmp(flat, "hello") == 0, "flatten of one segment");
+    CHECK(rope_flatten(rope) == flat, "one segment flattened again moved");
+    rope_delete(rope);
+
+    /* Empty rope */
+    rope = rope_new(4);
+    flat = rope_flatten(rope);
+    CHECK(flat && flat[0] == '\0', "flatten of empty rope");
+    rope_delete(rope);
+
+    rope = rope_new(4);
+    ref.len = 0;
+    for (int i = 0; i < 100; i++) {
+        rope_appendf(rope, "%d ", i);
+        ref_appendf(&ref, "%d ", i);
+    }
+    flat = rope_flatten(rope);
+    CHECK(flat && strlen(flat) == ref.len && memcmp(flat, ref.data, ref.len) == 0, "flatten of many segments");
+    CHECK(rope_equals(rope, &ref), "rope after flatten");
+
+    /* Still appendable, and flattens again */
+    rope_append(rope, "end", 3);
+    ref_append(&ref, "end", 3);
+    CHECK(rope_equals(rope, &ref), "append after flatten");
+    flat = rope_flatten(rope);
+    CHECK(flat && strlen(flat) == ref.len && memcmp(flat, ref.data, ref.len) == 0, "second flatten");
+    rope_delete(rope);
+}
+
+static void test_random()
+{
+    static ref_t ref;
+    char piece[100];
+
+    for (int round = 0; round < 200; round++) {
+        rope_t *rope = rope_new(2 + rng() % 40);
+        ref.len = 0;
+        while (ref.len < REF_SIZE - 2 * sizeof(piece)) {
+            size_t len = rng() % sizeof(piece);
+            for (size_t i = 0; i < len; i++) {
+                piece[i] = rng();
+            }
+            switch (rng() % 8) {
+            case 0:
+                rope_appendf(rope, "%u", (unsigned) len);
+                ref_appendf(&ref, "%u", (unsigned) len);
+                break;
+            case 1:
+                if (rng() % 4 == 0) {
+                    rope_flatten(rope);
+                }
+                break;
+            default:
+                rope_append(rope, piece, len);
+                ref_append(&ref, piece, len);
+                break;
+            }
+        }
+        CHECK(rope_equals(rope, &ref), "random round %d", round);
+        rope_delete(rope);
+    }
+}
+
+static void test_out_of_memory()
+{
+    rope_t *rope = rope_new(8);
+    char data[64];
+
+    memset(data, 'm', sizeof(data));
+    allocs_left = 2;
+    CHECK(rope_append(rope, data, sizeof(data)) == -1, "append without memory");
+    allocs_left = 0;
+    CHECK(rope_appendf(rope, "%s", "longer than what is left") == -1, "appendf without memory");
+    CHECK(rope_flatten(rope) == NULL, "flatten without memory");
+    allocs_left = -1;
+    rope_delete(rope);
+    CHECK(allocated == 0, "%d allocations leaked", allocated);
+}
+
+int main()
+{
+    test_append();
+    test_appendf();
+    test_cursor_read();
+    test_flatten();
+    test_random();
+    test_out_of_memory();
+    CHECK(allocated == 0, "%d allocations leaked", allocated);
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of the keyframe LED animations (va_led_anim.c).
+ *
+ *   ./test_led_anim  run the tests, the exit status tells whether they passed
+ *
+ * Animations are played by va_led.c one frame at a time, frame n at
+ * n * va_led_anim_frame_ms(), wrapping at va_led_anim_num_frames() when
+ * looping. The tests render them the same way.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <va_led_anim.h>
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+#define ALL(v)  {v, v, v, v, v, v, v, v, v, v, v, v}
+#define NUM_KF(kf)  (sizeof(kf) / sizeof(kf[0]))
+
+static uint32_t channel(uint32_t val, int shift)
+{
+    return (val >> shift) & 0xFF;
+}
+
+/* LED 0 at t_ms */
+static uint32_t render0(const va_led_anim_t *anim, uint32_t t_ms)
+{
+    uint32_t val[VA_LED_ANIM_NUM_LEDS];
+    memset(val, 0xAA, sizeof(val));
+    va_led_anim_render(anim, t_ms, val);
+    return val[0];
+}
+
+static void test_linear()
+{
+    static const va_led_keyframe_t kf[] = {
+        {0, VA_LED_EASE_LINEAR, {0x000000, 0x00FF00, 0xFF00FF, 0x102030}},
+        {100, VA_LED_EASE_STEP, {0xFF8040, 0xFF00FF, 0x00FF00, 0x102030}},
+    };
+    const va_led_anim_t anim = {kf, NUM_KF(kf), 100, 0, false};
+    uint32_t val[VA_LED_ANIM_NUM_LEDS];
+
+    va_led_anim_render(&anim, 0, val);
+    CHECK(val[0] == 0x000000 && val[1] == 0x00FF00, "start: %06x %06x", val[0], val[1]);
+
+    va_led_anim_render(&anim, 50, val);
+    CHECK(val[0] == 0x7F4020, "halfway up: %06x", val[0]);
+    /* Channels going opposite ways do not borrow from each other */
+    CHECK(val[1] == 0x7F7F7F && val[2] == 0x7F7F7F, "halfway across: %06x %06x", val[1], val[2]);
+    CHECK(val[3] == 0x102030, "constant LED: %06x", val[3]);
+    CHECK(val[4] == 0, "unset LED: %06x", val[4]);
+
+    va_led_anim_render(&anim, 100, val);
+    CHECK(val[0] == 0xFF8040 && val[2] == 0x00FF00, "end: %06x %06x", val[0], val[2]);
+
+    /* Every channel moves one way, at most one step off a straight line */
+    uint32_t prev = 0;
+    for (uint32_t t = 0; t <= 100; t++) {
+        uint32_t v = render0(&anim, t);
+        for (int shift = 0; shift < 24; shift += 8) {
+            uint32_t c = channel(v, shift);
+            uint32_t ideal = channel(0xFF8040, shift) * t / 100;
+            CHECK(c >= channel(prev, shift), "t %u: channel %d went down", t, shift);
+            CHECK(c + 1 >= ideal && c <= ideal + 1, "t %u: channel %d is %u, not %u", t, shift, c, ideal);
+        }
+        prev = v;
+    }
+}
+
+static void test_ease()
+{
+    static const struct {
+        uint8_t ease;
+        uint32_t mid;
+    } cases[] = {
+        {VA_LED_EASE_LINEAR, 0x7F},
+        {VA_LED_EASE_IN, 0x3F},
+        {VA_LED_EASE_OUT, 0xBF},
+        {VA_LED_EASE_IN_OUT, 0x7F},
+        {VA_LED_EASE_STEP, 0x00},
+    };
+
+    for (int i = 0; i < NUM_KF(cases); i++) {
+        const va_led_keyframe_t kf[] = {
+            {0, cases[i].ease, ALL(0x000000)},
+            {1000, VA_LED_EASE_STEP, ALL(0x00FF00)},
+        };
+        const va_led_anim_t anim = {kf, NUM_KF(kf), 1000, 0, false};
+        uint32_t prev = 0;
+
+        CHECK(render0(&anim, 0) == 0, "ease %d: start %06x", cases[i].ease, render0(&anim, 0));
+        uint32_t mid = channel(render0(&anim, 500), 8);
+        CHECK(mid + 1 >= cases[i].mid && mid <= cases[i].mid + 1, "ease %d: %02x halfway", cases[i].ease, mid);
+        for (uint32_t t = 0; t < 1000; t++) {
+            uint32_t c = channel(render0(&anim, t), 8);
+            CHECK(c >= prev, "ease %d: t %u at %02x after %02x", cases[i].ease, t, c, prev);
+            prev = c;
+        }
+        CHECK(render0(&anim, 1000) == 0x00FF00, "ease %d: end %06x", cases[i].ease, render0(&anim, 1000));
+    }
+}
+
+static void test_step()
+{
+    static const va_led_keyframe_t kf[] = {
+        {0, VA_LED_EASE_STEP, ALL(0x000011)},
+        {30, VA_LED_EASE_STEP, ALL(0x000022)},
+        {60, VA_LED_EASE_LINEAR, ALL(0x000000)},
+        {80, VA_LED_EASE_STEP, ALL(0x0000FF)},
+    };
+    const va_led_anim_t anim = {kf, NUM_KF(kf), 100, 0, false};
+
+    CHECK(render0(&anim, 0) == 0x11 && render0(&anim, 29) == 0x11, "first step not held");
+    CHECK(render0(&anim, 30) == 0x22 && render0(&anim, 59) == 0x22, "second step not held");
+    CHECK(render0(&anim, 60) == 0x00 && render0(&anim, 70) == 0x7F, "fade after the steps");
+}
+
+/* End of pattern: the last keyframe is held until the duration, and later
+ * times clamp to it */
+static void test_end()
+{
+    static const va_led_keyframe_t kf[] = {
+        {0, VA_LED_EASE_LINEAR, ALL(0x000000)},
+        {40, VA_LED_EASE_LINEAR, ALL(0x00FF00)},
+    };
+    const va_led_anim_t anim = {kf, NUM_KF(kf), 100, 0, false};
+
+    CHECK(render0(&anim, 40) == 0x00FF00, "last keyframe: %06x", render0(&anim, 40));
+    CHECK(render0(&anim, 99) == 0x00FF00, "last keyframe not held: %06x", render0(&anim, 99));
+    CHECK(render0(&anim, 100) == 0x00FF00 && render0(&anim, 100000) == 0x00FF00, "past the end");
+
+    /* A single keyframe is a still */
+    static const va_led_keyframe_t still_kf[] = {
+        {0, VA_LED_EASE_LINEAR, ALL(0x123456)},
+    };
+    const va_led_anim_t still = {still_kf, NUM_KF(still_kf), 10, 0, false};
+    CHECK(render0(&still, 0) == 0x123456 && render0(&still, 10) == 0x123456, "still");
+    CHECK(va_led_anim_num_frames(&still) == 1, "still has %u frames", va_led_anim_num_frames(&still));
+}
+
+static void test_frames()
+{
+    static const va_led_keyframe_t kf[] = {
+        {0, VA_LED_EASE_STEP, ALL(0)},
+    };
+    const va_led_anim_t def = {kf, 1, 1500, 0, true};
+    const va_led_anim_t fast = {kf, 1, 120, 10, false};
+    const va_led_anim_t short_anim = {kf, 1, 5, 0, false};
+
+    CHECK(va_led_anim_frame_ms(&def) == VA_LED_ANIM_FRAME_MS, "default frame period %u", va_led_anim_frame_ms(&def));
+    CHECK(va_led_anim_num_frames(&def) == 1500 / VA_LED_ANIM_FRAME_MS, "%u frames", va_led_anim_num_frames(&def));
+    CHECK(va_led_anim_frame_ms(&fast) == 10 && va_led_anim_num_frames(&fast) == 12, "own frame period");
+    CHECK(va_led_anim_num_frames(&short_anim) == 1, "shorter than a frame: %u frames",
+          va_led_anim_num_frames(&short_anim));
+}
+
+/* Played in a loop, a pattern that fades up and back down comes round
+ * without a jump, and every loop is the same */
+static void test_loop()
+{
+    static const va_led_keyframe_t kf[] = {
+        {0, VA_LED_EASE_LINEAR, ALL(0x00000F)},
+        {450, VA_LED_EASE_LINEAR, ALL(0x0000FF)},
+        {870, VA_LED_EASE_STEP, ALL(0x00001F)},
+    };
+    const va_led_anim_t anim = {kf, NUM_KF(kf), 900, 0, true};
+    uint16_t frames = va_led_anim_num_frames(&anim);
+    uint8_t frame_ms = va_led_anim_frame_ms(&anim);
+    uint32_t first[64];
+    uint32_t prev = render0(&anim, (frames - 1) * frame_ms);
+    uint32_t peak = 0;
+
+    CHECK(frames == 45 && frames <= sizeof(first) / sizeof(first[0]), "%u frames", frames);
+    for (int counter = 0, n = 0; n < 3 * frames; n++) {
+        uint32_t v = render0(&anim, counter * frame_ms);
+        int step = (int) v - (int) prev;
+        if (n < frames) {
+            first[counter] = v;
+            peak = v > peak ? v : peak;
+        } else {
+            CHECK(v == first[counter], "loop %d frame %d: %06x, not %06x", n / frames, counter, v, first[counter]);
+        }
+        CHECK(step >= -0x10 && step <= 0x10, "frame %d: jump from %02x to %02x", counter, prev, v);
+        prev = v;
+        counter = (counter + 1) % frames;
+    }
+    CHECK(first[0] == 0x0F, "loop starts at %02x", first[0]);
+    CHECK(peak >= 0xF0 && peak <= 0xFF, "peak is %02x", peak);
+}
+
+int main()
+{
+    test_linear();
+    test_ease();
+    test_step();
+    test_end();
+    test_frames();
+    test_loop();
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
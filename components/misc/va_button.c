@@ -10,9 +10,13 @@
 #include "va_dsp.h"
 #include "va_nvs_utils.h"
 #include "va_led.h"
+#include "esp_timer.h"
 
 
 #define VA_BUTTON_QUEUE_LENGTH 1
+#define VA_BUTTON_EVT_QUEUE_LENGTH 8
+#define VA_BUTTON_SCAN_PERIOD_MS 20
+#define VA_BUTTON_NONE 0xff
 #define ESP_INTR_FLAG_DEFAULT  0
 //#define PA_SPEAKER_EN 33
 #define VOLUME_STEP 5
@@ -21,12 +25,51 @@
 #define WIFI_RST_DELAY 5000
 #define V_REF   1100
 
+/* Events sent from the scan timer to the dispatcher task */
+typedef enum {
+    VA_BUTTON_EVT_PRESS = 0,
+    VA_BUTTON_EVT_CLICK,        /* Released before the long press fired */
+    VA_BUTTON_EVT_LONG_PRESS,
+    VA_BUTTON_EVT_REPEAT,
+    VA_BUTTON_EVT_RELEASE,      /* Released after the long press fired */
+} va_button_evt_type_t;
+
+typedef struct {
+    uint8_t button;
+    uint8_t type;
+} va_button_evt_t;
+
+typedef struct {
+    uint8_t debounce_cnt;       /* Consecutive samples needed to accept a new level */
+    uint16_t long_ms;           /* 0: no long press */
+    uint16_t repeat_delay_ms;   /* 0: no auto repeat */
+    uint16_t repeat_ms;
+} va_button_param_t;
+
+static const va_button_param_t va_button_params[VA_BUTTON_MAX] = {
+    [VA_BUTTON_TAP_TO_TALK] = {2, WIFI_RST_DELAY, 0, 0},
+    [VA_BUTTON_MIC_MUTE]    = {2, 0, 0, 0},
+    [VA_BUTTON_VOLUME_UP]   = {2, 0, 400, 200},
+    [VA_BUTTON_VOLUME_DOWN] = {2, 0, 400, 200},
+    [VA_BUTTON_FACTORY_RST] = {2, FACTORY_RST_DELAY, 0, 0},
+    [VA_BUTTON_CUSTOM_1]    = {2, 0, 0, 0},
+    [VA_BUTTON_CUSTOM_2]    = {2, 0, 0, 0},
+    [VA_BUTTON_VAL_IDLE]    = {2, 0, 0, 0},
+};
+
+typedef struct {
+    uint8_t stable;             /* Debounced button, VA_BUTTON_VAL_IDLE when released */
+    uint8_t candidate;
+    uint8_t cnt;
+    bool long_sent;
+    uint32_t held_ms;
+    uint32_t next_repeat_ms;
+} va_button_scan_t;
+
 static const char *TAG = "[va_button]";
 extern bool ab_but_mute;
-static bool va_button_wifi_rst_en = false;
 static bool va_button_factory_rst_en = false;
 static bool va_button_is_wifi_rst = false;
-static bool va_button_is_factory_rst = false;
 static va_button_wifi_reset_cb_t va_button_wifi_reset_cb = NULL;
 static uint8_t mute_btn_press_flg = 1;
 
@@ -35,12 +78,13 @@ typedef struct {
     esp_adc_cal_characteristics_t characteristics;
     TaskHandle_t va_button_task_handle;
     esp_timer_handle_t esp_timer_handler_f;
-    esp_timer_handle_t esp_timer_handler_w;
+    esp_timer_handle_t esp_timer_handler_scan;
     xQueueHandle ui_button_queue;
     button_cfg_t but_cfg;
+    va_button_scan_t scan;
 } va_button_t;
 
-static va_button_t button_st = {false, {0}, NULL, NULL, NULL, NULL, {0}};
+static va_button_t button_st = {false, {0}, NULL, NULL, NULL, NULL, {0}, {0}};
 
 int number_of_active_alerts = 0;
 
@@ -59,12 +103,6 @@ static void va_button_factory_reset_timer_cb()
     ESP_LOGI(TAG, "Factory Reset initiated, erasing nvs flash and rebooting");
 }
 
-static void va_button_wifi_reset_timer_cb()
-{
-    va_button_wifi_rst_en = true;
-    ESP_LOGI(TAG, "Wifi Reset initiated");
-}
-
 void va_button_notify_mute(bool va_btn_mute)
 {
     if(va_btn_mute) {
@@ -73,162 +111,235 @@ void va_button_notify_mute(bool va_btn_mute)
     }
 }
 
-static void va_button_adc_task(void *arg)
+/* Map an ADC reading to a button, VA_BUTTON_VAL_IDLE or VA_BUTTON_NONE (between windows) */
+static uint8_t va_button_adc_classify(uint32_t adc_val)
 {
-    //Init ADC and Characteristics
-    bool en_timer = 0;
+    const button_cfg_t *cfg = &button_st.but_cfg;
+    int val = (int)adc_val;
+    for (int i = 0; i < VA_BUTTON_VAL_IDLE; i++) {
+        if ((cfg->va_button_adc_val[i] != -1) &&
+            (val > (cfg->va_button_adc_val[i] - cfg->tolerance)) &&
+            (val < (cfg->va_button_adc_val[i] + cfg->tolerance))) {
+            return i;
+        }
+    }
+    if (val > cfg->va_button_adc_val[VA_BUTTON_VAL_IDLE]) {
+        return VA_BUTTON_VAL_IDLE;
+    }
+    return VA_BUTTON_NONE;
+}
+
+static void va_button_post(uint8_t button, uint8_t type)
+{
+    va_button_evt_t evt = {button, type};
+    if (xQueueSend(button_st.ui_button_queue, &evt, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Event queue full, dropping event %d for button %d", type, button);
+    }
+}
+
+/* Runs from the esp_timer task every VA_BUTTON_SCAN_PERIOD_MS. Only samples and posts events, never blocks. */
+static void va_button_scan_cb(void *arg)
+{
+    va_button_scan_t *s = &button_st.scan;
     uint32_t current_adc_val;
+    esp_adc_cal_get_voltage(button_st.but_cfg.va_button_adc_ch_num, &button_st.characteristics, &current_adc_val);
+    uint8_t btn = va_button_adc_classify(current_adc_val);
+    if (btn == VA_BUTTON_NONE) {
+        /* Ladder is settling between two levels, keep the current state */
+        return;
+    }
+
+    if (btn != s->stable) {
+        if (btn != s->candidate) {
+            s->candidate = btn;
+            s->cnt = 0;
+        }
+        if (++s->cnt < va_button_params[btn].debounce_cnt) {
+            return;
+        }
+        if (s->stable != VA_BUTTON_VAL_IDLE) {
+            va_button_post(s->stable, s->long_sent ? VA_BUTTON_EVT_RELEASE : VA_BUTTON_EVT_CLICK);
+        }
+        s->stable = btn;
+        s->cnt = 0;
+        s->held_ms = 0;
+        s->long_sent = false;
+        if (btn != VA_BUTTON_VAL_IDLE) {
+            s->next_repeat_ms = va_button_params[btn].repeat_delay_ms;
+            va_button_post(btn, VA_BUTTON_EVT_PRESS);
+        }
+        return;
+    }
+
+    s->candidate = btn;
+    s->cnt = 0;
+    if (btn == VA_BUTTON_VAL_IDLE) {
+        return;
+    }
+    const va_button_param_t *param = &va_button_params[btn];
+    s->held_ms += VA_BUTTON_SCAN_PERIOD_MS;
+    if (param->long_ms && !s->long_sent && s->held_ms >= param->long_ms) {
+        s->long_sent = true;
+        va_button_post(btn, VA_BUTTON_EVT_LONG_PRESS);
+    }
+    if (param->repeat_ms && s->held_ms >= s->next_repeat_ms) {
+        s->next_repeat_ms += param->repeat_ms;
+        va_button_post(btn, VA_BUTTON_EVT_REPEAT);
+    }
+}
+
+static int va_button_volume_step(int step)
+{
     uint8_t current_vol;
-    int set_volume = 0;
-    int64_t curr_time = esp_timer_get_time();
-    bool active_btn_press = false;
-    bool act_btn_press_en = false;
+    int set_volume;
+    media_hal_get_volume(media_hal_get_handle(), &current_vol);
+    set_volume = current_vol + step;
+    if (set_volume > 100) {
+        set_volume = 100;
+        ESP_LOGI(TAG, "volume_max");
+    } else if (set_volume < 0) {
+        set_volume = 0;
+        ESP_LOGI(TAG, "volume_min");
+    }
+    media_hal_set_mute(media_hal_get_handle(), 0);
+    volume_to_set = set_volume;
+    va_led_set(VA_SET_VOLUME);
+    media_hal_control_volume(media_hal_get_handle(), set_volume);
+    /* It is good if we play some tone (when nothing else is playing). But there is no dedicated tone for volume. So putting our custom tone. */
+    tone_play(TONE_VOLUME);
+    return set_volume;
+}
+
+static void va_button_tap_to_talk()
+{
+    printf("%s: Tap to talk button pressed\n", TAG);
+    if (number_of_active_alerts > 0) {
+#ifdef VOICE_ASSISTANT_ALEXA
+        if (alerts_is_active() == true) {
+            alerts_stop_currently_active();
+        }
+#endif /* VOICE_ASSISTANT_ALEXA */
+    } else {
+        if (((ab_but_mute) || !(button_st.b_mute)) && (va_boot_is_finish())) {
+            va_dsp_tap_to_talk_start();
+        }
+    }
+}
+
+static void va_button_mic_mute_toggle()
+{
+    if (mute_btn_press_flg == 1) {
+        button_st.b_mute = true;
+        va_dsp_mic_mute(button_st.b_mute);
+        va_led_set(VA_MUTE_ENABLE);
+        tone_play(TONE_PRIVACY_ON);
+        mute_btn_press_flg = 3;
+    } else if (mute_btn_press_flg == 3) {
+        button_st.b_mute = false;
+        va_dsp_mic_mute(button_st.b_mute);
+        va_led_set(VA_MUTE_DISABLE);
+        tone_play(TONE_PRIVACY_OFF);
+        mute_btn_press_flg = 1;
+    }
+}
+
+static void va_button_wifi_reset()
+{
+    ESP_LOGI(TAG, "Wifi Reset initiated");
+    if (va_button_wifi_reset_cb == NULL) {
+        ESP_LOGE(TAG, "No callback set for wifi reset");
+        return;
+    }
+    /* Do not set any led here. Instead set the Factory reset led when starting provisioning after restart. */
+    va_led_set(LED_OFF);
+    va_reset();
+    (*va_button_wifi_reset_cb)(NULL);
+    va_button_is_wifi_rst = true;   //Since non-blocking as of now
+}
+
+static void va_button_factory_reset()
+{
+    ESP_LOGI(TAG, "Factory Reset initiated, erasing nvs flash and rebooting");
+    /* Do not set any led here. Instead set the Factory reset led when starting provisioning after restart. */
+    va_led_set(LED_OFF);
+    va_nvs_flash_erase();
+    va_reset();
+    esp_restart();
+}
+
+/* Action dispatcher: all codec, tone and LED work for the ADC buttons happens here, off the scan path */
+static void va_button_adc_task(void *arg)
+{
     int (*button_exe_internal)(int) = (int(*)(int))arg;
+    va_button_evt_t evt;
+    uint32_t armed = 0;     /* Buttons whose press was accepted by the board callback */
+    int set_volume = 0;
+    bool vol_notif_pending = false;
+    int64_t vol_time = 0;
+
     while (1) {
-        esp_adc_cal_get_voltage(button_st.but_cfg.va_button_adc_ch_num, &button_st.characteristics, &current_adc_val);
-        //printf("%d: current_adc_val\n", current_adc_val);
-        if ((button_st.but_cfg.va_button_adc_val[VA_BUTTON_TAP_TO_TALK] != -1) &&
-            (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_TAP_TO_TALK] - button_st.but_cfg.tolerance)) &&
-            (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_TAP_TO_TALK] + button_st.but_cfg.tolerance))) {    //tap to talk button
-            if(button_exe_internal(VA_BUTTON_TAP_TO_TALK)) {
-                esp_timer_start_once(button_st.esp_timer_handler_w, (WIFI_RST_DELAY * 1000));
-                act_btn_press_en = true;
+        TickType_t wait = portMAX_DELAY;
+        if (vol_notif_pending) {
+            int64_t left_ms = VOL_NOTIF_DELAY - ((esp_timer_get_time() - vol_time) / 1000);
+            if (left_ms <= 0) {
+                speaker_notify_vol_changed(set_volume);
+                va_led_set(VA_SET_VOLUME_DONE);
+                vol_notif_pending = false;
+            } else {
+                wait = pdMS_TO_TICKS(left_ms);
             }
-        } else if ((button_st.but_cfg.va_button_adc_val[VA_BUTTON_MIC_MUTE] != -1) &&
-                   (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_MIC_MUTE] - button_st.but_cfg.tolerance)) &&
-                   (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_MIC_MUTE] + button_st.but_cfg.tolerance))) {    //mic mute button
-            if(button_exe_internal(VA_BUTTON_MIC_MUTE)) {
-                if(va_boot_is_finish()) {
-                    if(mute_btn_press_flg == 1) {
-                        button_st.b_mute = true;
-                        mute_btn_press_flg = 2;
-                    } else if(mute_btn_press_flg == 3) {
-                        mute_btn_press_flg = 4;
-                        button_st.b_mute = false;
-                    }
+        }
+        if (xQueueReceive(button_st.ui_button_queue, &evt, wait) != pdTRUE) {
+            continue;
+        }
+
+        uint32_t mask = 1 << evt.button;
+        switch (evt.type) {
+            case VA_BUTTON_EVT_PRESS:
+                if (!button_exe_internal(evt.button)) {
+                    armed &= ~mask;
+                    break;
                 }
-            }
-        } else if ((button_st.but_cfg.va_button_adc_val[VA_BUTTON_VOLUME_UP] != -1) &&
-                   (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_VOLUME_UP] - button_st.but_cfg.tolerance)) &&
-                   (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_VOLUME_UP] + button_st.but_cfg.tolerance))) {    //volume increase button
-            if(button_exe_internal(VA_BUTTON_VOLUME_UP)) {
-                if(va_boot_is_finish()) {
-                    media_hal_get_volume(media_hal_get_handle(), &current_vol);
-                    set_volume = current_vol + VOLUME_STEP;
-                    if (set_volume > 100) {
-                        set_volume = 100;
-                        ESP_LOGI(TAG, "volume_max");
-                    }
-                    media_hal_set_mute(media_hal_get_handle(), 0);
-                    volume_to_set = set_volume;
-                    va_led_set(VA_SET_VOLUME);
-                    media_hal_control_volume(media_hal_get_handle(), set_volume);
-                    /* It is good if we play some tone (when nothing else is playing). But there is no dedicated tone for volume. So putting our custom tone. */
-                    tone_play(TONE_VOLUME);
-                    curr_time = esp_timer_get_time();
-                    en_timer = true;
+                armed |= mask;
+                /* Fall through */
+            case VA_BUTTON_EVT_REPEAT:
+                if (!(armed & mask) || !va_boot_is_finish()) {
+                    break;
                 }
-            }
-        } else if ((button_st.but_cfg.va_button_adc_val[VA_BUTTON_VOLUME_DOWN] != -1) &&
-                   (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_VOLUME_DOWN] - button_st.but_cfg.tolerance)) &&
-                   (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_VOLUME_DOWN] + button_st.but_cfg.tolerance))) {    //volume decrease button
-            if(button_exe_internal(VA_BUTTON_VOLUME_DOWN)) {
-                if(va_boot_is_finish()) {
-                    media_hal_get_volume(media_hal_get_handle(), &current_vol);
-                    set_volume = current_vol - VOLUME_STEP;
-                    if (set_volume < 0) {
-                        set_volume = 0;
-                        ESP_LOGI(TAG, "volume_min");
-                    }
-                    media_hal_set_mute(media_hal_get_handle(), 0);
-                    volume_to_set = set_volume;
-                    va_led_set(VA_SET_VOLUME);
-                    media_hal_control_volume(media_hal_get_handle(), set_volume);
-                    /* It is good if we play some tone (when nothing else is playing). But there is no dedicated tone for volume. So putting our custom tone. */
-                    tone_play(TONE_VOLUME);
-                    curr_time = esp_timer_get_time();
-                    en_timer = true;
+                if (evt.button == VA_BUTTON_VOLUME_UP || evt.button == VA_BUTTON_VOLUME_DOWN) {
+                    set_volume = va_button_volume_step(evt.button == VA_BUTTON_VOLUME_UP ? VOLUME_STEP : -VOLUME_STEP);
+                    vol_time = esp_timer_get_time();
+                    vol_notif_pending = true;
                 }
-            }
-        } else if ((button_st.but_cfg.va_button_adc_val[VA_BUTTON_FACTORY_RST] != -1) &&
-                   (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_FACTORY_RST] - button_st.but_cfg.tolerance)) &&
-                   (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_FACTORY_RST] + button_st.but_cfg.tolerance))) {    //factory reset case
-            if(button_exe_internal(VA_BUTTON_FACTORY_RST)) {
-                esp_timer_start_once(button_st.esp_timer_handler_f, (FACTORY_RST_DELAY * 1000));
-            }
-        } else if((button_st.but_cfg.va_button_adc_val[VA_BUTTON_CUSTOM_1] != -1) &&
-                  (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_CUSTOM_1] - button_st.but_cfg.tolerance)) &&
-                  (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_CUSTOM_1] + button_st.but_cfg.tolerance))) {    //button number 5 - custom
-            if(button_exe_internal(VA_BUTTON_CUSTOM_1)) {
-            }
-        } else if((button_st.but_cfg.va_button_adc_val[VA_BUTTON_CUSTOM_2] != -1) &&
-                  (current_adc_val > (button_st.but_cfg.va_button_adc_val[VA_BUTTON_CUSTOM_2] - button_st.but_cfg.tolerance)) && 
-                  (current_adc_val < (button_st.but_cfg.va_button_adc_val[VA_BUTTON_CUSTOM_2] + button_st.but_cfg.tolerance))) {    //button number 6 - custom
-            if(button_exe_internal(VA_BUTTON_CUSTOM_2)) {
-            }
-        } else if (current_adc_val > button_st.but_cfg.va_button_adc_val[VA_BUTTON_VAL_IDLE]) {    //idle case
-            if(button_exe_internal(VA_BUTTON_VAL_IDLE)) {
-                esp_timer_stop(button_st.esp_timer_handler_w);  //Stop wifi reset timer
-                esp_timer_stop(button_st.esp_timer_handler_f);  //Stop factory reset timer
-                if(act_btn_press_en) {
-                    active_btn_press = true;
+                break;
+            case VA_BUTTON_EVT_LONG_PRESS:
+                if (!(armed & mask)) {
+                    break;
                 }
-                if(mute_btn_press_flg == 2) {
-                    va_dsp_mic_mute(button_st.b_mute);
-                    va_led_set(VA_MUTE_ENABLE);
-                    tone_play(TONE_PRIVACY_ON);
-                    mute_btn_press_flg = 3;
-                } else if (mute_btn_press_flg == 4) {
-                    va_dsp_mic_mute(button_st.b_mute);
-                    va_led_set(VA_MUTE_DISABLE);
-                    tone_play(TONE_PRIVACY_OFF);
-                    mute_btn_press_flg = 1;
+                if (evt.button == VA_BUTTON_TAP_TO_TALK) {
+                    va_button_wifi_reset();
+                } else if (evt.button == VA_BUTTON_FACTORY_RST) {
+                    va_button_factory_reset();
                 }
-            }
-        }
-        if (((esp_timer_get_time() - curr_time) > (VOL_NOTIF_DELAY * 1000)) && en_timer) {
-            speaker_notify_vol_changed(set_volume);
-            va_led_set(VA_SET_VOLUME_DONE);
-            en_timer = false;
-        }
-        if(va_button_wifi_rst_en) {
-            if (va_button_wifi_reset_cb == NULL) {
-                ESP_LOGE(TAG, "No callback set for wifi reset");
-            } else {
-                /* Do not set any led here. Instead set the Factory reset led when starting provisioning after restart. */
-                va_led_set(LED_OFF);
-                va_reset();
-                (*va_button_wifi_reset_cb)(NULL);
-                va_button_is_wifi_rst = true;   //Since non-blocking as of now
-            }
-            va_button_wifi_rst_en = false;
-        }
-        if(va_button_factory_rst_en) {
-            va_button_is_factory_rst = true;   //Lets keep for it, can be removed as this is a blocking call
-            /* Do not set any led here. Instead set the Factory reset led when starting provisioning after restart. */
-            va_led_set(LED_OFF);
-            va_nvs_flash_erase();
-            va_reset();
-            esp_restart();
-            va_button_factory_rst_en = false;
-        }
-        if(active_btn_press && act_btn_press_en && !(va_button_factory_rst_en) && !(va_button_is_wifi_rst)) {
-            printf("%s: Tap to talk button pressed\n", TAG);
-            if (number_of_active_alerts > 0) {
-#ifdef VOICE_ASSISTANT_ALEXA
-                if (alerts_is_active() == true) {
-                    alerts_stop_currently_active();
+                break;
+            case VA_BUTTON_EVT_CLICK:
+                if (!(armed & mask) || !button_exe_internal(VA_BUTTON_VAL_IDLE)) {
+                    break;
                 }
-#endif /* VOICE_ASSISTANT_ALEXA */
-            } else {
-                if (((ab_but_mute) || !(button_st.b_mute)) && (va_boot_is_finish())) {
-                    va_dsp_tap_to_talk_start();
+                if (evt.button == VA_BUTTON_TAP_TO_TALK && !va_button_is_wifi_rst) {
+                    va_button_tap_to_talk();
+                } else if (evt.button == VA_BUTTON_MIC_MUTE && va_boot_is_finish()) {
+                    va_button_mic_mute_toggle();
                 }
-            }
-            active_btn_press = false;
-            act_btn_press_en = false;
+                armed &= ~mask;
+                break;
+            case VA_BUTTON_EVT_RELEASE:
+                button_exe_internal(VA_BUTTON_VAL_IDLE);
+                armed &= ~mask;
+                break;
+            default:
+                break;
         }
-        vTaskDelay(pdMS_TO_TICKS(200));
     }
 }
 
@@ -269,10 +380,7 @@ static void va_button_gpio_task(void *arg)
     int io_num;
     uint8_t mute_btn_press_en = false;
     while (1) {
-        if (xQueueReceive(button_st.ui_button_queue, &io_num, 0) != pdTRUE) {
-            //ESP_LOGE(TAG, "Failed to receive from led queue");
-            vTaskDelay(100/portTICK_RATE_MS);
-        } else {
+        if (xQueueReceive(button_st.ui_button_queue, &io_num, 100/portTICK_RATE_MS) == pdTRUE) {
             printf("%s: button pressed: %d\n", TAG, io_num);
             if (io_num == button_st.but_cfg.va_button_gpio_num[VA_BUTTON_TAP_TO_TALK]) {
                 ESP_LOGI(TAG, "tap to talk pressed");
@@ -320,18 +428,19 @@ esp_err_t va_button_init(const button_cfg_t *button_cfg, int (*button_event_cb)(
         ESP_LOGE(TAG, "Failed to create esp timer for reset-to-factory button");
         return ESP_FAIL;
     }
-    timer_arg.callback = va_button_wifi_reset_timer_cb;
-    timer_arg.name = "va button wifi reset timer";
-    if (esp_timer_create(&timer_arg, &button_st.esp_timer_handler_w) != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to create esp timer for reset-to-wifi button");
-        return ESP_FAIL;
-    }
 
     if(button_st.but_cfg.is_adc) {
         va_button_adc_init(button_st.but_cfg.va_button_adc_ch_num);
         if(button_st.but_cfg.va_button_adc_val[VA_BUTTON_MIC_MUTE] == -1) {
             button_st.b_mute = true;
         }
+        button_st.scan.stable = VA_BUTTON_VAL_IDLE;
+        button_st.scan.candidate = VA_BUTTON_VAL_IDLE;
+        button_st.ui_button_queue = xQueueCreate(VA_BUTTON_EVT_QUEUE_LENGTH, sizeof(va_button_evt_t));
+        if (button_st.ui_button_queue == NULL) {
+            ESP_LOGE(TAG, "Could not create queue");
+            return ESP_FAIL;
+        }
 
         StackType_t *va_button_task_stack = (StackType_t *)va_mem_alloc(VA_BUTTON_TASK_BUFFER_SZ, VA_MEM_EXTERNAL);
         static StaticTask_t va_button_task_buf;
@@ -341,6 +450,14 @@ esp_err_t va_button_init(const button_cfg_t *button_cfg, int (*button_event_cb)(
             ESP_LOGE(TAG, "Could not create va button task");
             return ESP_FAIL;
         }
+
+        timer_arg.callback = va_button_scan_cb;
+        timer_arg.name = "va button scan timer";
+        if (esp_timer_create(&timer_arg, &button_st.esp_timer_handler_scan) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create esp timer for button scan");
+            return ESP_FAIL;
+        }
+        esp_timer_start_periodic(button_st.esp_timer_handler_scan, VA_BUTTON_SCAN_PERIOD_MS * 1000);
     } else if(button_st.but_cfg.is_gpio) {
         button_st.ui_button_queue = xQueueCreate(VA_BUTTON_QUEUE_LENGTH, sizeof(uint32_t));
         if (button_st.ui_button_queue == NULL) {
@@ -9,6 +9,7 @@
 #include <va_mem_utils.h>
 #include <va_led.h>
 #include <esp_timer.h>
+#include <va_trace.h>
 
 #include "app_defs.h"
 
@@ -34,7 +35,8 @@ static bool va_led_dnd_st = false;
 static bool va_led_error_st = false;
 static bool va_led_alert_short_en = false;
 static bool init_done;
-static uint8_t counter = 0;
+static uint16_t counter = 0;
+static va_led_fade_cb_t va_led_fade_cb;
 
 typedef struct {
     TaskHandle_t va_led_task_handle;
@@ -58,6 +60,7 @@ void va_led_delay_timer_cb()
 
 IRAM_ATTR esp_err_t va_led_set(int va_state)
 {
+    VA_TRACE_INSTANT("va_state", va_state);
     if (!init_done) {
         return ESP_OK;
     }
@@ -101,17 +104,75 @@ IRAM_ATTR esp_err_t va_led_set(int va_state)
     return ESP_OK;
 }
 
-static void va_led_send_vl(va_led_specs_t *va_led_v, uint8_t num)
+static const va_led_anim_t *va_led_get_anim(const va_led_config_t *va_led_con)
 {
+    return va_led_con->va_led_state_sz ? NULL : va_led_con->va_led_anim;
+}
+
+static uint16_t va_led_num_frames(const va_led_config_t *va_led_con)
+{
+    const va_led_anim_t *anim = va_led_get_anim(va_led_con);
+
+    if (anim == NULL) {
+        return va_led_con->va_led_state_sz;
+    }
+    if (va_led_fade_cb) {
+        return anim->num_kf;
+    }
+    return va_led_anim_num_frames(anim);
+}
+
+static bool va_led_loop_en(const va_led_config_t *va_led_con)
+{
+    const va_led_anim_t *anim = va_led_get_anim(va_led_con);
+
+    if (anim) {
+        return anim->loop_en;
+    }
+    return va_led_con->va_led_state_st->loop_en;
+}
+
+/* With a fade callback, frame num of an animation is its keyframe segment num */
+static int va_led_send_anim_segment(const va_led_anim_t *anim, uint16_t num)
+{
+    const va_led_keyframe_t *kf = &anim->kf[num];
+    int end_ms = (num + 1 < anim->num_kf) ? anim->kf[num + 1].t_ms : anim->duration_ms;
+
+    if (num == 0 || num + 1 >= anim->num_kf || kf->ease == VA_LED_EASE_STEP) {
+        va_led_set_pwm(kf->va_led_val);
+    }
+    if (num + 1 < anim->num_kf && kf->ease != VA_LED_EASE_STEP) {
+        /* Hardware fades are linear, the ease curve is approximated */
+        va_led_fade_cb(anim->kf[num + 1].va_led_val, end_ms - kf->t_ms);
+    }
+    return end_ms - kf->t_ms;
+}
+
+static void va_led_send_vl(const va_led_config_t *va_led_con, uint16_t num)
+{
+    uint32_t va_led_val[VA_LED_ANIM_NUM_LEDS];
+    const va_led_anim_t *anim = va_led_get_anim(va_led_con);
+    int delay_ms;
+
     xSemaphoreTake(led_st.va_led_tim_sema, portMAX_DELAY);
-    va_led_set_pwm((uint32_t *)va_led_v[num].va_led_val);
-    esp_timer_start_once(led_st.esp_delay_timer_hdl, (va_led_v[num].va_led_delay * 1000));
+    if (anim == NULL) {
+        va_led_set_pwm(va_led_con->va_led_state_st[num].va_led_val);
+        delay_ms = va_led_con->va_led_state_st[num].va_led_delay;
+    } else if (va_led_fade_cb) {
+        delay_ms = va_led_send_anim_segment(anim, num);
+    } else {
+        delay_ms = va_led_anim_frame_ms(anim);
+        va_led_anim_render(anim, num * delay_ms, va_led_val);
+        va_led_set_pwm(va_led_val);
+    }
+    esp_timer_start_once(led_st.esp_delay_timer_hdl, (delay_ms * 1000));
 }
 
-static void va_led_set_state(size_t sz, const va_led_specs_t *va_led_conf)
+static void va_led_set_state(const va_led_config_t *va_led_con)
 {
+    uint16_t sz = va_led_num_frames(va_led_con);
     for(int i = 0; i < sz; i++) {
-        va_led_send_vl((va_led_specs_t *)va_led_conf, i);
+        va_led_send_vl(va_led_con, i);
     }
 }
 
@@ -127,11 +188,11 @@ static void va_led_task(void *arg)
         xSemaphoreTake(led_st.va_led_patttern_sema, va_led_tick);
         //Handle Mute
         if (va_led_priority[0].va_led_priority_status) {
-            if (!(va_led_con[VA_LED_MIC_OFF_START].va_led_state_st->loop_en)) {
-              va_led_set_state(va_led_con[VA_LED_MIC_OFF_START].va_led_state_sz, va_led_con[VA_LED_MIC_OFF_START].va_led_state_st);
+            if (!va_led_loop_en(&va_led_con[VA_LED_MIC_OFF_START])) {
+              va_led_set_state(&va_led_con[VA_LED_MIC_OFF_START]);
             }
-            if (!(va_led_con[VA_LED_MIC_OFF_ON].va_led_state_st->loop_en)) {
-                va_led_set_state(va_led_con[VA_LED_MIC_OFF_ON].va_led_state_sz, va_led_con[VA_LED_MIC_OFF_ON].va_led_state_st);
+            if (!va_led_loop_en(&va_led_con[VA_LED_MIC_OFF_ON])) {
+                va_led_set_state(&va_led_con[VA_LED_MIC_OFF_ON]);
             }
             va_led_is_mute = true;
             va_led_priority[0].va_led_priority_status = false;
@@ -139,8 +200,8 @@ static void va_led_task(void *arg)
         }
         //Handle Un-mute
         if (va_led_priority[1].va_led_priority_status) {
-            if (!(va_led_con[VA_LED_MIC_OFF_END].va_led_state_st->loop_en)) {
-                va_led_set_state(va_led_con[VA_LED_MIC_OFF_END].va_led_state_sz, va_led_con[VA_LED_MIC_OFF_END].va_led_state_st);
+            if (!va_led_loop_en(&va_led_con[VA_LED_MIC_OFF_END])) {
+                va_led_set_state(&va_led_con[VA_LED_MIC_OFF_END]);
             }
             va_led_is_mute = false;
             va_led_priority[1].va_led_priority_status = false;
@@ -150,14 +211,14 @@ static void va_led_task(void *arg)
         if (va_led_priority[2].va_led_priority_status) {
             if(volume_to_set == 0 || va_led_priority[2].va_led_current_state == VA_SPEAKER_MUTE_ENABLE) {
                 for(int i = 0; i < 3; i++) {
-                    va_led_set_state(va_led_con[VA_LED_SPEAKER_MUTE].va_led_state_sz, va_led_con[VA_LED_SPEAKER_MUTE].va_led_state_st);
+                    va_led_set_state(&va_led_con[VA_LED_SPEAKER_MUTE]);
                 }
             } else {
                 uint8_t vol = volume_to_set / 5;
                 if (vol <= 0) {
                     vol = 1;
                 }
-                va_led_send_vl(va_led_con[VA_LED_SPEAKER_VOL].va_led_state_st, vol - 1);
+                va_led_send_vl(&va_led_con[VA_LED_SPEAKER_VOL], vol - 1);
                 vTaskDelay(178 / portTICK_RATE_MS); //Need to figue out this delay
             }
             va_led_priority[2].va_led_priority_status = false;
@@ -166,12 +227,12 @@ static void va_led_task(void *arg)
         if (va_led_priority[3].va_led_priority_status) {
             switch (va_led_priority[3].va_led_current_state) {
                 case VA_CAN_START :
-                    if (!(va_led_con[VA_LED_BOOTUP_1].va_led_state_st->loop_en)) {
-                        va_led_set_state(va_led_con[VA_LED_BOOTUP_1].va_led_state_sz, va_led_con[VA_LED_BOOTUP_1].va_led_state_st);  //bootup 1
+                    if (!va_led_loop_en(&va_led_con[VA_LED_BOOTUP_1])) {
+                        va_led_set_state(&va_led_con[VA_LED_BOOTUP_1]);  //bootup 1
                     }
                     while (!(va_boot_is_finish()) && !(va_led_priority[3].va_led_current_state == LED_OFF)) {
-                        va_led_send_vl(va_led_con[VA_LED_BOOTUP_2].va_led_state_st, counter);
-                        counter = (counter + 1) % va_led_con[VA_LED_BOOTUP_2].va_led_state_sz;
+                        va_led_send_vl(&va_led_con[VA_LED_BOOTUP_2], counter);
+                        counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_BOOTUP_2]);
                     }
                     va_led_tick = portMAX_DELAY;
                 break;
@@ -185,38 +246,38 @@ static void va_led_task(void *arg)
 #endif
 
                     if(va_led_listening_end_flag && (va_led_priority[3].va_led_current_state == VA_IDLE)) {
-                        va_led_set_state(va_led_con[VA_LED_WW_DEACTIVATE].va_led_state_sz, va_led_con[VA_LED_WW_DEACTIVATE].va_led_state_st);
+                        va_led_set_state(&va_led_con[VA_LED_WW_DEACTIVATE]);
                         va_led_listening_end_flag = false;
                         va_led_listen_on_going = false;
                     }
                     if (va_led_dnd_st) {
-                        va_led_set_state(va_led_con[VA_LED_DND].va_led_state_sz, va_led_con[VA_LED_DND].va_led_state_st);
+                        va_led_set_state(&va_led_con[VA_LED_DND]);
                         va_led_dnd_st = false;
                     }
                     if (va_led_error_st) {
-                        va_led_set_state(va_led_con[VA_LED_ERROR].va_led_state_sz, va_led_con[VA_LED_ERROR].va_led_state_st);
+                        va_led_set_state(&va_led_con[VA_LED_ERROR]);
                         va_led_error_st = false;
                     }
                     if (NOTIFICATION_IS_PRESENT && (!(ALERT_IS_PRESENT > 0) || va_led_notif_incoming_is_done == true)) {
                         if(va_led_notif_incoming_is_done) {
-                            va_led_set_state(va_led_con[VA_LED_NTF_INCOMING].va_led_state_sz, va_led_con[VA_LED_NTF_INCOMING].va_led_state_st);
+                            va_led_set_state(&va_led_con[VA_LED_NTF_INCOMING]);
                             va_led_notif_incoming_is_done = false;
                         }
                         if (!(ALERT_IS_PRESENT > 0)) {
-                            va_led_send_vl(va_led_con[VA_LED_NTF_QUEUED].va_led_state_st, counter);
-                            counter = (counter + 1) % va_led_con[VA_LED_NTF_QUEUED].va_led_state_sz;
+                            va_led_send_vl(&va_led_con[VA_LED_NTF_QUEUED], counter);
+                            counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_NTF_QUEUED]);
                             va_led_tick = 0;
                         }
                     } else if (ALERT_IS_PRESENT > 0) {
-                        va_led_send_vl(va_led_con[VA_LED_ALERT].va_led_state_st, counter);
-                        counter = (counter + 1) % va_led_con[VA_LED_ALERT].va_led_state_sz;
+                        va_led_send_vl(&va_led_con[VA_LED_ALERT], counter);
+                        counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_ALERT]);
                         va_led_tick = 0;
                     } else if(va_led_is_mute) {
-                        va_led_send_vl(va_led_con[VA_LED_MIC_OFF_ON].va_led_state_st, (va_led_con[VA_LED_MIC_OFF_ON].va_led_state_sz -1));
+                        va_led_send_vl(&va_led_con[VA_LED_MIC_OFF_ON], (va_led_num_frames(&va_led_con[VA_LED_MIC_OFF_ON]) - 1));
                         va_led_tick = portMAX_DELAY;
                         break;
                     } else {
-                        va_led_set_state(va_led_con[VA_LED_OFF].va_led_state_sz, va_led_con[VA_LED_OFF].va_led_state_st);  //LED off
+                        va_led_set_state(&va_led_con[VA_LED_OFF]);  //LED off
                         va_led_tick = portMAX_DELAY;
                     }
                 break;
@@ -225,19 +286,19 @@ static void va_led_task(void *arg)
 					gpio_set_level(TRI_LED, 0);
 #endif
                     va_led_listening_end_flag = true;
-                    if (va_led_listen_on_going == false && !(va_led_con[VA_LED_WW_ACTIVE].va_led_state_st->loop_en)) {
-                        va_led_set_state(va_led_con[VA_LED_WW_ACTIVE].va_led_state_sz, va_led_con[VA_LED_WW_ACTIVE].va_led_state_st);
+                    if (va_led_listen_on_going == false && !va_led_loop_en(&va_led_con[VA_LED_WW_ACTIVE])) {
+                        va_led_set_state(&va_led_con[VA_LED_WW_ACTIVE]);
                         va_led_listen_on_going = true;
                         va_led_alert_short_en = false;
                     }
                     if (va_led_alert_short_en) {
-                        va_led_send_vl(va_led_con[VA_LED_ALERT_SHORT].va_led_state_st, counter);
-                        if ((counter = (counter + 1) % va_led_con[VA_LED_ALERT_SHORT].va_led_state_sz) == 0) {
+                        va_led_send_vl(&va_led_con[VA_LED_ALERT_SHORT], counter);
+                        if ((counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_ALERT_SHORT])) == 0) {
                             va_led_alert_short_en = false;
                         }
                         va_led_tick = 0;
                     } else {
-                        va_led_send_vl(va_led_con[VA_LED_WW_ONGOING].va_led_state_st, 0);
+                        va_led_send_vl(&va_led_con[VA_LED_WW_ONGOING], 0);
                         va_led_tick = portMAX_DELAY;
                     }
                 break;
@@ -245,13 +306,13 @@ static void va_led_task(void *arg)
                     va_led_listening_end_flag = true;
                     va_led_listen_on_going = false;
                     if (va_led_alert_short_en) {
-                        va_led_send_vl(va_led_con[VA_LED_ALERT_SHORT].va_led_state_st, counter);
-                        if ((counter = (counter + 1) % va_led_con[VA_LED_ALERT_SHORT].va_led_state_sz) == 0) {
+                        va_led_send_vl(&va_led_con[VA_LED_ALERT_SHORT], counter);
+                        if ((counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_ALERT_SHORT])) == 0) {
                             va_led_alert_short_en = false;
                         }
                     } else {
-                        va_led_send_vl(va_led_con[VA_LED_THINKING].va_led_state_st, counter);
-                        counter = (counter + 1) % va_led_con[VA_LED_THINKING].va_led_state_sz;
+                        va_led_send_vl(&va_led_con[VA_LED_THINKING], counter);
+                        counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_THINKING]);
                     }
                     va_led_tick = 0;
                 break;
@@ -263,13 +324,13 @@ static void va_led_task(void *arg)
                     va_led_listening_end_flag = true;
                     va_led_listen_on_going = false;
                     if (va_led_alert_short_en) {
-                        va_led_send_vl(va_led_con[VA_LED_ALERT_SHORT].va_led_state_st, counter);
-                        if ((counter = (counter + 1) % va_led_con[VA_LED_ALERT_SHORT].va_led_state_sz) == 0) {
+                        va_led_send_vl(&va_led_con[VA_LED_ALERT_SHORT], counter);
+                        if ((counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_ALERT_SHORT])) == 0) {
                             va_led_alert_short_en = false;
                         }
                     } else {
-                        va_led_send_vl(va_led_con[VA_LED_SPEAKING].va_led_state_st, counter);
-                        counter = (counter + 1) % va_led_con[VA_LED_SPEAKING].va_led_state_sz;
+                        va_led_send_vl(&va_led_con[VA_LED_SPEAKING], counter);
+                        counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_SPEAKING]);
                     }
                     va_led_tick = 0;
                     if (DND_IS_PRESENT) {
@@ -277,17 +338,17 @@ static void va_led_task(void *arg)
                     }
                     break;
                 case LED_RESET :
-                    va_led_send_vl(va_led_con[VA_LED_FACTORY_RESET].va_led_state_st, counter);
-                    counter = (counter + 1) % va_led_con[VA_LED_FACTORY_RESET].va_led_state_sz;
+                    va_led_send_vl(&va_led_con[VA_LED_FACTORY_RESET], counter);
+                    counter = (counter + 1) % va_led_num_frames(&va_led_con[VA_LED_FACTORY_RESET]);
                     va_led_tick = 0;
                 break;
                 case LED_OTA :
-                    va_led_set_state(va_led_con[VA_LED_OTA].va_led_state_sz, va_led_con[VA_LED_OTA].va_led_state_st);  //led off
+                    va_led_set_state(&va_led_con[VA_LED_OTA]);  //led off
                     va_led_tick = portMAX_DELAY;
                 break;
                 case LED_OFF :
-                    if (!(va_led_con[VA_LED_OFF].va_led_state_st->loop_en)) {
-                        va_led_set_state(va_led_con[VA_LED_OFF].va_led_state_sz, va_led_con[VA_LED_OFF].va_led_state_st);  //led off
+                    if (!va_led_loop_en(&va_led_con[VA_LED_OFF])) {
+                        va_led_set_state(&va_led_con[VA_LED_OFF]);  //led off
                     }
                     va_led_tick = portMAX_DELAY;
                 break;
@@ -330,6 +391,11 @@ void va_led_set_alert(alexa_alert_types_t alert_type, alexa_alert_state_t alert_
     }
 }
 
+void va_led_set_fade_cb(va_led_fade_cb_t fade_cb)
+{
+    va_led_fade_cb = fade_cb;
+}
+
 void va_led_set_dnd(bool dnd_state)
 {
     DND_IS_PRESENT = dnd_state;
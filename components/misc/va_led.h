@@ -10,6 +10,7 @@
 #include "esp_system.h"
 #include <voice_assistant.h>
 #include <voice_assistant_app_cb.h>
+#include <va_led_anim.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -44,11 +45,23 @@ typedef enum {
     VA_LED_SINGLE,
 } va_led_animation_type_t;
 
+/*
+ * The layout is shared with pattern tables built into the prebuilt voice
+ * assistant libraries (led_radial12), so an animation takes the place of the
+ * frame table instead of adding a member.
+ */
 typedef struct {
     uint8_t va_led_state_sz;
-    va_led_specs_t *va_led_state_st;
+    union {
+        va_led_specs_t *va_led_state_st;
+        /* With va_led_state_sz 0, the pattern is rendered from keyframes */
+        const va_led_anim_t *va_led_anim;
+    };
 } va_led_config_t;
 
+/* Start a hardware fade of all the LEDs towards va_led_v, completing in fade_ms */
+typedef void (*va_led_fade_cb_t)(const uint32_t *va_led_v, int fade_ms);
+
 enum {
     VA_LED_BOOTUP_1 = 0,
     VA_LED_BOOTUP_2,
@@ -85,6 +98,15 @@ esp_err_t va_led_init(va_led_config_t va_led_conf[VA_LED_PATTERN_MAX]);
 
 void va_led_set_pwm(const uint32_t * va_led_v);
 
+/**
+ * @brief Let keyframe animations drive hardware fades
+ *
+ * Boards whose LED driver can fade on its own register a callback here. Keyframe
+ * animations are then played one keyframe segment at a time instead of one
+ * frame at a time. Call before va_led_init().
+ */
+void va_led_set_fade_cb(va_led_fade_cb_t fade_cb);
+
 void va_led_set_alert(alexa_alert_types_t alert_type, alexa_alert_state_t alert_state);
 
 void va_led_set_dnd(bool dnd_state);
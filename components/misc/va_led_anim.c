@@ -0,0 +1,72 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+#include <string.h>
+#include <va_led_anim.h>
+
+#define Q15_ONE     (1 << 15)
+
+uint8_t va_led_anim_frame_ms(const va_led_anim_t *anim)
+{
+    return anim->frame_ms ? anim->frame_ms : VA_LED_ANIM_FRAME_MS;
+}
+
+uint16_t va_led_anim_num_frames(const va_led_anim_t *anim)
+{
+    uint16_t frames = anim->duration_ms / va_led_anim_frame_ms(anim);
+    return frames ? frames : 1;
+}
+
+/* p and the result are in Q15, 0 to Q15_ONE */
+static uint32_t va_led_anim_ease(uint8_t ease, uint32_t p)
+{
+    switch (ease) {
+        case VA_LED_EASE_IN:
+            return (p * p) >> 15;
+        case VA_LED_EASE_OUT:
+            return (p * (2 * Q15_ONE - p)) >> 15;
+        case VA_LED_EASE_IN_OUT:
+            return (((p * p) >> 15) * (3 * Q15_ONE - 2 * p)) >> 15;
+        case VA_LED_EASE_STEP:
+            return 0;
+        case VA_LED_EASE_LINEAR:
+        default:
+            return p;
+    }
+}
+
+static uint32_t va_led_anim_lerp(uint32_t a, uint32_t b, uint32_t e)
+{
+    uint32_t val = 0;
+    for (int shift = 0; shift < 24; shift += 8) {
+        int32_t ca = (a >> shift) & 0xFF;
+        int32_t cb = (b >> shift) & 0xFF;
+        val |= (uint32_t)(ca + (((cb - ca) * (int32_t)e) >> 15)) << shift;
+    }
+    return val;
+}
+
+void va_led_anim_render(const va_led_anim_t *anim, uint32_t t_ms, uint32_t *va_led_val)
+{
+    const va_led_keyframe_t *from, *to;
+    uint32_t p, e;
+    int i = 0;
+
+    if (t_ms > anim->duration_ms) {
+        t_ms = anim->duration_ms;
+    }
+    while ((i + 1 < anim->num_kf) && (anim->kf[i + 1].t_ms <= t_ms)) {
+        i++;
+    }
+    from = &anim->kf[i];
+    if (i + 1 >= anim->num_kf || from->ease == VA_LED_EASE_STEP) {
+        memcpy(va_led_val, from->va_led_val, sizeof(from->va_led_val));
+        return;
+    }
+    to = &anim->kf[i + 1];
+    p = ((t_ms - from->t_ms) << 15) / (to->t_ms - from->t_ms);
+    e = va_led_anim_ease(from->ease, p);
+    for (i = 0; i < VA_LED_ANIM_NUM_LEDS; i++) {
+        va_led_val[i] = va_led_anim_lerp(from->va_led_val[i], to->va_led_val[i], e);
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+#ifndef _VA_LED_ANIM_H_
+#define _VA_LED_ANIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default frame period of an animation, in ms (50 fps) */
+#define VA_LED_ANIM_FRAME_MS    20
+
+#define VA_LED_ANIM_NUM_LEDS    12
+
+/* Curve used to go from a keyframe to the next one */
+typedef enum {
+    VA_LED_EASE_LINEAR = 0,
+    VA_LED_EASE_IN,         /* Quadratic, slow start */
+    VA_LED_EASE_OUT,        /* Quadratic, slow end */
+    VA_LED_EASE_IN_OUT,     /* Smoothstep */
+    VA_LED_EASE_STEP,       /* Hold this keyframe until the next one */
+} va_led_ease_t;
+
+typedef struct {
+    uint16_t t_ms;                                  /* Offset from the start of the animation */
+    uint8_t ease;                                   /* va_led_ease_t towards the next keyframe */
+    uint32_t va_led_val[VA_LED_ANIM_NUM_LEDS];      /* 0xRRGGBB per LED */
+} va_led_keyframe_t;
+
+typedef struct {
+    const va_led_keyframe_t *kf;    /* Keyframes, sorted by t_ms, the first one at 0 */
+    uint8_t num_kf;
+    uint16_t duration_ms;           /* The last keyframe is held until then */
+    uint8_t frame_ms;               /* Frame period, 0 for VA_LED_ANIM_FRAME_MS */
+    bool loop_en;
+} va_led_anim_t;
+
+/**
+ * @brief Number of frames the animation is rendered in at its frame rate
+ */
+uint16_t va_led_anim_num_frames(const va_led_anim_t *anim);
+
+/**
+ * @brief Frame period of the animation, in ms
+ */
+uint8_t va_led_anim_frame_ms(const va_led_anim_t *anim);
+
+/**
+ * @brief Interpolate the LED values of the animation at time t_ms
+ *
+ * Interpolation is done per colour channel in Q15 fixed point.
+ *
+ * @param[in]  anim        The animation
+ * @param[in]  t_ms        Time from the start of the animation, clamped to duration_ms
+ * @param[out] va_led_val  VA_LED_ANIM_NUM_LEDS values in the va_led_set_pwm() format
+ */
+void va_led_anim_render(const va_led_anim_t *anim, uint32_t t_ms, uint32_t *va_led_val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VA_LED_ANIM_H_ */
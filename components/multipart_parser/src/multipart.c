@@ -28,6 +28,7 @@ This file has the function definations required for the multipart parser
 
 #include <stdio.h>
 #include <multipart.h>
+#include <va_latency.h>
 
 static const char *TAG = "[multipart]";
 
@@ -136,6 +137,7 @@ int multipart_parse_data(multipart_handle_t *handle, multipart_callbacks_t *cbs,
             if (buffer[handle->iterator] == '\r') {
                 if (handle->first_header_name) {
                     cbs->part_begin_cb(handle);
+                    va_latency_mark(VA_LATENCY_MULTIPART);
                     handle->first_header_name = 0;
                     handle->prev_matcher = 0;
                     handle->matcher = 0;
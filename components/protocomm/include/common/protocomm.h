@@ -117,6 +117,8 @@ esp_err_t protocomm_remove_endpoint(protocomm_t *pc, const char *ep_name);
  *  - An endpoint must be bound to a valid protocomm instance,
  *    created using `protocomm_new()`.
  *  - Resulting output buffer must be deallocated by the user.
+ *  - Transports that can hand over a writable request buffer should use
+ *    `protocomm_req_handle_inplace()`, which saves copying the output.
  *
  * @param[in]  pc         Pointer to the protocomm instance
  * @param[in]  ep_name    Endpoint identifier(name) string
@@ -140,6 +142,52 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
                                const uint8_t *inbuf, ssize_t inlen,
                                uint8_t **outbuf, ssize_t *outlen);
 
+/**
+ * @brief   Same as `protocomm_req_handle()`, but decrypts the request
+ *          over the input buffer itself and leaves the output in the
+ *          request arena
+ *
+ * Transports which own a writable copy of the request should prefer this
+ * API, as it saves allocating and filling a separate plaintext buffer,
+ * and copying the output out of the arena.
+ *
+ * @note
+ *  - Contents of `inbuf` are undefined once this returns.
+ *  - Resulting output buffer must be released through
+ *    `protocomm_req_release()`, not free(), once it has been sent.
+ *
+ * @param[in]  pc         Pointer to the protocomm instance
+ * @param[in]  ep_name    Endpoint identifier(name) string
+ * @param[in]  session_id Unique ID for a communication session
+ * @param[in]  inbuf      Writable input buffer containing request data
+ * @param[in]  inlen      Length of the input buffer
+ * @param[out] outbuf     Pointer to internally allocated output buffer
+ * @param[out] outlen     Buffer length of the allocated output buffer
+ *
+ * @return
+ *  - Same as `protocomm_req_handle()`
+ */
+esp_err_t protocomm_req_handle_inplace(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                                       uint8_t *inbuf, ssize_t inlen,
+                                       uint8_t **outbuf, ssize_t *outlen);
+
+/**
+ * @brief   Release the output buffer and request memory of the last request
+ *
+ * Messages, crypto buffers and the output buffer of a request are
+ * allocated from a per-request arena. This API frees all of it in one
+ * go, and should be called by the transport once it is done sending the
+ * output buffer returned by `protocomm_req_handle_inplace()`.
+ *
+ * @note    Output buffers which were allocated by handlers using plain
+ *          malloc() are freed as well.
+ *
+ * @param[in] pc        Pointer to the protocomm instance
+ * @param[in] outbuf    Output buffer returned by `protocomm_req_handle_inplace()`
+ *                      (can be NULL)
+ */
+void protocomm_req_release(protocomm_t *pc, uint8_t *outbuf);
+
 /**
  * @brief   Add endpoint security for a protocomm instance
  *
@@ -0,0 +1,62 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <protobuf-c/protobuf-c.h>
+
+/**
+ * @brief   Allocate memory for the request currently being handled
+ *
+ * While an endpoint handler runs from within `protocomm_req_handle()`,
+ * allocations are carved out of a per-request arena owned by the protocomm
+ * instance and are all released together once the transport is done with
+ * the response (see `protocomm_req_release()`). Outside of a request, or
+ * if the arena is already in use by another task, this falls back to malloc.
+ *
+ * @note    Memory returned by this API must only be released through
+ *          `protocomm_req_free()`. This is also the preferred way for
+ *          handlers to allocate their output buffer.
+ *
+ * @param[in] size  Number of bytes to allocate
+ *
+ * @return
+ *  - Pointer to allocated memory on success
+ *  - NULL : Out of memory
+ */
+void *protocomm_req_alloc(size_t size);
+
+/**
+ * @brief   Free memory obtained through `protocomm_req_alloc()`
+ *
+ * Arena memory is left alone (it goes away with the request), everything
+ * else is handed to free(). NULL is ignored.
+ *
+ * @param[in] ptr   Pointer to memory to be freed
+ */
+void protocomm_req_free(void *ptr);
+
+/**
+ * @brief   Get the protobuf-c allocator for the request currently being handled
+ *
+ * Pass the result to the `*__unpack()` and `*__free_unpacked()` calls
+ * of generated protobuf-c code, so that the unpacked message is built
+ * inside the request arena.
+ *
+ * @return
+ *  - Pointer to the arena allocator inside a request
+ *  - NULL : Not inside a request. protobuf-c then uses its default allocator
+ */
+ProtobufCAllocator *protocomm_req_allocator(void);
@@ -78,14 +78,16 @@ typedef struct protocomm_security {
                                       void *priv_data);
 
     /**
-     * Function which implements the encryption algorithm
+     * Function which implements the encryption algorithm.
+     * Must work in place, i.e. with inbuf == outbuf
      */
     esp_err_t (*encrypt)(uint32_t session_id,
                          const uint8_t *inbuf, ssize_t inlen,
                          uint8_t *outbuf, ssize_t *outlen);
 
     /**
-     * Function which implements the decryption algorithm
+     * Function which implements the decryption algorithm.
+     * Must work in place, i.e. with inbuf == outbuf
      */
     esp_err_t (*decrypt)(uint32_t session_id,
                          const uint8_t *inbuf, ssize_t inlen,
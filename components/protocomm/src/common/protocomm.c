@@ -21,6 +21,7 @@
 
 #include <protocomm.h>
 #include <protocomm_security.h>
+#include <protocomm_arena.h>
 
 #include "protocomm_priv.h"
 
@@ -36,6 +37,7 @@ protocomm_t *protocomm_new()
        return NULL;
     }
     SLIST_INIT(&pc->endpoints);
+    protocomm_arena_init(&pc->arena);
 
     return pc;
 }
@@ -52,6 +54,7 @@ void protocomm_delete(protocomm_t *pc)
         free(it);
     }
 
+    protocomm_arena_deinit(&pc->arena);
     free(pc);
 }
 
@@ -136,9 +139,13 @@ esp_err_t protocomm_remove_endpoint(protocomm_t *pc, const char *ep_name)
     return ESP_ERR_NOT_FOUND;
 }
 
-esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t session_id,
-                               const uint8_t *inbuf, ssize_t inlen,
-                               uint8_t **outbuf, ssize_t *outlen)
+/* `inplace` is either NULL or `inbuf` itself, when the transport lets
+ * the request be decrypted over its own buffer */
+static esp_err_t protocomm_req_handle_internal(protocomm_t *pc, const char *ep_name,
+                                               uint32_t session_id,
+                                               const uint8_t *inbuf, uint8_t *inplace,
+                                               ssize_t inlen,
+                                               uint8_t **outbuf, ssize_t *outlen)
 {
     if ((pc == NULL) || (ep_name == NULL)) {
         ESP_LOGE(TAG, "Invalid params %p %p", pc, ep_name);
@@ -151,6 +158,11 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
         return ESP_ERR_NOT_FOUND;
     }
 
+    /* Drop whatever a previous request left behind, in case
+     * the transport did not call protocomm_req_release() */
+    protocomm_arena_reset(&pc->arena);
+    bool arena_entered = protocomm_arena_enter(&pc->arena);
+
     esp_err_t ret = ESP_FAIL;
     if (ep->flag & SEC_EP) {
         /* Call the registered endpoint handler for establishing secure session */
@@ -158,15 +170,24 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
         ESP_LOGD(TAG, "SEC_EP Req handler returned %d", ret);
     } else if (ep->flag & REQ_EP) {
         if (pc->sec && pc->sec->decrypt) {
-            /* Decrypt the data first */
-            uint8_t *dec_inbuf = (uint8_t *) malloc(inlen);
+            /* Decrypt the data first. AES-CTR is a stream cipher, so this
+             * is done in place whenever the transport allows it */
+            uint8_t *dec_inbuf = inplace;
             if (!dec_inbuf) {
-                ESP_LOGE(TAG, "Failed to allocate decrypt buf len %d", inlen);
-                return ESP_ERR_NO_MEM;
+                dec_inbuf = (uint8_t *) protocomm_req_alloc(inlen);
+                if (!dec_inbuf) {
+                    ESP_LOGE(TAG, "Failed to allocate decrypt buf len %d", inlen);
+                    ret = ESP_ERR_NO_MEM;
+                    goto exit;
+                }
             }
 
             ssize_t dec_inbuf_len = inlen;
-            pc->sec->decrypt(session_id, inbuf, inlen, dec_inbuf, &dec_inbuf_len);
+            ret = pc->sec->decrypt(session_id, inbuf, inlen, dec_inbuf, &dec_inbuf_len);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Decryption of request for %s failed", ep_name);
+                goto exit;
+            }
 
             /* Invoke the request handler */
             uint8_t *plaintext_resp;
@@ -175,32 +196,29 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
                                   dec_inbuf, dec_inbuf_len,
                                   &plaintext_resp, &plaintext_resp_len,
                                   ep->priv_data);
+            if (dec_inbuf != inplace) {
+                /* We don't need decrypted data anymore */
+                protocomm_req_free(dec_inbuf);
+            }
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Request handler for %s failed", ep_name);
                 *outbuf = NULL;
                 *outlen = 0;
-                free(dec_inbuf);
-                return ret;
-            }
-            /* We don't need decrypted data anymore */
-            free(dec_inbuf);
-
-            /* Encrypt response to be sent back */
-            uint8_t *enc_resp = (uint8_t *) malloc(plaintext_resp_len);
-            if (!enc_resp) {
-                ESP_LOGE(TAG, "Failed to allocate decrypt buf len %d", inlen);
-                return ESP_ERR_NO_MEM;
+                goto exit;
             }
 
+            /* Encrypt response in place, the handler allocated it for us */
             ssize_t enc_resp_len = plaintext_resp_len;
-            pc->sec->encrypt(session_id, plaintext_resp, plaintext_resp_len,
-                             enc_resp, &enc_resp_len);
-
-            /* We no more need plaintext response */
-            free(plaintext_resp);
+            ret = pc->sec->encrypt(session_id, plaintext_resp, plaintext_resp_len,
+                                   plaintext_resp, &enc_resp_len);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Encryption of response for %s failed", ep_name);
+                protocomm_req_free(plaintext_resp);
+                goto exit;
+            }
 
             /* Set outbuf and outlen appropriately */
-            *outbuf = enc_resp;
+            *outbuf = plaintext_resp;
             *outlen = enc_resp_len;
         } else {
             /* No encryption */
@@ -214,9 +232,66 @@ esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t se
         ret = ep->req_handler(session_id, inbuf, inlen, outbuf, outlen, ep->priv_data);
         ESP_LOGD(TAG, "VER_EP Req handler returned %d", ret);
     }
+
+exit:
+    if (arena_entered) {
+        protocomm_arena_exit(&pc->arena);
+    }
+    if (ret != ESP_OK) {
+        protocomm_arena_reset(&pc->arena);
+    }
     return ret;
 }
 
+esp_err_t protocomm_req_handle(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                               const uint8_t *inbuf, ssize_t inlen,
+                               uint8_t **outbuf, ssize_t *outlen)
+{
+    esp_err_t ret = protocomm_req_handle_internal(pc, ep_name, session_id, inbuf, NULL, inlen,
+                                                  outbuf, outlen);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* Callers free() the output themselves, so it can't stay in the arena */
+    if (*outbuf && protocomm_arena_owns(&pc->arena, *outbuf)) {
+        uint8_t *copy = malloc(*outlen > 0 ? *outlen : 1);
+        if (!copy) {
+            ESP_LOGE(TAG, "Failed to allocate output buf len %d", *outlen);
+            protocomm_arena_reset(&pc->arena);
+            *outbuf = NULL;
+            *outlen = 0;
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(copy, *outbuf, *outlen);
+        *outbuf = copy;
+    }
+    protocomm_arena_reset(&pc->arena);
+    return ESP_OK;
+}
+
+esp_err_t protocomm_req_handle_inplace(protocomm_t *pc, const char *ep_name, uint32_t session_id,
+                                       uint8_t *inbuf, ssize_t inlen,
+                                       uint8_t **outbuf, ssize_t *outlen)
+{
+    return protocomm_req_handle_internal(pc, ep_name, session_id, inbuf, inbuf, inlen,
+                                         outbuf, outlen);
+}
+
+void protocomm_req_release(protocomm_t *pc, uint8_t *outbuf)
+{
+    if (pc == NULL) {
+        free(outbuf);
+        return;
+    }
+
+    /* Output produced by handlers that still use malloc */
+    if (outbuf && !protocomm_arena_owns(&pc->arena, outbuf)) {
+        free(outbuf);
+    }
+    protocomm_arena_reset(&pc->arena);
+}
+
 static int protocomm_common_security_handler(uint32_t session_id,
                                              const uint8_t *inbuf, ssize_t inlen,
                                              uint8_t **outbuf, ssize_t *outlen,
@@ -332,8 +407,8 @@ static int protocomm_version_handler(uint32_t session_id,
 
     /* Output is a non null terminated string with length specified */
     *outlen = strlen(result_msg);
-    *outbuf = malloc(strlen(result_msg));
-    if (outbuf == NULL) {
+    *outbuf = protocomm_req_alloc(strlen(result_msg));
+    if (*outbuf == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for version check response");
         return ESP_ERR_NO_MEM;
     }
@@ -0,0 +1,189 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <protocomm.h>
+#include <protocomm_arena.h>
+
+#include "protocomm_priv.h"
+
+static const char *TAG = "protocomm_arena";
+
+/* Allocations larger than what is left in the arena block are served from
+ * separate chunks, linked together so that they go away on reset as well */
+struct protocomm_arena_chunk {
+    struct protocomm_arena_chunk *next;
+    size_t size;
+    uint64_t data[];
+};
+
+#define ARENA_ALIGN(size)   (((size) + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1))
+
+/* Arena of the request being handled, and the task handling it. Only one
+ * request at a time gets an arena, concurrent ones fall back to malloc. */
+static protocomm_arena_t *active_arena;
+static TaskHandle_t active_task;
+static portMUX_TYPE active_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void *arena_pb_alloc(void *allocator_data, size_t size)
+{
+    return protocomm_arena_alloc((protocomm_arena_t *) allocator_data, size);
+}
+
+static void arena_pb_free(void *allocator_data, void *ptr)
+{
+    /* Released with the arena */
+}
+
+void protocomm_arena_init(protocomm_arena_t *arena)
+{
+    memset(arena, 0, sizeof(*arena));
+    arena->allocator.alloc = arena_pb_alloc;
+    arena->allocator.free = arena_pb_free;
+    arena->allocator.allocator_data = arena;
+}
+
+void *protocomm_arena_alloc(protocomm_arena_t *arena, size_t size)
+{
+    size = ARENA_ALIGN(size ? size : 1);
+
+    if (!arena->buf) {
+        /* Allocated on first use, kept for the lifetime of the instance */
+        arena->buf = malloc(PROTOCOMM_ARENA_SIZE);
+    }
+    if (arena->buf && (PROTOCOMM_ARENA_SIZE - arena->used) >= size) {
+        void *ptr = arena->buf + arena->used;
+        arena->used += size;
+        return ptr;
+    }
+
+    struct protocomm_arena_chunk *chunk = malloc(sizeof(*chunk) + size);
+    if (!chunk) {
+        ESP_LOGE(TAG, "Error allocating %d bytes", size);
+        return NULL;
+    }
+    ESP_LOGD(TAG, "Arena full, using overflow chunk of %d bytes", size);
+    chunk->size = size;
+    chunk->next = arena->overflow;
+    arena->overflow = chunk;
+    return chunk->data;
+}
+
+bool protocomm_arena_owns(const protocomm_arena_t *arena, const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *) ptr;
+    if (arena->buf && p >= arena->buf && p < arena->buf + PROTOCOMM_ARENA_SIZE) {
+        return true;
+    }
+    for (struct protocomm_arena_chunk *c = arena->overflow; c; c = c->next) {
+        if (p == (const uint8_t *) c->data) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void protocomm_arena_reset(protocomm_arena_t *arena)
+{
+    struct protocomm_arena_chunk *chunk = arena->overflow;
+    while (chunk) {
+        struct protocomm_arena_chunk *next = chunk->next;
+        /* Requests carry session keys and Wi-Fi credentials in plaintext */
+        memset(chunk->data, 0, chunk->size);
+        free(chunk);
+        chunk = next;
+    }
+    arena->overflow = NULL;
+
+    if (arena->buf) {
+        memset(arena->buf, 0, arena->used);
+    }
+    arena->used = 0;
+}
+
+void protocomm_arena_deinit(protocomm_arena_t *arena)
+{
+    protocomm_arena_reset(arena);
+    free(arena->buf);
+    arena->buf = NULL;
+}
+
+bool protocomm_arena_enter(protocomm_arena_t *arena)
+{
+    bool entered = false;
+
+    portENTER_CRITICAL(&active_lock);
+    if (active_arena == NULL) {
+        active_arena = arena;
+        active_task = xTaskGetCurrentTaskHandle();
+        entered = true;
+    }
+    portEXIT_CRITICAL(&active_lock);
+    return entered;
+}
+
+void protocomm_arena_exit(protocomm_arena_t *arena)
+{
+    portENTER_CRITICAL(&active_lock);
+    if (active_arena == arena) {
+        active_arena = NULL;
+        active_task = NULL;
+    }
+    portEXIT_CRITICAL(&active_lock);
+}
+
+static protocomm_arena_t *protocomm_arena_current()
+{
+    protocomm_arena_t *arena = NULL;
+
+    portENTER_CRITICAL(&active_lock);
+    if (active_arena && active_task == xTaskGetCurrentTaskHandle()) {
+        arena = active_arena;
+    }
+    portEXIT_CRITICAL(&active_lock);
+    return arena;
+}
+
+void *protocomm_req_alloc(size_t size)
+{
+    protocomm_arena_t *arena = protocomm_arena_current();
+    if (arena) {
+        return protocomm_arena_alloc(arena, size);
+    }
+    return malloc(size);
+}
+
+void protocomm_req_free(void *ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+    protocomm_arena_t *arena = protocomm_arena_current();
+    if (arena && protocomm_arena_owns(arena, ptr)) {
+        return;
+    }
+    free(ptr);
+}
+
+ProtobufCAllocator *protocomm_req_allocator()
+{
+    protocomm_arena_t *arena = protocomm_arena_current();
+    return arena ? &arena->allocator : NULL;
+}
@@ -14,8 +14,10 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <rom/queue.h>
 #include <protocomm_security.h>
+#include <protocomm_arena.h>
 #include <esp_err.h>
 
 #define PROTOCOMM_NO_SESSION_ID UINT32_MAX
@@ -26,6 +28,35 @@
 #define SEC_EP      (1 << 1)    /*!< Flag indicating security handling endpoint */
 #define VER_EP      (1 << 2)    /*!< Flag indicating version  handling endpoint */
 
+/* Size of the arena block backing a single request. Enough for session
+ * setup and Wi-Fi config messages, larger ones spill into malloc'ed chunks */
+#define PROTOCOMM_ARENA_SIZE    1024
+
+/**
+ * @brief   Per-request bump allocator
+ *
+ * Request and response messages, along with the crypto buffers of a
+ * request, are allocated from here and released in one go by
+ * protocomm_arena_reset() once the response has been sent.
+ */
+typedef struct protocomm_arena {
+    uint8_t *buf;                               /*!< Arena block, allocated on first use */
+    size_t used;                                /*!< Bytes handed out from the block */
+    struct protocomm_arena_chunk *overflow;     /*!< Allocations which did not fit the block */
+    ProtobufCAllocator allocator;               /*!< protobuf-c allocator backed by the arena */
+} protocomm_arena_t;
+
+void protocomm_arena_init(protocomm_arena_t *arena);
+void protocomm_arena_deinit(protocomm_arena_t *arena);
+void *protocomm_arena_alloc(protocomm_arena_t *arena, size_t size);
+bool protocomm_arena_owns(const protocomm_arena_t *arena, const void *ptr);
+void protocomm_arena_reset(protocomm_arena_t *arena);
+
+/* Make an arena the one used by protocomm_req_alloc() and friends on the
+ * calling task. Returns false if another request already holds the slot */
+bool protocomm_arena_enter(protocomm_arena_t *arena);
+void protocomm_arena_exit(protocomm_arena_t *arena);
+
 /**
  * @brief   Protocomm endpoint table entry prototype
  *
@@ -76,4 +107,7 @@ struct protocomm {
 
     /* Application specific version string */
     const char* ver;
+
+    /* Arena for allocations made while handling a request */
+    protocomm_arena_t arena;
 };
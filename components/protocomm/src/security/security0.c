@@ -19,6 +19,7 @@
 #include <esp_err.h>
 #include <esp_log.h>
 
+#include <protocomm_arena.h>
 #include <protocomm_security.h>
 #include <protocomm_security0.h>
 
@@ -32,10 +33,12 @@ static esp_err_t sec0_session_setup(uint32_t session_id,
                                     SessionData *req, SessionData *resp,
                                     const protocomm_security_pop_t *pop)
 {
-    Sec0Payload *out = (Sec0Payload *) malloc(sizeof(Sec0Payload));
-    S0SessionResp *s0resp = (S0SessionResp *) malloc(sizeof(S0SessionResp));
+    Sec0Payload *out = (Sec0Payload *) protocomm_req_alloc(sizeof(Sec0Payload));
+    S0SessionResp *s0resp = (S0SessionResp *) protocomm_req_alloc(sizeof(S0SessionResp));
     if (!out || !s0resp) {
         ESP_LOGE(TAG, "Error allocating response");
+        protocomm_req_free(out);
+        protocomm_req_free(s0resp);
         return ESP_ERR_NO_MEM;
     }
     sec0_payload__init(out);
@@ -54,12 +57,12 @@ static esp_err_t sec0_session_setup(uint32_t session_id,
 
 static void sec0_session_setup_cleanup(uint32_t session_id, SessionData *resp)
 {
-    if (!resp) {
+    if (!resp || !resp->sec0) {
         return;
     }
 
-    free(resp->sec0->sr);
-    free(resp->sec0);
+    protocomm_req_free(resp->sec0->sr);
+    protocomm_req_free(resp->sec0);
     return;
 }
 
@@ -72,31 +75,32 @@ static esp_err_t sec0_req_handler(const protocomm_security_pop_t *pop, uint32_t
     SessionData resp;
     esp_err_t ret;
 
-    req = session_data__unpack(NULL, inlen, inbuf);
+    req = session_data__unpack(protocomm_req_allocator(), inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack setup_req");
         return ESP_ERR_INVALID_ARG;
     }
     if (req->sec_ver != protocomm_security0.ver) {
         ESP_LOGE(TAG, "Security version mismatch. Closing connection");
+        session_data__free_unpacked(req, protocomm_req_allocator());
         return ESP_ERR_INVALID_ARG;
     }
 
     session_data__init(&resp);
     ret = sec0_session_setup(session_id, req, &resp, pop);
+    resp.sec_ver = req->sec_ver;
+    session_data__free_unpacked(req, protocomm_req_allocator());
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Session setup error %d", ret);
+        sec0_session_setup_cleanup(session_id, &resp);
         return ESP_FAIL;
     }
 
-    session_data__free_unpacked(req, NULL);
-
-    resp.sec_ver = req->sec_ver;
-
     *outlen = session_data__get_packed_size(&resp);
-    *outbuf = (uint8_t *) malloc(*outlen);
+    *outbuf = (uint8_t *) protocomm_req_alloc(*outlen);
     if (!*outbuf) {
         ESP_LOGE(TAG, "System out of memory");
+        sec0_session_setup_cleanup(session_id, &resp);
         return ESP_ERR_NO_MEM;
     }
     session_data__pack(&resp, *outbuf);
@@ -26,6 +26,7 @@
 #include <mbedtls/error.h>
 #include <mbedtls/ssl_internal.h>
 
+#include <protocomm_arena.h>
 #include <protocomm_security.h>
 #include <protocomm_security1.h>
 
@@ -58,6 +59,64 @@ typedef struct session {
 
 static session_t *cur_session;
 
+/* Contexts for the session handshake. These are large and the DRBG
+ * needs seeding from the entropy pool, so they are set up on the first
+ * handshake and kept around until security is cleaned up */
+typedef struct sec1_crypto {
+    mbedtls_ecdh_context     ctx_server;
+    mbedtls_entropy_context  entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+} sec1_crypto_t;
+
+static sec1_crypto_t *sec1_crypto;
+
+static void sec1_crypto_free()
+{
+    if (!sec1_crypto) {
+        return;
+    }
+    mbedtls_ecdh_free(&sec1_crypto->ctx_server);
+    mbedtls_ctr_drbg_free(&sec1_crypto->ctr_drbg);
+    mbedtls_entropy_free(&sec1_crypto->entropy);
+    free(sec1_crypto);
+    sec1_crypto = NULL;
+}
+
+static esp_err_t sec1_crypto_init()
+{
+    int mbed_err;
+
+    if (sec1_crypto) {
+        return ESP_OK;
+    }
+
+    sec1_crypto = (sec1_crypto_t *) calloc(1, sizeof(sec1_crypto_t));
+    if (!sec1_crypto) {
+        ESP_LOGE(TAG, "Failed to allocate memory for mbedtls context");
+        return ESP_ERR_NO_MEM;
+    }
+
+    mbedtls_ecdh_init(&sec1_crypto->ctx_server);
+    mbedtls_ctr_drbg_init(&sec1_crypto->ctr_drbg);
+    mbedtls_entropy_init(&sec1_crypto->entropy);
+
+    mbed_err = mbedtls_ctr_drbg_seed(&sec1_crypto->ctr_drbg, mbedtls_entropy_func,
+                                     &sec1_crypto->entropy, NULL, 0);
+    if (mbed_err != 0) {
+        ESP_LOGE(TAG, "Failed at mbedtls_ctr_drbg_seed with error code : -0x%x", -mbed_err);
+        sec1_crypto_free();
+        return ESP_FAIL;
+    }
+
+    mbed_err = mbedtls_ecp_group_load(&sec1_crypto->ctx_server.grp, MBEDTLS_ECP_DP_CURVE25519);
+    if (mbed_err != 0) {
+        ESP_LOGE(TAG, "Failed at mbedtls_ecp_group_load with error code : -0x%x", -mbed_err);
+        sec1_crypto_free();
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
 static void flip_endian(uint8_t *data, size_t len)
 {
     uint8_t swp_buf;
@@ -97,7 +156,9 @@ static esp_err_t handle_session_command1(uint32_t session_id,
         return ESP_ERR_INVALID_ARG;
     }
 
-    /* Initialise crypto context */
+    /* Initialise crypto context. It is kept for the lifetime of the
+     * session and used for every request, so drop any earlier key */
+    mbedtls_aes_free(&cur_session->ctx_aes);
     mbedtls_aes_init(&cur_session->ctx_aes);
     memset(cur_session->stb, 0, sizeof(cur_session->stb));
     cur_session->nc_off = 0;
@@ -130,25 +191,31 @@ static esp_err_t handle_session_command1(uint32_t session_id,
         return ESP_FAIL;
     }
 
-    Sec1Payload *out = (Sec1Payload *) malloc(sizeof(Sec1Payload));
+    Sec1Payload *out = (Sec1Payload *) protocomm_req_alloc(sizeof(Sec1Payload));
+    SessionResp1 *out_resp = (SessionResp1 *) protocomm_req_alloc(sizeof(SessionResp1));
+    uint8_t *outbuf = (uint8_t *) protocomm_req_alloc(PUBLIC_KEY_LEN);
+    if (!out || !out_resp || !outbuf) {
+        ESP_LOGE(TAG, "Error allocating memory for response");
+        protocomm_req_free(out);
+        protocomm_req_free(out_resp);
+        protocomm_req_free(outbuf);
+        return ESP_ERR_NO_MEM;
+    }
+
     sec1_payload__init(out);
-    SessionResp1 *out_resp = (SessionResp1 *) malloc(sizeof(SessionResp1));
     session_resp1__init(out_resp);
 
     out_resp->status = STATUS__Success;
 
-    uint8_t *outbuf = (uint8_t *) malloc(PUBLIC_KEY_LEN);
-    if (!outbuf) {
-        ESP_LOGE(TAG, "Error allocating ciphertext buffer");
-        return ESP_ERR_NO_MEM;
-    }
-
     mbed_err = mbedtls_aes_crypt_ctr(&cur_session->ctx_aes,
                                      PUBLIC_KEY_LEN, &cur_session->nc_off,
                                      cur_session->rand, cur_session->stb,
                                      cur_session->client_pubkey, outbuf);
     if (mbed_err != 0) {
         ESP_LOGE(TAG, "Failure at mbedtls_aes_crypt_ctr with error code : -0x%x", -mbed_err);
+        protocomm_req_free(out);
+        protocomm_req_free(out_resp);
+        protocomm_req_free(outbuf);
         return ESP_FAIL;
     }
 
@@ -198,35 +265,13 @@ static esp_err_t handle_session_command0(uint32_t session_id,
 
     cur_session->state = SESSION_STATE_1;
 
-    mbedtls_ecdh_context     *ctx_server = malloc(sizeof(mbedtls_ecdh_context));
-    mbedtls_entropy_context  *entropy    = malloc(sizeof(mbedtls_entropy_context));
-    mbedtls_ctr_drbg_context *ctr_drbg   = malloc(sizeof(mbedtls_ctr_drbg_context));
-    if (!ctx_server || !ctx_server || !ctr_drbg) {
-        ESP_LOGE(TAG, "Failed to allocate memory for mbedtls context");
-        free(ctx_server);
-        free(entropy);
-        free(ctr_drbg);
-        return ESP_ERR_NO_MEM;
-    }
-
-    mbedtls_ecdh_init(ctx_server);
-    mbedtls_ctr_drbg_init(ctr_drbg);
-    mbedtls_entropy_init(entropy);
-
-    mbed_err = mbedtls_ctr_drbg_seed(ctr_drbg, mbedtls_entropy_func,
-                                     entropy, NULL, 0);
-    if (mbed_err != 0) {
-        ESP_LOGE(TAG, "Failed at mbedtls_ctr_drbg_seed with error code : -0x%x", -mbed_err);
-        ret = ESP_FAIL;
-        goto exit_cmd0;
+    ret = sec1_crypto_init();
+    if (ret != ESP_OK) {
+        return ret;
     }
 
-    mbed_err = mbedtls_ecp_group_load(&ctx_server->grp, MBEDTLS_ECP_DP_CURVE25519);
-    if (mbed_err != 0) {
-        ESP_LOGE(TAG, "Failed at mbedtls_ecp_group_load with error code : -0x%x", -mbed_err);
-        ret = ESP_FAIL;
-        goto exit_cmd0;
-    }
+    mbedtls_ecdh_context     *ctx_server = &sec1_crypto->ctx_server;
+    mbedtls_ctr_drbg_context *ctr_drbg   = &sec1_crypto->ctr_drbg;
 
     mbed_err = mbedtls_ecdh_gen_public(&ctx_server->grp, &ctx_server->d, &ctx_server->Q,
                                        mbedtls_ctr_drbg_random, ctr_drbg);
@@ -312,10 +357,12 @@ static esp_err_t handle_session_command0(uint32_t session_id,
 
     hexdump("Device random", cur_session->rand, SZ_RANDOM);
 
-    Sec1Payload *out = (Sec1Payload *) malloc(sizeof(Sec1Payload));
-    SessionResp0 *out_resp = (SessionResp0 *) malloc(sizeof(SessionResp0));
+    Sec1Payload *out = (Sec1Payload *) protocomm_req_alloc(sizeof(Sec1Payload));
+    SessionResp0 *out_resp = (SessionResp0 *) protocomm_req_alloc(sizeof(SessionResp0));
     if (!out || !out_resp) {
         ESP_LOGE(TAG, "Error allocating memory for response");
+        protocomm_req_free(out);
+        protocomm_req_free(out_resp);
         ret = ESP_FAIL;
         goto exit_cmd0;
     }
@@ -342,14 +389,12 @@ static esp_err_t handle_session_command0(uint32_t session_id,
     ret = ESP_OK;
 
 exit_cmd0:
-    mbedtls_ecdh_free(ctx_server);
-    free(ctx_server);
-
-    mbedtls_ctr_drbg_free(ctr_drbg);
-    free(ctr_drbg);
-
-    mbedtls_entropy_free(entropy);
-    free(entropy);
+    /* Only the curve stays loaded, ephemeral keys and the shared
+     * secret are wiped for the next handshake */
+    mbedtls_mpi_free(&ctx_server->d);
+    mbedtls_mpi_free(&ctx_server->z);
+    mbedtls_ecp_point_free(&ctx_server->Q);
+    mbedtls_ecp_point_free(&ctx_server->Qp);
 
     return ret;
 }
@@ -389,24 +434,22 @@ static void sec1_session_setup_cleanup(uint32_t session_id, SessionData *resp)
         case SEC1_MSG_TYPE__Session_Response0:
             {
                 SessionResp0 *out_resp0 = out->sr0;
-                if (out_resp0) {
-                    free(out_resp0);
-                }
+                protocomm_req_free(out_resp0);
                 break;
             }
         case SEC1_MSG_TYPE__Session_Response1:
             {
                 SessionResp1 *out_resp1 = out->sr1;
                 if (out_resp1) {
-                    free(out_resp1->device_verify_data.data);
-                    free(out_resp1);
+                    protocomm_req_free(out_resp1->device_verify_data.data);
+                    protocomm_req_free(out_resp1);
                 }
                 break;
             }
         default:
             break;
     }
-    free(out);
+    protocomm_req_free(out);
 
     return;
 }
@@ -416,7 +459,7 @@ static esp_err_t sec1_init()
     return ESP_OK;
 }
 
-static esp_err_t sec1_cleanup()
+static void sec1_free_session()
 {
     if (cur_session) {
         ESP_LOGD(TAG, "Closing current session with id %u", cur_session->id);
@@ -425,6 +468,12 @@ static esp_err_t sec1_cleanup()
         free(cur_session);
         cur_session = NULL;
     }
+}
+
+static esp_err_t sec1_cleanup()
+{
+    sec1_free_session();
+    sec1_crypto_free();
     return ESP_OK;
 }
 
@@ -432,7 +481,7 @@ static esp_err_t sec1_new_session(uint32_t session_id)
 {
     if (cur_session && cur_session->id != session_id) {
         ESP_LOGE(TAG, "Closing old session with id %u", cur_session->id);
-        sec1_cleanup();
+        sec1_free_session();
     } else if (cur_session && cur_session->id == session_id) {
         return ESP_OK;
     }
@@ -454,9 +503,7 @@ static esp_err_t sec1_close_session(uint32_t session_id)
         return ESP_ERR_INVALID_ARG;
     }
 
-    bzero(cur_session, sizeof(session_t));
-    free(cur_session);
-    cur_session = NULL;
+    sec1_free_session();
     return ESP_OK;
 }
 
@@ -472,6 +519,8 @@ static esp_err_t sec1_decrypt(uint32_t session_id,
         return ESP_ERR_INVALID_STATE;
     }
     *outlen = inlen;
+    /* Whole buffer in a single call, which lets the hardware AES driver
+     * run all blocks under one acquisition. inbuf may equal outbuf */
     int ret = mbedtls_aes_crypt_ctr(&cur_session->ctx_aes, inlen, &cur_session->nc_off,
                                     cur_session->rand, cur_session->stb, inbuf, outbuf);
     if (ret != 0) {
@@ -490,31 +539,32 @@ static esp_err_t sec1_req_handler(const protocomm_security_pop_t *pop, uint32_t
     SessionData resp;
     esp_err_t ret;
 
-    req = session_data__unpack(NULL, inlen, inbuf);
+    req = session_data__unpack(protocomm_req_allocator(), inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack setup_req");
         return ESP_ERR_INVALID_ARG;
     }
     if (req->sec_ver != protocomm_security1.ver) {
         ESP_LOGE(TAG, "Security version mismatch. Closing connection");
+        session_data__free_unpacked(req, protocomm_req_allocator());
         return ESP_ERR_INVALID_ARG;
     }
 
     session_data__init(&resp);
     ret = sec1_session_setup(session_id, req, &resp, pop);
+    resp.sec_ver = req->sec_ver;
+    session_data__free_unpacked(req, protocomm_req_allocator());
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Session setup error %d", ret);
+        sec1_session_setup_cleanup(session_id, &resp);
         return ESP_FAIL;
     }
 
-    session_data__free_unpacked(req, NULL);
-
-    resp.sec_ver = req->sec_ver;
-
     *outlen = session_data__get_packed_size(&resp);
-    *outbuf = (uint8_t *) malloc(*outlen);
+    *outbuf = (uint8_t *) protocomm_req_alloc(*outlen);
     if (!*outbuf) {
         ESP_LOGE(TAG, "System out of memory");
+        sec1_session_setup_cleanup(session_id, &resp);
         return ESP_ERR_NO_MEM;
     }
     session_data__pack(&resp, *outbuf);
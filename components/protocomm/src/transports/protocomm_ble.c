@@ -245,12 +245,12 @@ static void transport_simple_ble_exec_write(esp_gatts_cb_event_t event, esp_gatt
     if ((param->exec_write.exec_write_flag == ESP_GATT_PREP_WRITE_EXEC)
             &&
             prepare_write_env.prepare_buf) {
-        err = protocomm_req_handle(protoble_internal->pc_ble,
-                                   handle_to_handler(prepare_write_env.handle),
-                                   param->exec_write.conn_id,
-                                   prepare_write_env.prepare_buf,
-                                   prepare_write_env.prepare_len,
-                                   &outbuf, &outlen);
+        err = protocomm_req_handle_inplace(protoble_internal->pc_ble,
+                                           handle_to_handler(prepare_write_env.handle),
+                                           param->exec_write.conn_id,
+                                           prepare_write_env.prepare_buf,
+                                           prepare_write_env.prepare_len,
+                                           &outbuf, &outlen);
 
         if (err != ESP_OK) {
             ESP_LOGE(TAG, "Invalid content received, killing connection");
@@ -270,9 +270,7 @@ static void transport_simple_ble_exec_write(esp_gatts_cb_event_t event, esp_gatt
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Send response error in exec write");
     }
-    if (outbuf) {
-        free(outbuf);
-    }
+    protocomm_req_release(protoble_internal->pc_ble, outbuf);
 }
 
 static void transport_simple_ble_disconnect(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
@@ -156,7 +156,7 @@ static int common_cmd_handler(int argc, char** argv)
         }
     }
 
-    ret = protocomm_req_handle(pc_console, argv[0], cur_session_id, buf, len, &outbuf, &outlen);
+    ret = protocomm_req_handle_inplace(pc_console, argv[0], cur_session_id, buf, len, &outbuf, &outlen);
     free(buf);
 
     if (ret == ESP_OK) {
@@ -166,8 +166,8 @@ static int common_cmd_handler(int argc, char** argv)
         }
         ESP_LOGI(TAG, "\r\n");
 
-        /* Transport is responsible for freeing the transmit buffer */
-        free(outbuf);
+        /* Transport is responsible for releasing the transmit buffer */
+        protocomm_req_release(pc_console, outbuf);
 
         return ESP_OK;
     } else {
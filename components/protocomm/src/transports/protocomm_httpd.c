@@ -98,8 +98,8 @@ static esp_err_t common_post_handler(httpd_req_t *req)
     /* Extract the endpoint name from URI string of type "/ep_name" */
     ep_name = req->uri + 1;
 
-    ret = protocomm_req_handle(pc_httpd, ep_name, session_id,
-                               (uint8_t *)req_body, recv_size, &outbuf, &outlen);
+    ret = protocomm_req_handle_inplace(pc_httpd, ep_name, session_id,
+                                       (uint8_t *)req_body, recv_size, &outbuf, &outlen);
 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Data handler failed");
@@ -118,9 +118,7 @@ out:
     if (req_body) {
         free(req_body);
     }
-    if (outbuf) {
-        free(outbuf);
-    }
+    protocomm_req_release(pc_httpd, outbuf);
     return ret;
 }
 
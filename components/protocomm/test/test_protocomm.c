@@ -30,6 +30,7 @@
 #include <mbedtls/ssl_internal.h>
 
 #include <protocomm.h>
+#include <protocomm_arena.h>
 #include <protocomm_security.h>
 #include <protocomm_security0.h>
 #include <protocomm_security1.h>
@@ -1022,6 +1023,102 @@ static esp_err_t test_security0 (void)
     return ESP_OK;
 }
 
+static esp_err_t test_arena_req_handler(uint32_t session_id,
+                                        const uint8_t *inbuf, ssize_t inlen,
+                                        uint8_t **outbuf, ssize_t *outlen,
+                                        void *priv_data)
+{
+    if (protocomm_req_allocator() == NULL) {
+        ESP_LOGE(TAG, "No arena while handling request");
+        return ESP_FAIL;
+    }
+
+    /* Small allocations come from the arena block, large ones overflow */
+    uint8_t *small = protocomm_req_alloc(16);
+    uint8_t *large = protocomm_req_alloc(inlen);
+    if (!small || !large) {
+        ESP_LOGE(TAG, "Error allocating from arena");
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(large, inbuf, inlen);
+    protocomm_req_free(small);
+
+    *outbuf = large;
+    *outlen = inlen;
+    return ESP_OK;
+}
+
+static esp_err_t test_req_arena(void)
+{
+    ESP_LOGI(TAG, "Starting request arena test");
+
+    static uint8_t test_data[2048];
+    getrandom(test_data, sizeof(test_data), 0);
+
+    unsigned pre_start_mem = esp_get_free_heap_size();
+
+    protocomm_t *pc = protocomm_new();
+    if (pc == NULL) {
+        ESP_LOGE(TAG, "Failed to create new protocomm instance");
+        return ESP_FAIL;
+    }
+
+    if (protocomm_add_endpoint(pc, "test-arena", test_arena_req_handler, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set test-arena endpoint handler");
+        protocomm_delete(pc);
+        return ESP_FAIL;
+    }
+
+    /* The in place API leaves the output in the arena until released, the
+     * plain one hands out a copy that is freed as usual */
+    static uint8_t req_buf[sizeof(test_data)];
+    for (int i = 0; i < 4; i++) {
+        bool inplace = (i % 2) == 0;
+        uint8_t *outbuf = NULL;
+        ssize_t outlen = 0;
+        esp_err_t ret;
+        if (inplace) {
+            memcpy(req_buf, test_data, sizeof(test_data));
+            ret = protocomm_req_handle_inplace(pc, "test-arena", 0, req_buf, sizeof(req_buf),
+                                               &outbuf, &outlen);
+        } else {
+            ret = protocomm_req_handle(pc, "test-arena", 0, test_data, sizeof(test_data),
+                                       &outbuf, &outlen);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "test-arena handler failed");
+            protocomm_delete(pc);
+            return ESP_FAIL;
+        }
+        bool ok = true;
+        if (protocomm_req_allocator() != NULL) {
+            ESP_LOGE(TAG, "Arena still active after request");
+            ok = false;
+        } else if (outlen != sizeof(test_data) || memcmp(outbuf, test_data, outlen)) {
+            ESP_LOGE(TAG, "incorrect response from test-arena");
+            ok = false;
+        }
+        if (inplace) {
+            protocomm_req_release(pc, outbuf);
+        } else {
+            free(outbuf);
+        }
+        if (!ok) {
+            protocomm_delete(pc);
+            return ESP_FAIL;
+        }
+    }
+
+    protocomm_remove_endpoint(pc, "test-arena");
+    protocomm_delete(pc);
+
+    if (pre_start_mem != esp_get_free_heap_size()) {
+        ESP_LOGE(TAG, "Mismatch in free heap size");
+    }
+    ESP_LOGI(TAG, "Request arena test successful");
+    return ESP_OK;
+}
+
 TEST_CASE("leak test", "[PROTOCOMM]")
 {
 #ifdef DO_HEAP_TRACING
@@ -1087,3 +1184,8 @@ TEST_CASE("security 1 weak session test", "[PROTOCOMM]")
 {
     TEST_ASSERT(test_security1_weak_session() == ESP_OK);
 }
+
+TEST_CASE("request arena test", "[PROTOCOMM]")
+{
+    TEST_ASSERT(test_req_arena() == ESP_OK);
+}
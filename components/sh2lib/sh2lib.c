@@ -22,8 +22,10 @@
 #include <netdb.h>
 #include <esp_log.h>
 #include <http_parser.h>
+#include <va_latency.h>
 
 #include "sh2lib.h"
+#include "sh2lib_priv.h"
 
 static const char *TAG = "[sh2lib]";
 
@@ -166,6 +168,12 @@ static int callback_on_frame_recv(nghttp2_session *session,
             hd->go_away_cb(hd);
         }
     }
+    if (frame->hd.type == NGHTTP2_HEADERS || frame->hd.type == NGHTTP2_DATA) {
+        va_latency_mark(VA_LATENCY_RESPONSE);
+    }
+    if (frame->hd.type == NGHTTP2_PING && (frame->hd.flags & NGHTTP2_FLAG_ACK)) {
+        sh2lib_loop_on_ping_ack((struct sh2lib_handle *)user_data, frame->ping.opaque_data);
+    }
 #if 0
     if (frame->hd.type != NGHTTP2_DATA) {
         return 0;
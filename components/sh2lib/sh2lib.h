@@ -276,4 +276,147 @@ int sh2lib_do_putpost_with_nv(struct sh2lib_handle *hd, const nghttp2_nv *nva, s
  * @param[in] stream_id Stream ID on which to resume sending the data
  */
 int sh2lib_resume_deferred_data(struct sh2lib_handle *hd, int32_t stream_id);
+
+/*
+ * Event loop
+ *
+ * sh2lib_wait_for_io() + sh2lib_execute() poll one socket and always run a
+ * full send followed by a full receive, so a busy downchannel holds up
+ * uploads until everything readable has been consumed. The loop below
+ * instead:
+ *  - wakes up on socket readiness, or when a producer (e.g. mic capture)
+ *    signals that a deferred stream has data again (sh2lib_loop_notify()),
+ *  - reads a bounded amount per iteration and sends in between, with the
+ *    outgoing DATA frames scheduled by stream priority,
+ *  - tracks, per stream, how often and how long it was blocked on the
+ *    peer's (send) or our own (receive) flow control window.
+ *
+ * The loop lives next to the handle (struct sh2lib_handle is shared with
+ * prebuilt libraries and cannot grow). All APIs except sh2lib_loop_notify()
+ * must be called from the task running the loop, like the rest of sh2lib.
+ */
+struct sh2lib_loop;
+
+/** Stream priorities, see sh2lib_loop_add_stream() */
+typedef enum {
+    /** Background transfers, e.g. events and state reports */
+    SH2LIB_PRIO_LOW,
+    /** Default priority of HTTP/2 streams */
+    SH2LIB_PRIO_NORMAL,
+    /** Latency critical, e.g. Recognize audio. Other streams only get to
+     *  send while this one has nothing to send */
+    SH2LIB_PRIO_HIGH,
+} sh2lib_prio_t;
+
+/** Flow control statistics of a stream */
+struct sh2lib_stream_stats {
+    /** Number of times the stream ran out of send window */
+    uint32_t send_stalls;
+    /** Total time spent without send window, in milliseconds */
+    uint32_t send_stall_ms;
+    /** Number of times the peer ran out of window to send to us */
+    uint32_t recv_stalls;
+    /** Total time the peer spent without window, in milliseconds */
+    uint32_t recv_stall_ms;
+    /** Send window currently available, -1 once the stream is closed */
+    int32_t send_window;
+    /** Receive window currently available, -1 once the stream is closed */
+    int32_t recv_window;
+};
+
+/**
+ * @brief Create an event loop for a connected handle
+ *
+ * @param[in] hd  Pointer to a connected sh2lib handle
+ *
+ * @return
+ *             - Pointer to the loop on success
+ *             - NULL if resources could not be allocated
+ */
+struct sh2lib_loop *sh2lib_loop_create(struct sh2lib_handle *hd);
+
+/**
+ * @brief Delete an event loop
+ *
+ * The handle itself is left alone, sh2lib_free() it separately.
+ */
+void sh2lib_loop_delete(struct sh2lib_loop *loop);
+
+/**
+ * @brief Track a stream and set its priority
+ *
+ * Flow control statistics are only kept for streams added here.
+ *
+ * @param[in] loop       Pointer to the loop
+ * @param[in] stream_id  Stream ID as returned by sh2lib_do_*()
+ * @param[in] prio       Priority of the stream
+ *
+ * @return
+ *             - ESP_OK on success
+ *             - ESP_FAIL if the stream could not be tracked or the priority not set
+ */
+int sh2lib_loop_add_stream(struct sh2lib_loop *loop, int32_t stream_id, sh2lib_prio_t prio);
+
+/**
+ * @brief Signal that data is ready on a deferred stream
+ *
+ * Producers call this, from any task, after their data provider returned
+ * NGHTTP2_ERR_DEFERRED and new data became available. The stream is
+ * resumed and sent out by the loop task.
+ *
+ * @param[in] loop       Pointer to the loop
+ * @param[in] stream_id  Stream ID on which data is ready
+ *
+ * @return
+ *             - ESP_OK on success
+ *             - ESP_FAIL if the loop could not be woken up
+ */
+int sh2lib_loop_notify(struct sh2lib_loop *loop, int32_t stream_id);
+
+/**
+ * @brief Run one iteration of the loop
+ *
+ * Waits for socket readiness or a notification for up to `timeout_ms`
+ * (-1 to wait forever), then performs the pending receive and send work.
+ *
+ * @param[in] loop        Pointer to the loop
+ * @param[in] timeout_ms  Maximum time to wait for an event
+ *
+ * @return
+ *             - ESP_OK if the connection is still usable
+ *             - ESP_FAIL on connection errors
+ */
+int sh2lib_loop_run(struct sh2lib_loop *loop, int timeout_ms);
+
+/**
+ * @brief Get the flow control statistics of a tracked stream
+ *
+ * Statistics stay available after the stream closes, until its slot is
+ * reused by another stream.
+ *
+ * @param[in]  loop       Pointer to the loop
+ * @param[in]  stream_id  Stream ID
+ * @param[out] stats      Filled with the stream's statistics
+ *
+ * @return
+ *             - ESP_OK on success
+ *             - ESP_FAIL if the stream is not tracked
+ */
+int sh2lib_loop_get_stream_stats(struct sh2lib_loop *loop, int32_t stream_id, struct sh2lib_stream_stats *stats);
+
+/**
+ * @brief Get the smoothed round trip time of the connection
+ *
+ * The loop sends a PING every few seconds to measure it.
+ *
+ * @param[in] loop  Pointer to the loop
+ *
+ * @return Round trip time in milliseconds, 0 if not measured yet
+ */
+int sh2lib_loop_get_rtt_ms(struct sh2lib_loop *loop);
+
+/**
+ * @brief Get the sh2lib handle the loop was created for
+ */
+struct sh2lib_handle *sh2lib_loop_get_handle(struct sh2lib_loop *loop);
 #endif /* ! __ESP_EXAMPLE_SH2_LIB_H_ */
@@ -0,0 +1,458 @@
+// Copyright 2017-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "sh2lib.h"
+#include "sh2lib_priv.h"
+
+static const char *TAG = "[sh2lib-loop]";
+
+/* Streams whose priority and statistics are tracked */
+#define SH2LIB_LOOP_MAX_STREAMS   8
+/* Bytes read from the socket before giving the send side a turn */
+#define SH2LIB_LOOP_RECV_BUDGET   4096
+#define SH2LIB_LOOP_RX_BUF_SIZE   1024
+/* RTT is sampled with a PING this often */
+#define SH2LIB_LOOP_PING_INTERVAL_MS  5000
+/* Marks our PINGs, the application may send its own */
+#define SH2LIB_LOOP_PING_MAGIC    0x5348
+
+struct sh2lib_loop_stream {
+    int32_t stream_id;
+    bool closed;
+    /* Set by sh2lib_loop_notify(), cleared by the loop task */
+    bool data_ready;
+    int64_t send_stall_start;
+    int64_t recv_stall_start;
+    struct sh2lib_stream_stats stats;
+};
+
+struct sh2lib_loop {
+    struct sh2lib_handle *hd;
+    /* Wakeup socket bound to loopback, and the one producers send from */
+    int ctrl_fd;
+    int notify_fd;
+    struct sockaddr_in ctrl_addr;
+    /* A wakeup is already queued on ctrl_fd */
+    bool wakeup_pending;
+    /* Last receive stopped because of the budget, not lack of data */
+    bool recv_more;
+    portMUX_TYPE lock;
+    /* Smoothed RTT in ms, 0 until the first PING is acknowledged */
+    int srtt_ms;
+    int64_t last_ping_ms;
+    struct sh2lib_loop *next;
+    struct sh2lib_loop_stream streams[SH2LIB_LOOP_MAX_STREAMS];
+    uint8_t rx_buf[SH2LIB_LOOP_RX_BUF_SIZE];
+};
+
+/* Loops in use, so that PING ACKs seen by sh2lib.c can be routed back.
+ * Each connection may run its loop on a task of its own. */
+static struct sh2lib_loop *loop_list;
+static portMUX_TYPE loop_list_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static int64_t loop_time_ms()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static int loop_create_ctrl_sock(struct sh2lib_loop *loop)
+{
+    socklen_t addr_len = sizeof(loop->ctrl_addr);
+
+    loop->ctrl_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    loop->notify_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (loop->ctrl_fd < 0 || loop->notify_fd < 0) {
+        return -1;
+    }
+    /* Let the stack pick the port, several loops may exist */
+    memset(&loop->ctrl_addr, 0, sizeof(loop->ctrl_addr));
+    loop->ctrl_addr.sin_family = AF_INET;
+    loop->ctrl_addr.sin_port = 0;
+    inet_aton("127.0.0.1", &loop->ctrl_addr.sin_addr);
+    if (bind(loop->ctrl_fd, (struct sockaddr *)&loop->ctrl_addr, sizeof(loop->ctrl_addr)) < 0) {
+        return -1;
+    }
+    if (getsockname(loop->ctrl_fd, (struct sockaddr *)&loop->ctrl_addr, &addr_len) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+struct sh2lib_loop *sh2lib_loop_create(struct sh2lib_handle *hd)
+{
+    struct sh2lib_loop *loop = calloc(1, sizeof(struct sh2lib_loop));
+    if (!loop) {
+        ESP_LOGE(TAG, "[loop-create] Failed to allocate loop");
+        return NULL;
+    }
+    loop->hd = hd;
+    loop->ctrl_fd = loop->notify_fd = -1;
+    loop->lock = (portMUX_TYPE) portMUX_INITIALIZER_UNLOCKED;
+    if (loop_create_ctrl_sock(loop) != 0) {
+        ESP_LOGE(TAG, "[loop-create] Failed to create control socket");
+        sh2lib_loop_delete(loop);
+        return NULL;
+    }
+    portENTER_CRITICAL(&loop_list_lock);
+    loop->next = loop_list;
+    loop_list = loop;
+    portEXIT_CRITICAL(&loop_list_lock);
+    return loop;
+}
+
+void sh2lib_loop_delete(struct sh2lib_loop *loop)
+{
+    portENTER_CRITICAL(&loop_list_lock);
+    for (struct sh2lib_loop **l = &loop_list; *l; l = &(*l)->next) {
+        if (*l == loop) {
+            *l = loop->next;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&loop_list_lock);
+    if (loop->ctrl_fd >= 0) {
+        close(loop->ctrl_fd);
+    }
+    if (loop->notify_fd >= 0) {
+        close(loop->notify_fd);
+    }
+    free(loop);
+}
+
+static struct sh2lib_loop_stream *loop_find_stream(struct sh2lib_loop *loop, int32_t stream_id)
+{
+    for (int i = 0; i < SH2LIB_LOOP_MAX_STREAMS; i++) {
+        if (loop->streams[i].stream_id == stream_id) {
+            return &loop->streams[i];
+        }
+    }
+    return NULL;
+}
+
+int sh2lib_loop_add_stream(struct sh2lib_loop *loop, int32_t stream_id, sh2lib_prio_t prio)
+{
+    nghttp2_priority_spec pri_spec;
+    struct sh2lib_loop_stream *stream = loop_find_stream(loop, stream_id);
+
+    if (!stream) {
+        /* Free slot, or else the slot of a closed stream */
+        stream = loop_find_stream(loop, 0);
+        for (int i = 0; !stream && i < SH2LIB_LOOP_MAX_STREAMS; i++) {
+            if (loop->streams[i].closed) {
+                stream = &loop->streams[i];
+            }
+        }
+        if (!stream) {
+            ESP_LOGE(TAG, "[loop-add] No free slot for stream %d", stream_id);
+            return -1;
+        }
+        portENTER_CRITICAL(&loop->lock);
+        memset(stream, 0, sizeof(*stream));
+        stream->stream_id = stream_id;
+        portEXIT_CRITICAL(&loop->lock);
+    }
+
+    switch (prio) {
+    case SH2LIB_PRIO_HIGH:
+        /* Exclusive child of the root: every other stream now depends on
+         * this one and only gets scheduled while it is blocked */
+        nghttp2_priority_spec_init(&pri_spec, 0, NGHTTP2_MAX_WEIGHT, 1);
+        break;
+    case SH2LIB_PRIO_LOW:
+        nghttp2_priority_spec_init(&pri_spec, 0, NGHTTP2_MIN_WEIGHT, 0);
+        break;
+    case SH2LIB_PRIO_NORMAL:
+    default:
+        nghttp2_priority_spec_init(&pri_spec, 0, NGHTTP2_DEFAULT_WEIGHT, 0);
+        break;
+    }
+    int ret = nghttp2_submit_priority(loop->hd->http2_sess, NGHTTP2_FLAG_NONE, stream_id, &pri_spec);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "[loop-add] Setting priority of stream %d failed %d", stream_id, ret);
+        return -1;
+    }
+    return 0;
+}
+
+int sh2lib_loop_notify(struct sh2lib_loop *loop, int32_t stream_id)
+{
+    bool send_wakeup = false;
+    uint8_t byte = 0;
+
+    portENTER_CRITICAL(&loop->lock);
+    struct sh2lib_loop_stream *stream = loop_find_stream(loop, stream_id);
+    if (stream && stream_id != 0) {
+        stream->data_ready = true;
+        if (!loop->wakeup_pending) {
+            /* One queued wakeup covers any number of notifications */
+            loop->wakeup_pending = true;
+            send_wakeup = true;
+        }
+    }
+    portEXIT_CRITICAL(&loop->lock);
+
+    if (!stream || stream_id == 0) {
+        ESP_LOGE(TAG, "[loop-notify] Stream %d is not tracked", stream_id);
+        return -1;
+    }
+    if (send_wakeup &&
+            sendto(loop->notify_fd, &byte, sizeof(byte), 0,
+                   (struct sockaddr *)&loop->ctrl_addr, sizeof(loop->ctrl_addr)) < 0) {
+        portENTER_CRITICAL(&loop->lock);
+        loop->wakeup_pending = false;
+        portEXIT_CRITICAL(&loop->lock);
+        return -1;
+    }
+    return 0;
+}
+
+static void loop_handle_notify(struct sh2lib_loop *loop)
+{
+    uint8_t byte;
+    int32_t ready[SH2LIB_LOOP_MAX_STREAMS];
+    int num_ready = 0;
+
+    recvfrom(loop->ctrl_fd, &byte, sizeof(byte), MSG_DONTWAIT, NULL, NULL);
+
+    portENTER_CRITICAL(&loop->lock);
+    loop->wakeup_pending = false;
+    for (int i = 0; i < SH2LIB_LOOP_MAX_STREAMS; i++) {
+        if (loop->streams[i].data_ready) {
+            loop->streams[i].data_ready = false;
+            ready[num_ready++] = loop->streams[i].stream_id;
+        }
+    }
+    portEXIT_CRITICAL(&loop->lock);
+
+    for (int i = 0; i < num_ready; i++) {
+        /* Fails harmlessly if the stream was not deferred */
+        nghttp2_session_resume_data(loop->hd->http2_sess, ready[i]);
+    }
+}
+
+static int loop_wait(struct sh2lib_loop *loop, int timeout_ms, bool *readable, bool *notified)
+{
+    int sockfd = loop->hd->http2_tls->sockfd;
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    fd_set read_fds, write_fds;
+
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    FD_SET(sockfd, &read_fds);
+    FD_SET(loop->ctrl_fd, &read_fds);
+    /* Same as sh2lib_wait_for_io(), the socket is almost always writeable */
+    if (nghttp2_session_want_write(loop->hd->http2_sess)) {
+        FD_SET(sockfd, &write_fds);
+    }
+    int maxfd = sockfd > loop->ctrl_fd ? sockfd : loop->ctrl_fd;
+    int ret = select(maxfd + 1, &read_fds, &write_fds, NULL, timeout_ms < 0 ? NULL : &tv);
+    if (ret < 0) {
+        return -1;
+    }
+    *readable = FD_ISSET(sockfd, &read_fds);
+    *notified = FD_ISSET(loop->ctrl_fd, &read_fds);
+    return 0;
+}
+
+static int loop_recv(struct sh2lib_loop *loop)
+{
+    int total = 0;
+
+    loop->recv_more = false;
+    while (total < SH2LIB_LOOP_RECV_BUDGET) {
+        int len = esp_tls_conn_read(loop->hd->http2_tls, loop->rx_buf, sizeof(loop->rx_buf));
+        if (len == MBEDTLS_ERR_SSL_WANT_READ || len == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return 0;
+        }
+        if (len <= 0) {
+            ESP_LOGE(TAG, "[loop-recv] Connection closed %d", len);
+            return -1;
+        }
+        ssize_t ret = nghttp2_session_mem_recv(loop->hd->http2_sess, loop->rx_buf, len);
+        if (ret < 0) {
+            ESP_LOGE(TAG, "[loop-recv] HTTP2 session recv failed %d", (int) ret);
+            return -1;
+        }
+        total += len;
+    }
+    /* Possibly more to read, TLS may also hold already decrypted data that
+     * select() cannot see. Come back right after sending. */
+    loop->recv_more = true;
+    return 0;
+}
+
+static void loop_stall_update(uint32_t *stalls, uint32_t *stall_ms, int64_t *start, bool stalled, int64_t now)
+{
+    if (stalled && *start == 0) {
+        (*stalls)++;
+        *start = now;
+    } else if (!stalled && *start != 0) {
+        *stall_ms += now - *start;
+        *start = 0;
+    }
+}
+
+static void loop_update_stats(struct sh2lib_loop *loop)
+{
+    nghttp2_session *sess = loop->hd->http2_sess;
+    int64_t now = loop_time_ms();
+    int32_t conn_send_window = nghttp2_session_get_remote_window_size(sess);
+
+    for (int i = 0; i < SH2LIB_LOOP_MAX_STREAMS; i++) {
+        struct sh2lib_loop_stream *stream = &loop->streams[i];
+        if (stream->stream_id == 0 || stream->closed) {
+            continue;
+        }
+        int32_t send_window = nghttp2_session_get_stream_remote_window_size(sess, stream->stream_id);
+        if (send_window < 0) {
+            /* Stream is gone, close any open stall interval */
+            loop_stall_update(&stream->stats.send_stalls, &stream->stats.send_stall_ms,
+                              &stream->send_stall_start, false, now);
+            loop_stall_update(&stream->stats.recv_stalls, &stream->stats.recv_stall_ms,
+                              &stream->recv_stall_start, false, now);
+            stream->stats.send_window = stream->stats.recv_window = -1;
+            stream->closed = true;
+            continue;
+        }
+        int32_t recv_window = nghttp2_session_get_stream_effective_local_window_size(sess, stream->stream_id) -
+                              nghttp2_session_get_stream_effective_recv_data_length(sess, stream->stream_id);
+
+        bool send_stalled = !nghttp2_session_get_stream_local_close(sess, stream->stream_id) &&
+                            (send_window <= 0 || conn_send_window <= 0);
+        bool recv_stalled = !nghttp2_session_get_stream_remote_close(sess, stream->stream_id) &&
+                            recv_window <= 0;
+        loop_stall_update(&stream->stats.send_stalls, &stream->stats.send_stall_ms,
+                          &stream->send_stall_start, send_stalled, now);
+        loop_stall_update(&stream->stats.recv_stalls, &stream->stats.recv_stall_ms,
+                          &stream->recv_stall_start, recv_stalled, now);
+        stream->stats.send_window = send_window < conn_send_window ? send_window : conn_send_window;
+        stream->stats.recv_window = recv_window;
+    }
+}
+
+static void loop_ping(struct sh2lib_loop *loop, int64_t now)
+{
+    uint8_t opaque[8];
+    uint64_t ts = (uint64_t) esp_timer_get_time();
+
+    /* Magic followed by the low 48 bits of the send time in us */
+    opaque[0] = SH2LIB_LOOP_PING_MAGIC >> 8;
+    opaque[1] = SH2LIB_LOOP_PING_MAGIC & 0xff;
+    for (int i = 0; i < 6; i++) {
+        opaque[2 + i] = ts >> (8 * (5 - i));
+    }
+    if (nghttp2_submit_ping(loop->hd->http2_sess, NGHTTP2_FLAG_NONE, opaque) == 0) {
+        loop->last_ping_ms = now;
+    }
+}
+
+void sh2lib_loop_on_ping_ack(struct sh2lib_handle *hd, const uint8_t *opaque)
+{
+    struct sh2lib_loop *loop;
+    uint64_t sent = 0;
+
+    if (((opaque[0] << 8) | opaque[1]) != SH2LIB_LOOP_PING_MAGIC) {
+        return;
+    }
+    /* Only the task running the loop of `hd` gets here, and deletes it */
+    portENTER_CRITICAL(&loop_list_lock);
+    for (loop = loop_list; loop && loop->hd != hd; loop = loop->next);
+    portEXIT_CRITICAL(&loop_list_lock);
+    if (!loop) {
+        return;
+    }
+    for (int i = 0; i < 6; i++) {
+        sent = (sent << 8) | opaque[2 + i];
+    }
+    uint64_t now = (uint64_t) esp_timer_get_time() & 0xffffffffffffULL;
+    int sample_ms = ((now - sent) & 0xffffffffffffULL) / 1000;
+    /* Same smoothing as TCP's SRTT */
+    loop->srtt_ms = loop->srtt_ms ? (7 * loop->srtt_ms + sample_ms) / 8 : sample_ms;
+    ESP_LOGD(TAG, "[loop-rtt] sample %d ms, smoothed %d ms", sample_ms, loop->srtt_ms);
+}
+
+int sh2lib_loop_get_rtt_ms(struct sh2lib_loop *loop)
+{
+    return loop->srtt_ms;
+}
+
+struct sh2lib_handle *sh2lib_loop_get_handle(struct sh2lib_loop *loop)
+{
+    return loop->hd;
+}
+
+int sh2lib_loop_run(struct sh2lib_loop *loop, int timeout_ms)
+{
+    bool readable = false, notified = false;
+    int ret;
+
+    int64_t now = loop_time_ms();
+    if (now - loop->last_ping_ms >= SH2LIB_LOOP_PING_INTERVAL_MS) {
+        loop_ping(loop, now);
+    }
+
+    if (loop_wait(loop, loop->recv_more ? 0 : timeout_ms, &readable, &notified) != 0) {
+        ESP_LOGE(TAG, "[loop-run] select failed");
+        return -1;
+    }
+    if (notified) {
+        loop_handle_notify(loop);
+    }
+    if (readable || loop->recv_more) {
+        /* Receive first, incoming WINDOW_UPDATEs may unblock our streams */
+        if (loop_recv(loop) != 0) {
+            return -1;
+        }
+    }
+    ret = nghttp2_session_send(loop->hd->http2_sess);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "[loop-run] HTTP2 session send failed %d", ret);
+        return -1;
+    }
+    loop_update_stats(loop);
+    return 0;
+}
+
+int sh2lib_loop_get_stream_stats(struct sh2lib_loop *loop, int32_t stream_id, struct sh2lib_stream_stats *stats)
+{
+    struct sh2lib_loop_stream *stream = loop_find_stream(loop, stream_id);
+    if (!stream || stream_id == 0) {
+        return -1;
+    }
+    *stats = stream->stats;
+    /* Include a stall that is still in progress */
+    int64_t now = loop_time_ms();
+    if (stream->send_stall_start) {
+        stats->send_stall_ms += now - stream->send_stall_start;
+    }
+    if (stream->recv_stall_start) {
+        stats->recv_stall_ms += now - stream->recv_stall_start;
+    }
+    return 0;
+}
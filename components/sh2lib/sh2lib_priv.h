@@ -0,0 +1,25 @@
+// Copyright 2017-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SH2LIB_PRIV_H_
+#define __SH2LIB_PRIV_H_
+
+#include <stdint.h>
+
+struct sh2lib_handle;
+
+/* Called by sh2lib.c for every PING ACK received on a handle */
+void sh2lib_loop_on_ping_ack(struct sh2lib_handle *hd, const uint8_t *opaque);
+
+#endif /* ! __SH2LIB_PRIV_H_ */
@@ -0,0 +1,235 @@
+// Copyright 2017-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdlib.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include "sh2lib_upload.h"
+
+static const char *TAG = "[sh2lib-upload]";
+
+#define SH2LIB_UPLOAD_DEF_MIN_FRAME_MS    20
+#define SH2LIB_UPLOAD_DEF_MAX_LATENCY_MS  200
+/* Aim for this many frames per round trip */
+#define SH2LIB_UPLOAD_FRAMES_PER_RTT      4
+
+struct sh2lib_upload {
+    struct sh2lib_loop *loop;
+    struct sh2lib_upload_cfg cfg;
+    int32_t stream_id;
+    bool deferred;
+    bool done;
+    /* Written by the capture task, 0 until end of speech */
+    volatile uint32_t eos_ms;
+    struct sh2lib_upload_stats stats;
+};
+
+static uint32_t upload_time_ms()
+{
+    return esp_timer_get_time() / 1000;
+}
+
+struct sh2lib_upload *sh2lib_upload_create(struct sh2lib_loop *loop, const struct sh2lib_upload_cfg *cfg)
+{
+    if (!cfg->rb || cfg->bytes_per_ms <= 0) {
+        ESP_LOGE(TAG, "[upload-create] Invalid configuration");
+        return NULL;
+    }
+    struct sh2lib_upload *up = calloc(1, sizeof(struct sh2lib_upload));
+    if (!up) {
+        ESP_LOGE(TAG, "[upload-create] Failed to allocate upload");
+        return NULL;
+    }
+    up->loop = loop;
+    up->cfg = *cfg;
+    if (up->cfg.min_frame_ms <= 0) {
+        up->cfg.min_frame_ms = SH2LIB_UPLOAD_DEF_MIN_FRAME_MS;
+    }
+    if (up->cfg.max_latency_ms <= 0) {
+        up->cfg.max_latency_ms = SH2LIB_UPLOAD_DEF_MAX_LATENCY_MS;
+    }
+    if (up->cfg.min_frame_ms > up->cfg.max_latency_ms) {
+        up->cfg.min_frame_ms = up->cfg.max_latency_ms;
+    }
+    return up;
+}
+
+void sh2lib_upload_delete(struct sh2lib_upload *up)
+{
+    free(up);
+}
+
+void sh2lib_upload_attach(struct sh2lib_upload *up, int32_t stream_id)
+{
+    up->stream_id = stream_id;
+    up->deferred = false;
+    up->done = false;
+    up->eos_ms = 0;
+    memset(&up->stats, 0, sizeof(up->stats));
+    up->stats.eos_to_last_byte_ms = -1;
+}
+
+static int32_t upload_send_window(struct sh2lib_upload *up)
+{
+    nghttp2_session *sess = sh2lib_loop_get_handle(up->loop)->http2_sess;
+    int32_t stream_window = nghttp2_session_get_stream_remote_window_size(sess, up->stream_id);
+    int32_t conn_window = nghttp2_session_get_remote_window_size(sess);
+    return stream_window < conn_window ? stream_window : conn_window;
+}
+
+/* Age of the oldest buffered byte, the source being realtime */
+static int upload_age_ms(struct sh2lib_upload *up, int filled)
+{
+    return filled / up->cfg.bytes_per_ms;
+}
+
+/* Frame size in bytes: a quarter of the RTT worth of audio, between
+ * min_frame_ms and max_latency_ms, and at most half the send window unless
+ * that is below min_frame_ms */
+static int upload_frame_size(const struct sh2lib_upload_cfg *cfg, int rtt_ms, int32_t window)
+{
+    int min_frame = cfg->min_frame_ms * cfg->bytes_per_ms;
+    int target_ms = rtt_ms / SH2LIB_UPLOAD_FRAMES_PER_RTT;
+
+    if (target_ms < cfg->min_frame_ms) {
+        target_ms = cfg->min_frame_ms;
+    } else if (target_ms > cfg->max_latency_ms) {
+        target_ms = cfg->max_latency_ms;
+    }
+    int target = target_ms * cfg->bytes_per_ms;
+    /* Leave room for the next frame, instead of one frame eating the
+     * whole window and the stream then waiting on a WINDOW_UPDATE */
+    if (target > window / 2) {
+        target = window / 2;
+    }
+    if (target < min_frame) {
+        target = min_frame;
+    }
+    return target;
+}
+
+static int upload_target_frame(struct sh2lib_upload *up, int32_t window)
+{
+    up->stats.target_frame = upload_frame_size(&up->cfg, sh2lib_loop_get_rtt_ms(up->loop), window);
+    return up->stats.target_frame;
+}
+
+static bool upload_frame_due(struct sh2lib_upload *up, int filled, int32_t window)
+{
+    int min_frame = up->cfg.min_frame_ms * up->cfg.bytes_per_ms;
+
+    if (window <= 0) {
+        return false;
+    }
+    if (rb_is_writer_finished(up->cfg.rb)) {
+        return true;
+    }
+    if (filled <= 0) {
+        return false;
+    }
+    if (upload_age_ms(up, filled) >= up->cfg.max_latency_ms) {
+        /* Latency cap: whatever fits, however small */
+        return true;
+    }
+    return filled >= upload_target_frame(up, window) &&
+           window >= (filled < min_frame ? filled : min_frame);
+}
+
+ssize_t sh2lib_upload_read(struct sh2lib_upload *up, uint8_t *buf, size_t length,
+                           uint32_t *data_flags)
+{
+    up->deferred = false;
+    if (up->done) {
+        *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+        return 0;
+    }
+    /* nghttp2 has already capped length to the send window */
+    int filled = rb_filled(up->cfg.rb);
+    if (!upload_frame_due(up, filled, length)) {
+        up->deferred = true;
+        up->stats.deferrals++;
+        return NGHTTP2_ERR_DEFERRED;
+    }
+
+    /* Whatever is buffered goes out, which also lets a backlog catch up */
+    int len = filled < (int) length ? filled : (int) length;
+    if (len > 0) {
+        len = rb_read(up->cfg.rb, buf, len, 0);
+        if (len == RB_WRITER_FINISHED) {
+            len = 0;
+        } else if (len < 0) {
+            ESP_LOGE(TAG, "[upload-read] Ring buffer read failed %d", len);
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+    }
+    if (len > 0) {
+        int latency_ms = upload_age_ms(up, filled);
+        up->stats.frames++;
+        up->stats.bytes += len;
+        if (latency_ms > up->stats.max_frame_latency_ms) {
+            up->stats.max_frame_latency_ms = latency_ms;
+        }
+    }
+
+    if (rb_is_writer_finished(up->cfg.rb) && rb_filled(up->cfg.rb) == 0) {
+        up->done = true;
+        *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+        if (up->eos_ms) {
+            up->stats.eos_to_last_byte_ms = upload_time_ms() - up->eos_ms;
+        }
+        ESP_LOGI(TAG, "[upload-read] Stream %d done: %u bytes in %u frames, %u deferrals, "
+                 "max frame latency %d ms, end of speech to last byte %d ms",
+                 up->stream_id, up->stats.bytes, up->stats.frames, up->stats.deferrals,
+                 up->stats.max_frame_latency_ms, up->stats.eos_to_last_byte_ms);
+    }
+    return len;
+}
+
+int sh2lib_upload_poll(struct sh2lib_upload *up)
+{
+    if (!up->deferred || up->done || up->stream_id <= 0) {
+        return up->cfg.max_latency_ms;
+    }
+
+    int filled = rb_filled(up->cfg.rb);
+    int32_t window = upload_send_window(up);
+    if (upload_frame_due(up, filled, window)) {
+        up->deferred = false;
+        nghttp2_session_resume_data(sh2lib_loop_get_handle(up->loop)->http2_sess, up->stream_id);
+        return 0;
+    }
+    if (window <= 0) {
+        /* The WINDOW_UPDATE will wake up the loop */
+        return up->cfg.max_latency_ms;
+    }
+
+    /* Until either the target frame is buffered or the latency cap hits */
+    int target_ms = (upload_target_frame(up, window) - filled) / up->cfg.bytes_per_ms + 1;
+    int cap_ms = up->cfg.max_latency_ms - upload_age_ms(up, filled);
+    return target_ms < cap_ms ? target_ms : cap_ms;
+}
+
+void sh2lib_upload_end_of_speech(struct sh2lib_upload *up)
+{
+    uint32_t now = upload_time_ms();
+    up->eos_ms = now ? now : 1;
+    sh2lib_loop_notify(up->loop, up->stream_id);
+}
+
+void sh2lib_upload_get_stats(struct sh2lib_upload *up, struct sh2lib_upload_stats *stats)
+{
+    *stats = up->stats;
+}
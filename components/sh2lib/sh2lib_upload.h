@@ -0,0 +1,146 @@
+// Copyright 2017-2018 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __SH2LIB_UPLOAD_H_
+#define __SH2LIB_UPLOAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ringbuf.h>
+
+#include "sh2lib.h"
+
+/*
+ * Realtime upload of captured audio over an HTTP/2 stream.
+ *
+ * Sits between the capture ring buffer and the stream's data provider and
+ * decides how much audio goes into each DATA frame:
+ *  - frames grow with the connection RTT (more audio per frame when each
+ *    round trip is expensive anyway) and shrink to fit the send window,
+ *    so weak links get neither a flood of tiny frames nor a stalled stream,
+ *  - no audio waits in the ring for longer than `max_latency_ms`, whatever
+ *    the above says,
+ *  - the stream is deferred while not enough audio is buffered, and
+ *    resumed from sh2lib_upload_poll() when it is.
+ *
+ * Since the source is captured in real time, the age of the oldest
+ * buffered byte is derived from the fill level and `bytes_per_ms`.
+ *
+ * Typical use from the task running the sh2lib loop:
+ *
+ *     sid = sh2lib_do_putpost_with_nv(hd, nva, nvlen, recognize_data_cb, arg);
+ *     sh2lib_loop_add_stream(loop, sid, SH2LIB_PRIO_HIGH);
+ *     sh2lib_upload_attach(up, sid);
+ *     while (!done) {
+ *         sh2lib_loop_run(loop, sh2lib_upload_poll(up));
+ *     }
+ *
+ * where recognize_data_cb() emits any multipart headers and then returns
+ * sh2lib_upload_read(). Once the user stops talking, the capture side calls
+ * rb_signal_writer_finished() followed by sh2lib_upload_end_of_speech().
+ */
+struct sh2lib_upload;
+
+struct sh2lib_upload_cfg {
+    /** Ring buffer the captured audio is written to */
+    ringbuf_t *rb;
+    /** Capture rate, 32 for 16KHz 16-bit mono */
+    int bytes_per_ms;
+    /** Smallest frame worth sending, in ms of audio (default 20) */
+    int min_frame_ms;
+    /** Hard cap on how long audio may wait before being sent (default 200) */
+    int max_latency_ms;
+};
+
+struct sh2lib_upload_stats {
+    uint32_t frames;
+    uint32_t bytes;
+    /** Times the stream was deferred waiting for audio or window */
+    uint32_t deferrals;
+    /** Frame size currently aimed at, in bytes */
+    int target_frame;
+    /** Largest time any audio waited in the ring before being framed */
+    int max_frame_latency_ms;
+    /** From sh2lib_upload_end_of_speech() to the last byte, -1 if not done */
+    int eos_to_last_byte_ms;
+};
+
+/**
+ * @brief Create an upload for a loop
+ *
+ * @param[in] loop  Loop of the connection the upload goes out on
+ * @param[in] cfg   Upload configuration
+ *
+ * @return
+ *             - Pointer to the upload on success
+ *             - NULL on invalid configuration or if out of memory
+ */
+struct sh2lib_upload *sh2lib_upload_create(struct sh2lib_loop *loop, const struct sh2lib_upload_cfg *cfg);
+
+/**
+ * @brief Delete an upload
+ */
+void sh2lib_upload_delete(struct sh2lib_upload *up);
+
+/**
+ * @brief Start uploading on a stream
+ *
+ * Resets the statistics, so one upload object can serve consecutive
+ * Recognize requests.
+ *
+ * @param[in] up         Pointer to the upload
+ * @param[in] stream_id  Stream whose data provider calls sh2lib_upload_read()
+ */
+void sh2lib_upload_attach(struct sh2lib_upload *up, int32_t stream_id);
+
+/**
+ * @brief Fill a DATA frame
+ *
+ * To be returned from the stream's nghttp2 data provider, which passes on
+ * its `buf`, `length` and `data_flags`. Sets NGHTTP2_DATA_FLAG_EOF once the
+ * writer has finished and the ring is drained. A provider that still has a
+ * multipart trailer to send clears the flag again and sends it next time.
+ *
+ * @return
+ *             - Number of bytes placed in `buf`
+ *             - NGHTTP2_ERR_DEFERRED if it is too early for a frame
+ *             - NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE if the ring was aborted
+ */
+ssize_t sh2lib_upload_read(struct sh2lib_upload *up, uint8_t *buf, size_t length,
+                           uint32_t *data_flags);
+
+/**
+ * @brief Resume the stream when a frame is due
+ *
+ * Must be called from the loop task before every sh2lib_loop_run().
+ *
+ * @return Timeout in ms to pass to sh2lib_loop_run(), so that the loop
+ *         wakes up in time for the next frame
+ */
+int sh2lib_upload_poll(struct sh2lib_upload *up);
+
+/**
+ * @brief Mark the end of speech
+ *
+ * Starts the end-of-speech-to-last-byte measurement and wakes up the loop
+ * for the final frame. Can be called from the capture task.
+ */
+void sh2lib_upload_end_of_speech(struct sh2lib_upload *up);
+
+/**
+ * @brief Get the upload statistics
+ */
+void sh2lib_upload_get_stats(struct sh2lib_upload *up, struct sh2lib_upload_stats *stats);
+
+#endif /* ! __SH2LIB_UPLOAD_H_ */
@@ -0,0 +1,16 @@
+#pragma once
+
+/* The part of esp_tls the sh2lib loop uses, reads are provided by the test */
+
+#include <sys/types.h>
+
+#define MBEDTLS_ERR_SSL_WANT_READ   -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE  -0x6880
+
+typedef struct esp_tls_cfg esp_tls_cfg_t;
+
+struct esp_tls {
+    int sockfd;
+};
+
+ssize_t esp_tls_conn_read(struct esp_tls *tls, void *data, size_t datalen);
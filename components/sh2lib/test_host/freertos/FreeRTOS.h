@@ -0,0 +1,15 @@
+#pragma once
+
+/* Critical sections and the types the ring buffer header needs, the tests
+ * run on one thread */
+
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct {
+    int count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portENTER_CRITICAL(mux)         ((mux)->count++)
+#define portEXIT_CRITICAL(mux)          ((mux)->count--)
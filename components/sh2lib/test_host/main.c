@@ -0,0 +1,373 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of the sh2lib event loop (sh2lib_loop.c).
+ *
+ *   ./test_loop  run the tests, the exit status tells whether they passed
+ *
+ * The HTTP/2 session and the TLS reads are faked below; the loop's own
+ * select() and wakeup sockets are real, on a socketpair and loopback.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "sh2lib.h"
+#include "sh2lib_priv.h"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Time seen by the loop, moved by the tests */
+static int64_t test_time_us = 10 * 1000 * 1000;
+
+int64_t esp_timer_get_time(void)
+{
+    return test_time_us;
+}
+
+static int64_t real_time_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Session */
+
+#define TEST_MAX_CALLS 16
+
+struct nghttp2_session {
+    int num_prio;
+    int32_t prio_stream[TEST_MAX_CALLS];
+    nghttp2_priority_spec prio[TEST_MAX_CALLS];
+    int num_resumed;
+    int32_t resumed[TEST_MAX_CALLS];
+    int pings;
+    uint8_t ping[8];
+    int sends;
+    size_t recv_bytes;
+    size_t recv_since_send;
+    size_t max_recv_between_sends;
+    /* Streams with an id above this are closed */
+    int32_t last_open_stream;
+};
+
+void nghttp2_priority_spec_init(nghttp2_priority_spec *pri_spec, int32_t stream_id, int32_t weight, int exclusive)
+{
+    pri_spec->stream_id = stream_id;
+    pri_spec->weight = weight;
+    pri_spec->exclusive = exclusive != 0;
+}
+
+int nghttp2_submit_priority(nghttp2_session *session, uint8_t flags, int32_t stream_id,
+                            const nghttp2_priority_spec *pri_spec)
+{
+    if (session->num_prio < TEST_MAX_CALLS) {
+        session->prio_stream[session->num_prio] = stream_id;
+        session->prio[session->num_prio] = *pri_spec;
+    }
+    session->num_prio++;
+    return 0;
+}
+
+int nghttp2_submit_ping(nghttp2_session *session, uint8_t flags, const uint8_t *opaque_data)
+{
+    memcpy(session->ping, opaque_data, sizeof(session->ping));
+    session->pings++;
+    return 0;
+}
+
+int nghttp2_session_resume_data(nghttp2_session *session, int32_t stream_id)
+{
+    if (session->num_resumed < TEST_MAX_CALLS) {
+        session->resumed[session->num_resumed] = stream_id;
+    }
+    session->num_resumed++;
+    return 0;
+}
+
+int nghttp2_session_want_write(nghttp2_session *session)
+{
+    return 0;
+}
+
+ssize_t nghttp2_session_mem_recv(nghttp2_session *session, const uint8_t *in, size_t inlen)
+{
+    session->recv_bytes += inlen;
+    session->recv_since_send += inlen;
+    if (session->recv_since_send > session->max_recv_between_sends) {
+        session->max_recv_between_sends = session->recv_since_send;
+    }
+    return inlen;
+}
+
+int nghttp2_session_send(nghttp2_session *session)
+{
+    session->sends++;
+    session->recv_since_send = 0;
+    return 0;
+}
+
+int32_t nghttp2_session_get_remote_window_size(nghttp2_session *session)
+{
+    return 65535;
+}
+
+int32_t nghttp2_session_get_stream_remote_window_size(nghttp2_session *session, int32_t stream_id)
+{
+    return stream_id > session->last_open_stream ? -1 : 65535;
+}
+
+int32_t nghttp2_session_get_stream_effective_local_window_size(nghttp2_session *session, int32_t stream_id)
+{
+    return 65535;
+}
+
+int32_t nghttp2_session_get_stream_effective_recv_data_length(nghttp2_session *session, int32_t stream_id)
+{
+    return 0;
+}
+
+int nghttp2_session_get_stream_local_close(nghttp2_session *session, int32_t stream_id)
+{
+    return 0;
+}
+
+int nghttp2_session_get_stream_remote_close(nghttp2_session *session, int32_t stream_id)
+{
+    return 0;
+}
+
+/* Connection: a socketpair for select(), and bytes the TLS layer has to give */
+
+struct test_conn {
+    struct esp_tls tls;
+    int peer_fd;
+    size_t pending;
+    struct nghttp2_session sess;
+    struct sh2lib_handle hd;
+};
+
+ssize_t esp_tls_conn_read(struct esp_tls *tls, void *data, size_t datalen)
+{
+    struct test_conn *conn = (struct test_conn *) tls;
+    size_t len = datalen < conn->pending ? datalen : conn->pending;
+
+    if (len == 0) {
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    memset(data, 0, len);
+    conn->pending -= len;
+    return len;
+}
+
+static void conn_init(struct test_conn *conn)
+{
+    int sv[2];
+
+    memset(conn, 0, sizeof(*conn));
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    conn->tls.sockfd = sv[0];
+    conn->peer_fd = sv[1];
+    conn->sess.last_open_stream = 1000;
+    conn->hd.http2_sess = &conn->sess;
+    conn->hd.http2_tls = &conn->tls;
+}
+
+static void conn_cleanup(struct test_conn *conn)
+{
+    close(conn->tls.sockfd);
+    close(conn->peer_fd);
+}
+
+/* Whether select() sees the socket readable */
+static void conn_set_readable(struct test_conn *conn, bool readable)
+{
+    uint8_t byte = 0;
+    if (readable) {
+        send(conn->peer_fd, &byte, 1, 0);
+    } else {
+        while (recv(conn->tls.sockfd, &byte, 1, MSG_DONTWAIT) > 0);
+    }
+}
+
+static void check_prio(struct nghttp2_session *sess, int call, int32_t stream_id, int32_t weight, uint8_t exclusive)
+{
+    CHECK(sess->prio_stream[call] == stream_id, "call %d for stream %d, not %d", call, sess->prio_stream[call],
+          stream_id);
+    CHECK(sess->prio[call].stream_id == 0, "stream %d depends on %d, not the root", stream_id,
+          sess->prio[call].stream_id);
+    CHECK(sess->prio[call].weight == weight && sess->prio[call].exclusive == exclusive,
+          "stream %d: weight %d exclusive %d", stream_id, sess->prio[call].weight, sess->prio[call].exclusive);
+}
+
+static void test_priority()
+{
+    struct test_conn conn;
+    conn_init(&conn);
+    struct sh2lib_loop *loop = sh2lib_loop_create(&conn.hd);
+
+    CHECK(sh2lib_loop_add_stream(loop, 1, SH2LIB_PRIO_HIGH) == 0, "add high");
+    CHECK(sh2lib_loop_add_stream(loop, 3, SH2LIB_PRIO_LOW) == 0, "add low");
+    CHECK(sh2lib_loop_add_stream(loop, 5, SH2LIB_PRIO_NORMAL) == 0, "add normal");
+    CHECK(sh2lib_loop_add_stream(loop, 7, (sh2lib_prio_t) 42) == 0, "add unknown priority");
+    CHECK(conn.sess.num_prio == 4, "%d PRIORITY frames", conn.sess.num_prio);
+    check_prio(&conn.sess, 0, 1, NGHTTP2_MAX_WEIGHT, 1);
+    check_prio(&conn.sess, 1, 3, NGHTTP2_MIN_WEIGHT, 0);
+    check_prio(&conn.sess, 2, 5, NGHTTP2_DEFAULT_WEIGHT, 0);
+    check_prio(&conn.sess, 3, 7, NGHTTP2_DEFAULT_WEIGHT, 0);
+
+    /* Changing the priority of a tracked stream takes no new slot */
+    CHECK(sh2lib_loop_add_stream(loop, 1, SH2LIB_PRIO_NORMAL) == 0, "reprioritize");
+    check_prio(&conn.sess, 4, 1, NGHTTP2_DEFAULT_WEIGHT, 0);
+    for (int32_t id = 9; id <= 15; id += 2) {
+        CHECK(sh2lib_loop_add_stream(loop, id, SH2LIB_PRIO_LOW) == 0, "add stream %d", id);
+    }
+    CHECK(sh2lib_loop_add_stream(loop, 17, SH2LIB_PRIO_HIGH) != 0, "ninth stream tracked");
+    CHECK(conn.sess.num_prio == 9, "PRIORITY frame for an untracked stream");
+
+    /* Once the loop sees a stream gone, its slot is free again */
+    conn.sess.last_open_stream = 13;
+    CHECK(sh2lib_loop_run(loop, 0) == 0, "run");
+    struct sh2lib_stream_stats stats;
+    CHECK(sh2lib_loop_get_stream_stats(loop, 15, &stats) == 0 && stats.send_window == -1, "stream 15 not closed");
+    CHECK(sh2lib_loop_add_stream(loop, 17, SH2LIB_PRIO_HIGH) == 0, "no slot after a stream closed");
+    check_prio(&conn.sess, 9, 17, NGHTTP2_MAX_WEIGHT, 1);
+    CHECK(sh2lib_loop_get_stream_stats(loop, 15, &stats) != 0, "closed stream still tracked");
+
+    sh2lib_loop_delete(loop);
+    conn_cleanup(&conn);
+}
+
+/* A busy downchannel is read 4KB at a time, with a send in between */
+static void test_recv_budget()
+{
+    struct test_conn conn;
+    conn_init(&conn);
+    struct sh2lib_loop *loop = sh2lib_loop_create(&conn.hd);
+
+    conn.pending = 3 * 4096 + 1000;
+    conn_set_readable(&conn, true);
+    CHECK(sh2lib_loop_run(loop, 0) == 0, "run");
+    CHECK(conn.sess.recv_bytes == 4096, "first run read %zu bytes", conn.sess.recv_bytes);
+    CHECK(conn.sess.sends == 1, "%d sends", conn.sess.sends);
+
+    /* The rest is held by TLS, out of sight of select(). The loop comes
+     * back for it without waiting. */
+    conn_set_readable(&conn, false);
+    for (int run = 2; run <= 4; run++) {
+        int64_t start = real_time_ms();
+        CHECK(sh2lib_loop_run(loop, 1000) == 0, "run %d", run);
+        CHECK(real_time_ms() - start < 500, "run %d waited", run);
+    }
+    CHECK(conn.sess.recv_bytes == 3 * 4096 + 1000, "read %zu bytes", conn.sess.recv_bytes);
+    CHECK(conn.sess.sends == 4, "%d sends", conn.sess.sends);
+    CHECK(conn.sess.max_recv_between_sends == 4096, "%zu bytes read without sending",
+          conn.sess.max_recv_between_sends);
+
+    /* All read, the next run waits */
+    int64_t start = real_time_ms();
+    CHECK(sh2lib_loop_run(loop, 50) == 0, "run");
+    CHECK(real_time_ms() - start >= 40, "did not wait for the socket");
+    CHECK(conn.sess.recv_bytes == 3 * 4096 + 1000, "read %zu bytes", conn.sess.recv_bytes);
+
+    sh2lib_loop_delete(loop);
+    conn_cleanup(&conn);
+}
+
+static void test_notify()
+{
+    struct test_conn conn;
+    conn_init(&conn);
+    struct sh2lib_loop *loop = sh2lib_loop_create(&conn.hd);
+
+    sh2lib_loop_add_stream(loop, 1, SH2LIB_PRIO_HIGH);
+    sh2lib_loop_add_stream(loop, 3, SH2LIB_PRIO_LOW);
+    CHECK(sh2lib_loop_notify(loop, 5) != 0, "notified an untracked stream");
+    CHECK(sh2lib_loop_notify(loop, 3) == 0 && sh2lib_loop_notify(loop, 3) == 0, "notify");
+    CHECK(sh2lib_loop_notify(loop, 1) == 0, "notify");
+
+    int64_t start = real_time_ms();
+    CHECK(sh2lib_loop_run(loop, 1000) == 0, "run");
+    CHECK(real_time_ms() - start < 500, "not woken up");
+    CHECK(conn.sess.num_resumed == 2, "%d streams resumed", conn.sess.num_resumed);
+    CHECK(conn.sess.resumed[0] + conn.sess.resumed[1] == 4, "resumed %d and %d", conn.sess.resumed[0],
+          conn.sess.resumed[1]);
+
+    /* The wakeup was consumed */
+    start = real_time_ms();
+    CHECK(sh2lib_loop_run(loop, 50) == 0, "run");
+    CHECK(real_time_ms() - start >= 40 && conn.sess.num_resumed == 2, "woken up again");
+
+    sh2lib_loop_delete(loop);
+    conn_cleanup(&conn);
+}
+
+/* PING ACKs reach the loop of their connection only */
+static void test_rtt()
+{
+    struct test_conn conn[2];
+    struct sh2lib_loop *loop[2];
+
+    for (int i = 0; i < 2; i++) {
+        conn_init(&conn[i]);
+        loop[i] = sh2lib_loop_create(&conn[i].hd);
+        sh2lib_loop_run(loop[i], 0);
+        CHECK(conn[i].sess.pings == 1, "connection %d: %d PINGs", i, conn[i].sess.pings);
+    }
+
+    test_time_us += 80 * 1000;
+    sh2lib_loop_on_ping_ack(&conn[1].hd, conn[1].sess.ping);
+    CHECK(sh2lib_loop_get_rtt_ms(loop[1]) == 80, "RTT %d ms", sh2lib_loop_get_rtt_ms(loop[1]));
+    CHECK(sh2lib_loop_get_rtt_ms(loop[0]) == 0, "other loop got RTT %d ms", sh2lib_loop_get_rtt_ms(loop[0]));
+
+    /* Smoothed over samples, and PINGs of the application are left alone */
+    test_time_us += 80 * 1000;
+    sh2lib_loop_on_ping_ack(&conn[1].hd, conn[1].sess.ping);
+    CHECK(sh2lib_loop_get_rtt_ms(loop[1]) == (7 * 80 + 160) / 8, "RTT %d ms", sh2lib_loop_get_rtt_ms(loop[1]));
+    uint8_t app_ping[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    sh2lib_loop_on_ping_ack(&conn[0].hd, app_ping);
+    CHECK(sh2lib_loop_get_rtt_ms(loop[0]) == 0, "application PING measured");
+
+    /* Deleting the newest loop keeps the older one reachable */
+    sh2lib_loop_delete(loop[1]);
+    sh2lib_loop_on_ping_ack(&conn[1].hd, conn[1].sess.ping);
+    sh2lib_loop_on_ping_ack(&conn[0].hd, conn[0].sess.ping);
+    CHECK(sh2lib_loop_get_rtt_ms(loop[0]) == 160, "RTT %d ms", sh2lib_loop_get_rtt_ms(loop[0]));
+
+    /* No PING until the interval is over */
+    sh2lib_loop_run(loop[0], 0);
+    CHECK(conn[0].sess.pings == 1, "%d PINGs", conn[0].sess.pings);
+    test_time_us += 5000 * 1000;
+    sh2lib_loop_run(loop[0], 0);
+    CHECK(conn[0].sess.pings == 2, "%d PINGs", conn[0].sess.pings);
+
+    sh2lib_loop_delete(loop[0]);
+    conn_cleanup(&conn[0]);
+    conn_cleanup(&conn[1]);
+}
+
+int main()
+{
+    test_priority();
+    test_recv_budget();
+    test_notify();
+    test_rtt();
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
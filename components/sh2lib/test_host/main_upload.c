@@ -0,0 +1,199 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests of the upload frame sizing (sh2lib_upload.c).
+ *
+ *   ./test_upload  run the tests, the exit status tells whether they passed
+ *
+ * The file is included to reach upload_frame_size(). The loop, the session
+ * and the ring buffer are faked below.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../sh2lib_upload.c"
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static int test_rtt_ms;
+static int32_t test_window = 65535;
+static int test_filled;
+static int test_resumed;
+
+int64_t esp_timer_get_time(void)
+{
+    return 10 * 1000 * 1000;
+}
+
+int sh2lib_loop_get_rtt_ms(struct sh2lib_loop *loop)
+{
+    return test_rtt_ms;
+}
+
+struct sh2lib_handle *sh2lib_loop_get_handle(struct sh2lib_loop *loop)
+{
+    static struct sh2lib_handle hd;
+    return &hd;
+}
+
+int sh2lib_loop_notify(struct sh2lib_loop *loop, int32_t stream_id)
+{
+    return 0;
+}
+
+int32_t nghttp2_session_get_remote_window_size(nghttp2_session *session)
+{
+    return 1 << 20;
+}
+
+int32_t nghttp2_session_get_stream_remote_window_size(nghttp2_session *session, int32_t stream_id)
+{
+    return test_window;
+}
+
+int nghttp2_session_resume_data(nghttp2_session *session, int32_t stream_id)
+{
+    test_resumed++;
+    return 0;
+}
+
+int rb_is_writer_finished(ringbuf_t *rb)
+{
+    return 0;
+}
+
+ssize_t rb_filled(ringbuf_t *rb)
+{
+    return test_filled;
+}
+
+int rb_read(ringbuf_t *rb, uint8_t *buf, int len, uint32_t ticks_to_wait)
+{
+    len = len < test_filled ? len : test_filled;
+    memset(buf, 0, len);
+    test_filled -= len;
+    return len;
+}
+
+/* 16KHz 16-bit mono, default frame and latency limits */
+static const struct sh2lib_upload_cfg cfg = {
+    .bytes_per_ms = 32,
+    .min_frame_ms = 20,
+    .max_latency_ms = 200,
+};
+
+static void test_rtt_clamp()
+{
+    static const struct {
+        int rtt_ms;
+        int frame_ms;
+    } cases[] = {
+        {0, 20},        /* no RTT measured yet */
+        {79, 20},
+        {80, 20},
+        {84, 21},
+        {200, 50},
+        {400, 100},
+        {800, 200},
+        {801, 200},
+        {5000, 200},
+    };
+
+    for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int size = upload_frame_size(&cfg, cases[i].rtt_ms, 65535);
+        CHECK(size == cases[i].frame_ms * cfg.bytes_per_ms, "RTT %d ms: %d bytes, not %d ms",
+              cases[i].rtt_ms, size, cases[i].frame_ms);
+    }
+}
+
+static void test_window_limit()
+{
+    /* Half the window, even when the RTT asks for more */
+    CHECK(upload_frame_size(&cfg, 400, 4000) == 2000, "%d bytes", upload_frame_size(&cfg, 400, 4000));
+    CHECK(upload_frame_size(&cfg, 5000, 10000) == 5000, "%d bytes", upload_frame_size(&cfg, 5000, 10000));
+    /* A window that fits the RTT target twice does not limit it */
+    CHECK(upload_frame_size(&cfg, 400, 6400) == 3200, "%d bytes", upload_frame_size(&cfg, 400, 6400));
+    /* But never below the smallest frame, however small the window */
+    CHECK(upload_frame_size(&cfg, 400, 1000) == 640, "%d bytes", upload_frame_size(&cfg, 400, 1000));
+    CHECK(upload_frame_size(&cfg, 400, 0) == 640, "%d bytes", upload_frame_size(&cfg, 400, 0));
+    CHECK(upload_frame_size(&cfg, 400, -1) == 640, "%d bytes", upload_frame_size(&cfg, 400, -1));
+
+    /* Within the limits and growing with the RTT, for any window */
+    static const int32_t windows[] = {0, 1000, 3000, 8000, 65535};
+    for (int w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        int prev = 0;
+        int max = windows[w] / 2 > 640 ? windows[w] / 2 : 640;
+        for (int rtt = 0; rtt <= 3000; rtt++) {
+            int size = upload_frame_size(&cfg, rtt, windows[w]);
+            CHECK(size >= prev && size >= 640 && size <= 6400 && size <= max,
+                  "window %d RTT %d: %d bytes after %d", windows[w], rtt, size, prev);
+            prev = size;
+        }
+    }
+}
+
+/* Defaults and limits as resolved by sh2lib_upload_create() */
+static void test_cfg()
+{
+    struct sh2lib_upload_cfg c = { .rb = (ringbuf_t *) 1, .bytes_per_ms = 16 };
+    struct sh2lib_upload *up = sh2lib_upload_create(NULL, &c);
+
+    CHECK(upload_frame_size(&up->cfg, 0, 65535) == 20 * 16, "default smallest frame");
+    CHECK(upload_frame_size(&up->cfg, 10000, 65535) == 200 * 16, "default latency cap");
+    sh2lib_upload_delete(up);
+
+    c.min_frame_ms = 300;
+    c.max_latency_ms = 100;
+    up = sh2lib_upload_create(NULL, &c);
+    CHECK(upload_frame_size(&up->cfg, 0, 65535) == 100 * 16, "smallest frame above the latency cap");
+    sh2lib_upload_delete(up);
+}
+
+/* The data provider waits for a frame of the size above */
+static void test_read()
+{
+    struct sh2lib_upload_cfg c = cfg;
+    c.rb = (ringbuf_t *) 1;
+    struct sh2lib_upload *up = sh2lib_upload_create(NULL, &c);
+    uint8_t buf[8192];
+    uint32_t flags = 0;
+    struct sh2lib_upload_stats stats;
+
+    sh2lib_upload_attach(up, 1);
+    test_rtt_ms = 400;
+    test_window = 4000;
+    test_filled = 1999;
+    CHECK(sh2lib_upload_read(up, buf, test_window, &flags) == NGHTTP2_ERR_DEFERRED, "read before a frame");
+    sh2lib_upload_get_stats(up, &stats);
+    CHECK(stats.target_frame == 2000 && stats.deferrals == 1, "target %d, %u deferrals", stats.target_frame,
+          stats.deferrals);
+
+    test_filled = 2000;
+    CHECK(sh2lib_upload_poll(up) == 0 && test_resumed == 1, "not resumed with a frame buffered");
+    CHECK(sh2lib_upload_read(up, buf, test_window, &flags) == 2000, "frame not read");
+    CHECK(flags == 0, "flags %x", flags);
+    sh2lib_upload_delete(up);
+}
+
+int main()
+{
+    test_rtt_clamp();
+    test_window_limit();
+    test_cfg();
+    test_read();
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
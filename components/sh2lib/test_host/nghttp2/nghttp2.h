@@ -0,0 +1,53 @@
+#pragma once
+
+/* The part of the nghttp2 API sh2lib uses, sessions are faked by the test */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define NGHTTP2_FLAG_NONE       0
+#define NGHTTP2_DEFAULT_WEIGHT  16
+#define NGHTTP2_MAX_WEIGHT      256
+#define NGHTTP2_MIN_WEIGHT      1
+
+#define NGHTTP2_DATA_FLAG_EOF   0x01
+
+#define NGHTTP2_ERR_DEFERRED                    -508
+#define NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE   -521
+
+typedef struct nghttp2_session nghttp2_session;
+
+typedef struct {
+    int32_t stream_id;
+    int32_t weight;
+    uint8_t exclusive;
+} nghttp2_priority_spec;
+
+typedef struct {
+    uint8_t *name;
+    uint8_t *value;
+    size_t namelen;
+    size_t valuelen;
+    uint8_t flags;
+} nghttp2_nv;
+
+typedef void (*nghttp2_on_header_callback)(void);
+typedef void (*nghttp2_on_data_chunk_recv_callback)(void);
+typedef void (*nghttp2_on_stream_close_callback)(void);
+typedef void (*nghttp2_data_source_read_callback)(void);
+
+void nghttp2_priority_spec_init(nghttp2_priority_spec *pri_spec, int32_t stream_id, int32_t weight, int exclusive);
+int nghttp2_submit_priority(nghttp2_session *session, uint8_t flags, int32_t stream_id,
+                            const nghttp2_priority_spec *pri_spec);
+int nghttp2_submit_ping(nghttp2_session *session, uint8_t flags, const uint8_t *opaque_data);
+int nghttp2_session_resume_data(nghttp2_session *session, int32_t stream_id);
+int nghttp2_session_want_write(nghttp2_session *session);
+ssize_t nghttp2_session_mem_recv(nghttp2_session *session, const uint8_t *in, size_t inlen);
+int nghttp2_session_send(nghttp2_session *session);
+int32_t nghttp2_session_get_remote_window_size(nghttp2_session *session);
+int32_t nghttp2_session_get_stream_remote_window_size(nghttp2_session *session, int32_t stream_id);
+int32_t nghttp2_session_get_stream_effective_local_window_size(nghttp2_session *session, int32_t stream_id);
+int32_t nghttp2_session_get_stream_effective_recv_data_length(nghttp2_session *session, int32_t stream_id);
+int nghttp2_session_get_stream_local_close(nghttp2_session *session, int32_t stream_id);
+int nghttp2_session_get_stream_remote_close(nghttp2_session *session, int32_t stream_id);
@@ -23,19 +23,310 @@
  */
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
 
 #include <esp_err.h>
 #include <esp_log.h>
 #include <esp_audio_mem.h>
+#include <esp_timer.h>
 #include <fs_stream.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 
 #define FSTAG   "FATFSStream"
 
+/*
+ * Read-ahead and write-behind.
+ *
+ * The file is accessed in blocks of whole sectors, through a ring of
+ * `depth` blocks shared by the stream task and an I/O task. The `free`
+ * semaphore counts the blocks the producer may fill, `full` the ones the
+ * consumer may drain: for a reader, the I/O task produces, for a writer it
+ * consumes. Each side only touches the block it owns, so the ring needs no
+ * lock. A block of length 0 is the end of the file for a reader, and tells a
+ * writer's I/O task to finish.
+ */
+typedef struct {
+    uint8_t *buf;
+    int len;
+} fs_block_t;
+
+struct fs_stream_ring {
+    int fd;
+    int depth;
+    int block_size;
+    int fsync_interval_ms;
+    fs_block_t *blocks;
+    /* Next block of the I/O task */
+    int head;
+    /* Block of the stream task, and its position in it */
+    int tail;
+    int pos;
+    bool tail_owned;
+    bool eof;
+    volatile bool stop;
+    volatile bool error;
+    SemaphoreHandle_t free;
+    SemaphoreHandle_t full;
+    SemaphoreHandle_t done;
+};
+
+static void fs_stats_add_io(fs_stream_t *stream, int64_t start, int bytes)
+{
+    uint32_t us = esp_timer_get_time() - start;
+    stream->_stats.io_us += us;
+    stream->_stats.io_count++;
+    if (us > stream->_stats.io_max_us) {
+        stream->_stats.io_max_us = us;
+    }
+    if (bytes > 0) {
+        stream->_stats.bytes += bytes;
+    }
+}
+
+/* Take a ring semaphore, counting the wait as a stall if it has to block */
+static void fs_ring_take(fs_stream_t *stream, SemaphoreHandle_t sem)
+{
+    if (xSemaphoreTake(sem, 0) == pdTRUE) {
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+    xSemaphoreTake(sem, portMAX_DELAY);
+    stream->_stats.stalls++;
+    stream->_stats.stall_us += esp_timer_get_time() - start;
+}
+
+static void fs_read_ahead_task(void *arg)
+{
+    fs_stream_t *stream = (fs_stream_t *) arg;
+    struct fs_stream_ring *ring = stream->_ring;
+
+    while (1) {
+        xSemaphoreTake(ring->free, portMAX_DELAY);
+        if (ring->stop) {
+            break;
+        }
+        fs_block_t *b = &ring->blocks[ring->head];
+        int64_t start = esp_timer_get_time();
+        b->len = read(ring->fd, b->buf, ring->block_size);
+        fs_stats_add_io(stream, start, b->len);
+        if (b->len < 0) {
+            ESP_LOGE(FSTAG, "Error reading %s", stream->cfg.file_path);
+            ring->error = true;
+            b->len = 0;
+        }
+        ring->head = (ring->head + 1) % ring->depth;
+        xSemaphoreGive(ring->full);
+        if (b->len == 0) {
+            break;
+        }
+    }
+    xSemaphoreGive(ring->done);
+    vTaskDelete(NULL);
+}
+
+static void fs_write_behind_task(void *arg)
+{
+    fs_stream_t *stream = (fs_stream_t *) arg;
+    struct fs_stream_ring *ring = stream->_ring;
+    int64_t last_sync = esp_timer_get_time();
+
+    while (1) {
+        xSemaphoreTake(ring->full, portMAX_DELAY);
+        fs_block_t *b = &ring->blocks[ring->head];
+        if (b->len == 0) {
+            break;
+        }
+        if (!ring->error) {
+            int64_t start = esp_timer_get_time();
+            int ret = write(ring->fd, b->buf, b->len);
+            fs_stats_add_io(stream, start, ret);
+            if (ret != b->len) {
+                /* Keep draining the ring, the stream task fails on its next write */
+                ESP_LOGE(FSTAG, "Error writing %s", stream->cfg.file_path);
+                ring->error = true;
+            }
+        }
+        ring->head = (ring->head + 1) % ring->depth;
+        xSemaphoreGive(ring->free);
+
+        if (esp_timer_get_time() - last_sync >= ring->fsync_interval_ms * 1000LL) {
+            int64_t start = esp_timer_get_time();
+            fsync(ring->fd);
+            fs_stats_add_io(stream, start, 0);
+            last_sync = esp_timer_get_time();
+        }
+    }
+    fsync(ring->fd);
+    xSemaphoreGive(ring->done);
+    vTaskDelete(NULL);
+}
+
+static void fs_ring_free(struct fs_stream_ring *ring)
+{
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+    if (ring->blocks) {
+        for (int i = 0; i < ring->depth; i++) {
+            free(ring->blocks[i].buf);
+        }
+        free(ring->blocks);
+    }
+    if (ring->free) {
+        vSemaphoreDelete(ring->free);
+    }
+    if (ring->full) {
+        vSemaphoreDelete(ring->full);
+    }
+    if (ring->done) {
+        vSemaphoreDelete(ring->done);
+    }
+    free(ring);
+}
+
+static esp_err_t fs_ring_open(fs_stream_t *stream)
+{
+    struct fs_stream_ring *ring = calloc(1, sizeof(struct fs_stream_ring));
+    if (!ring) {
+        return ESP_ERR_NO_MEM;
+    }
+    int block_size = stream->cfg.block_size ? stream->cfg.block_size : FATFS_STREAM_BLOCK_SIZE;
+    ring->block_size = (block_size + FATFS_STREAM_SECTOR_SIZE - 1) & ~(FATFS_STREAM_SECTOR_SIZE - 1);
+    ring->depth = stream->cfg.prefetch_depth;
+    ring->fsync_interval_ms = stream->cfg.fsync_interval_ms ? stream->cfg.fsync_interval_ms : FATFS_STREAM_FSYNC_INTERVAL_MS;
+    ring->fd = -1;
+
+    ring->blocks = calloc(ring->depth, sizeof(fs_block_t));
+    ring->free = xSemaphoreCreateCounting(ring->depth, ring->depth);
+    ring->full = xSemaphoreCreateCounting(ring->depth, 0);
+    ring->done = xSemaphoreCreateBinary();
+    if (!ring->blocks || !ring->free || !ring->full || !ring->done) {
+        goto err;
+    }
+    for (int i = 0; i < ring->depth; i++) {
+        ring->blocks[i].buf = esp_audio_mem_alloc_dma(1, ring->block_size);
+        if (!ring->blocks[i].buf) {
+            ESP_LOGE(FSTAG, "Failed to allocate %d byte block", ring->block_size);
+            goto err;
+        }
+    }
+
+    bool writer = stream->base.type == STREAM_TYPE_WRITER;
+    /* Recorder always creates a new file */
+    ring->fd = writer ? open(stream->cfg.file_path, O_WRONLY | O_CREAT | O_TRUNC) :
+               open(stream->cfg.file_path, O_RDONLY);
+    if (ring->fd < 0) {
+        ESP_LOGE(FSTAG, "Error opening file %s", stream->cfg.file_path);
+        fs_ring_free(ring);
+        return -3;
+    }
+
+    stream->_ring = ring;
+    if (xTaskCreate(writer ? fs_write_behind_task : fs_read_ahead_task, writer ? "fs_write" : "fs_read",
+                    FATFS_STREAM_IO_TASK_STACK_SIZE, stream, FATFS_STREAM_IO_TASK_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(FSTAG, "Failed to create I/O task");
+        stream->_ring = NULL;
+        goto err;
+    }
+    return ESP_OK;
+
+err:
+    fs_ring_free(ring);
+    return ESP_ERR_NO_MEM;
+}
+
+static void fs_ring_close(fs_stream_t *stream)
+{
+    struct fs_stream_ring *ring = stream->_ring;
+
+    if (stream->base.type == STREAM_TYPE_WRITER) {
+        /* Hand over what is left, then the end marker */
+        if (ring->tail_owned && ring->blocks[ring->tail].len) {
+            xSemaphoreGive(ring->full);
+            ring->tail = (ring->tail + 1) % ring->depth;
+            ring->tail_owned = false;
+        }
+        if (!ring->tail_owned) {
+            xSemaphoreTake(ring->free, portMAX_DELAY);
+        }
+        ring->blocks[ring->tail].len = 0;
+        xSemaphoreGive(ring->full);
+    } else {
+        ring->stop = true;
+        xSemaphoreGive(ring->free);
+    }
+    xSemaphoreTake(ring->done, portMAX_DELAY);
+    fs_ring_free(ring);
+    stream->_ring = NULL;
+}
+
+static ssize_t fs_ring_read(fs_stream_t *stream, void *buf, ssize_t len)
+{
+    struct fs_stream_ring *ring = stream->_ring;
+
+    if (ring->eof) {
+        return -1;
+    }
+    if (!ring->tail_owned) {
+        fs_ring_take(stream, ring->full);
+        ring->tail_owned = true;
+        ring->pos = 0;
+    }
+    fs_block_t *b = &ring->blocks[ring->tail];
+    if (b->len == 0) {
+        ring->eof = true;
+        return -1;
+    }
+    int n = b->len - ring->pos;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(buf, b->buf + ring->pos, n);
+    ring->pos += n;
+    if (ring->pos == b->len) {
+        ring->tail_owned = false;
+        ring->tail = (ring->tail + 1) % ring->depth;
+        xSemaphoreGive(ring->free);
+    }
+    return n;
+}
+
+static ssize_t fs_ring_write(fs_stream_t *stream, void *buf, ssize_t len)
+{
+    struct fs_stream_ring *ring = stream->_ring;
+    ssize_t done = 0;
+
+    while (done < len) {
+        if (ring->error) {
+            return -1;
+        }
+        if (!ring->tail_owned) {
+            fs_ring_take(stream, ring->free);
+            ring->tail_owned = true;
+            ring->blocks[ring->tail].len = 0;
+        }
+        fs_block_t *b = &ring->blocks[ring->tail];
+        int n = ring->block_size - b->len;
+        if (n > len - done) {
+            n = len - done;
+        }
+        memcpy(b->buf + b->len, (uint8_t *) buf + done, n);
+        b->len += n;
+        done += n;
+        if (b->len == ring->block_size) {
+            ring->tail_owned = false;
+            ring->tail = (ring->tail + 1) % ring->depth;
+            xSemaphoreGive(ring->full);
+        }
+    }
+    return done;
+}
+
 static esp_err_t parse_fs_config(void *base_stream)
 {
     fs_stream_t *stream = (fs_stream_t *) base_stream;
@@ -44,6 +335,16 @@ static esp_err_t parse_fs_config(void *base_stream)
         return -1;
     }
 
+    memset(&stream->_stats, 0, sizeof(stream->_stats));
+    if (stream->cfg.prefetch_depth > 0) {
+        if (stream->base.type == STREAM_TYPE_READER) {
+            struct stat st = {0};
+            stat(stream->cfg.file_path, &st);
+            stream->total_bytes = st.st_size;
+        }
+        return fs_ring_open(stream);
+    }
+
     if (stream->base.type == STREAM_TYPE_WRITER) {
         stream->_file = fopen(stream->cfg.file_path, "w");
         if (stream->_file) {
@@ -72,6 +373,9 @@ static esp_err_t parse_fs_config(void *base_stream)
 static void reset_fs_config(void *base_stream)
 {
     fs_stream_t *stream = (fs_stream_t *) base_stream;
+    if (stream->_ring) {
+        fs_ring_close(stream);
+    }
     if (stream->_file) {
         fclose(stream->_file);
         stream->_file = NULL;
@@ -85,7 +389,12 @@ ssize_t fs_read(void *s, void *buf, ssize_t len)
 {
     int ret;
     fs_stream_t *stream = (fs_stream_t *) s;
+    if (stream->_ring) {
+        return fs_ring_read(stream, buf, len);
+    }
+    int64_t start = esp_timer_get_time();
     ret = fread(buf, 1, len, stream->_file);
+    fs_stats_add_io(stream, start, ret);
     if (ret == 0) {
         return -1;
     }
@@ -96,7 +405,12 @@ ssize_t fs_write(void *s, void *buf, ssize_t len)
 {
     int ret;
     fs_stream_t *stream = (fs_stream_t *) s;
+    if (stream->_ring) {
+        return fs_ring_write(stream, buf, len);
+    }
+    int64_t start = esp_timer_get_time();
     ret = fwrite(buf, 1, len, stream->_file);
+    fs_stats_add_io(stream, start, ret);
     if (ret == 0) {
         return -1;
     }
@@ -170,5 +484,18 @@ esp_err_t fs_stream_set_config(fs_stream_t *stream, fs_stream_config_t *cfg)
     }
 
     snprintf(stream->cfg.file_path, FATFS_STREAM_FILE_PATH_MAX, "%s", cfg->file_path);
+    stream->cfg.prefetch_depth = cfg->prefetch_depth;
+    stream->cfg.block_size = cfg->block_size;
+    stream->cfg.fsync_interval_ms = cfg->fsync_interval_ms;
+    return ESP_OK;
+}
+
+esp_err_t fs_stream_get_stats(fs_stream_t *stream, fs_stream_stats_t *stats)
+{
+    if (stream == NULL || stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Updated without locking, a figure may be one I/O behind */
+    *stats = stream->_stats;
     return ESP_OK;
 }
@@ -31,8 +31,29 @@
 
 typedef struct fs_stream_config {
     char file_path[FATFS_STREAM_FILE_PATH_MAX];   /* Path of the file used for read/write */
+    /* Number of blocks read ahead, or written behind, by an I/O task of the
+     * stream's own. With 0, the stream task does the I/O through stdio. */
+    int prefetch_depth;
+    /* Size of these blocks, rounded up to whole sectors. They are read and
+     * written at sector aligned offsets, from DMA capable memory, so that the
+     * card driver transfers them directly. 0 for FATFS_STREAM_BLOCK_SIZE. */
+    int block_size;
+    /* Writer only: fsync at least this often while writing behind, 0 for
+     * FATFS_STREAM_FSYNC_INTERVAL_MS */
+    int fsync_interval_ms;
 } fs_stream_config_t;
 
+typedef struct fs_stream_stats {
+    uint64_t bytes;         /* Read from or written to the file */
+    uint64_t io_us;         /* Time spent in file I/O, bytes / io_us is the card throughput */
+    uint32_t io_count;
+    uint32_t io_max_us;     /* Longest single I/O, card stalls show here */
+    uint32_t stalls;        /* Times the stream task waited for the I/O task */
+    uint64_t stall_us;
+} fs_stream_stats_t;
+
+struct fs_stream_ring;
+
 typedef struct fs_stream {
     audio_stream_t base;
     fs_stream_config_t cfg;
@@ -40,6 +61,8 @@ typedef struct fs_stream {
     /* Private members */
     FILE *_file;
     size_t total_bytes;
+    struct fs_stream_ring *_ring;
+    fs_stream_stats_t _stats;
 } fs_stream_t;
 
 fs_stream_t *fs_reader_stream_create(fs_stream_config_t *cfg);
@@ -50,7 +73,17 @@ esp_err_t fs_stream_destroy(fs_stream_t *stream);
 esp_err_t fs_stream_set_config(fs_stream_t *stream, fs_stream_config_t *cfg);
 void fs_stream_set_stack_size(fs_stream_t *stream, ssize_t stack_size);
 
+/* Statistics of the current file, reset when a file is opened */
+esp_err_t fs_stream_get_stats(fs_stream_t *stream, fs_stream_stats_t *stats);
+
 #define FATFS_STREAM_BUFFER_SIZE (2*1024)
 #define FATFS_STREAM_TASK_STACK_SIZE    2200
 #define FATFS_STREAM_TASK_PRIORITY      4
+
+#define FATFS_STREAM_SECTOR_SIZE        512
+#define FATFS_STREAM_BLOCK_SIZE         (8*1024)
+#define FATFS_STREAM_FSYNC_INTERVAL_MS  1000
+#define FATFS_STREAM_IO_TASK_STACK_SIZE 3072
+/* Above the stream task, so that the card is kept busy */
+#define FATFS_STREAM_IO_TASK_PRIORITY   (FATFS_STREAM_TASK_PRIORITY + 1)
 #endif /* _FATFS_STREAM_H_ */
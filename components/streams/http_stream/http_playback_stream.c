@@ -23,6 +23,9 @@
  */
 
 #include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include <esp_err.h>
 #include <esp_log.h>
 #include <http_playback_stream.h>
@@ -31,6 +34,56 @@
 
 static const char *TAG = "[http_playback_stream]";
 
+#define PREFETCH_READ_SIZE 1024
+
+typedef enum {
+    PREFETCH_IDLE,
+    PREFETCH_REQUESTED,
+    PREFETCH_RUNNING,
+    PREFETCH_READY,
+} prefetch_state_t;
+
+/* Next track fetched ahead, see http_playback_stream_prefetch() */
+static struct {
+    SemaphoreHandle_t mutex;
+    SemaphoreHandle_t req_sem;
+    TaskHandle_t task;
+    portMUX_TYPE lock;
+    volatile prefetch_state_t state;
+    /* Connection and playlists of the URL being fetched */
+    http_playback_stream_t stream;
+    char *url;
+    int offset_in_ms;
+    size_t budget;
+    http_hls_mime_type_t mime_type;
+    uint8_t *buf;
+    size_t len;
+    bool eof;
+    /* Stop fetching, but keep what is there */
+    volatile bool finish;
+    TickType_t ready_at;
+} prefetch = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static ssize_t http_read(void *s, void *buf, ssize_t len);
+static void reset_http_config(void *base_stream);
+
+/* Reads return every 500ms at most, so that a stalled server does not keep
+ * a reader from noticing it has been stopped */
+static void http_playback_set_recv_timeout(httpc_conn_t *handle)
+{
+    struct timeval tv = {
+        .tv_sec = 0,
+        .tv_usec = 500 * 1000, /* 500 msec */
+    };
+    if (handle && handle->tls) {
+        setsockopt(handle->tls->sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+}
+
+static bool http_playback_prefetch_adopt(http_playback_stream_t *hstream, http_hls_mime_type_t *mime_type);
+
 static esp_err_t parse_http_config(void *base_stream)
 {
     http_playback_stream_t *hstream = (http_playback_stream_t *) base_stream;
@@ -43,23 +96,29 @@ static esp_err_t parse_http_config(void *base_stream)
         return 0;
     }
 
-    if (http_playback_stream_create_or_renew_session(hstream) != ESP_OK) {
-        return ESP_FAIL;
-    }
+    bool adopted = http_playback_prefetch_adopt(hstream, &mime_type);
+    if (adopted) {
+        /* Connected to the audio, or first variant, already */
+        is_hls = hstream->hls_cfg.variant_playlist != NULL;
+    } else {
+        if (http_playback_stream_create_or_renew_session(hstream) != ESP_OK) {
+            return ESP_FAIL;
+        }
 
-    const char *content_type = http_response_get_content_type(hstream->handle);
+        const char *content_type = http_response_get_content_type(hstream->handle);
 
-    mime_type = http_hls_identify_and_init_playlist(&hstream->hls_cfg, content_type, hstream->handle, hstream->cfg.url);
-    if (mime_type == APPLE_URL || mime_type == MPEG_URL || mime_type == XSCPLS_URL) {
-        is_hls = true;
-    } else {
-        /* if it's not HLS, it could be a direct audio url */
-        is_hls = false;
+        mime_type = http_hls_identify_and_init_playlist(&hstream->hls_cfg, content_type, hstream->handle, hstream->cfg.url);
+        if (mime_type == APPLE_URL || mime_type == MPEG_URL || mime_type == XSCPLS_URL) {
+            is_hls = true;
+        } else {
+            /* if it's not HLS, it could be a direct audio url */
+            is_hls = false;
+        }
     }
 
     int ret = 0;
     do {
-        if (is_hls) {
+        if (is_hls && !adopted) {
             mime_type = http_hls_connect_new_variant(hstream);
             if (!hstream->handle) { /* Variant playlist exhausted but no luck. */
                 return ESP_FAIL;
@@ -68,6 +127,7 @@ static esp_err_t parse_http_config(void *base_stream)
                 continue;
             }
         }
+        adopted = false;
 
         http_playback_stream_custom_data_t custom_data = {
             .content_type = mime_type,
@@ -76,11 +136,7 @@ static esp_err_t parse_http_config(void *base_stream)
 
         ret = hstream->base.event_func.func(hstream->base.event_func.arg, STREAM_EVENT_CUSTOM_DATA, &custom_data);
         if (ret == 0) { /* Play successful. set socketopts and break. */
-            struct timeval tv = {
-                .tv_sec = 0,
-                .tv_usec = 500 * 1000, /* 500 msec */
-            };
-            setsockopt(hstream->handle->tls->sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            http_playback_set_recv_timeout(hstream->handle);
             break;
         } else { /* Couldn't play this url. */
             ESP_LOGE(TAG, "Could not play url: %s", hstream->cfg.url);
@@ -90,9 +146,7 @@ static esp_err_t parse_http_config(void *base_stream)
                 continue; /* Cannot play this variant. Try next. */
             } else {
                 /* This is direct url. And we cannot play. break. */
-                http_request_delete(hstream->handle);
-                http_connection_delete(hstream->handle);
-                hstream->handle = NULL;
+                reset_http_config(hstream);
                 return ESP_FAIL;
             }
         }
@@ -111,11 +165,32 @@ static void reset_http_config(void *base_stream)
         http_connection_delete(stream->handle);
         stream->handle = NULL;
     }
+    if (stream->prefetch_buf) {
+        esp_audio_mem_free(stream->prefetch_buf);
+        stream->prefetch_buf = NULL;
+    }
 }
 
 static ssize_t http_read(void *s, void *buf, ssize_t len)
 {
     http_playback_stream_t *bstream = (http_playback_stream_t *) s;
+    if (bstream->prefetch_buf) {
+        size_t left = bstream->prefetch_len - bstream->prefetch_pos;
+        if (left) {
+            if (left > len) {
+                left = len;
+            }
+            memcpy(buf, bstream->prefetch_buf + bstream->prefetch_pos, left);
+            bstream->prefetch_pos += left;
+            return left;
+        }
+        esp_audio_mem_free(bstream->prefetch_buf);
+        bstream->prefetch_buf = NULL;
+    }
+    if (!bstream->handle) {
+        /* The whole track was prefetched, nothing more to come */
+        return -1;
+    }
     int data_read = http_response_recv(bstream->handle, buf, len);
     if (data_read == -EAGAIN) {
         printf("%s: [http_response_recv]: returning EAGAIN\n", TAG);
@@ -147,6 +222,9 @@ static void http_playback_stream_free(http_playback_stream_t *stream)
     if (!stream) {
         return;
     }
+    if (stream->prefetch_buf) {
+        esp_audio_mem_free(stream->prefetch_buf);
+    }
     free(stream->cfg.url);
     free(stream);
 }
@@ -321,3 +399,256 @@ esp_err_t http_playback_stream_set_config(http_playback_stream_t *stream, http_p
     stream->cfg.offset_in_ms = cfg->offset_in_ms;
     return ESP_OK;
 }
+
+/* Drop everything fetched ahead. The fetch task must not be running. */
+static void http_playback_prefetch_release()
+{
+    http_playback_stream_t *s = &prefetch.stream;
+
+    reset_http_config(s);
+    if (s->hls_cfg.media_playlist) {
+        playlist_free(s->hls_cfg.media_playlist);
+    }
+    if (s->hls_cfg.variant_playlist) {
+        playlist_free(s->hls_cfg.variant_playlist);
+    }
+    memset(&s->hls_cfg, 0, sizeof(s->hls_cfg));
+    free(s->cfg.url);
+    s->cfg.url = NULL;
+    if (prefetch.buf) {
+        esp_audio_mem_free(prefetch.buf);
+        prefetch.buf = NULL;
+    }
+    prefetch.len = 0;
+    prefetch.eof = false;
+    free(prefetch.url);
+    prefetch.url = NULL;
+}
+
+static bool http_playback_prefetch_run(http_playback_stream_t *s)
+{
+    s->base._run = 1;
+    s->cfg.url = strdup(prefetch.url);
+    s->cfg.offset_in_ms = prefetch.offset_in_ms;
+    if (!s->cfg.url || http_playback_stream_create_or_renew_session(s) != ESP_OK) {
+        return false;
+    }
+    /* Dropping or adopting the fetch waits for it to notice */
+    http_playback_set_recv_timeout(s->handle);
+
+    const char *content_type = http_response_get_content_type(s->handle);
+    http_hls_mime_type_t mime_type = http_hls_identify_and_init_playlist(&s->hls_cfg, content_type, s->handle, s->cfg.url);
+    if (mime_type == APPLE_URL || mime_type == MPEG_URL || mime_type == XSCPLS_URL) {
+        /* Same choice of variant as parse_http_config() makes first */
+        mime_type = http_hls_connect_new_variant(s);
+        if (!s->handle || mime_type == UNKNOWN_URL || mime_type == NO_URL) {
+            return false;
+        }
+        http_playback_set_recv_timeout(s->handle);
+    }
+    prefetch.mime_type = mime_type;
+
+    prefetch.buf = esp_audio_mem_malloc(prefetch.budget);
+    if (!prefetch.buf) {
+        ESP_LOGE(TAG, "Failed to allocate %d bytes for prefetch", prefetch.budget);
+        return false;
+    }
+    httpc_conn_t *handle = s->handle;
+    while (s->base._run && !prefetch.finish && prefetch.len < prefetch.budget) {
+        size_t len = prefetch.budget - prefetch.len;
+        ssize_t data_read = http_read(s, prefetch.buf + prefetch.len,
+                                      len < PREFETCH_READ_SIZE ? len : PREFETCH_READ_SIZE);
+        if (data_read < 0) {
+            prefetch.eof = true;
+            break;
+        }
+        prefetch.len += data_read;
+        if (s->handle != handle) {
+            /* Moved on to the next playlist segment */
+            handle = s->handle;
+            http_playback_set_recv_timeout(handle);
+        }
+    }
+    if (prefetch.eof && s->handle && !s->hls_cfg.variant_playlist) {
+        /* All of it is in the buffer, the TLS session is of no more use */
+        http_request_delete(s->handle);
+        http_connection_delete(s->handle);
+        s->handle = NULL;
+    }
+    return s->base._run;
+}
+
+/* Drop a fetch nobody took in time */
+static void http_playback_prefetch_expire()
+{
+    xSemaphoreTake(prefetch.mutex, portMAX_DELAY);
+    if (prefetch.state == PREFETCH_READY && !prefetch.eof &&
+            (xTaskGetTickCount() - prefetch.ready_at) >= HTTP_PLAYBACK_PREFETCH_MAX_IDLE_MS / portTICK_PERIOD_MS) {
+        ESP_LOGI(TAG, "Dropping %d prefetched bytes, unused for %d ms", prefetch.len, HTTP_PLAYBACK_PREFETCH_MAX_IDLE_MS);
+        http_playback_prefetch_release();
+        prefetch.state = PREFETCH_IDLE;
+    }
+    xSemaphoreGive(prefetch.mutex);
+}
+
+static void http_playback_prefetch_task(void *arg)
+{
+    while (1) {
+        TickType_t wait = portMAX_DELAY;
+        if (prefetch.state == PREFETCH_READY && !prefetch.eof) {
+            TickType_t idle = xTaskGetTickCount() - prefetch.ready_at;
+            TickType_t max_idle = HTTP_PLAYBACK_PREFETCH_MAX_IDLE_MS / portTICK_PERIOD_MS;
+            wait = idle < max_idle ? max_idle - idle : 0;
+        }
+        if (xSemaphoreTake(prefetch.req_sem, wait) != pdTRUE) {
+            http_playback_prefetch_expire();
+            continue;
+        }
+
+        portENTER_CRITICAL(&prefetch.lock);
+        bool requested = prefetch.state == PREFETCH_REQUESTED;
+        if (requested) {
+            prefetch.state = PREFETCH_RUNNING;
+        }
+        portEXIT_CRITICAL(&prefetch.lock);
+        if (!requested) {
+            continue;
+        }
+
+        ESP_LOGI(TAG, "Prefetching %s", prefetch.url);
+        bool ok = http_playback_prefetch_run(&prefetch.stream);
+        if (ok) {
+            ESP_LOGI(TAG, "Prefetched %d bytes%s", prefetch.len, prefetch.eof ? ", whole track" : "");
+            prefetch.ready_at = xTaskGetTickCount();
+            prefetch.state = PREFETCH_READY;
+        } else {
+            http_playback_prefetch_release();
+            prefetch.state = PREFETCH_IDLE;
+        }
+    }
+}
+
+/* Stop and drop any fetch. Called with the mutex held. */
+static void http_playback_prefetch_drop()
+{
+    portENTER_CRITICAL(&prefetch.lock);
+    if (prefetch.state == PREFETCH_REQUESTED) {
+        prefetch.state = PREFETCH_IDLE;
+    }
+    portEXIT_CRITICAL(&prefetch.lock);
+
+    if (prefetch.state == PREFETCH_RUNNING) {
+        prefetch.stream.base._run = 0;
+        while (prefetch.state == PREFETCH_RUNNING) {
+            vTaskDelay(10 / portTICK_PERIOD_MS);
+        }
+    }
+    http_playback_prefetch_release();
+    prefetch.state = PREFETCH_IDLE;
+}
+
+static bool http_playback_prefetch_adopt(http_playback_stream_t *hstream, http_hls_mime_type_t *mime_type)
+{
+    http_playback_stream_t *s = &prefetch.stream;
+    bool adopted = false;
+
+    if (!prefetch.mutex || !hstream->cfg.url) {
+        return false;
+    }
+    xSemaphoreTake(prefetch.mutex, portMAX_DELAY);
+    if (!prefetch.url || strcmp(prefetch.url, hstream->cfg.url) != 0 ||
+            prefetch.offset_in_ms != hstream->cfg.offset_in_ms) {
+        /* Not for this track, maybe for the one after */
+        xSemaphoreGive(prefetch.mutex);
+        return false;
+    }
+
+    if (prefetch.state == PREFETCH_RUNNING) {
+        /* Whatever is there by now is better than starting over */
+        prefetch.finish = true;
+        while (prefetch.state == PREFETCH_RUNNING) {
+            vTaskDelay(10 / portTICK_PERIOD_MS);
+        }
+        prefetch.finish = false;
+    }
+    if (prefetch.state == PREFETCH_READY &&
+            (prefetch.eof || (xTaskGetTickCount() - prefetch.ready_at) < HTTP_PLAYBACK_PREFETCH_MAX_IDLE_MS / portTICK_PERIOD_MS)) {
+        hstream->handle = s->handle;
+        s->handle = NULL;
+        hstream->hls_cfg = s->hls_cfg;
+        memset(&s->hls_cfg, 0, sizeof(s->hls_cfg));
+        /* Redirected or variant URL */
+        free(hstream->cfg.url);
+        hstream->cfg.url = s->cfg.url;
+        s->cfg.url = NULL;
+        hstream->prefetch_buf = prefetch.buf;
+        hstream->prefetch_len = prefetch.len;
+        hstream->prefetch_pos = 0;
+        prefetch.buf = NULL;
+        *mime_type = prefetch.mime_type;
+        ESP_LOGI(TAG, "Starting with %d prefetched bytes", hstream->prefetch_len);
+        adopted = true;
+    }
+    /* Used or stale, either way gone */
+    http_playback_prefetch_drop();
+    xSemaphoreGive(prefetch.mutex);
+    return adopted;
+}
+
+esp_err_t http_playback_stream_prefetch(const char *url, int offset_in_ms, size_t budget)
+{
+    if (url == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!prefetch.mutex) {
+        prefetch.mutex = xSemaphoreCreateMutex();
+        prefetch.req_sem = xSemaphoreCreateBinary();
+        if (!prefetch.mutex || !prefetch.req_sem) {
+            ESP_LOGE(TAG, "Failed to create prefetch semaphores");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(prefetch.mutex, portMAX_DELAY);
+    if (!prefetch.task) {
+        /* Same stack as the playback stream, which TLS needs */
+        StackType_t *task_stack = (StackType_t *) esp_audio_mem_calloc(1, HTTP_PLAYBACK_STREAM_TASK_STACK_SIZE);
+        StaticTask_t *task_buf = (StaticTask_t *) heap_caps_calloc(1, sizeof(StaticTask_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (task_stack && task_buf) {
+            prefetch.task = xTaskCreateStatic(http_playback_prefetch_task, "http_prefetch",
+                                              HTTP_PLAYBACK_STREAM_TASK_STACK_SIZE, NULL,
+                                              HTTP_PLAYBACK_STREAM_TASK_PRIORITY - 1, task_stack, task_buf);
+        }
+        if (!prefetch.task) {
+            ESP_LOGE(TAG, "Error creating prefetch task");
+            esp_audio_mem_free(task_stack);
+            free(task_buf);
+            xSemaphoreGive(prefetch.mutex);
+            return ESP_FAIL;
+        }
+    }
+
+    http_playback_prefetch_drop();
+    prefetch.url = strdup(url);
+    if (!prefetch.url) {
+        xSemaphoreGive(prefetch.mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    prefetch.offset_in_ms = offset_in_ms;
+    prefetch.budget = budget ? budget : HTTP_PLAYBACK_PREFETCH_DEFAULT_BUDGET;
+    prefetch.state = PREFETCH_REQUESTED;
+    xSemaphoreGive(prefetch.req_sem);
+    xSemaphoreGive(prefetch.mutex);
+    return ESP_OK;
+}
+
+void http_playback_stream_prefetch_cancel()
+{
+    if (!prefetch.mutex) {
+        return;
+    }
+    xSemaphoreTake(prefetch.mutex, portMAX_DELAY);
+    http_playback_prefetch_drop();
+    xSemaphoreGive(prefetch.mutex);
+}
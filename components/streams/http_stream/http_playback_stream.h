@@ -56,6 +56,10 @@ typedef struct http_playback_stream {
     http_stream_hls_config_t hls_cfg;
     /* Private members */
     httpc_conn_t *handle;
+    /* Data fetched ahead by http_playback_stream_prefetch(), served before the connection */
+    uint8_t *prefetch_buf;
+    size_t prefetch_len;
+    size_t prefetch_pos;
 } http_playback_stream_t;
 
 http_playback_stream_t *http_playback_stream_create_writer(http_playback_stream_config_t *cfg);
@@ -66,9 +70,36 @@ esp_err_t http_playback_stream_set_config(http_playback_stream_t *stream, http_p
 void http_playback_stream_set_stack_size(http_playback_stream_t *stream, ssize_t stack_size);
 esp_err_t http_playback_stream_create_or_renew_session(http_playback_stream_t *hstream);
 
+/**
+ * Fetch the start of the next track ahead of time.
+ *
+ * Resolves redirects and playlists, opens the connection and buffers up to `budget` bytes of
+ * audio for `url` in the background. When a playback stream is next configured for the same
+ * `url` and `offset_in_ms`, it takes over the connection and the buffered data, so that the
+ * decoder gets data as soon as the stream starts instead of after connection setup.
+ *
+ * Meant to be called for the next queued track once the current one has finished downloading
+ * (AP_NOTIFY_PB_DOWNLOAD_FINISHED), by whoever owns the play queue. The audio_player queue
+ * lives in the prebuilt voice assistant library, so nothing in this tree calls it yet. Only one URL is fetched ahead at a time, a new call drops
+ * the previous one. Unused data is dropped after HTTP_PLAYBACK_PREFETCH_MAX_IDLE_MS, unless
+ * the whole track fitted within the budget.
+ *
+ * @param url           URL of the next track
+ * @param offset_in_ms  Offset the track will be played from
+ * @param budget        Memory to use for buffered data, 0 for default
+ */
+esp_err_t http_playback_stream_prefetch(const char *url, int offset_in_ms, size_t budget);
+
+/**
+ * Drop any data fetched ahead.
+ */
+void http_playback_stream_prefetch_cancel();
+
 #define HTTP_PLAYBACK_STREAM_BUFFER_SIZE        (512)
 #define HTTP_PLAYBACK_STREAM_TASK_STACK_SIZE    10240
 #define HTTP_PLAYBACK_STREAM_TASK_PRIORITY      4
+#define HTTP_PLAYBACK_PREFETCH_DEFAULT_BUDGET   (64 * 1024)
+#define HTTP_PLAYBACK_PREFETCH_MAX_IDLE_MS      (30 * 1000)
 
 #ifdef __cplusplus
 }
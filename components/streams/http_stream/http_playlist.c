@@ -156,7 +156,10 @@ int http_playlist_read_data(void *base_stream, void *buf, ssize_t len)
             data_read = http_response_recv(bstream->handle, buf, len);
             continue;
 error2:
-            bstream->base.event_func.func(bstream->base.event_func.arg, STREAM_EVENT_FAILED, 0);
+            /* Streams fetching ahead have nobody to tell */
+            if (bstream->base.event_func.func) {
+                bstream->base.event_func.func(bstream->base.event_func.arg, STREAM_EVENT_FAILED, 0);
+            }
             http_request_delete(bstream->handle);
 error1:
             http_connection_delete(bstream->handle);
@@ -31,6 +31,7 @@
 #include <esp_log.h>
 #include <esp_audio_mem.h>
 #include <i2s_stream.h>
+#include <media_hal_mixer.h>
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -96,6 +97,8 @@ static void i2s_on_event(void *base_stream, audio_stream_event_t event)
 {
     if (event == STREAM_EVENT_PAUSED || event == STREAM_EVENT_STOPPED || event == STREAM_EVENT_DESTROYED) {
         i2s_stream_t *stream = (i2s_stream_t *) base_stream;
+        /* What the mixer holds would otherwise play on after the stop */
+        media_hal_mixer_input_flush(NULL);
         i2s_zero_dma_buffer(stream->cfg.i2s_num);
     }
 }
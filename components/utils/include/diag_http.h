@@ -0,0 +1,64 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _DIAG_HTTP_H_
+#define _DIAG_HTTP_H_
+
+#include <esp_err.h>
+#include <http_server.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Diagnostics http server.
+ *
+ * One small http_server shared by the diagnostics modules (va_trace,
+ * va_latency), each serving its data under its own URI.
+ */
+
+/**
+ * @brief   Start the server on `port`, unless it is already running
+ *
+ * @return  ESP_OK on success, error from http_server otherwise
+ */
+esp_err_t diag_http_start(uint16_t port);
+
+/**
+ * @brief   Serve GET requests for `uri` with `handler`
+ *
+ * Registering the same URI again is not an error.
+ *
+ * @return  ESP_OK on success, ESP_ERR_INVALID_STATE if the server is not
+ *          running, error from http_server otherwise
+ */
+esp_err_t diag_http_register(const char *uri, esp_err_t (*handler)(httpd_req_t *req));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _DIAG_HTTP_H_ */
@@ -0,0 +1,96 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _VA_BOOT_H_
+#define _VA_BOOT_H_
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Boot time profiling and parallel bring-up.
+ *
+ * Each init step records when it ran, on which core and for how long. Steps
+ * run inline are recorded with va_boot_record(). Steps added with
+ * va_boot_add() run in a task of their own, once the steps they depend on
+ * are done, so independent steps (e.g. a DSP firmware load and the Wi-Fi
+ * connection) overlap. The record is printed by va_boot_dump() and the
+ * `boot-time` diag CLI command.
+ */
+
+#define VA_BOOT_MAX_STEPS       24
+#define VA_BOOT_MAX_RECORDS     32
+
+typedef struct {
+    const char *name;
+    void (*fn)(void *arg);
+    void *arg;
+    /** Steps, as returned by va_boot_add(), to wait for before running */
+    uint32_t deps;
+    /** Core to run on, tskNO_AFFINITY for either */
+    int core;
+    /** Stack size of the step's task, 4096 if 0 */
+    uint32_t stack_size;
+} va_boot_step_t;
+
+/**
+ * @brief   Run a step in its own task once its dependencies are done
+ *
+ * The step is copied. It runs at the priority of the caller. If there is no
+ * room for its task, it is run inline after waiting for its dependencies.
+ *
+ * @return  The step, to depend on or wait for, 0 if it was run inline
+ */
+uint32_t va_boot_add(const va_boot_step_t *step);
+
+/**
+ * @brief   Wait for steps to be done
+ *
+ * @param   steps   Steps as returned by va_boot_add(), or-ed together
+ */
+void va_boot_wait(uint32_t steps);
+
+/**
+ * @brief   Record a step that ran inline
+ *
+ * @param   name        Step name, must be a string literal
+ * @param   start_us    esp_timer_get_time() when the step started
+ */
+void va_boot_record(const char *name, int64_t start_us);
+
+/**
+ * @brief   Print the recorded steps
+ */
+void va_boot_dump();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VA_BOOT_H_ */
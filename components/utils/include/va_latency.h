@@ -0,0 +1,123 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef _VA_LATENCY_H_
+#define _VA_LATENCY_H_
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Interaction latency metrics.
+ *
+ * An interaction runs from the wake word to the first response audio
+ * reaching I2S. Each stage below is stamped where it happens, and the time
+ * since the previous stamped stage of the same interaction is added to that
+ * stage's metric. Two more metrics cover the whole interaction and the part
+ * the user waits for, from the end of speech to audio out.
+ *
+ * Every metric keeps its last VA_LATENCY_WINDOW samples, in fixed memory, to
+ * report p50/p95/p99 over. They are printed by the `latency` diag CLI
+ * command, which also serves them as JSON at http://<device>:8080/latency.
+ *
+ * Stamping is cheap and can be done from any task. Only the first stamp of a
+ * stage in an interaction counts, and stages must come in order: a stamp
+ * for an earlier stage than the last one is ignored. Stages from
+ * VA_LATENCY_RESPONSE on also need the end of speech to have been stamped, so
+ * that directives and tones before it aren't taken for the response.
+ */
+
+typedef enum {
+    /** Wake word detected, starts an interaction */
+    VA_LATENCY_WAKE = 0,
+    /** Voice assistant accepted the recognize request, starts an interaction
+     * if there was no wake word, e.g. tap to talk */
+    VA_LATENCY_RECOGNIZE,
+    /** End of speech: the whole request is uploaded */
+    VA_LATENCY_END_OF_SPEECH,
+    /** First response frame from the cloud */
+    VA_LATENCY_RESPONSE,
+    /** First part of a multipart response parsed */
+    VA_LATENCY_MULTIPART,
+    /** Decoder found the format of the response audio */
+    VA_LATENCY_DECODE,
+    /** First response audio written to I2S, ends the interaction */
+    VA_LATENCY_AUDIO_OUT,
+    VA_LATENCY_STAGE_MAX,
+} va_latency_stage_t;
+
+#define VA_LATENCY_WINDOW   64
+
+/** Stages but the first one, the whole interaction and end of speech to audio out */
+#define VA_LATENCY_METRICS  (VA_LATENCY_STAGE_MAX + 1)
+
+typedef struct {
+    const char *name;
+    /** Samples ever taken, the percentiles are over the last VA_LATENCY_WINDOW */
+    uint32_t count;
+    uint32_t p50_ms;
+    uint32_t p95_ms;
+    uint32_t p99_ms;
+    uint32_t max_ms;
+} va_latency_stats_t;
+
+/**
+ * @brief   Stamp a stage of the current interaction
+ */
+void va_latency_mark(va_latency_stage_t stage);
+
+/**
+ * @brief   Drop the current interaction, e.g. when it ends without audio
+ */
+void va_latency_cancel();
+
+/**
+ * @brief   Forget all samples
+ */
+void va_latency_reset();
+
+/**
+ * @brief   Get the statistics of all metrics
+ *
+ * @param[out] stats    Array of VA_LATENCY_METRICS entries
+ */
+void va_latency_get_stats(va_latency_stats_t stats[VA_LATENCY_METRICS]);
+
+/**
+ * @brief   Serve the statistics as JSON at /latency on the diag http server
+ *
+ * @return  ESP_OK on success, error from http_server otherwise
+ */
+esp_err_t va_latency_http_start(uint16_t port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VA_LATENCY_H_ */
@@ -0,0 +1,114 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef _VA_TRACE_H_
+#define _VA_TRACE_H_
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Event tracing.
+ *
+ * Trace points record into a binary ring per core: a cycle counter
+ * timestamp, the current task, a name and an argument. Recording takes one
+ * atomic increment and a 20 byte store, with no locks, so trace points can
+ * sit on the audio path and in ISRs. When the ring is full the oldest events
+ * are overwritten.
+ *
+ * The rings are exported as Chrome trace JSON (chrome://tracing or
+ * ui.perfetto.dev), one process per core and one thread per task: the
+ * `trace` diag CLI command serves them at http://<device>:8080/trace.
+ *
+ * Without CONFIG_VA_TRACE all the macros compile to nothing.
+ *
+ * Names must be string literals, or otherwise outlive the trace.
+ */
+
+typedef enum {
+    VA_TRACE_PH_BEGIN = 'B',
+    VA_TRACE_PH_END = 'E',
+    VA_TRACE_PH_INSTANT = 'i',
+    VA_TRACE_PH_COUNTER = 'C',
+} va_trace_type_t;
+
+#ifdef CONFIG_VA_TRACE
+
+#define VA_TRACE_BEGIN(name, arg)   va_trace_record(VA_TRACE_PH_BEGIN, name, arg)
+#define VA_TRACE_END(name, arg)     va_trace_record(VA_TRACE_PH_END, name, arg)
+#define VA_TRACE_INSTANT(name, arg) va_trace_record(VA_TRACE_PH_INSTANT, name, arg)
+#define VA_TRACE_COUNTER(name, arg) va_trace_record(VA_TRACE_PH_COUNTER, name, arg)
+
+/**
+ * @brief   Record an event, see the VA_TRACE_* macros
+ */
+void va_trace_record(va_trace_type_t type, const char *name, int32_t arg);
+
+/**
+ * @brief   Allocate the rings and start recording
+ *
+ * @return  ESP_OK on success, ESP_ERR_NO_MEM if the rings can't be allocated
+ */
+esp_err_t va_trace_start();
+
+/**
+ * @brief   Stop recording, keeping what was recorded
+ */
+void va_trace_stop();
+
+/**
+ * @brief   Export the rings as Chrome trace JSON
+ *
+ * Recording is paused while exporting. `write` gets the JSON in pieces and
+ * returns non-zero to stop.
+ *
+ * @return  ESP_OK on success, ESP_FAIL if `write` failed
+ */
+esp_err_t va_trace_export(int (*write)(void *ctx, const char *buf, int len), void *ctx);
+
+/**
+ * @brief   Serve the trace at /trace on an http_server on `port`
+ *
+ * @return  ESP_OK on success, error from http_server otherwise
+ */
+esp_err_t va_trace_http_start(uint16_t port);
+
+#else
+
+#define VA_TRACE_BEGIN(name, arg)   do { } while (0)
+#define VA_TRACE_END(name, arg)     do { } while (0)
+#define VA_TRACE_INSTANT(name, arg) do { } while (0)
+#define VA_TRACE_COUNTER(name, arg) do { } while (0)
+
+#endif /* CONFIG_VA_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _VA_TRACE_H_ */
@@ -31,6 +31,9 @@
 #include <freertos/task.h>
 #include <esp_audio_mem.h>
 #include <esp_timer.h>
+#include <va_trace.h>
+#include <va_latency.h>
+#include <va_boot.h>
 
 #include <string.h>
 
@@ -46,6 +49,14 @@ static int up_time_cli_handler(int argc, char *argv[])
     return 0;
 }
 
+static int boot_time_cli_handler(int argc, char *argv[])
+{
+    /* Just to go to the next line */
+    printf("\n");
+    va_boot_dump();
+    return 0;
+}
+
 static int task_dump_cli_handler(int argc, char *argv[])
 {
     int num_of_tasks = uxTaskGetNumberOfTasks();
@@ -177,12 +188,75 @@ static int heap_trace_cli_handler(int argc, char *argv[])
     return 0;
 }
 
+#define DIAG_HTTP_PORT 8080
+
+static int trace_cli_handler(int argc, char *argv[])
+{
+    /* Just to go to the next line */
+    printf("\n");
+#ifndef CONFIG_VA_TRACE
+    printf("%s: To use this utility enable: Component config --> Utils --> Event tracing\n", TAG);
+#else
+    if (argc != 2) {
+        printf("%s: Incorrect arguments\n", TAG);
+        return 0;
+    }
+    if (strcmp(argv[1], "start") == 0) {
+        if (va_trace_start() != ESP_OK) {
+            printf("%s: Failed to start tracing\n", TAG);
+        }
+    } else if (strcmp(argv[1], "stop") == 0) {
+        va_trace_stop();
+    } else if (strcmp(argv[1], "http") == 0) {
+        if (va_trace_http_start(DIAG_HTTP_PORT) == ESP_OK) {
+            printf("%s: Trace at http://<device-ip>:%d/trace\n", TAG, DIAG_HTTP_PORT);
+        } else {
+            printf("%s: Failed to start http server\n", TAG);
+        }
+    } else {
+        printf("%s: Invalid argument:%s:\n", TAG, argv[1]);
+    }
+#endif
+    return 0;
+}
+
+static int latency_cli_handler(int argc, char *argv[])
+{
+    /* Just to go to the next line */
+    printf("\n");
+    if (argc == 1) {
+        va_latency_stats_t stats[VA_LATENCY_METRICS];
+        va_latency_get_stats(stats);
+        printf("%28s\tCount\tp50\tp95\tp99\tMax (ms)\n", "Stage");
+        for (int i = 0; i < VA_LATENCY_METRICS; i++) {
+            printf("%28s\t%u\t%u\t%u\t%u\t%u\n", stats[i].name, stats[i].count,
+                   stats[i].p50_ms, stats[i].p95_ms, stats[i].p99_ms, stats[i].max_ms);
+        }
+    } else if (strcmp(argv[1], "reset") == 0) {
+        va_latency_reset();
+    } else if (strcmp(argv[1], "http") == 0) {
+        if (va_latency_http_start(DIAG_HTTP_PORT) == ESP_OK) {
+            printf("%s: Latency at http://<device-ip>:%d/latency\n", TAG, DIAG_HTTP_PORT);
+        } else {
+            printf("%s: Failed to start http server\n", TAG);
+        }
+    } else {
+        printf("%s: Invalid argument:%s:\n", TAG, argv[1]);
+    }
+    return 0;
+}
+
 static esp_console_cmd_t diag_cmds[] = {
     {
         .command = "up-time",
         .help = "Device up time in milliseconds precision",
         .func = up_time_cli_handler,
     },
+    {
+        .command = "boot-time",
+        .help = "Time taken by each boot step",
+        .func = boot_time_cli_handler,
+    },
     {
         .command = "mem-dump",
         .help = "",
@@ -203,6 +277,16 @@ static esp_console_cmd_t diag_cmds[] = {
         .help = "<start|stop> [trace-buf-size]",
         .func = heap_trace_cli_handler,
     },
+    {
+        .command = "trace",
+        .help = "<start|stop|http>",
+        .func = trace_cli_handler,
+    },
+    {
+        .command = "latency",
+        .help = "[reset|http]",
+        .func = latency_cli_handler,
+    },
 };
 
 int diag_register_cli()
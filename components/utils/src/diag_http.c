@@ -0,0 +1,67 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <esp_log.h>
+#include <http_server.h>
+
+#include "diag_http.h"
+
+static const char *TAG = "[diag_http]";
+
+static httpd_handle_t diag_httpd;
+
+esp_err_t diag_http_start(uint16_t port)
+{
+    if (diag_httpd) {
+        return ESP_OK;
+    }
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = port;
+    /* Next to the provisioning server, if any */
+    config.ctrl_port = 32769;
+    esp_err_t err = httpd_start(&diag_httpd, &config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start http server: %d", err);
+        diag_httpd = NULL;
+    }
+    return err;
+}
+
+esp_err_t diag_http_register(const char *uri, esp_err_t (*handler)(httpd_req_t *req))
+{
+    if (!diag_httpd) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    httpd_uri_t diag_uri = {
+        .uri = uri,
+        .method = HTTP_GET,
+        .handler = handler,
+    };
+    esp_err_t err = httpd_register_uri_handler(diag_httpd, &diag_uri);
+    if (err == ESP_ERR_HTTPD_HANDLER_EXISTS) {
+        return ESP_OK;
+    }
+    return err;
+}
@@ -35,6 +35,7 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include <esp_audio_mem.h>
+#include <va_trace.h>
 
 #define RB_TAG "RINGBUF"
 
@@ -155,7 +156,10 @@ int rb_read(ringbuf_t *rb, uint8_t *buf, int buf_len, uint32_t ticks_to_wait)
 
         xSemaphoreGive(rb->lock);
         if (!rb->writer_finished && !rb->abort_read && !rb->reader_unblock) {
-            if (xSemaphoreTake(rb->can_read, ticks_to_wait) != pdTRUE) {
+            VA_TRACE_BEGIN("rb_read_wait", 0);
+            BaseType_t got = xSemaphoreTake(rb->can_read, ticks_to_wait);
+            VA_TRACE_END("rb_read_wait", 0);
+            if (got != pdTRUE) {
                 goto out;
             }
         }
@@ -163,7 +167,7 @@ int rb_read(ringbuf_t *rb, uint8_t *buf, int buf_len, uint32_t ticks_to_wait)
             total_read_size = RB_ABORT;
             goto out;
         }
-        if (rb->writer_finished == 1) {
+        if (rb->writer_finished == 1 && rb->fill_cnt == 0) {
             goto out;
         }
         if (rb->reader_unblock == 1) {
@@ -234,7 +238,10 @@ int rb_write(ringbuf_t *rb, const uint8_t *buf, int buf_len, uint32_t ticks_to_w
         if (rb->writer_finished) {
             return write_size > 0 ? write_size : RB_WRITER_FINISHED;
         }
-        if (xSemaphoreTake(rb->can_write, ticks_to_wait) != pdTRUE) {
+        VA_TRACE_BEGIN("rb_write_wait", 0);
+        BaseType_t got = xSemaphoreTake(rb->can_write, ticks_to_wait);
+        VA_TRACE_END("rb_write_wait", 0);
+        if (got != pdTRUE) {
             goto out;
         }
         if (rb->abort_write == 1) {
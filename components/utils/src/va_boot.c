@@ -0,0 +1,141 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/event_groups.h>
+
+#include "va_boot.h"
+
+#define STEP_DEFAULT_STACK  4096
+
+static const char *TAG = "[va_boot]";
+
+typedef struct {
+    const char *name;
+    int64_t start_us;
+    int64_t end_us;
+    int core;
+} boot_record_t;
+
+static struct {
+    portMUX_TYPE lock;
+    EventGroupHandle_t done;
+    int num_steps;
+    va_boot_step_t steps[VA_BOOT_MAX_STEPS];
+    int num_records;
+    boot_record_t records[VA_BOOT_MAX_RECORDS];
+} boot = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+void va_boot_record(const char *name, int64_t start_us)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&boot.lock);
+    if (boot.num_records < VA_BOOT_MAX_RECORDS) {
+        boot_record_t *r = &boot.records[boot.num_records++];
+        r->name = name;
+        r->start_us = start_us;
+        r->end_us = now;
+        r->core = xPortGetCoreID();
+    }
+    portEXIT_CRITICAL(&boot.lock);
+}
+
+void va_boot_wait(uint32_t steps)
+{
+    if (steps && boot.done) {
+        xEventGroupWaitBits(boot.done, steps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+}
+
+static void va_boot_run_step(va_boot_step_t *step)
+{
+    va_boot_wait(step->deps);
+    int64_t start = esp_timer_get_time();
+    step->fn(step->arg);
+    va_boot_record(step->name, start);
+}
+
+static void va_boot_step_task(void *arg)
+{
+    int id = (int) arg;
+
+    va_boot_run_step(&boot.steps[id]);
+    xEventGroupSetBits(boot.done, 1 << id);
+    vTaskDelete(NULL);
+}
+
+uint32_t va_boot_add(const va_boot_step_t *step)
+{
+    if (!boot.done) {
+        boot.done = xEventGroupCreate();
+    }
+    if (!boot.done || boot.num_steps >= VA_BOOT_MAX_STEPS) {
+        ESP_LOGW(TAG, "Running %s inline", step->name);
+        va_boot_step_t inline_step = *step;
+        va_boot_run_step(&inline_step);
+        return 0;
+    }
+
+    int id = boot.num_steps++;
+    boot.steps[id] = *step;
+    if (xTaskCreatePinnedToCore(va_boot_step_task, step->name,
+                                step->stack_size ? step->stack_size : STEP_DEFAULT_STACK,
+                                (void *) id, uxTaskPriorityGet(NULL), NULL, step->core) != pdPASS) {
+        ESP_LOGW(TAG, "Failed to create task, running %s inline", step->name);
+        va_boot_run_step(&boot.steps[id]);
+        xEventGroupSetBits(boot.done, 1 << id);
+    }
+    return 1 << id;
+}
+
+void va_boot_dump()
+{
+    boot_record_t records[VA_BOOT_MAX_RECORDS];
+
+    portENTER_CRITICAL(&boot.lock);
+    int n = boot.num_records;
+    memcpy(records, boot.records, n * sizeof(boot_record_t));
+    portEXIT_CRITICAL(&boot.lock);
+
+    int64_t end = 0;
+    printf("%16s\tCore\tStart\tEnd\tDuration (ms)\n", "Step");
+    for (int i = 0; i < n; i++) {
+        boot_record_t *r = &records[i];
+        printf("%16s\t%d\t%lld\t%lld\t%lld\n", r->name, r->core,
+               r->start_us / 1000, r->end_us / 1000, (r->end_us - r->start_us) / 1000);
+        if (r->end_us > end) {
+            end = r->end_us;
+        }
+    }
+    printf("%16s\t\t\t%lld\n", "Done", end / 1000);
+}
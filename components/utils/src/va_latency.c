@@ -0,0 +1,215 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <http_server.h>
+#include <diag_http.h>
+#include <rope.h>
+
+#include "va_latency.h"
+
+/* Interactions that don't get to audio out by then are dropped */
+#define INTERACTION_TIMEOUT_US  (30 * 1000 * 1000LL)
+
+#define METRIC_TOTAL    (VA_LATENCY_STAGE_MAX - 1)
+#define METRIC_WAIT     (VA_LATENCY_STAGE_MAX)
+
+static const char *metric_names[VA_LATENCY_METRICS] = {
+    "recognize",
+    "end_of_speech",
+    "response",
+    "multipart",
+    "decode",
+    "audio_out",
+    "total",
+    "end_of_speech_to_audio_out",
+};
+
+typedef struct {
+    uint32_t count;
+    uint16_t ms[VA_LATENCY_WINDOW];
+} metric_t;
+
+static struct {
+    portMUX_TYPE lock;
+    volatile bool open;
+    int last;
+    int64_t start_us;
+    int64_t last_us;
+    int64_t eos_us;
+    metric_t metrics[VA_LATENCY_METRICS];
+} lat = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+static void metric_add(metric_t *m, int64_t us)
+{
+    int64_t ms = us / 1000;
+    m->ms[m->count % VA_LATENCY_WINDOW] = ms > UINT16_MAX ? UINT16_MAX : ms;
+    m->count++;
+}
+
+void va_latency_mark(va_latency_stage_t stage)
+{
+    if (stage >= VA_LATENCY_STAGE_MAX) {
+        return;
+    }
+    /* Most stamps are outside of interactions, don't take the lock for them */
+    if (stage > VA_LATENCY_RECOGNIZE && !lat.open) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&lat.lock);
+    if (lat.open && now - lat.start_us > INTERACTION_TIMEOUT_US) {
+        lat.open = false;
+    }
+    if (stage == VA_LATENCY_WAKE || (stage == VA_LATENCY_RECOGNIZE && !lat.open)) {
+        lat.open = true;
+        lat.last = stage;
+        lat.start_us = lat.last_us = now;
+    } else if (lat.open && stage > lat.last &&
+               (stage <= VA_LATENCY_END_OF_SPEECH || lat.last >= VA_LATENCY_END_OF_SPEECH)) {
+        metric_add(&lat.metrics[stage - 1], now - lat.last_us);
+        lat.last = stage;
+        lat.last_us = now;
+        if (stage == VA_LATENCY_END_OF_SPEECH) {
+            lat.eos_us = now;
+        } else if (stage == VA_LATENCY_AUDIO_OUT) {
+            metric_add(&lat.metrics[METRIC_TOTAL], now - lat.start_us);
+            metric_add(&lat.metrics[METRIC_WAIT], now - lat.eos_us);
+            lat.open = false;
+        }
+    }
+    portEXIT_CRITICAL(&lat.lock);
+}
+
+void va_latency_cancel()
+{
+    portENTER_CRITICAL(&lat.lock);
+    lat.open = false;
+    portEXIT_CRITICAL(&lat.lock);
+}
+
+void va_latency_reset()
+{
+    portENTER_CRITICAL(&lat.lock);
+    lat.open = false;
+    memset(lat.metrics, 0, sizeof(lat.metrics));
+    portEXIT_CRITICAL(&lat.lock);
+}
+
+/* Nearest rank on sorted samples */
+static uint32_t percentile(const uint16_t *sorted, int n, int p)
+{
+    int rank = (p * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void va_latency_get_stats(va_latency_stats_t stats[VA_LATENCY_METRICS])
+{
+    uint16_t ms[VA_LATENCY_WINDOW];
+
+    for (int i = 0; i < VA_LATENCY_METRICS; i++) {
+        portENTER_CRITICAL(&lat.lock);
+        uint32_t count = lat.metrics[i].count;
+        memcpy(ms, lat.metrics[i].ms, sizeof(ms));
+        portEXIT_CRITICAL(&lat.lock);
+
+        memset(&stats[i], 0, sizeof(stats[i]));
+        stats[i].name = metric_names[i];
+        stats[i].count = count;
+        int n = count < VA_LATENCY_WINDOW ? count : VA_LATENCY_WINDOW;
+        if (n == 0) {
+            continue;
+        }
+        /* Insertion sort, the window is small */
+        for (int j = 1; j < n; j++) {
+            uint16_t v = ms[j];
+            int k = j;
+            for (; k > 0 && ms[k - 1] > v; k--) {
+                ms[k] = ms[k - 1];
+            }
+            ms[k] = v;
+        }
+        stats[i].p50_ms = percentile(ms, n, 50);
+        stats[i].p95_ms = percentile(ms, n, 95);
+        stats[i].p99_ms = percentile(ms, n, 99);
+        stats[i].max_ms = ms[n - 1];
+    }
+}
+
+static esp_err_t latency_http_handler(httpd_req_t *req)
+{
+    va_latency_stats_t stats[VA_LATENCY_METRICS];
+    esp_err_t ret = ESP_FAIL;
+
+    /* Built up front and sent a segment per chunk, rather than a chunk
+     * per metric */
+    rope_t *rope = rope_new(0);
+    if (!rope) {
+        return httpd_resp_send_500(req);
+    }
+    va_latency_get_stats(stats);
+    bool failed = rope_appendf(rope, "{\"unit\":\"ms\",\"window\":%d,\"metrics\":[", VA_LATENCY_WINDOW) < 0;
+    for (int i = 0; i < VA_LATENCY_METRICS; i++) {
+        failed |= rope_appendf(rope, "%s{\"name\":\"%s\",\"count\":%u,\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%u}",
+                               i ? "," : "", stats[i].name, stats[i].count,
+                               stats[i].p50_ms, stats[i].p95_ms, stats[i].p99_ms, stats[i].max_ms) < 0;
+    }
+    failed |= rope_append(rope, "]}\n", 3) < 0;
+    if (failed) {
+        httpd_resp_send_500(req);
+        goto out;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    rope_cursor_t cur;
+    const char *data;
+    size_t len;
+    rope_cursor_init(rope, &cur);
+    while ((len = rope_cursor_peek(&cur, &data)) > 0) {
+        if (httpd_resp_send_chunk(req, data, len) != ESP_OK) {
+            goto out;
+        }
+        rope_cursor_advance(&cur, len);
+    }
+    ret = httpd_resp_send_chunk(req, NULL, 0);
+out:
+    rope_delete(rope);
+    return ret;
+}
+
+esp_err_t va_latency_http_start(uint16_t port)
+{
+    esp_err_t err = diag_http_start(port);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return diag_http_register("/latency", latency_http_handler);
+}
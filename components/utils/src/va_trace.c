@@ -0,0 +1,241 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2018 <ESPRESSIF SYSTEMS (SHANGHAI) PTE LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include <esp_attr.h>
+#include <rom/ets_sys.h>
+#include <xtensa/hal.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_audio_mem.h>
+#include <http_server.h>
+#include <diag_http.h>
+
+#include "va_trace.h"
+
+#ifdef CONFIG_VA_TRACE
+
+#define TRACE_EVENTS CONFIG_VA_TRACE_EVENTS_PER_CORE
+#define TRACE_OUT_BUF_SIZE 512
+
+static const char *TAG = "[va_trace]";
+
+typedef struct {
+    uint32_t cycles;
+    const char *name;
+    void *task;
+    int32_t arg;
+    uint8_t type;
+} va_trace_event_t;
+
+typedef struct {
+    /* Events ever recorded, the ring holds the last TRACE_EVENTS */
+    uint32_t head;
+    va_trace_event_t *events;
+} va_trace_ring_t;
+
+static va_trace_ring_t trace_rings[portNUM_PROCESSORS];
+static volatile bool trace_on;
+
+IRAM_ATTR void va_trace_record(va_trace_type_t type, const char *name, int32_t arg)
+{
+    if (!trace_on) {
+        return;
+    }
+    uint32_t cycles = xthal_get_ccount();
+    /* Cycle counters are per core, so are the rings. A task moving to the
+     * other core right here only puts its event slightly out of order. */
+    va_trace_ring_t *ring = &trace_rings[xPortGetCoreID()];
+    uint32_t i = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED) % TRACE_EVENTS;
+    va_trace_event_t *e = &ring->events[i];
+    e->cycles = cycles;
+    e->name = name;
+    e->task = xTaskGetCurrentTaskHandle();
+    e->arg = arg;
+    e->type = type;
+}
+
+esp_err_t va_trace_start()
+{
+    for (int i = 0; i < portNUM_PROCESSORS; i++) {
+        if (!trace_rings[i].events) {
+            trace_rings[i].events = esp_audio_mem_calloc(TRACE_EVENTS, sizeof(va_trace_event_t));
+            if (!trace_rings[i].events) {
+                ESP_LOGE(TAG, "Failed to allocate trace ring");
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        trace_rings[i].head = 0;
+    }
+    trace_on = true;
+    return ESP_OK;
+}
+
+void va_trace_stop()
+{
+    trace_on = false;
+}
+
+typedef struct {
+    int (*write)(void *ctx, const char *buf, int len);
+    void *ctx;
+    int len;
+    bool failed;
+    char buf[TRACE_OUT_BUF_SIZE];
+} trace_out_t;
+
+static void trace_out_flush(trace_out_t *o)
+{
+    if (o->len && !o->failed) {
+        o->failed = o->write(o->ctx, o->buf, o->len) != 0;
+    }
+    o->len = 0;
+}
+
+static void trace_out_printf(trace_out_t *o, const char *fmt, ...)
+{
+    va_list ap;
+    for (int retry = 0; retry < 2; retry++) {
+        va_start(ap, fmt);
+        int n = vsnprintf(o->buf + o->len, sizeof(o->buf) - o->len, fmt, ap);
+        va_end(ap);
+        if (n < sizeof(o->buf) - o->len) {
+            o->len += n;
+            return;
+        }
+        /* Didn't fit, flush and try again on an empty buffer */
+        trace_out_flush(o);
+    }
+}
+
+static void trace_export_tasks(trace_out_t *o)
+{
+    int num_of_tasks = uxTaskGetNumberOfTasks();
+    TaskStatus_t *task_array = esp_audio_mem_calloc(num_of_tasks, sizeof(TaskStatus_t));
+    if (!task_array) {
+        return;
+    }
+    /* Only tasks still alive get their names, others show as their handle */
+    num_of_tasks = uxTaskGetSystemState(task_array, num_of_tasks, NULL);
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        trace_out_printf(o, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"Core %d\"}},\n",
+                         core, core);
+        for (int i = 0; i < num_of_tasks; i++) {
+            trace_out_printf(o, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+                             core, (uint32_t) task_array[i].xHandle, task_array[i].pcTaskName);
+        }
+    }
+    esp_audio_mem_free(task_array);
+}
+
+static void trace_export_ring(trace_out_t *o, int core, uint32_t mhz)
+{
+    va_trace_ring_t *ring = &trace_rings[core];
+    uint32_t head = ring->head;
+    uint32_t count = head < TRACE_EVENTS ? head : TRACE_EVENTS;
+    uint64_t wraps = 0;
+    uint32_t prev = 0;
+
+    for (uint32_t n = head - count; n != head; n++) {
+        va_trace_event_t *e = &ring->events[n % TRACE_EVENTS];
+        /* The counter wraps every 2^32 cycles. Tell that from events being
+         * slightly out of order by how far back it went. */
+        if (n != head - count && e->cycles < prev && prev - e->cycles > 0x80000000) {
+            wraps += 1ULL << 32;
+        }
+        prev = e->cycles;
+        uint64_t cycles = wraps + e->cycles;
+
+        trace_out_printf(o, "{\"ph\":\"%c\",\"name\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%llu.%03u",
+                         e->type, e->name, core, (uint32_t) e->task,
+                         cycles / mhz, (uint32_t) (cycles % mhz) * 1000 / mhz);
+        if (e->type == VA_TRACE_PH_COUNTER) {
+            trace_out_printf(o, ",\"args\":{\"value\":%d}},\n", e->arg);
+        } else if (e->type == VA_TRACE_PH_INSTANT) {
+            trace_out_printf(o, ",\"s\":\"t\",\"args\":{\"arg\":%d}},\n", e->arg);
+        } else {
+            trace_out_printf(o, ",\"args\":{\"arg\":%d}},\n", e->arg);
+        }
+    }
+}
+
+esp_err_t va_trace_export(int (*write)(void *ctx, const char *buf, int len), void *ctx)
+{
+    trace_out_t *o = esp_audio_mem_calloc(1, sizeof(trace_out_t));
+    if (!o) {
+        return ESP_ERR_NO_MEM;
+    }
+    o->write = write;
+    o->ctx = ctx;
+
+    bool was_on = trace_on;
+    trace_on = false;
+    /* Let events being recorded right now land */
+    vTaskDelay(1);
+
+    uint32_t mhz = ets_get_cpu_frequency();
+    trace_out_printf(o, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    trace_export_tasks(o);
+    for (int core = 0; core < portNUM_PROCESSORS && trace_rings[core].events; core++) {
+        trace_export_ring(o, core, mhz);
+    }
+    /* Something to put after the last comma */
+    trace_out_printf(o, "{\"ph\":\"i\",\"name\":\"export\",\"pid\":0,\"tid\":0,\"ts\":0,\"s\":\"g\"}\n]}\n");
+    trace_out_flush(o);
+
+    trace_on = was_on;
+    esp_err_t ret = o->failed ? ESP_FAIL : ESP_OK;
+    esp_audio_mem_free(o);
+    return ret;
+}
+
+static int trace_http_write(void *ctx, const char *buf, int len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *) ctx, buf, len) != ESP_OK;
+}
+
+static esp_err_t trace_http_handler(httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"trace.json\"");
+    if (va_trace_export(trace_http_write, req) != ESP_OK) {
+        ESP_LOGW(TAG, "Trace export failed");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+esp_err_t va_trace_http_start(uint16_t port)
+{
+    esp_err_t err = diag_http_start(port);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return diag_http_register("/trace", trace_http_handler);
+}
+
+#endif /* CONFIG_VA_TRACE */
@@ -28,13 +28,23 @@ extern "C" {
  * variant 1.
  * @see https://tools.ietf.org/html/rfc4122.
  *
- * @return A uuid as a string.
+ * @return A uuid as a string, allocated with malloc. The caller frees it.
  */
 const char *generateUUID();
 
 /* ASCII UUID length including one for the terminating null character */
 #define UUID_MAX_LEN 37
 
+/**
+ * Same as @c generateUUID, into a caller provided buffer.
+ *
+ * The random bits come straight from the hardware RNG, and nothing is allocated or locked, so this can be called
+ * from any task.
+ *
+ * @param buf Buffer of at least @c UUID_MAX_LEN bytes, gets the null terminated uuid.
+ */
+void generate_uuid(char *buf);
+
 #ifdef __cplusplus
 }
 #endif
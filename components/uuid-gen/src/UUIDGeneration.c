@@ -0,0 +1,65 @@
+/*
+ * UUIDGeneration.c
+ *
+ * Copyright 2017 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *     http://aws.amazon.com/apache2.0/
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <esp_system.h>
+
+#include "UUIDGeneration.h"
+
+/// The UUID version (Version 4), in the high nibble of byte 6.
+#define UUID_VERSION_VALUE  0x40
+
+/// The UUID variant (Variant 1), in the two high bits of byte 8.
+#define UUID_VARIANT_VALUE  0x80
+
+static const char hex_digits[16] = "0123456789abcdef";
+
+/// Where each of the 16 bytes goes in xxxxxxxx-xxxx-Mxxx-Nxxx-xxxxxxxxxxxx
+static const uint8_t byte_offsets[16] = {
+    0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34
+};
+
+void generate_uuid(char *buf)
+{
+    uint32_t words[4];
+    uint8_t *bytes = (uint8_t *) words;
+
+    for (int i = 0; i < 4; i++) {
+        words[i] = esp_random();
+    }
+    bytes[6] = (bytes[6] & 0x0f) | UUID_VERSION_VALUE;
+    bytes[8] = (bytes[8] & 0x3f) | UUID_VARIANT_VALUE;
+
+    for (int i = 0; i < 16; i++) {
+        char *p = buf + byte_offsets[i];
+        p[0] = hex_digits[bytes[i] >> 4];
+        p[1] = hex_digits[bytes[i] & 0x0f];
+    }
+    buf[8] = buf[13] = buf[18] = buf[23] = '-';
+    buf[36] = '\0';
+}
+
+const char *generateUUID()
+{
+    /* Callers free what they get */
+    char *uuid = malloc(UUID_MAX_LEN);
+    if (uuid) {
+        generate_uuid(uuid);
+    }
+    return uuid;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+/* Provided by main.c */
+uint32_t esp_random(void);
@@ -0,0 +1,226 @@
+// Copyright 2018 Espressif Systems (Shanghai) PTE LTD
+// All rights reserved.
+
+/* Host tests and benchmark of the uuid generator (UUIDGeneration.c).
+ *
+ *   ./test_uuid      run the tests, the exit status tells whether they passed
+ *   ./test_uuid -b   benchmark as well
+ *
+ * esp_random() is stood in for by xorshift128, so the uniqueness test checks
+ * that formatting keeps every random bit, not the quality of the hardware RNG.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <UUIDGeneration.h>
+
+#define TEST_COUNT      (2 * 1000 * 1000)
+#define BENCH_SECONDS   3
+
+static int failures;
+
+#define CHECK(cond, ...) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+            failures++; \
+        } \
+    } while (0)
+
+static uint32_t rng_state[4];
+
+uint32_t esp_random(void)
+{
+    uint32_t t = rng_state[3];
+    uint32_t s = rng_state[0];
+    rng_state[3] = rng_state[2];
+    rng_state[2] = rng_state[1];
+    rng_state[1] = s;
+    t ^= t << 11;
+    t ^= t >> 8;
+    rng_state[0] = t ^ s ^ (s >> 19);
+    return rng_state[0];
+}
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct {
+    uint64_t hi, lo;
+} uuid_bits_t;
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/* Check the format and get the 128 bits back, returns 0 if well formed */
+static int parse_uuid(const char *uuid, uuid_bits_t *bits)
+{
+    int n = 0;
+    bits->hi = bits->lo = 0;
+    for (int i = 0; i < 36; i++) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            if (uuid[i] != '-') {
+                return -1;
+            }
+            continue;
+        }
+        int v = hex_value(uuid[i]);
+        if (v < 0) {
+            return -1;
+        }
+        if (n++ < 16) {
+            bits->hi = bits->hi << 4 | v;
+        } else {
+            bits->lo = bits->lo << 4 | v;
+        }
+    }
+    if (uuid[36] != '\0' || uuid[14] != '4' || hex_value(uuid[19]) >> 2 != 2) {
+        return -1;
+    }
+    return 0;
+}
+
+static int compare_bits(const void *a, const void *b)
+{
+    const uuid_bits_t *x = a, *y = b;
+    if (x->hi != y->hi) {
+        return x->hi < y->hi ? -1 : 1;
+    }
+    if (x->lo != y->lo) {
+        return x->lo < y->lo ? -1 : 1;
+    }
+    return 0;
+}
+
+static void test_format()
+{
+    char buf[UUID_MAX_LEN + 1];
+    uuid_bits_t bits;
+
+    /* Exactly UUID_MAX_LEN bytes are written */
+    memset(buf, 'x', sizeof(buf));
+    generate_uuid(buf);
+    CHECK(parse_uuid(buf, &bits) == 0, "malformed uuid %s", buf);
+    CHECK(buf[UUID_MAX_LEN] == 'x', "wrote past UUID_MAX_LEN");
+
+    const char *uuid = generateUUID();
+    CHECK(uuid && parse_uuid(uuid, &bits) == 0, "malformed uuid %s", uuid ? uuid : "(null)");
+    free((void *) uuid);
+}
+
+static void test_unique()
+{
+    uuid_bits_t *all = malloc(TEST_COUNT * sizeof(uuid_bits_t));
+    char buf[UUID_MAX_LEN];
+    uuid_bits_t ones = { 0, 0 }, zeros = { 0, 0 };
+    int malformed = 0;
+
+    if (!all) {
+        CHECK(0, "out of memory");
+        return;
+    }
+    double start = now();
+    for (int i = 0; i < TEST_COUNT; i++) {
+        generate_uuid(buf);
+        if (parse_uuid(buf, &all[i]) != 0) {
+            if (malformed++ == 0) {
+                printf("first malformed uuid: %s\n", buf);
+            }
+        }
+        ones.hi |= all[i].hi;
+        ones.lo |= all[i].lo;
+        zeros.hi |= ~all[i].hi;
+        zeros.lo |= ~all[i].lo;
+    }
+    double elapsed = now() - start;
+    CHECK(malformed == 0, "%d of %d uuids malformed", malformed, TEST_COUNT);
+
+    /* All but the 6 version and variant bits take both values */
+    uint64_t fixed_hi = 0xf000, fixed_lo = 0xc000000000000000ULL;
+    CHECK((ones.hi & zeros.hi) == ~fixed_hi && (ones.lo & zeros.lo) == ~fixed_lo,
+          "stuck bits %016llx %016llx", (unsigned long long) ~(ones.hi & zeros.hi),
+          (unsigned long long) ~(ones.lo & zeros.lo));
+
+    qsort(all, TEST_COUNT, sizeof(uuid_bits_t), compare_bits);
+    int duplicates = 0;
+    for (int i = 1; i < TEST_COUNT; i++) {
+        duplicates += compare_bits(&all[i - 1], &all[i]) == 0;
+    }
+    CHECK(duplicates == 0, "%d duplicates in %d uuids", duplicates, TEST_COUNT);
+    free(all);
+
+    printf("%d uuids generated and checked in %.2fs\n", TEST_COUNT, elapsed);
+}
+
+static void bench()
+{
+    char buf[UUID_MAX_LEN];
+    long count = 0;
+    double start = now(), elapsed;
+    do {
+        for (int i = 0; i < 100000; i++) {
+            generate_uuid(buf);
+        }
+        count += 100000;
+        elapsed = now() - start;
+    } while (elapsed < BENCH_SECONDS);
+    /* Keep the last one from being optimized out */
+    printf("generate_uuid: %.1fM uuids/s (%s)\n", count / elapsed / 1e6, buf);
+
+    count = 0;
+    start = now();
+    do {
+        for (int i = 0; i < 100000; i++) {
+            free((void *) generateUUID());
+        }
+        count += 100000;
+        elapsed = now() - start;
+    } while (elapsed < BENCH_SECONDS);
+    printf("generateUUID:  %.1fM uuids/s\n", count / elapsed / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    int do_bench = 0;
+    while ((opt = getopt(argc, argv, "b")) != -1) {
+        if (opt == 'b') {
+            do_bench = 1;
+        } else {
+            fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    rng_state[0] = time(NULL);
+    rng_state[1] = getpid();
+    rng_state[2] = 0x9e3779b9;
+    rng_state[3] = 0x7f4a7c15;
+
+    test_format();
+    test_unique();
+    if (do_bench) {
+        bench();
+    }
+
+    printf(failures ? "%d checks FAILED\n" : "All checks passed\n", failures);
+    return failures ? 1 : 0;
+}
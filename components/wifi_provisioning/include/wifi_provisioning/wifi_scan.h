@@ -148,6 +148,13 @@ typedef struct wifi_prov_scan_handlers {
      * Context pointer to be passed to above handler functions upon invocation
      */
     wifi_prov_scan_ctx_t *ctx;
+
+    /**
+     * Optional handler returning a number that changes whenever the
+     * results list changes. When set, packed scan result responses are
+     * cached and served again for as long as the number stays the same.
+     */
+    uint32_t (*scan_generation)(wifi_prov_scan_ctx_t **ctx);
 } wifi_prov_scan_handlers_t;
 
 /**
@@ -159,6 +166,15 @@ typedef struct wifi_prov_scan_handlers {
 esp_err_t wifi_prov_scan_handler(uint32_t session_id, const uint8_t *inbuf, ssize_t inlen,
                                  uint8_t **outbuf, ssize_t *outlen, void *priv_data);
 
+/**
+ * @brief   Free the cached scan result responses
+ *
+ * To be called once the `prov-scan` endpoint is no longer served, e.g.
+ * after provisioning has stopped. The cache is rebuilt on demand if the
+ * handler is called again.
+ */
+void wifi_prov_scan_cache_free(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,6 +17,8 @@
 #include <esp_err.h>
 #include <esp_log.h>
 
+#include <protocomm_arena.h>
+
 #include "wifi_constants.pb-c.h"
 #include "wifi_config.pb-c.h"
 
@@ -54,6 +56,17 @@ static wifi_prov_config_cmd_t cmd_table[] = {
     }
 };
 
+static char *wifi_prov_config_strndup(const char *str, size_t n)
+{
+    size_t len = strnlen(str, n);
+    char *dup = (char *) protocomm_req_alloc(len + 1);
+    if (dup) {
+        memcpy(dup, str, len);
+        dup[len] = '\0';
+    }
+    return dup;
+}
+
 static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
                                         WiFiConfigPayload *resp, void *priv_data)
 {
@@ -64,7 +77,7 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespGetStatus *resp_payload = (RespGetStatus *) malloc(sizeof(RespGetStatus));
+    RespGetStatus *resp_payload = (RespGetStatus *) protocomm_req_alloc(sizeof(RespGetStatus));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -80,7 +93,7 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
             resp_payload->sta_state  = WIFI_STATION_STATE__Connected;
             resp_payload->state_case = RESP_GET_STATUS__STATE_CONNECTED;
             WifiConnectedState *connected = (WifiConnectedState *)(
-                                            malloc(sizeof(WifiConnectedState)));
+                                            protocomm_req_alloc(sizeof(WifiConnectedState)));
             if (!connected) {
                 ESP_LOGE(TAG, "Error allocating memory");
                 return ESP_ERR_NO_MEM;
@@ -88,27 +101,32 @@ static esp_err_t cmd_get_status_handler(WiFiConfigPayload *req,
             resp_payload->connected  = connected;
             wifi_connected_state__init(connected);
 
-            connected->ip4_addr = strdup(resp_data.conn_info.ip_addr);
+            connected->ip4_addr = wifi_prov_config_strndup(resp_data.conn_info.ip_addr,
+                                                           sizeof(resp_data.conn_info.ip_addr));
             if (connected->ip4_addr == NULL) {
-                free(resp_payload);
+                protocomm_req_free(connected);
+                protocomm_req_free(resp_payload);
                 return ESP_ERR_NO_MEM;
             }
 
             connected->bssid.len  = sizeof(resp_data.conn_info.bssid);
-            connected->bssid.data = (uint8_t *) strndup(resp_data.conn_info.bssid,
-                                                        sizeof(resp_data.conn_info.bssid));
+            connected->bssid.data = protocomm_req_alloc(connected->bssid.len);
             if (connected->bssid.data == NULL) {
-                free(connected->ip4_addr);
-                free(resp_payload);
+                protocomm_req_free(connected->ip4_addr);
+                protocomm_req_free(connected);
+                protocomm_req_free(resp_payload);
                 return ESP_ERR_NO_MEM;
             }
+            memcpy(connected->bssid.data, resp_data.conn_info.bssid, connected->bssid.len);
 
-            connected->ssid.len   = strlen(resp_data.conn_info.ssid);
-            connected->ssid.data  = (uint8_t *) strdup(resp_data.conn_info.ssid);
+            connected->ssid.len   = strnlen(resp_data.conn_info.ssid, sizeof(resp_data.conn_info.ssid));
+            connected->ssid.data  = (uint8_t *) wifi_prov_config_strndup(resp_data.conn_info.ssid,
+                                                                         sizeof(resp_data.conn_info.ssid));
             if (connected->ssid.data == NULL) {
-                free(connected->bssid.data);
-                free(connected->ip4_addr);
-                free(resp_payload);
+                protocomm_req_free(connected->bssid.data);
+                protocomm_req_free(connected->ip4_addr);
+                protocomm_req_free(connected);
+                protocomm_req_free(resp_payload);
                 return ESP_ERR_NO_MEM;
             }
 
@@ -142,7 +160,7 @@ static esp_err_t cmd_set_config_handler(WiFiConfigPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespSetConfig *resp_payload = (RespSetConfig *) malloc(sizeof(RespSetConfig));
+    RespSetConfig *resp_payload = (RespSetConfig *) protocomm_req_alloc(sizeof(RespSetConfig));
     if (resp_payload == NULL) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -177,7 +195,7 @@ static esp_err_t cmd_apply_config_handler(WiFiConfigPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespApplyConfig *resp_payload = (RespApplyConfig *) malloc(sizeof(RespApplyConfig));
+    RespApplyConfig *resp_payload = (RespApplyConfig *) protocomm_req_alloc(sizeof(RespApplyConfig));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -223,15 +241,15 @@ static void wifi_prov_config_command_cleanup(WiFiConfigPayload *resp, void *priv
                     case WIFI_STATION_STATE__Connected:
                         if (resp->resp_get_status->connected) {
                             if (resp->resp_get_status->connected->ip4_addr) {
-                                free(resp->resp_get_status->connected->ip4_addr);
+                                protocomm_req_free(resp->resp_get_status->connected->ip4_addr);
                             }
                             if (resp->resp_get_status->connected->bssid.data) {
-                                free(resp->resp_get_status->connected->bssid.data);
+                                protocomm_req_free(resp->resp_get_status->connected->bssid.data);
                             }
                             if (resp->resp_get_status->connected->ssid.data) {
-                                free(resp->resp_get_status->connected->ssid.data);
+                                protocomm_req_free(resp->resp_get_status->connected->ssid.data);
                             }
-                            free(resp->resp_get_status->connected);
+                            protocomm_req_free(resp->resp_get_status->connected);
                         }
                         break;
                     case WIFI_STATION_STATE__ConnectionFailed:
@@ -239,17 +257,17 @@ static void wifi_prov_config_command_cleanup(WiFiConfigPayload *resp, void *priv
                     default:
                         break;
                 }
-                free(resp->resp_get_status);
+                protocomm_req_free(resp->resp_get_status);
             }
             break;
         case WI_FI_CONFIG_MSG_TYPE__TypeRespSetConfig:
             {
-                free(resp->resp_set_config);
+                protocomm_req_free(resp->resp_set_config);
             }
             break;
         case WI_FI_CONFIG_MSG_TYPE__TypeRespApplyConfig:
             {
-                free(resp->resp_apply_config);
+                protocomm_req_free(resp->resp_apply_config);
             }
             break;
         default:
@@ -288,7 +306,7 @@ esp_err_t wifi_prov_config_data_handler(uint32_t session_id, const uint8_t *inbu
     WiFiConfigPayload resp;
     esp_err_t ret;
 
-    req = wi_fi_config_payload__unpack(NULL, inlen, inbuf);
+    req = wi_fi_config_payload__unpack(protocomm_req_allocator(), inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack config data");
         return ESP_ERR_INVALID_ARG;
@@ -302,7 +320,7 @@ esp_err_t wifi_prov_config_data_handler(uint32_t session_id, const uint8_t *inbu
     }
 
     resp.msg = req->msg + 1; /* Response is request + 1 */
-    wi_fi_config_payload__free_unpacked(req, NULL);
+    wi_fi_config_payload__free_unpacked(req, protocomm_req_allocator());
 
     *outlen = wi_fi_config_payload__get_packed_size(&resp);
     if (*outlen <= 0) {
@@ -310,7 +328,7 @@ esp_err_t wifi_prov_config_data_handler(uint32_t session_id, const uint8_t *inbu
         return ESP_FAIL;
     }
 
-    *outbuf = (uint8_t *) malloc(*outlen);
+    *outbuf = (uint8_t *) protocomm_req_alloc(*outlen);
     if (!*outbuf) {
         ESP_LOGE(TAG, "System out of memory");
         return ESP_ERR_NO_MEM;
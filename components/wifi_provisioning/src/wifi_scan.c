@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <esp_log.h>
 #include <string.h>
 #include <esp_err.h>
 #include <esp_wifi.h>
 
+#include <protocomm_arena.h>
+
 #include "wifi_scan.pb-c.h"
 
 #include <wifi_provisioning/wifi_scan.h>
@@ -42,6 +45,76 @@ static esp_err_t cmd_scan_result_handler(WiFiScanPayload *req,
                                          WiFiScanPayload *resp,
                                          void *priv_data);
 
+/* Packed scan result responses, as clients tend to page through the same
+ * results repeatedly while the user is picking a network. Entries are only
+ * valid for the results generation they were built from. Protocomm handles
+ * one request at a time, so no locking is needed. */
+#define SCAN_PAGE_CACHE_SLOTS 4
+
+static struct scan_page_cache {
+    const wifi_prov_scan_handlers_t *h;
+    uint32_t gen;
+    uint32_t start_index;
+    uint32_t count;
+    ssize_t len;
+    uint8_t *data;
+} page_cache[SCAN_PAGE_CACHE_SLOTS];
+static uint8_t page_cache_next;
+
+static void scan_page_cache_flush(void)
+{
+    for (int i = 0; i < SCAN_PAGE_CACHE_SLOTS; i++) {
+        free(page_cache[i].data);
+        page_cache[i].data = NULL;
+    }
+}
+
+static struct scan_page_cache *scan_page_cache_find(const wifi_prov_scan_handlers_t *h,
+                                                    uint32_t gen, const CmdScanResult *cmd)
+{
+    for (int i = 0; i < SCAN_PAGE_CACHE_SLOTS; i++) {
+        struct scan_page_cache *c = &page_cache[i];
+        if (!c->data) {
+            continue;
+        }
+        if (c->h != h || c->gen != gen) {
+            /* Results have changed since */
+            scan_page_cache_flush();
+            return NULL;
+        }
+        if (c->start_index == cmd->start_index && c->count == cmd->count) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+static void scan_page_cache_store(const wifi_prov_scan_handlers_t *h, uint32_t gen,
+                                  const CmdScanResult *cmd, const uint8_t *buf, ssize_t len)
+{
+    struct scan_page_cache *c = &page_cache[page_cache_next];
+    uint8_t *data = malloc(len);
+    if (!data) {
+        /* Not caching is fine */
+        return;
+    }
+    memcpy(data, buf, len);
+    free(c->data);
+    c->h = h;
+    c->gen = gen;
+    c->start_index = cmd->start_index;
+    c->count = cmd->count;
+    c->len = len;
+    c->data = data;
+    page_cache_next = (page_cache_next + 1) % SCAN_PAGE_CACHE_SLOTS;
+}
+
+void wifi_prov_scan_cache_free(void)
+{
+    scan_page_cache_flush();
+    page_cache_next = 0;
+}
+
 static wifi_prov_scan_cmd_t cmd_table[] = {
     {
         .cmd_num = WI_FI_SCAN_MSG_TYPE__TypeCmdScanStart,
@@ -66,7 +139,7 @@ static esp_err_t cmd_scan_start_handler(WiFiScanPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespScanStart *resp_payload = (RespScanStart *) malloc(sizeof(RespScanStart));
+    RespScanStart *resp_payload = (RespScanStart *) protocomm_req_alloc(sizeof(RespScanStart));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -96,7 +169,7 @@ static esp_err_t cmd_scan_status_handler(WiFiScanPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespScanStatus *resp_payload = (RespScanStatus *) malloc(sizeof(RespScanStatus));
+    RespScanStatus *resp_payload = (RespScanStatus *) protocomm_req_alloc(sizeof(RespScanStatus));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -124,7 +197,7 @@ static esp_err_t cmd_scan_result_handler(WiFiScanPayload *req,
         return ESP_ERR_INVALID_STATE;
     }
 
-    RespScanResult *resp_payload = (RespScanResult *) malloc(sizeof(RespScanResult));
+    RespScanResult *resp_payload = (RespScanResult *) protocomm_req_alloc(sizeof(RespScanResult));
     if (!resp_payload) {
         ESP_LOGE(TAG, "Error allocating memory");
         return ESP_ERR_NO_MEM;
@@ -135,12 +208,13 @@ static esp_err_t cmd_scan_result_handler(WiFiScanPayload *req,
     resp->payload_case = WI_FI_SCAN_PAYLOAD__PAYLOAD_RESP_SCAN_RESULT;
     resp->resp_scan_result = resp_payload;
 
-    results = (WiFiScanResult **) calloc(req->cmd_scan_result->count,
-                                         sizeof(WiFiScanResult *));
+    results = (WiFiScanResult **) protocomm_req_alloc(req->cmd_scan_result->count *
+                                                      sizeof(WiFiScanResult *));
     if (!results) {
         ESP_LOGE(TAG, "Failed to allocate memory for results array");
         return ESP_ERR_NO_MEM;
     }
+    memset(results, 0, req->cmd_scan_result->count * sizeof(WiFiScanResult *));
     resp_payload->entries = results;
     resp_payload->n_entries = req->cmd_scan_result->count;
 
@@ -152,7 +226,7 @@ static esp_err_t cmd_scan_result_handler(WiFiScanPayload *req,
             break;
         }
 
-        results[i] = (WiFiScanResult *) malloc(sizeof(WiFiScanResult));
+        results[i] = (WiFiScanResult *) protocomm_req_alloc(sizeof(WiFiScanResult));
         if (!results[i]) {
             ESP_LOGE(TAG, "Failed to allocate memory for result entry");
             return ESP_ERR_NO_MEM;
@@ -160,18 +234,19 @@ static esp_err_t cmd_scan_result_handler(WiFiScanPayload *req,
         wi_fi_scan_result__init(results[i]);
 
         results[i]->ssid.len = strnlen(scan_result.ssid, 32);
-        results[i]->ssid.data = (uint8_t *) strndup(scan_result.ssid, 32);
+        results[i]->ssid.data = (uint8_t *) protocomm_req_alloc(results[i]->ssid.len + 1);
         if (!results[i]->ssid.data) {
             ESP_LOGE(TAG, "Failed to allocate memory for scan result entry SSID");
             return ESP_ERR_NO_MEM;
         }
+        memcpy(results[i]->ssid.data, scan_result.ssid, results[i]->ssid.len);
 
         results[i]->channel = scan_result.channel;
         results[i]->rssi = scan_result.rssi;
         results[i]->auth = scan_result.auth;
 
         results[i]->bssid.len = sizeof(scan_result.bssid);
-        results[i]->bssid.data = malloc(results[i]->bssid.len);
+        results[i]->bssid.data = protocomm_req_alloc(results[i]->bssid.len);
         if (!results[i]->bssid.data) {
             ESP_LOGE(TAG, "Failed to allocate memory for scan result entry BSSID");
             return ESP_ERR_NO_MEM;
@@ -200,12 +275,12 @@ static void wifi_prov_scan_cmd_cleanup(WiFiScanPayload *resp, void *priv_data)
     switch (resp->msg) {
         case WI_FI_SCAN_MSG_TYPE__TypeRespScanStart:
             {
-                free(resp->resp_scan_start);
+                protocomm_req_free(resp->resp_scan_start);
             }
             break;
         case WI_FI_SCAN_MSG_TYPE__TypeRespScanStatus:
             {
-                free(resp->resp_scan_status);
+                protocomm_req_free(resp->resp_scan_status);
             }
             break;
         case WI_FI_SCAN_MSG_TYPE__TypeRespScanResult:
@@ -214,13 +289,13 @@ static void wifi_prov_scan_cmd_cleanup(WiFiScanPayload *resp, void *priv_data)
                 if (resp->resp_scan_result->entries) {
                     for (uint16_t i = 0; i < resp->resp_scan_result->n_entries; i++) {
                         if (!resp->resp_scan_result->entries[i]) continue;
-                        free(resp->resp_scan_result->entries[i]->ssid.data);
-                        free(resp->resp_scan_result->entries[i]->bssid.data);
-                        free(resp->resp_scan_result->entries[i]);
+                        protocomm_req_free(resp->resp_scan_result->entries[i]->ssid.data);
+                        protocomm_req_free(resp->resp_scan_result->entries[i]->bssid.data);
+                        protocomm_req_free(resp->resp_scan_result->entries[i]);
                     }
-                    free(resp->resp_scan_result->entries);
+                    protocomm_req_free(resp->resp_scan_result->entries);
                 }
-                free(resp->resp_scan_result);
+                protocomm_req_free(resp->resp_scan_result);
             }
             break;
         default:
@@ -259,13 +334,38 @@ esp_err_t wifi_prov_scan_handler(uint32_t session_id, const uint8_t *inbuf, ssiz
     WiFiScanPayload resp;
     esp_err_t ret = ESP_OK;
 
-    req = wi_fi_scan_payload__unpack(NULL, inlen, inbuf);
+    req = wi_fi_scan_payload__unpack(protocomm_req_allocator(), inlen, inbuf);
     if (!req) {
         ESP_LOGE(TAG, "Unable to unpack scan message");
         return ESP_ERR_INVALID_ARG;
     }
 
     wi_fi_scan_payload__init(&resp);
+
+    wifi_prov_scan_handlers_t *h = (wifi_prov_scan_handlers_t *) priv_data;
+    bool cacheable = false;
+    uint32_t gen = 0;
+    if (h && h->scan_generation && req->msg == WI_FI_SCAN_MSG_TYPE__TypeCmdScanResult &&
+            req->cmd_scan_result) {
+        cacheable = true;
+        gen = h->scan_generation(&h->ctx);
+        struct scan_page_cache *c = scan_page_cache_find(h, gen, req->cmd_scan_result);
+        if (c) {
+            *outbuf = (uint8_t *) protocomm_req_alloc(c->len);
+            if (!*outbuf) {
+                ESP_LOGE(TAG, "System out of memory");
+                ret = ESP_ERR_NO_MEM;
+            } else {
+                memcpy(*outbuf, c->data, c->len);
+                *outlen = c->len;
+                ESP_LOGD(TAG, "Cached response packet size : %d", *outlen);
+            }
+            /* Nothing was built for resp, so no cleanup either */
+            wi_fi_scan_payload__free_unpacked(req, protocomm_req_allocator());
+            return ret;
+        }
+    }
+
     ret = wifi_prov_scan_cmd_dispatcher(req, &resp, priv_data);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Command dispatcher error %d", ret);
@@ -281,7 +381,7 @@ esp_err_t wifi_prov_scan_handler(uint32_t session_id, const uint8_t *inbuf, ssiz
         goto exit;
     }
 
-    *outbuf = (uint8_t *) malloc(*outlen);
+    *outbuf = (uint8_t *) protocomm_req_alloc(*outlen);
     if (!*outbuf) {
         ESP_LOGE(TAG, "System out of memory");
         ret = ESP_ERR_NO_MEM;
@@ -289,9 +389,12 @@ esp_err_t wifi_prov_scan_handler(uint32_t session_id, const uint8_t *inbuf, ssiz
     }
     wi_fi_scan_payload__pack(&resp, *outbuf);
     ESP_LOGD(TAG, "Response packet size : %d", *outlen);
+    if (cacheable && resp.status == STATUS__Success) {
+        scan_page_cache_store(h, gen, req->cmd_scan_result, *outbuf, *outlen);
+    }
     exit:
 
-    wi_fi_scan_payload__free_unpacked(req, NULL);
+    wi_fi_scan_payload__free_unpacked(req, protocomm_req_allocator());
     wifi_prov_scan_cmd_cleanup(&resp, priv_data);
     return ret;
 }
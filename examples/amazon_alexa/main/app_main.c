@@ -24,6 +24,8 @@
 #include <tone.h>
 #include <avs_config.h>
 #include <speech_recognizer.h>
+#include <esp_timer.h>
+#include <va_boot.h>
 #include "va_board.h"
 #include "app_auth.h"
 #include "app_wifi.h"
@@ -1994,6 +1996,52 @@ static void wifi_init_sta()
         .port_num = 0,                          \
     };
 
+#if defined(CTC_CS48L32)
+/* DSP and codec bring-up, in a task of its own next to the network bring-up */
+static void audio_bringup_step(void *arg)
+{
+	int64_t t = esp_timer_get_time();
+	cs_reset();
+	va_boot_record("dsp_reset", t);
+
+	t = esp_timer_get_time();
+	cs_spi_init();
+
+	cs_spi_register_write(0, CS48L32_CONFIG_REG, CS48L32_REG_TYPE_CONFIG);
+	vTaskDelay(100 / portTICK_PERIOD_MS);
+
+	cs_spi_register_write(0, (CS48L32_DSP_PROGRAM_REG - 2), CS48L32_REG_TYPE_DSP_PROGRAM);
+	vTaskDelay(500 / portTICK_PERIOD_MS);
+	va_boot_record("dsp_config", t);
+
+	t = esp_timer_get_time();
+	cs_spi_firmware_write();
+	vTaskDelay(100 / portTICK_PERIOD_MS);
+	va_boot_record("dsp_firmware", t);
+
+	t = esp_timer_get_time();
+	cs_spi_register_write((CS48L32_DSP_PROGRAM_REG - 2), CS48L32_DSP_PROGRAM_REG, CS48L32_REG_TYPE_DSP_PROGRAM);
+	vTaskDelay(100 / portTICK_PERIOD_MS);
+
+#if defined(CTC_CS48L32_TUNE_1ST)
+	cs_spi_register_write(0, CS48L32_TUNE_1ST_REG, CS48L32_REG_TYPE_TUNE_1ST);
+	vTaskDelay(500 / portTICK_PERIOD_MS);
+#endif
+
+	cs_spi_register_write(0, CS48L32_DSP_START_REG, CS48L32_REG_TYPE_DSP_START);
+	vTaskDelay(1000 / portTICK_PERIOD_MS);
+
+	esp_cs_irq_intr_init();
+	va_boot_record("dsp_start", t);
+
+	t = esp_timer_get_time();
+	ak_reset();
+	va_boot_record("codec_reset", t);
+	
+	ESP_LOGE(TAG, "[APP] Free memory: %d bytes", esp_get_free_heap_size());
+}
+#endif
+
 void app_prov_done_cb()
 {
     xEventGroupSetBits(cm_event_group, PROV_DONE_BIT);
@@ -2012,13 +2060,16 @@ void app_main()
     }
     va_cfg->product_id = CONFIG_ALEXA_PRODUCT_ID;
 
+    int64_t t = esp_timer_get_time();
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK( ret );
+    va_boot_record("nvs", t);
 
+    t = esp_timer_get_time();
     va_board_init();
     static media_hal_config_t media_hal_conf = MEDIA_HAL_DEFAULT();
     media_hal_init(&media_hal_conf);
@@ -2029,39 +2080,25 @@ void app_main()
 	va_board_button_init();
 #endif
     va_board_led_init();
+    va_boot_record("board", t);
 
+    /* Audio bring-up is mostly waiting for the DSP, overlap it with the
+     * network bring-up and Wi-Fi connect. The codec is held in reset for
+     * part of it, so every path joins it before the first audio user:
+     * provisioning, alexa_local_config_start and alexa_init all play. */
+    uint32_t audio_ready = 0;
 #if defined(CTC_CS48L32)
-	cs_reset();
-
-	cs_spi_init();
-
-	cs_spi_register_write(0, CS48L32_CONFIG_REG, CS48L32_REG_TYPE_CONFIG);
-	vTaskDelay(100 / portTICK_PERIOD_MS);
-
-	cs_spi_register_write(0, (CS48L32_DSP_PROGRAM_REG - 2), CS48L32_REG_TYPE_DSP_PROGRAM);
-	vTaskDelay(500 / portTICK_PERIOD_MS);
-
-	cs_spi_firmware_write();
-	vTaskDelay(100 / portTICK_PERIOD_MS);
-
-	cs_spi_register_write((CS48L32_DSP_PROGRAM_REG - 2), CS48L32_DSP_PROGRAM_REG, CS48L32_REG_TYPE_DSP_PROGRAM);
-	vTaskDelay(100 / portTICK_PERIOD_MS);
-
-#if defined(CTC_CS48L32_TUNE_1ST)
-	cs_spi_register_write(0, CS48L32_TUNE_1ST_REG, CS48L32_REG_TYPE_TUNE_1ST);
-	vTaskDelay(500 / portTICK_PERIOD_MS);
-#endif
-
-	cs_spi_register_write(0, CS48L32_DSP_START_REG, CS48L32_REG_TYPE_DSP_START);
-	vTaskDelay(1000 / portTICK_PERIOD_MS);
-
-	esp_cs_irq_intr_init();
-
-	ak_reset();
-	
-	ESP_LOGE(TAG, "[APP] Free memory: %d bytes", esp_get_free_heap_size());
+    va_boot_step_t audio_step = {
+        .name = "audio",
+        .fn = audio_bringup_step,
+        /* Wi-Fi runs on core 0 */
+        .core = 1,
+        .stack_size = 8192,
+    };
+    audio_ready = va_boot_add(&audio_step);
 #endif
 
+    t = esp_timer_get_time();
     scli_init();
     va_diag_register_cli();
     wifi_register_cli();
@@ -2072,6 +2109,9 @@ void app_main()
     tcpip_adapter_init();
     ESP_ERROR_CHECK(esp_event_loop_init(event_handler, NULL) );
 
+    va_boot_record("cli_net", t);
+
+    t = esp_timer_get_time();
     printf("\r");       // To remove a garbage print ">>"
     alexa_auth_delegate_init(NULL, NULL);
     bool provisioned = false;
@@ -2093,6 +2133,7 @@ void app_main()
 
     if (!provisioned) {
         va_led_set(LED_RESET);
+        va_boot_wait(audio_ready);
 
 #if defined (EMO_ROBOT)
 		/* This is a blocking call */
@@ -2129,9 +2170,18 @@ void app_main()
         wifi_init_sta();
     }
 
-#if !defined (EMO_ROBOT)
+#if defined (EMO_ROBOT)
+    /* Nothing else orders the bring-up task's SPI and ISR service use
+     * against what comes after app_main on this board */
+    va_boot_wait(audio_ready);
+#else
 
     xEventGroupWaitBits(cm_event_group, CONNECTED_BIT | PROV_DONE_BIT, false, true, portMAX_DELAY);
+    va_boot_record("connect", t);
+
+    t = esp_timer_get_time();
+    va_boot_wait(audio_ready);
+    va_boot_record("audio_wait", t);
 
     if (!provisioned) {
         va_led_set(VA_CAN_START);
@@ -2149,13 +2199,17 @@ void app_main()
 #ifdef ALEXA_BT
     alexa_bt_a2dp_sink_init();
 #endif
+    t = esp_timer_get_time();
     ret = alexa_init(va_cfg);
+    va_boot_record("alexa_init", t);
 
     if (ret != ESP_OK) {
         while(1) vTaskDelay(2);
     }
+    t = esp_timer_get_time();
     /* This is a blocking call */
     va_dsp_init(speech_recognizer_recognize, speech_recognizer_record);
+    va_boot_record("va_dsp_init", t);
 
 #if defined(CTC_CS48L32_FLL_ASP1_BCLK)
 	ESP_LOGE(TAG, "BCLK changed.");
@@ -2182,6 +2236,7 @@ void app_main()
 #endif
     /* This is only supported with minimum flash size of 8MB. */
     alexa_tone_enable_larger_tones();
+    va_boot_dump();
 
 #endif
 
@@ -9,6 +9,7 @@
 #include "esp_log.h"
 #include <esp_system.h>
 #include <esp_heap_caps.h>
+#include <va_latency.h>
 
 static const char *TAG = "[app_va_cb]";
 static int prv_led_state = 1000;
@@ -23,6 +24,11 @@ void va_app_dialog_states(va_dialog_states_t va_state)
     if(prv_led_state != va_state) {
         va_led_set(va_state);
         ESP_LOGI(TAG, "Dialog state is: %d", va_state);
+        if (va_state == VA_THINKING) {
+            va_latency_mark(VA_LATENCY_END_OF_SPEECH);
+        } else if (va_state == VA_IDLE) {
+            va_latency_cancel();
+        }
     }
     prv_led_state = va_state;
 }